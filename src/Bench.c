@@ -0,0 +1,777 @@
+#include "Core.h"
+#if defined CC_BUILD_BENCH
+#include "Bench.h"
+#include "String.h"
+#include "Platform.h"
+#include "Stream.h"
+#include "Constants.h"
+#include "Deflate.h"
+#include "Bitmap.h"
+#include "Vorbis.h"
+#include "Game.h"
+#include "World.h"
+#include "Generator.h"
+#include "Formats.h"
+#include "Block.h"
+#include "BlockID.h"
+#include "BlockPhysics.h"
+#include "Lighting.h"
+#include "Builder.h"
+#include "MapRenderer.h"
+#include "Graphics.h"
+#include "TexturePack.h"
+#include "Event.h"
+#include "Funcs.h"
+#include "Errors.h"
+#include "Window.h"
+#include "Logger.h"
+#include "Camera.h"
+#include "Vectors.h"
+#include "ExtMath.h"
+
+/* Inputs to every scenario are fixed, so that results can be compared between builds */
+#define BENCH_MAP_WIDTH  256
+#define BENCH_MAP_HEIGHT 64
+#define BENCH_MAP_LENGTH 256
+#define BENCH_MAP_SEED   1234
+
+#define BENCH_PNG_SIZE   512
+#define BENCH_FLOOD_SIZE 512
+#define BENCH_FLOOD_TICKS 200
+#define BENCH_FLOOD_SEED  5678
+
+#define BENCH_RENDER_FRAMES 120
+#define BENCH_RENDER_RADIUS 96.0f
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Benchmark results----------------------------------------------------*
+*#########################################################################################################################*/
+#define BENCH_MAX_RESULTS  32
+#define BENCH_MAX_METRICS  3
+
+struct BenchResult {
+	const char* name;
+	int iterations;
+	cc_uint64 totalUS, bestUS;
+	/* Scenario specific measurements (e.g. throughput) */
+	const char* metricNames[BENCH_MAX_METRICS];
+	float metricValues[BENCH_MAX_METRICS];
+	int metricsCount;
+	cc_bool skipped;
+};
+static struct BenchResult bench_results[BENCH_MAX_RESULTS];
+static int bench_resultsCount;
+typedef void (*Bench_Func)(void);
+
+static struct BenchResult* Bench_AddResult(const char* name) {
+	struct BenchResult* r;
+	if (bench_resultsCount == BENCH_MAX_RESULTS) Logger_Abort("Too many benchmark results");
+
+	r = &bench_results[bench_resultsCount++];
+	r->name = name;
+	return r;
+}
+
+static void Bench_AddMetric(struct BenchResult* r, const char* name, float value) {
+	if (r->metricsCount == BENCH_MAX_METRICS) return;
+	r->metricNames[r->metricsCount]  = name;
+	r->metricValues[r->metricsCount] = value;
+	r->metricsCount++;
+}
+
+/* Calculates how much of something was processed per second in the fastest iteration */
+static float Bench_PerSecond(struct BenchResult* r, float amount) {
+	if (!r->bestUS) return 0.0f;
+	return amount / (r->bestUS / 1000000.0f);
+}
+
+static void Bench_Skip(const char* name, const char* reason) {
+	struct BenchResult* r = Bench_AddResult(name);
+	r->skipped = true;
+	Platform_Log2("%c: skipped (%c)", name, reason);
+}
+
+/* Runs the given function for several iterations, measuring how long each iteration took */
+static struct BenchResult* Bench_Measure(const char* name, Bench_Func func, int iterations) {
+	struct BenchResult* r = Bench_AddResult(name);
+	cc_uint64 beg, elapsed;
+	int i, best, mean;
+
+	for (i = 0; i < iterations; i++)
+	{
+		beg = Stopwatch_Measure();
+		func();
+		elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+		r->totalUS += elapsed;
+		if (!i || elapsed < r->bestUS) r->bestUS = elapsed;
+	}
+	r->iterations = iterations;
+
+	best = (int)r->bestUS;
+	mean = (int)(r->totalUS / iterations);
+	Platform_Log3("%c: best %i us, mean %i us", name, &best, &mean);
+	return r;
+}
+
+static void Bench_WriteResult(struct Stream* s, struct BenchResult* r, cc_bool last) {
+	cc_string str; char strBuffer[512];
+	int i, best, mean;
+	String_InitArray(str, strBuffer);
+
+	String_Format1(&str, "    { \"name\": \"%c\"", r->name);
+	if (r->skipped) {
+		String_AppendConst(&str, ", \"skipped\": true");
+	} else {
+		best = (int)r->bestUS;
+		mean = (int)(r->totalUS / r->iterations);
+		String_Format3(&str, ", \"iterations\": %i, \"best_us\": %i, \"mean_us\": %i", &r->iterations, &best, &mean);
+	}
+
+	for (i = 0; i < r->metricsCount; i++)
+	{
+		String_Format2(&str, ", \"%c\": %f2", r->metricNames[i], &r->metricValues[i]);
+	}
+	String_AppendConst(&str, last ? " }" : " },");
+	Stream_WriteLine(s, &str);
+}
+
+static cc_result Bench_WriteResults(const cc_string* path) {
+	static const cc_string header  = String_FromConst("{");
+	static const cc_string version = String_FromConst("  \"version\": \"" GAME_APP_VER "\",");
+	static const cc_string results = String_FromConst("  \"results\": [");
+	static const cc_string footer1 = String_FromConst("  ]");
+	static const cc_string footer2 = String_FromConst("}");
+	struct Stream s;
+	cc_result res;
+	int i;
+
+	res = Stream_CreateFile(&s, path);
+	if (res) return res;
+
+	Stream_WriteLine(&s, (cc_string*)&header);
+	Stream_WriteLine(&s, (cc_string*)&version);
+	Stream_WriteLine(&s, (cc_string*)&results);
+	for (i = 0; i < bench_resultsCount; i++)
+	{
+		Bench_WriteResult(&s, &bench_results[i], i == bench_resultsCount - 1);
+	}
+	Stream_WriteLine(&s, (cc_string*)&footer1);
+	Stream_WriteLine(&s, (cc_string*)&footer2);
+	return s.Close(&s);
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Memory stream--------------------------------------------------------*
+*#########################################################################################################################*/
+/* Write only stream that stores all written data in a fixed size buffer */
+/*  (so that scenarios don't end up measuring the speed of the disk) */
+/* Meta.Buffered is used as: Base = start of buffer, Cur = current position, */
+/*  Length = capacity, Left = capacity left after Cur, End = furthest position written */
+static cc_result BenchMem_Write(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	count = min(count, s->Meta.Buffered.Left);
+	Mem_Copy(s->Meta.Buffered.Cur, data, count);
+
+	s->Meta.Buffered.Cur  += count;
+	s->Meta.Buffered.Left -= count;
+	s->Meta.Buffered.End   = max(s->Meta.Buffered.End, (cc_uint32)(s->Meta.Buffered.Cur - s->Meta.Buffered.Base));
+	*modified = count;
+	return 0;
+}
+
+static cc_result BenchMem_Seek(struct Stream* s, cc_uint32 position) {
+	if (position > s->Meta.Buffered.Length) return ERR_OUT_OF_MEMORY;
+	s->Meta.Buffered.Cur  = s->Meta.Buffered.Base   + position;
+	s->Meta.Buffered.Left = s->Meta.Buffered.Length - position;
+	return 0;
+}
+
+static cc_result BenchMem_Position(struct Stream* s, cc_uint32* position) {
+	*position = (cc_uint32)(s->Meta.Buffered.Cur - s->Meta.Buffered.Base); return 0;
+}
+
+static cc_result BenchMem_Length(struct Stream* s, cc_uint32* length) {
+	*length = s->Meta.Buffered.End; return 0;
+}
+
+static void BenchMem_Open(struct Stream* s, cc_uint8* buffer, cc_uint32 capacity) {
+	Stream_Init(s);
+	s->Write    = BenchMem_Write;
+	s->Seek     = BenchMem_Seek;
+	s->Position = BenchMem_Position;
+	s->Length   = BenchMem_Length;
+
+	s->Meta.Buffered.Base   = buffer;
+	s->Meta.Buffered.Cur    = buffer;
+	s->Meta.Buffered.Length = capacity;
+	s->Meta.Buffered.Left   = capacity;
+	s->Meta.Buffered.End    = 0;
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Engine state--------------------------------------------------------*
+*#########################################################################################################################*/
+/* Only the components needed by the scenarios are started */
+static struct IGameComponent* const bench_comps[] = {
+	&World_Component, &Gfx_Component, &Blocks_Component, &Lighting_Component,
+	&Builder_Component, &MapRenderer_Component, &Formats_Component
+};
+
+static void Bench_OnNewMap(void* obj) {
+	int i;
+	for (i = 0; i < Array_Elems(bench_comps); i++)
+	{
+		if (bench_comps[i]->OnNewMap) bench_comps[i]->OnNewMap();
+	}
+}
+
+static void Bench_OnNewMapLoaded(void* obj) {
+	int i;
+	for (i = 0; i < Array_Elems(bench_comps); i++)
+	{
+		if (bench_comps[i]->OnNewMapLoaded) bench_comps[i]->OnNewMapLoaded();
+	}
+}
+
+/* Terrain atlas with a distinct colour for each tile */
+static void Bench_MakeTerrain(void) {
+	struct Bitmap bmp;
+	int x, y, tile;
+	Bitmap_Allocate(&bmp, 256, 256);
+
+	for (y = 0; y < bmp.height; y++)
+	{
+		for (x = 0; x < bmp.width; x++)
+		{
+			tile = (y / 16) * 16 + (x / 16);
+			Bitmap_GetPixel(&bmp, x, y) = BitmapColor_RGB(tile, 255 - tile, (x ^ y) & 0xFF);
+		}
+	}
+	/* NOTE: The atlas takes ownership of the bitmap */
+	if (!Atlas_TryChange(&bmp)) Logger_Abort("Failed to create benchmark terrain");
+}
+
+static void Bench_Init(void) {
+	int i;
+	Window_Create3D(DisplayInfo.Width, DisplayInfo.Height);
+	Gfx_Create();
+	GameVersion_Load();
+
+	Event_Register_(&WorldEvents.NewMap,    NULL, Bench_OnNewMap);
+	Event_Register_(&WorldEvents.MapLoaded, NULL, Bench_OnNewMapLoaded);
+	for (i = 0; i < Array_Elems(bench_comps); i++)
+	{
+		if (bench_comps[i]->Init) bench_comps[i]->Init();
+	}
+
+	Physics_Init();
+	Bench_MakeTerrain();
+}
+
+static void Bench_Free(void) {
+	int i;
+	Physics_Free();
+	for (i = Array_Elems(bench_comps) - 1; i >= 0; i--)
+	{
+		if (bench_comps[i]->Free) bench_comps[i]->Free();
+	}
+	Gfx_Free();
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Map generation-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Copy of the generated map blocks, used as the input for compression scenarios */
+static BlockRaw* bench_blocks;
+static cc_uint32 bench_volume;
+
+static void Bench_GenerateMap(void) {
+	Mem_Free(Gen_Blocks);
+	Gen_Blocks = NULL;
+
+	World_SetDimensions(BENCH_MAP_WIDTH, BENCH_MAP_HEIGHT, BENCH_MAP_LENGTH);
+	Gen_Active = &NotchyGen;
+	Gen_Seed   = BENCH_MAP_SEED;
+	Gen_Start();
+
+	while (!Gen_IsDone()) { Thread_Sleep(1); }
+	if (!Gen_Blocks) Logger_Abort("Failed to generate benchmark map");
+}
+
+static void Bench_MapGen(void) {
+	struct BenchResult* r;
+	World_NewMap();
+	r = Bench_Measure("mapgen_notchy", Bench_GenerateMap, 3);
+	Bench_AddMetric(r, "blocks_per_sec", Bench_PerSecond(r, (float)World.Volume));
+
+	bench_volume = World.Volume;
+	bench_blocks = (BlockRaw*)Mem_Alloc(bench_volume, 1, "bench blocks");
+	Mem_Copy(bench_blocks, Gen_Blocks, bench_volume);
+
+	World_SetNewMap(Gen_Blocks, BENCH_MAP_WIDTH, BENCH_MAP_HEIGHT, BENCH_MAP_LENGTH);
+	Gen_Blocks = NULL;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Compression scenarios---------------------------------------------------*
+*#########################################################################################################################*/
+static struct GZipState bench_gzip;
+static struct InflateState bench_inflate;
+static cc_uint8* bench_output;
+static cc_uint32 bench_outputSize, bench_outputCapacity;
+static cc_uint8* bench_decompressed;
+static int bench_level;
+
+static void Bench_Deflate(void) {
+	struct Stream mem, compStream;
+	cc_result res;
+	BenchMem_Open(&mem, bench_output, bench_outputCapacity);
+
+	GZip_MakeStream(&compStream, &bench_gzip, &mem);
+	Deflate_SetLevel(&bench_gzip.Base, bench_level);
+	if ((res = Stream_Write(&compStream, bench_blocks, bench_volume))) Logger_Abort2(res, "Compressing");
+	if ((res = compStream.Close(&compStream)))                         Logger_Abort2(res, "Compressing");
+
+	bench_outputSize = mem.Meta.Buffered.End;
+}
+
+static void Bench_Inflate(void) {
+	struct Stream mem, compStream;
+	struct GZipHeader gzHeader;
+	cc_result res;
+	Stream_ReadonlyMemory(&mem, bench_output, bench_outputSize);
+
+	GZipHeader_Init(&gzHeader);
+	while (!gzHeader.done) {
+		if ((res = GZipHeader_Read(&mem, &gzHeader))) Logger_Abort2(res, "Decompressing");
+	}
+
+	Inflate_MakeStream2(&compStream, &bench_inflate, &mem);
+	if ((res = Stream_Read(&compStream, bench_decompressed, bench_volume))) Logger_Abort2(res, "Decompressing");
+}
+
+static void Bench_Compression(void) {
+	static const char* const names[DEFLATE_LEVEL_COUNT] = { "deflate_fast", "deflate_normal", "deflate_best" };
+	struct BenchResult* r;
+
+	/* Worst case for DEFLATE stored blocks is a few bytes of overhead per 64 kb */
+	bench_outputCapacity = bench_volume + bench_volume / 8 + 4096;
+	bench_output         = (cc_uint8*)Mem_Alloc(bench_outputCapacity, 1, "bench output");
+	bench_decompressed   = (cc_uint8*)Mem_Alloc(bench_volume, 1, "bench decompressed");
+
+	/* NORMAL is done last, so inflate measures decompressing what maps are usually saved as */
+	for (bench_level = DEFLATE_LEVEL_COUNT - 1; bench_level >= 0; bench_level--)
+	{
+		if (bench_level == DEFLATE_LEVEL_NORMAL) continue;
+		r = Bench_Measure(names[bench_level], Bench_Deflate, 3);
+		Bench_AddMetric(r, "mb_per_sec", Bench_PerSecond(r, bench_volume / (1024.0f * 1024.0f)));
+		Bench_AddMetric(r, "output_bytes", (float)bench_outputSize);
+	}
+	bench_level = DEFLATE_LEVEL_NORMAL;
+	r = Bench_Measure(names[bench_level], Bench_Deflate, 3);
+	Bench_AddMetric(r, "mb_per_sec", Bench_PerSecond(r, bench_volume / (1024.0f * 1024.0f)));
+	Bench_AddMetric(r, "output_bytes", (float)bench_outputSize);
+
+	r = Bench_Measure("inflate", Bench_Inflate, 5);
+	Bench_AddMetric(r, "mb_per_sec", Bench_PerSecond(r, bench_volume / (1024.0f * 1024.0f)));
+	if (!Mem_Equal(bench_decompressed, bench_blocks, bench_volume)) {
+		Platform_LogConst("inflate: decompressed data does not match original");
+	}
+
+	Mem_Free(bench_decompressed);
+	Mem_Free(bench_output);
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------PNG scenarios-------------------------------------------------------*
+*#########################################################################################################################*/
+static struct Bitmap bench_bmp;
+static cc_bool bench_pngAlpha;
+
+/* Top down view of the generated map, which behaves more like an actual screenshot than random noise would */
+static void Bench_MakeBitmap(void) {
+	int x, y, z, index;
+	BlockRaw block;
+	Bitmap_Allocate(&bench_bmp, BENCH_PNG_SIZE, BENCH_PNG_SIZE);
+
+	for (z = 0; z < BENCH_PNG_SIZE; z++)
+	{
+		for (x = 0; x < BENCH_PNG_SIZE; x++)
+		{
+			index = ((z / 2) % BENCH_MAP_LENGTH) * BENCH_MAP_WIDTH + ((x / 2) % BENCH_MAP_WIDTH);
+			block = BLOCK_AIR;
+
+			for (y = BENCH_MAP_HEIGHT - 1; y > 0; y--)
+			{
+				block = bench_blocks[index + y * (BENCH_MAP_WIDTH * BENCH_MAP_LENGTH)];
+				if (block != BLOCK_AIR) break;
+			}
+			Bitmap_GetPixel(&bench_bmp, x, z) = BitmapColor_RGB(block * 23, y * 4, block * 71);
+		}
+	}
+}
+
+static void Bench_PngEncode(void) {
+	struct Stream mem;
+	cc_result res;
+	BenchMem_Open(&mem, bench_output, bench_outputCapacity);
+
+	if ((res = Png_Encode(&bench_bmp, &mem, NULL, bench_pngAlpha))) Logger_Abort2(res, "Encoding PNG");
+	bench_outputSize = mem.Meta.Buffered.End;
+}
+
+static void Bench_PngDecode(void) {
+	struct Stream mem;
+	struct Bitmap bmp;
+	cc_result res;
+	Stream_ReadonlyMemory(&mem, bench_output, bench_outputSize);
+
+	if ((res = Png_Decode(&bmp, &mem))) Logger_Abort2(res, "Decoding PNG");
+	Mem_Free(bmp.scan0);
+}
+
+static void Bench_Png(void) {
+	struct BenchResult* r;
+	float pixels = BENCH_PNG_SIZE * BENCH_PNG_SIZE;
+	Bench_MakeBitmap();
+
+	bench_outputCapacity = BENCH_PNG_SIZE * BENCH_PNG_SIZE * 4 + 4096;
+	bench_output         = (cc_uint8*)Mem_Alloc(bench_outputCapacity, 1, "bench PNG");
+
+	r = Bench_Measure("png_encode", Bench_PngEncode, 5);
+	Bench_AddMetric(r, "pixels_per_sec", Bench_PerSecond(r, pixels));
+	Bench_AddMetric(r, "output_bytes", (float)bench_outputSize);
+
+	r = Bench_Measure("png_decode", Bench_PngDecode, 5);
+	Bench_AddMetric(r, "pixels_per_sec", Bench_PerSecond(r, pixels));
+
+	/* Texture packs are usually saved with an alpha channel */
+	bench_pngAlpha = true;
+	Bench_PngEncode();
+
+	r = Bench_Measure("png_decode_rgba", Bench_PngDecode, 5);
+	Bench_AddMetric(r, "pixels_per_sec", Bench_PerSecond(r, pixels));
+
+	Mem_Free(bench_output);
+	Mem_Free(bench_bmp.scan0);
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Vorbis scenario------------------------------------------------------*
+*#########################################################################################################################*/
+/* There's no encoder in the game, so decode one of the music files that the launcher downloads */
+static const cc_string bench_oggPath = String_FromConst("audio/calm1.ogg");
+static cc_uint8* bench_ogg;
+static cc_uint32 bench_oggSize;
+static int bench_samples;
+
+static void Bench_VorbisDecode(void) {
+	struct Stream mem;
+	struct OggState ogg;
+	struct VorbisState vorbis = { 0 };
+	cc_int16* data;
+	cc_result res;
+
+	Stream_ReadonlyMemory(&mem, bench_ogg, bench_oggSize);
+	Ogg_Init(&ogg, &mem);
+	vorbis.source = &ogg;
+	if ((res = Vorbis_DecodeHeaders(&vorbis))) Logger_Abort2(res, "Decoding vorbis headers");
+
+	data = (cc_int16*)Mem_Alloc(vorbis.blockSizes[1] * vorbis.channels, 2, "bench samples");
+	bench_samples = 0;
+
+	for (;;) {
+		if ((res = Vorbis_DecodeFrame(&vorbis))) break;
+		bench_samples += Vorbis_OutputFrame(&vorbis, data);
+	}
+	if (res != ERR_END_OF_STREAM) Logger_Abort2(res, "Decoding vorbis");
+
+	Mem_Free(data);
+	Vorbis_Free(&vorbis);
+}
+
+static void Bench_Vorbis(void) {
+	struct BenchResult* r;
+	struct Stream s;
+	cc_result res;
+
+	if (!File_Exists(&bench_oggPath)) {
+		Bench_Skip("vorbis_decode", "audio/calm1.ogg is missing"); return;
+	}
+	if ((res = Stream_OpenFile(&s, &bench_oggPath))) Logger_Abort2(res, "Opening ogg");
+	if ((res = s.Length(&s, &bench_oggSize)))        Logger_Abort2(res, "Opening ogg");
+
+	bench_ogg = (cc_uint8*)Mem_Alloc(bench_oggSize, 1, "bench ogg");
+	if ((res = Stream_Read(&s, bench_ogg, bench_oggSize))) Logger_Abort2(res, "Reading ogg");
+	(void)s.Close(&s);
+
+	r = Bench_Measure("vorbis_decode", Bench_VorbisDecode, 3);
+	Bench_AddMetric(r, "samples_per_sec", Bench_PerSecond(r, (float)bench_samples));
+	Mem_Free(bench_ogg);
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Mesh scenarios-------------------------------------------------------*
+*#########################################################################################################################*/
+static struct ChunkInfo* bench_chunks;
+static int bench_vertices;
+
+static void Bench_BuildChunks(void) {
+	struct ChunkInfo* info;
+	int x, y, z, index = 0;
+	bench_vertices = 0;
+
+	for (z = 0; z < World.Length; z += CHUNK_SIZE)
+	{
+		for (y = 0; y < World.Height; y += CHUNK_SIZE)
+		{
+			for (x = 0; x < World.Width; x += CHUNK_SIZE)
+			{
+				info = &bench_chunks[index++];
+				info->CentreX = x + HALF_CHUNK_SIZE;
+				info->CentreY = y + HALF_CHUNK_SIZE;
+				info->CentreZ = z + HALF_CHUNK_SIZE;
+				info->NormalParts      = NULL;
+				info->TranslucentParts = NULL;
+
+				bench_vertices += Builder_MakeChunk(info);
+				Gfx_DeleteVb(&info->Vb);
+			}
+		}
+	}
+}
+
+static void Bench_MeshWith(const char* name, cc_bool smooth, cc_bool greedy) {
+	struct BenchResult* r;
+	Builder_SmoothLighting = smooth;
+	Builder_GreedyMeshing  = greedy;
+	Builder_ApplyActive();
+	/* Greedy meshing only merges rows when the 1D atlases are rebuilt with one tile each */
+	Bench_MakeTerrain();
+
+	r = Bench_Measure(name, Bench_BuildChunks, 3);
+	Bench_AddMetric(r, "chunks_per_sec", Bench_PerSecond(r, (float)World.ChunksCount));
+	Bench_AddMetric(r, "vertices",       (float)bench_vertices);
+	Bench_AddMetric(r, "vertex_kb",      bench_vertices * (float)sizeof(struct VertexTextured) / 1024.0f);
+}
+
+static void Bench_Mesh(void) {
+	cc_bool smooth = Builder_SmoothLighting, greedy = Builder_GreedyMeshing;
+	bench_chunks   = (struct ChunkInfo*)Mem_AllocCleared(World.ChunksCount, sizeof(struct ChunkInfo), "bench chunks");
+
+	Bench_MeshWith("mesh_normal",   false, false);
+	Bench_MeshWith("mesh_greedy",   false, true);
+	Bench_MeshWith("mesh_advanced", true,  false);
+
+	Builder_SmoothLighting = smooth;
+	Builder_GreedyMeshing  = greedy;
+	Builder_ApplyActive();
+	Bench_MakeTerrain();
+	Mem_Free(bench_chunks);
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Render scenarios------------------------------------------------------*
+*#########################################################################################################################*/
+#define BENCH_FRAME_DELTA (1.0 / 60.0)
+static int bench_renderFrame, bench_renderVertices;
+
+/* Camera circles around the centre of the map while looking down at it */
+static void Bench_SetCamera(int frame) {
+	float angle = frame * (2.0f * MATH_PI / BENCH_RENDER_FRAMES);
+	Vec2 rot;
+
+	Camera.CurrentPos.X = World.Width  / 2.0f + Math_SinF(angle) * BENCH_RENDER_RADIUS;
+	Camera.CurrentPos.Y = World.Height + 16.0f;
+	Camera.CurrentPos.Z = World.Length / 2.0f + Math_CosF(angle) * BENCH_RENDER_RADIUS;
+
+	rot.X = -angle;
+	rot.Y = 30.0f * MATH_DEG2RAD;
+	Matrix_LookRot(&Gfx.View, Camera.CurrentPos, rot);
+	FrustumCulling_CalcFrustumEquations(&Gfx.Projection, &Gfx.View);
+}
+
+static void Bench_RenderFrame(void) {
+	Bench_SetCamera(bench_renderFrame++);
+	Gfx_BeginFrame();
+	Gfx_BindIb(Gfx_defaultIb);
+	Gfx_Clear();
+
+	Gfx_LoadMatrix(MATRIX_PROJECTION, &Gfx.Projection);
+	Gfx_LoadMatrix(MATRIX_VIEW,       &Gfx.View);
+	Game_Vertices = 0;
+
+	MapRenderer_Update(BENCH_FRAME_DELTA);
+	MapRenderer_RenderNormal(BENCH_FRAME_DELTA);
+	MapRenderer_RenderTranslucent(BENCH_FRAME_DELTA);
+	Gfx_EndFrame();
+	bench_renderVertices += Game_Vertices;
+}
+
+/* Builds every chunk of the map beforehand, so only drawing is measured */
+static void Bench_BuildAllChunks(void) {
+	int i;
+	for (i = 0; i < 100000 && MapRenderer_UnbuiltChunks(); i++)
+	{
+		MapRenderer_Update(BENCH_FRAME_DELTA);
+		Thread_Sleep(1);
+	}
+	if (MapRenderer_UnbuiltChunks()) Logger_Abort("Failed to build benchmark chunks");
+}
+
+static void Bench_Render(void) {
+	struct BenchResult* r;
+	Game.Width  = WindowInfo.Width;
+	Game.Height = WindowInfo.Height;
+	Gfx_OnWindowResize();
+
+	Gfx_CalcPerspectiveMatrix(&Gfx.Projection, 70.0f * MATH_DEG2RAD,
+		(float)Game.Width / (float)Game.Height, (float)Game_ViewDistance);
+	Gfx_ClearCol(Env.SkyCol);
+	Gfx_SetFog(true);
+	Gfx_SetFogMode(FOG_LINEAR);
+	Gfx_SetFogEnd((float)Game_ViewDistance);
+	Gfx_SetFogCol(Env.FogCol);
+
+	Bench_SetCamera(0);
+	Bench_BuildAllChunks();
+	bench_renderFrame    = 0;
+	bench_renderVertices = 0;
+
+	r = Bench_Measure("render_softgpu", Bench_RenderFrame, BENCH_RENDER_FRAMES);
+	Bench_AddMetric(r, "fps",      r->iterations / (r->totalUS / 1000000.0f));
+	Bench_AddMetric(r, "vertices", (float)bench_renderVertices / r->iterations);
+	Gfx_SetFog(false);
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Map file scenarios---------------------------------------------------*
+*#########################################################################################################################*/
+static void Bench_CwSave(void) {
+	struct Stream mem, compStream;
+	cc_result res;
+	BenchMem_Open(&mem, bench_output, bench_outputCapacity);
+
+	GZip_MakeStream(&compStream, &bench_gzip, &mem);
+	if ((res = Cw_Save(&compStream)))          Logger_Abort2(res, "Saving .cw");
+	if ((res = compStream.Close(&compStream))) Logger_Abort2(res, "Saving .cw");
+	bench_outputSize = mem.Meta.Buffered.End;
+}
+
+static void Bench_CwLoad(void) {
+	static const cc_string path = String_FromConst("bench.cw");
+	struct MapImporter* imp = MapImporter_Find(&path);
+	struct Stream mem;
+	cc_result res;
+
+	World_NewMap();
+	Stream_ReadonlyMemory(&mem, bench_output, bench_outputSize);
+	if ((res = imp->import(&mem))) Logger_Abort2(res, "Loading .cw");
+	World_SetNewMap(World.Blocks, World.Width, World.Height, World.Length);
+}
+
+static void Bench_MapFiles(void) {
+	struct BenchResult* r;
+	float volume = (float)World.Volume;
+
+	bench_outputCapacity = World.Volume * 2 + 65536;
+	bench_output         = (cc_uint8*)Mem_Alloc(bench_outputCapacity, 1, "bench map");
+
+	r = Bench_Measure("cw_save", Bench_CwSave, 3);
+	Bench_AddMetric(r, "blocks_per_sec", Bench_PerSecond(r, volume));
+	Bench_AddMetric(r, "output_bytes",   (float)bench_outputSize);
+
+	r = Bench_Measure("cw_load", Bench_CwLoad, 3);
+	Bench_AddMetric(r, "blocks_per_sec", Bench_PerSecond(r, volume));
+	Mem_Free(bench_output);
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Physics scenario------------------------------------------------------*
+*#########################################################################################################################*/
+static int bench_maxQueued;
+
+/* Flat map with water placed at several points, which then floods outwards every tick */
+static void Bench_MakeFloodMap(void) {
+	int size = BENCH_FLOOD_SIZE, height = BENCH_MAP_HEIGHT;
+	int x, z, ground = height / 2;
+	BlockRaw* blocks;
+	cc_uint32 oneY = size * size;
+
+	World_NewMap();
+	blocks = (BlockRaw*)Mem_Alloc(oneY * height, 1, "bench flood map");
+	Mem_Set(blocks,                 BLOCK_STONE, oneY * ground);
+	Mem_Set(blocks + oneY * ground, BLOCK_AIR,   oneY * (height - ground));
+	World_SetNewMap(blocks, size, height, size);
+
+	Physics_SetEnabled(true);
+	/* Random block ticks would otherwise be different every run */
+	Physics_SetSeed(BENCH_FLOOD_SEED);
+	for (z = size / 8; z < size; z += size / 4)
+	{
+		for (x = size / 8; x < size; x += size / 4)
+		{
+			Game_UpdateBlock(x, ground, z, BLOCK_WATER);
+			Physics_OnBlockChanged(x, ground, z, BLOCK_AIR, BLOCK_WATER);
+		}
+	}
+}
+
+static void Bench_PhysicsTick(void) {
+	Physics_Tick();
+	bench_maxQueued = max(bench_maxQueued, Physics_QueuedCount());
+}
+
+static void Bench_Physics(void) {
+	struct BenchResult* r;
+	Bench_MakeFloodMap();
+
+	r = Bench_Measure("physics_flood", Bench_PhysicsTick, BENCH_FLOOD_TICKS);
+	Bench_AddMetric(r, "ticks_per_sec",   r->iterations / (r->totalUS / 1000000.0f));
+	Bench_AddMetric(r, "max_queue_depth", (float)bench_maxQueued);
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Benchmark runner-----------------------------------------------------*
+*#########################################################################################################################*/
+int Bench_Run(int argc, char** argv) {
+	cc_string args[GAME_MAX_CMDARGS];
+	cc_string path = String_FromConst("bench.json");
+	int argsCount;
+	cc_result res;
+
+	argsCount = Platform_GetCommandLineArgs(argc, argv, args);
+	if (argsCount) path = args[0];
+
+	Bench_Init();
+	Bench_MapGen();
+	Bench_Compression();
+	Bench_Png();
+	Bench_Vorbis();
+	Bench_Mesh();
+	Bench_Render();
+	Bench_MapFiles();
+	Bench_Physics();
+
+	Mem_Free(bench_blocks);
+	Bench_Free();
+
+	res = Bench_WriteResults(&path);
+	if (res) { Logger_SysWarn2(res, "writing", &path); return 1; }
+
+	Platform_Log1("Benchmark results written to %s", &path);
+	return 0;
+}
+#endif
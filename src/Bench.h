@@ -0,0 +1,12 @@
+#ifndef CC_BENCH_H
+#define CC_BENCH_H
+#include "Core.h"
+/* Runs repeatable benchmarks of core engine modules without needing a window or GPU,
+     and then writes the results out in JSON format (to catch performance regressions)
+   Copyright 2014-2023 ClassiCube | Licensed under BSD-3
+*/
+
+/* Runs all of the benchmark scenarios, then writes the results to a .json file */
+/* NOTE: Only available in builds with CC_BUILD_BENCH defined (e.g. 'make bench') */
+int Bench_Run(int argc, char** argv);
+#endif
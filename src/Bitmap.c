@@ -6,6 +6,11 @@
 #include "Stream.h"
 #include "Errors.h"
 #include "Utils.h"
+#include "Funcs.h"
+#if defined __SSE2__
+#include <emmintrin.h>
+#define PNG_SSE2
+#endif
 
 BitmapCol BitmapColor_Offset(BitmapCol color, int rBy, int gBy, int bBy) {
 	int r, g, b;
@@ -88,52 +93,165 @@ cc_bool Png_Detect(const cc_uint8* data, cc_uint32 len) {
 
 /* 9 Filtering */
 /* 13.9 Filtering */
-static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) {
-	cc_uint32 i, j;
-	switch (type) {
-	case PNG_FILTER_NONE:
-		return;
+#define Png_Avg(a, b) (((a) + (b)) >> 1)
+#define Png_Abs(x) ((x) < 0 ? -(x) : (x))
 
+static CC_INLINE cc_uint8 Png_Paeth(cc_uint8 a, cc_uint8 b, cc_uint8 c) {
+	/* Equivalent to |p - a|, |p - b|, |p - c| where p = a + b - c */
+	int pa = b - c, pb = a - c, pc = pa + pb;
+	pa = Png_Abs(pa); pb = Png_Abs(pb); pc = Png_Abs(pc);
+
+	if (pa <= pb && pa <= pc) return a;
+	return pb <= pc ? b : c;
+}
+
+/* First pixel has no pixel to the left of it */
+static cc_uint32 Png_ReconstructFirst(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior) {
+	cc_uint32 i;
+	for (i = 0; i < bytesPerPixel; i++) {
+		if (type == PNG_FILTER_AVERAGE) line[i] += prior[i] >> 1;
+		if (type == PNG_FILTER_PAETH)   line[i] += prior[i];
+	}
+	return i;
+}
+
+static void Png_ReconstructScalar(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen, cc_uint32 i) {
+	cc_uint32 j = i - bytesPerPixel;
+
+	switch (type) {
 	case PNG_FILTER_SUB:
-		for (i = bytesPerPixel, j = 0; i < lineLen; i++, j++) {
+		for (; i < lineLen; i++, j++) {
 			line[i] += line[j];
 		}
 		return;
 
 	case PNG_FILTER_UP:
-		for (i = 0; i < lineLen; i++) {
+		for (; i < lineLen; i++) {
 			line[i] += prior[i];
 		}
 		return;
 
 	case PNG_FILTER_AVERAGE:
-		for (i = 0; i < bytesPerPixel; i++) {
-			line[i] += (prior[i] >> 1);
-		}
-		for (j = 0; i < lineLen; i++, j++) {
-			line[i] += ((prior[i] + line[j]) >> 1);
+		for (; i < lineLen; i++, j++) {
+			line[i] += Png_Avg(prior[i], line[j]);
 		}
 		return;
 
 	case PNG_FILTER_PAETH:
-		/* TODO: verify this is right */
-		for (i = 0; i < bytesPerPixel; i++) {
-			line[i] += prior[i];
+		for (; i < lineLen; i++, j++) {
+			line[i] += Png_Paeth(line[j], prior[i], prior[j]);
+		}
+		return;
+	}
+}
+
+#ifdef PNG_SSE2
+#define Png_Get32(p) ((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((cc_uint32)(p)[3] << 24))
+#define Png_Load(p) _mm_unpacklo_epi8(_mm_cvtsi32_si128(Png_Get32(p)), zero)
+
+/* Stores the lowest bytesPerPixel bytes of the given 8 bit pixel */
+static CC_INLINE void Png_Store(cc_uint8* p, __m128i pixel, cc_uint8 bytesPerPixel) {
+	cc_uint32 v = _mm_cvtsi128_si32(pixel);
+	p[0] = (cc_uint8)v; p[1] = (cc_uint8)(v >> 8); p[2] = (cc_uint8)(v >> 16);
+	if (bytesPerPixel == 4) p[3] = (cc_uint8)(v >> 24);
+}
+
+/* Reconstructs one pixel at a time, with each component of the pixel in a 16 bit lane */
+/* Returns the index of the first byte that still needs to be reconstructed */
+static cc_uint32 Png_ReconstructPixels(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) {
+	__m128i zero = _mm_setzero_si128(), a = zero, c = zero;
+	__m128i b, x, pa, pb, pc, smallest, nearest;
+	cc_uint32 i;
+
+	/* 4 bytes are always read, so stop before the last pixel when 3 bytes per pixel */
+	for (i = 0; i + 4 <= lineLen; i += bytesPerPixel) {
+		x = Png_Load(&line[i]);
+
+		switch (type) {
+		case PNG_FILTER_SUB:
+			a = _mm_add_epi16(x, a);
+			break;
+
+		case PNG_FILTER_AVERAGE:
+			b = Png_Load(&prior[i]);
+			a = _mm_add_epi16(x, _mm_srli_epi16(_mm_add_epi16(a, b), 1));
+			break;
+
+		case PNG_FILTER_PAETH:
+			b  = Png_Load(&prior[i]);
+			pa = _mm_sub_epi16(b, c);
+			pb = _mm_sub_epi16(a, c);
+			pc = _mm_add_epi16(pa, pb);
+
+			pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+			pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+			pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+			smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+			/* a if pa is smallest, otherwise b if pb is smallest, otherwise c */
+			nearest = _mm_cmpeq_epi16(pb, smallest);
+			nearest = _mm_or_si128(_mm_and_si128(nearest, b), _mm_andnot_si128(nearest, c));
+			smallest = _mm_cmpeq_epi16(pa, smallest);
+			nearest = _mm_or_si128(_mm_and_si128(smallest, a), _mm_andnot_si128(smallest, nearest));
+
+			a = _mm_add_epi16(x, nearest);
+			c = b;
+			break;
 		}
-		for (j = 0; i < lineLen; i++, j++) {
-			cc_uint8 a = line[j], b = prior[i], c = prior[j];
-			int p = a + b - c;
-			int pa = Math_AbsI(p - a);
-			int pb = Math_AbsI(p - b);
-			int pc = Math_AbsI(p - c);
-
-			if (pa <= pb && pa <= pc) { line[i] += a; } 
-			else if (pb <= pc) {        line[i] += b; } 
-			else {                      line[i] += c; }
+
+		/* Wrap each component around to 8 bits */
+		a = _mm_and_si128(a, _mm_set1_epi16(0xFF));
+		Png_Store(&line[i], _mm_packus_epi16(a, a), bytesPerPixel);
+	}
+	return i;
+}
+
+static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) {
+	__m128i x, y;
+	cc_uint32 i = 0;
+
+	if (type == PNG_FILTER_NONE) return;
+	if (type == PNG_FILTER_UP) {
+		for (; i + 16 <= lineLen; i += 16) {
+			x = _mm_loadu_si128((__m128i*)&line[i]);
+			y = _mm_loadu_si128((__m128i*)&prior[i]);
+			_mm_storeu_si128((__m128i*)&line[i], _mm_add_epi8(x, y));
 		}
+		Png_ReconstructScalar(type, bytesPerPixel, line, prior, lineLen, i);
 		return;
 	}
+
+	if (type == PNG_FILTER_SUB && bytesPerPixel == 4) {
+		/* Adds each pixel to all pixels after it in the same 4 pixels, then adds the last pixel of the previous 4 */
+		y = _mm_setzero_si128();
+		for (; i + 16 <= lineLen; i += 16) {
+			x = _mm_loadu_si128((__m128i*)&line[i]);
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi8(x, y);
+			_mm_storeu_si128((__m128i*)&line[i], x);
+			y = _mm_shuffle_epi32(x, 0xFF);
+		}
+		if (!i) i = Png_ReconstructFirst(type, bytesPerPixel, line, prior);
+	} else if (bytesPerPixel == 3 || bytesPerPixel == 4) {
+		/* Most common formats are RGB and RGBA with 8 bits per sample */
+		i = Png_ReconstructPixels(type, bytesPerPixel, line, prior, lineLen);
+		/* 1 pixel wide RGB rows are too short to be reconstructed above */
+		if (!i) i = Png_ReconstructFirst(type, bytesPerPixel, line, prior);
+	} else {
+		i = Png_ReconstructFirst(type, bytesPerPixel, line, prior);
+	}
+	Png_ReconstructScalar(type, bytesPerPixel, line, prior, lineLen, i);
 }
+#else
+static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) {
+	cc_uint32 i = 0;
+	if (type == PNG_FILTER_NONE) return;
+
+	if (type != PNG_FILTER_UP) i = Png_ReconstructFirst(type, bytesPerPixel, line, prior);
+	Png_ReconstructScalar(type, bytesPerPixel, line, prior, lineLen, i);
+}
+#endif
 
 #define Bitmap_Set(dst, r,g,b,a) dst = BitmapCol_Make(r, g, b, a);
 
@@ -188,10 +306,35 @@ static void Png_Expand_GRAYSCALE_16(int width, BitmapCol* palette, cc_uint8* src
 	}
 }
 
+#if defined PNG_SSE2 && BITMAPCOLOR_R_SHIFT == 16 && BITMAPCOLOR_G_SHIFT == 8 && BITMAPCOLOR_B_SHIFT == 0
+/* Converts 4 RGBA ordered pixels into BGRA ordered BitmapCols */
+static CC_INLINE __m128i Png_SwapRB(__m128i x) {
+	__m128i rb = _mm_and_si128(x, _mm_set1_epi32(0x00FF00FF));
+	__m128i ga = _mm_andnot_si128(_mm_set1_epi32(0x00FF00FF), x);
+	return _mm_or_si128(ga, _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)));
+}
+#define PNG_SSE2_EXPAND
+#elif defined PNG_SSE2 && BITMAPCOLOR_R_SHIFT == 0 && BITMAPCOLOR_G_SHIFT == 8 && BITMAPCOLOR_B_SHIFT == 16
+#define Png_SwapRB(x) (x)
+#define PNG_SSE2_EXPAND
+#endif
+
 static void Png_Expand_RGB_8(int width, BitmapCol* palette, cc_uint8* src, BitmapCol* dst) {
-	int i, j;
+	int i = 0, j = 0;
+#ifdef PNG_SSE2_EXPAND
+	__m128i x, lo, hi, alpha = _mm_set1_epi32(BITMAPCOLOR_A_MASK);
+
+	/* 16 bytes are read for every 12 bytes of 4 pixels, so stop 2 pixels early */
+	for (; i + 6 <= width; i += 4, j += 12) {
+		x  = _mm_loadu_si128((__m128i*)&src[j]);
+		lo = _mm_unpacklo_epi32(x, _mm_srli_si128(x, 3));
+		hi = _mm_unpacklo_epi32(_mm_srli_si128(x, 6), _mm_srli_si128(x, 9));
+		x  = _mm_or_si128(_mm_unpacklo_epi64(lo, hi), alpha);
+		_mm_storeu_si128((__m128i*)&dst[i], Png_SwapRB(x));
+	}
+#endif
 
-	for (i = 0, j = 0; i < (width & ~0x03); i += 4, j += 12) {
+	for (; i < (width & ~0x03); i += 4, j += 12) {
 		PNG_Do_RGB__8(i    , j    ); PNG_Do_RGB__8(i + 1, j + 3);
 		PNG_Do_RGB__8(i + 2, j + 6); PNG_Do_RGB__8(i + 3, j + 9);
 	}
@@ -255,9 +398,17 @@ static void Png_Expand_GRAYSCALE_A_16(int width, BitmapCol* palette, cc_uint8* s
 }
 
 static void Png_Expand_RGB_A_8(int width, BitmapCol* palette, cc_uint8* src, BitmapCol* dst) {
-	int i, j;
+	int i = 0, j = 0;
+#ifdef PNG_SSE2_EXPAND
+	__m128i x;
 
-	for (i = 0, j = 0; i < (width & ~0x3); i += 4, j += 16) {
+	for (; i + 4 <= width; i += 4, j += 16) {
+		x = _mm_loadu_si128((__m128i*)&src[j]);
+		_mm_storeu_si128((__m128i*)&dst[i], Png_SwapRB(x));
+	}
+#endif
+
+	for (; i < (width & ~0x3); i += 4, j += 16) {
 		PNG_Do_RGB_A__8(i    , j    ); PNG_Do_RGB_A__8(i + 1, j + 4 );
 		PNG_Do_RGB_A__8(i + 2, j + 8); PNG_Do_RGB_A__8(i + 3, j + 12);
 	}
@@ -334,8 +485,46 @@ static void ComputeTransparency(struct Bitmap* bmp, BitmapCol col) {
 /* Need to store both current and prior row, per PNG specification. */
 #define PNG_BUFFER_SIZE ((PNG_MAX_DIMS * 2 * 4 + 1) * 2)
 
+/* Result whose bitmap can be taken by Png_Decode, instead of decoding its data again */
+static struct PngDecodeResult* png_predecoded;
+
+static cc_result Png_PredecodedRead(struct Stream* s, cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	count = min(count, s->Meta.Mem.Left);
+	Mem_Copy(data, s->Meta.Mem.Cur, count);
+
+	s->Meta.Mem.Cur  += count; 
+	s->Meta.Mem.Left -= count;
+	*modified = count;
+	return 0;
+}
+
+void PngDecodeResult_MakeStream(struct Stream* s, struct PngDecodeResult* result) {
+	Stream_ReadonlyMemory(s, result->data, result->size);
+	if (result->res || !result->bmp.scan0) return;
+
+	/* Only streams made here use this Read function, so checking for it in */
+	/*  Png_Decode never touches png_predecoded from the background decoders */
+	s->Read        = Png_PredecodedRead;
+	png_predecoded = result;
+}
+
+static cc_bool Png_TakePredecoded(struct Bitmap* bmp, struct Stream* stream) {
+	struct PngDecodeResult* result = png_predecoded;
+	/* Data must not have been read from the stream yet */
+	if (!result || stream->Meta.Mem.Base != result->data) return false;
+	if (stream->Meta.Mem.Cur != stream->Meta.Mem.Base)    return false;
+
+	*bmp = result->bmp;
+	result->bmp.scan0 = NULL;
+	png_predecoded    = NULL;
+	/* Consume the data, just like decoding would have */
+	stream->Meta.Mem.Cur += stream->Meta.Mem.Left;
+	stream->Meta.Mem.Left = 0;
+	return true;
+}
+
 /* TODO: Test a lot of .png files and ensure output is right */
-cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
+static cc_result Png_DecodeCore(struct Bitmap* bmp, struct Stream* stream, cc_uint8* buffer) {
 	cc_uint8 tmp[64];
 	cc_uint32 dataSize, fourCC;
 	cc_result res;
@@ -353,7 +542,6 @@ cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 
 	/* idat state */
 	cc_uint32 curY = 0, begY, rowY, endY;
-	cc_uint8 buffer[PNG_BUFFER_SIZE];
 	cc_uint32 bufferRows, bufferLen;
 	cc_uint32 bufferIdx, read, left;
 	cc_bool initedBuffer = false;
@@ -363,9 +551,6 @@ cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 	struct Stream compStream, datStream;
 	struct ZLibHeader zlibHeader;
 
-	bmp->width = 0; bmp->height = 0;
-	bmp->scan0 = NULL;
-
 	res = Stream_Read(stream, tmp, PNG_SIG_SIZE);
 	if (res) return res;
 	if (!Png_Detect(tmp, PNG_SIG_SIZE)) return PNG_ERR_INVALID_SIG;
@@ -542,6 +727,252 @@ cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 	}
 }
 
+cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
+	cc_uint8* buffer;
+	cc_result res;
+
+	bmp->width = 0; bmp->height = 0;
+	bmp->scan0 = NULL;
+	if (stream->Read == Png_PredecodedRead && Png_TakePredecoded(bmp, stream)) return 0;
+
+	/* Row buffer is far too large to keep on the stack of background decoder threads */
+	buffer = (cc_uint8*)Mem_TryAlloc(PNG_BUFFER_SIZE, 1);
+	if (!buffer) return ERR_OUT_OF_MEMORY;
+
+	res = Png_DecodeCore(bmp, stream, buffer);
+	Mem_Free(buffer);
+	return res;
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Background PNG decoder------------------------------------------------*
+*#########################################################################################################################*/
+#if defined CC_BUILD_LOWMEM
+#define PNG_DECODE_WORKERS 1
+#else
+#define PNG_DECODE_WORKERS 4
+#endif
+
+#define PNG_JOB_PENDING 0
+#define PNG_JOB_BUSY    1
+#define PNG_JOB_DONE    2
+
+struct PngDecodeJob {
+	struct PngDecodeJob* next;
+	int id, state, arg;
+	cc_bool cancelled;
+	PngDecoder_ProcessFunc process;
+	struct PngDecodeResult result;
+};
+/* Decode jobs, in order they were added */
+static struct PngDecodeJob* decodeJobs;
+static int decodeNextID = 1;
+static void* decodeMutex;
+static void* decodeWaitable;
+/* Signalled whenever a worker finishes decoding a job */
+static void* decodeDoneWaitable;
+
+void PngDecodeResult_Free(struct PngDecodeResult* result) {
+	Mem_Free(result->bmp.scan0);
+	Mem_Free(result->data);
+	result->bmp.scan0 = NULL;
+	result->data      = NULL;
+}
+
+static void PngDecoder_Decode(struct PngDecodeJob* job) {
+	struct PngDecodeResult* result = &job->result;
+	struct Stream mem;
+
+	Stream_ReadonlyMemory(&mem, result->data, result->size);
+	result->res       = Png_Decode(&result->bmp, &mem);
+	result->srcWidth  = result->bmp.width;
+	result->srcHeight = result->bmp.height;
+
+	if (!result->res && job->process) 
+		result->res = job->process(&result->bmp, job->arg);
+}
+
+/* Removes the given job from the list of decode jobs, then frees it */
+static void PngDecoder_Remove(struct PngDecodeJob* job, cc_bool freeResult) {
+	struct PngDecodeJob** ptr = &decodeJobs;
+	while (*ptr != job) ptr = &(*ptr)->next;
+	*ptr = job->next;
+
+	if (freeResult) PngDecodeResult_Free(&job->result);
+	Mem_Free(job);
+}
+
+static struct PngDecodeJob* PngDecoder_NextPending(struct PngDecodeJob* job) {
+	while (job && job->state != PNG_JOB_PENDING) job = job->next;
+	return job;
+}
+
+static struct PngDecodeJob* PngDecoder_Find(int id) {
+	struct PngDecodeJob* job;
+	for (job = decodeJobs; job; job = job->next) 
+	{
+		if (job->id == id) return job;
+	}
+	return NULL;
+}
+
+#if !defined CC_BUILD_COOPTHREADED
+static void PngDecoder_WorkerLoop(void) {
+	struct PngDecodeJob* job;
+	cc_bool more;
+
+	for (;;) {
+		Mutex_Lock(decodeMutex);
+		{
+			job  = PngDecoder_NextPending(decodeJobs);
+			if (job) job->state = PNG_JOB_BUSY;
+			more = job && PngDecoder_NextPending(job->next);
+		}
+		Mutex_Unlock(decodeMutex);
+
+		if (!job) { Waitable_Wait(decodeWaitable); continue; }
+		/* Signals from several Adds may have been coalesced, so wake up another worker */
+		if (more) Waitable_Signal(decodeWaitable);
+		PngDecoder_Decode(job);
+
+		Mutex_Lock(decodeMutex);
+		{
+			job->state = PNG_JOB_DONE;
+			/* Cancelled while being decoded, so nothing will retrieve the result */
+			if (job->cancelled) PngDecoder_Remove(job, true);
+		}
+		Mutex_Unlock(decodeMutex);
+		Waitable_Signal(decodeDoneWaitable);
+	}
+}
+
+static void PngDecoder_StartWorkers(void) {
+	void* thread;
+	int i;
+
+	for (i = 0; i < PNG_DECODE_WORKERS; i++) 
+	{
+		thread = Thread_Create(PngDecoder_WorkerLoop);
+		Thread_Start2(thread, PngDecoder_WorkerLoop);
+		Thread_Detach(thread);
+	}
+}
+#else
+/* No background threads, so PNG data is decoded immediately on the main thread */
+static void PngDecoder_StartWorkers(void) { }
+#endif
+
+static void PngDecoder_Init(void) {
+	if (decodeMutex) return;
+
+	decodeMutex        = Mutex_Create();
+	decodeWaitable     = Waitable_Create();
+	decodeDoneWaitable = Waitable_Create();
+	PngDecoder_StartWorkers();
+}
+
+int PngDecoder_Add(const void* data, cc_uint32 size, PngDecoder_ProcessFunc process, int arg) {
+	cc_uint8* copy = (cc_uint8*)Mem_Alloc(size ? size : 1, 1, "PNG decode data");
+	Mem_Copy(copy, data, size);
+	return PngDecoder_AddOwned(copy, size, process, arg);
+}
+
+int PngDecoder_AddOwned(cc_uint8* data, cc_uint32 size, PngDecoder_ProcessFunc process, int arg) {
+	struct PngDecodeJob* job;
+	struct PngDecodeJob** tail;
+	PngDecoder_Init();
+
+	job = (struct PngDecodeJob*)Mem_AllocCleared(1, sizeof(struct PngDecodeJob), "PNG decode job");
+	job->result.data = data;
+	job->result.size = size;
+	job->process     = process;
+	job->arg         = arg;
+
+#if defined CC_BUILD_COOPTHREADED
+	PngDecoder_Decode(job);
+	job->state = PNG_JOB_DONE;
+#endif
+
+	Mutex_Lock(decodeMutex);
+	{
+		job->id = decodeNextID++;
+		for (tail = &decodeJobs; *tail; tail = &(*tail)->next) { }
+		*tail = job;
+	}
+	Mutex_Unlock(decodeMutex);
+
+	Waitable_Signal(decodeWaitable);
+	return job->id;
+}
+
+cc_bool PngDecoder_GetResult(int id, struct PngDecodeResult* result) {
+	struct PngDecodeJob* job;
+	cc_bool done = false;
+	if (!decodeMutex) return false;
+
+	Mutex_Lock(decodeMutex);
+	{
+		job = PngDecoder_Find(id);
+		if (job && job->state == PNG_JOB_DONE) {
+			*result = job->result;
+			PngDecoder_Remove(job, false);
+			done = true;
+		}
+	}
+	Mutex_Unlock(decodeMutex);
+	return done;
+}
+
+cc_bool PngDecoder_WaitResult(int id, struct PngDecodeResult* result) {
+	struct PngDecodeJob* job;
+	cc_bool found;
+	if (!decodeMutex) return false;
+
+	for (;;) {
+		if (PngDecoder_GetResult(id, result)) return true;
+
+		Mutex_Lock(decodeMutex);
+		{
+			job   = PngDecoder_Find(id);
+			found = job != NULL;
+			if (job && job->state == PNG_JOB_PENDING) job->state = PNG_JOB_BUSY;
+			else job = NULL;
+		}
+		Mutex_Unlock(decodeMutex);
+
+		if (!found) return false;
+		/* Still being decoded by a worker */
+		if (!job) { Waitable_Wait(decodeDoneWaitable); continue; }
+
+		/* Decode on this thread rather than waiting for a worker to get to it */
+		PngDecoder_Decode(job);
+		Mutex_Lock(decodeMutex);
+		{
+			job->state = PNG_JOB_DONE;
+		}
+		Mutex_Unlock(decodeMutex);
+	}
+}
+
+void PngDecoder_Cancel(int id) {
+	struct PngDecodeJob* job;
+	if (!decodeMutex) return;
+
+	Mutex_Lock(decodeMutex);
+	{
+		job = PngDecoder_Find(id);
+		if (!job) {
+			/* Job has already finished, or never existed */
+		} else if (job->state == PNG_JOB_BUSY) {
+			job->cancelled = true;
+		} else {
+			PngDecoder_Remove(job, true);
+		}
+	}
+	Mutex_Unlock(decodeMutex);
+}
+
 
 /*########################################################################################################################*
 *------------------------------------------------------PNG encoder--------------------------------------------------------*
@@ -687,6 +1118,8 @@ cc_result Png_Encode(struct Bitmap* bmp, struct Stream* stream,
 	if ((res = Stream_Write(&chunk, tmp, 4))) return res;
 
 	ZLib_MakeStream(&zlStream, &zlState, &chunk); 
+	/* Mostly used for screenshots taken during gameplay, so favour speed over size */
+	Deflate_SetLevel(&zlState.Base, DEFLATE_LEVEL_FAST);
 	lineSize = bmp->width * (alpha ? 4 : 3);
 	Mem_Set(prevLine, 0, lineSize);
 
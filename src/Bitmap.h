@@ -96,6 +96,41 @@ typedef BitmapCol* (*Png_RowGetter)(struct Bitmap* bmp, int row);
      https://github.com/nothings/stb/blob/master/stb_image.h
 */
 CC_API cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream);
+
+/* Result of decoding PNG data on a background thread */
+struct PngDecodeResult {
+	struct Bitmap bmp;        /* Decoded bitmap, after being processed */
+	cc_result res;            /* 0 on success, otherwise error from decoding or processing */
+	int srcWidth, srcHeight;  /* Dimensions of the decoded bitmap before it was processed */
+	cc_uint8* data;           /* Copy of the PNG data that was decoded */
+	cc_uint32 size;           /* Size of the PNG data that was decoded */
+};
+/* Frees the bitmap and PNG data of a decode result */
+void PngDecodeResult_Free(struct PngDecodeResult* result);
+/* Wraps the PNG data of a decode result. Png_Decode on this stream takes the */
+/*  already decoded bitmap from the result, instead of decoding the data again. */
+/* NOTE: Only the most recently made stream can take its bitmap this way. */
+void PngDecodeResult_MakeStream(struct Stream* s, struct PngDecodeResult* result);
+/* Called on the background thread after a bitmap has been successfully decoded. (e.g. to resize it) */
+/* NOTE: Must not access any state that may be modified by the main thread. */
+typedef cc_result (*PngDecoder_ProcessFunc)(struct Bitmap* bmp, int arg);
+
+/* Queues PNG data to be decoded on a background thread, returning the ID of the decode job. */
+/* process is optional, and is called with arg once the bitmap has been decoded. */
+/* NOTE: You don't have to persist data, a copy is made of it. */
+int PngDecoder_Add(const void* data, cc_uint32 size, PngDecoder_ProcessFunc process, int arg);
+/* Same as PngDecoder_Add, but takes ownership of data instead of making a copy of it. */
+/* NOTE: data MUST have been allocated using Mem_Alloc/Mem_TryAlloc. */
+int PngDecoder_AddOwned(cc_uint8* data, cc_uint32 size, PngDecoder_ProcessFunc process, int arg);
+/* Attempts to retrieve the result of the given decode job, returning false if not finished yet. */
+/* NOTE: You MUST call PngDecodeResult_Free once done with the result. */
+cc_bool PngDecoder_GetResult(int id, struct PngDecodeResult* result);
+/* Waits until the given decode job has finished, then retrieves its result. */
+/* Returns false if there is no such decode job. (e.g. it was cancelled) */
+/* NOTE: You MUST call PngDecodeResult_Free once done with the result. */
+cc_bool PngDecoder_WaitResult(int id, struct PngDecodeResult* result);
+/* Cancels the given decode job, discarding its result. */
+void PngDecoder_Cancel(int id);
 /* Encodes a bitmap in PNG format. */
 /* getRow is optional. Can be used to modify how rows are encoded. (e.g. flip image) */
 /* if alpha is non-zero, RGBA channels are saved, otherwise only RGB channels are. */
@@ -22,6 +22,8 @@ struct TickQueue {
 	int count;    /* Number of used elements */
 	int head;     /* Head index into the buffer */
 	int tail;     /* Tail index into the buffer */
+	cc_uint8* pending; /* Bit for each block in the world, set when the block has an entry in the queue */
+	cc_uint32 pendingSize; /* Size of pending in bytes */
 };
 
 static void TickQueue_Init(struct TickQueue* queue) {
@@ -34,11 +36,29 @@ static void TickQueue_Init(struct TickQueue* queue) {
 }
 
 static void TickQueue_Clear(struct TickQueue* queue) {
+	if (queue->pending) Mem_Set(queue->pending, 0, queue->pendingSize);
 	if (!queue->entries) return;
 	Mem_Free(queue->entries);
 	TickQueue_Init(queue);
 }
 
+static void TickQueue_FreePending(struct TickQueue* queue) {
+	Mem_Free(queue->pending);
+	queue->pending     = NULL;
+	queue->pendingSize = 0;
+}
+
+/* Allocates the bit set used to avoid queueing the same block more than once */
+/* NOTE: If this fails, blocks are just queued multiple times like before */
+static void TickQueue_AllocPending(struct TickQueue* queue) {
+	cc_uint32 size = (World.Volume + 7) / 8;
+	TickQueue_FreePending(queue);
+	if (!size) return;
+
+	queue->pending = (cc_uint8*)Mem_TryAllocCleared(size, 1);
+	if (queue->pending) queue->pendingSize = size;
+}
+
 static void TickQueue_Resize(struct TickQueue* queue) {
 	cc_uint32* entries;
 	int i, idx, capacity;
@@ -91,6 +111,7 @@ static RNGState physics_rnd;
 static int physics_tickCount;
 static int physics_maxWaterX, physics_maxWaterY, physics_maxWaterZ;
 static struct TickQueue lavaQ, waterQ;
+static void Physics_FreeTickItems(void);
 
 #define PHYSICS_DELAY_MASK 0xF8000000UL
 #define PHYSICS_POS_MASK   0x07FFFFFFUL
@@ -99,15 +120,51 @@ static struct TickQueue lavaQ, waterQ;
 #define PHYSICS_LAVA_DELAY (30U << PHYSICS_DELAY_SHIFT)
 #define PHYSICS_WATER_DELAY (5U << PHYSICS_DELAY_SHIFT)
 
+/* Queues a tick of the given block after a delay, unless the block is already waiting to be ticked */
+/* (ticking a liquid block twice in a row has no further effect, so duplicate entries would only */
+/*  make the queue grow - with large floods, eventually until "Too many physics entries" occurs) */
+static void TickQueue_Schedule(struct TickQueue* queue, int index, cc_uint32 delay) {
+	cc_uint8 bit = 1 << (index & 7);
+	if (queue->pending) {
+		if (queue->pending[index >> 3] & bit) return;
+		queue->pending[index >> 3] |= bit;
+	}
+	TickQueue_Enqueue(queue, delay | index);
+}
+
+/* Marks the given block as no longer waiting to be ticked */
+static void TickQueue_Unschedule(struct TickQueue* queue, int index) {
+	if (queue->pending) queue->pending[index >> 3] &= ~(1 << (index & 7));
+}
+
+/* Physics only looks at the lower 8 bits of blocks */
+#ifdef CC_BUILD_PALETTEDWORLD
+#define Physics_GetBlock(index) ((BlockRaw)World_GetRawBlock(index))
+#else
+#define Physics_GetBlock(index) World.Blocks[index]
+#endif
+
 static void Physics_OnNewMapLoaded(void* obj) {
+	TickQueue_FreePending(&lavaQ);
+	TickQueue_FreePending(&waterQ);
 	TickQueue_Clear(&lavaQ);
 	TickQueue_Clear(&waterQ);
+	Physics_FreeTickItems();
+
+	if (Physics.Enabled) {
+		TickQueue_AllocPending(&lavaQ);
+		TickQueue_AllocPending(&waterQ);
+	}
 
 	physics_maxWaterX = World.MaxX - 2;
 	physics_maxWaterY = World.MaxY - 2;
 	physics_maxWaterZ = World.MaxZ - 2;
 
+#ifdef CC_BUILD_PALETTEDWORLD
+	Tree_Blocks = NULL;
+#else
 	Tree_Blocks = World.Blocks;
+#endif
 	Random_SeedFromCurrentTime(&physics_rnd);
 	Tree_Rnd = &physics_rnd;
 }
@@ -118,7 +175,7 @@ void Physics_SetEnabled(cc_bool enabled) {
 }
 
 static void Physics_Activate(int index) {
-	BlockID block = World.Blocks[index];
+	BlockID block = Physics_GetBlock(index);
 	PhysicsHandler activate = Physics.OnActivate[block];
 	if (activate) activate(index, block);
 }
@@ -180,17 +237,17 @@ static void Physics_TickRandomBlocks(void) {
 				hi = World_Pack(x2, y2, z2);
 				
 				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
+				block = Physics_GetBlock(index);
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
 
 				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
+				block = Physics_GetBlock(index);
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
 
 				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
+				block = Physics_GetBlock(index);
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
 			}
@@ -207,7 +264,7 @@ static void Physics_DoFalling(int index, BlockID block) {
 	/* Find lowest block can fall into */
 	while (index >= World.OneY) {
 		index -= World.OneY;
-		other  = World.Blocks[index];
+		other  = Physics_GetBlock(index);
 
 		if (other == BLOCK_AIR || (other >= BLOCK_WATER && other <= BLOCK_STILL_LAVA))
 			found = index;
@@ -233,6 +290,8 @@ static cc_bool Physics_CheckItem(struct TickQueue* queue, int* posIndex) {
 		TickQueue_Enqueue(queue, item);
 		return false;
 	}
+
+	TickQueue_Unschedule(queue, *posIndex);
 	return true;
 }
 
@@ -247,7 +306,7 @@ static void Physics_HandleSapling(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 
 	below = BLOCK_AIR;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = Physics_GetBlock(index - World.OneY);
 	if (below != BLOCK_GRASS) return;
 
 	height = 5 + Random_Next(&physics_rnd, 3);
@@ -294,7 +353,7 @@ static void Physics_HandleFlower(int index, BlockID block) {
 	}
 
 	below = BLOCK_DIRT;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = Physics_GetBlock(index - World.OneY);
 	if (!(below == BLOCK_DIRT || below == BLOCK_GRASS)) {
 		Game_UpdateBlock(x, y, z, BLOCK_AIR);
 		Physics_ActivateNeighbours(x, y, z, index);
@@ -313,7 +372,7 @@ static void Physics_HandleMushroom(int index, BlockID block) {
 	}
 
 	below = BLOCK_STONE;
-	if (y > 0) below = World.Blocks[index - World.OneY];
+	if (y > 0) below = Physics_GetBlock(index - World.OneY);
 	if (!(below == BLOCK_STONE || below == BLOCK_COBBLE)) {
 		Game_UpdateBlock(x, y, z, BLOCK_AIR);
 		Physics_ActivateNeighbours(x, y, z, index);
@@ -322,11 +381,11 @@ static void Physics_HandleMushroom(int index, BlockID block) {
 
 
 static void Physics_PlaceLava(int index, BlockID block) {
-	TickQueue_Enqueue(&lavaQ, PHYSICS_LAVA_DELAY | index);
+	TickQueue_Schedule(&lavaQ, index, PHYSICS_LAVA_DELAY);
 }
 
 static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
-	BlockID block = World.Blocks[posIndex];
+	BlockID block = Physics_GetBlock(posIndex);
 
 	if (block >= BLOCK_WATER && block <= BLOCK_STILL_LAVA) {
 		/* Lava spreading into water turns the water solid */
@@ -334,7 +393,7 @@ static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
 			Game_UpdateBlock(x, y, z, BLOCK_STONE);
 		}
 	} else if (Blocks.Collide[block] == COLLIDE_NONE) {
-		TickQueue_Enqueue(&lavaQ, PHYSICS_LAVA_DELAY | posIndex);
+		TickQueue_Schedule(&lavaQ, posIndex, PHYSICS_LAVA_DELAY);
 		Game_UpdateBlock(x, y, z, BLOCK_LAVA);
 	}
 }
@@ -355,7 +414,7 @@ static void Physics_TickLava(void) {
 	for (i = 0; i < count; i++) {
 		int index;
 		if (Physics_CheckItem(&lavaQ, &index)) {
-			BlockID block = World.Blocks[index];
+			BlockID block = Physics_GetBlock(index);
 			if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
 			Physics_ActivateLava(index, block);
 		}
@@ -364,53 +423,303 @@ static void Physics_TickLava(void) {
 
 
 static void Physics_PlaceWater(int index, BlockID block) {
-	TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | index);
+	TickQueue_Schedule(&waterQ, index, PHYSICS_WATER_DELAY);
 }
 
-static void Physics_PropagateWater(int posIndex, int x, int y, int z) {
-	BlockID block = World.Blocks[posIndex];
+/* Whether water is able to flow into a block that it is currently in */
+#define Physics_WaterCanFlowInto(block) (!(block >= BLOCK_WATER && block <= BLOCK_STILL_LAVA) && Blocks.Collide[block] == COLLIDE_NONE)
+
+/* Whether there are any sponges within 2 blocks of the given coordinates */
+/* NOTE: Only reads from the world, so this is safe to call from physics worker threads */
+static cc_bool Physics_NearSponge(int x, int y, int z) {
 	int xx, yy, zz;
 
+	for (yy = (y < 2 ? 0 : y - 2); yy <= (y > physics_maxWaterY ? World.MaxY : y + 2); yy++) {
+		for (zz = (z < 2 ? 0 : z - 2); zz <= (z > physics_maxWaterZ ? World.MaxZ : z + 2); zz++) {
+			for (xx = (x < 2 ? 0 : x - 2); xx <= (x > physics_maxWaterX ? World.MaxX : x + 2); xx++) {
+				if (World_GetBlock(xx, yy, zz) == BLOCK_SPONGE) return true;
+			}
+		}
+	}
+	return false;
+}
+
+/* Results of sponge checks for the neighbours of a water block, which are evaluated ahead of time */
+/*  Bits 0-4 - whether the sponge check was done for that neighbour */
+/*  Bits 8-12 - whether there is a sponge near that neighbour */
+#define SPONGE_CHECKED(n) (1 << (n))
+#define SPONGE_NEARBY(n)  (1 << ((n) + 8))
+
+static void Physics_PropagateWater(int posIndex, int x, int y, int z, int sponges, int n) {
+	BlockID block = Physics_GetBlock(posIndex);
+
 	if (block >= BLOCK_WATER && block <= BLOCK_STILL_LAVA) {
 		/* Water spreading into lava turns the lava solid */
 		if (block == BLOCK_LAVA || block == BLOCK_STILL_LAVA) {
 			Game_UpdateBlock(x, y, z, BLOCK_STONE);
 		}
 	} else if (Blocks.Collide[block] == COLLIDE_NONE) {
-		/* Sponge check */		
-		for (yy = (y < 2 ? 0 : y - 2); yy <= (y > physics_maxWaterY ? World.MaxY : y + 2); yy++) {
-			for (zz = (z < 2 ? 0 : z - 2); zz <= (z > physics_maxWaterZ ? World.MaxZ : z + 2); zz++) {
-				for (xx = (x < 2 ? 0 : x - 2); xx <= (x > physics_maxWaterX ? World.MaxX : x + 2); xx++) {
-					block = World_GetBlock(xx, yy, zz);
-					if (block == BLOCK_SPONGE) return;
-				}
-			}
+		if (sponges & SPONGE_CHECKED(n)) {
+			if (sponges & SPONGE_NEARBY(n)) return;
+		} else if (Physics_NearSponge(x, y, z)) {
+			return;
 		}
 
-		TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | posIndex);
+		TickQueue_Schedule(&waterQ, posIndex, PHYSICS_WATER_DELAY);
 		Game_UpdateBlock(x, y, z, BLOCK_WATER);
 	}
 }
 
-static void Physics_ActivateWater(int index, BlockID block) {
+static void Physics_SpreadWater(int index, int sponges) {
 	int x, y, z;
 	World_Unpack(index, x, y, z);
 
-	if (x > 0)          Physics_PropagateWater(index - 1,           x - 1, y,     z);
-	if (x < World.MaxX) Physics_PropagateWater(index + 1,           x + 1, y,     z);
-	if (z > 0)          Physics_PropagateWater(index - World.Width, x,     y,     z - 1);
-	if (z < World.MaxZ) Physics_PropagateWater(index + World.Width, x,     y,     z + 1);
-	if (y > 0)          Physics_PropagateWater(index - World.OneY,  x,     y - 1, z);
+	if (x > 0)          Physics_PropagateWater(index - 1,           x - 1, y,     z,     sponges, 0);
+	if (x < World.MaxX) Physics_PropagateWater(index + 1,           x + 1, y,     z,     sponges, 1);
+	if (z > 0)          Physics_PropagateWater(index - World.Width, x,     y,     z - 1, sponges, 2);
+	if (z < World.MaxZ) Physics_PropagateWater(index + World.Width, x,     y,     z + 1, sponges, 3);
+	if (y > 0)          Physics_PropagateWater(index - World.OneY,  x,     y - 1, z,     sponges, 4);
+}
+
+static void Physics_ActivateWater(int index, BlockID block) {
+	Physics_SpreadWater(index, 0);
+}
+
+/* Cooperatively threaded platforms can't tick physics in parallel */
+#if !defined CC_BUILD_COOPTHREADED
+/*########################################################################################################################*
+*-----------------------------------------------------Physics threads-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Flooding large maps means ticking many thousands of water blocks every tick, which is mostly spent */
+/*  checking for nearby sponges. Since only water or stone are placed while ticking water, sponges can't */
+/*  change during the tick, so the sponge checks for all the blocks are done ahead of time in parallel. */
+/* Blocks are still changed afterwards on the main thread in the same order as before, so the */
+/*  resulting world is identical regardless of how many threads are used */
+#define MAX_PHYSICS_WORKERS 16
+/* Minimum number of water blocks to tick before it is worth using worker threads */
+#define PHYSICS_PARALLEL_MIN 1024
+/* Number of water blocks that threads take at a time */
+#define PHYSICS_BATCH_SIZE 256
+
+static cc_uint32* tickItems;
+static cc_uint16* tickSponges;
+static int tickItemsCapacity;
+
+static void* workerThreads[MAX_PHYSICS_WORKERS];
+static void* workerWaitables[MAX_PHYSICS_WORKERS];
+static int workersCount, workersStarted, busyWorkers, nextItem, itemsCount;
+static void* workersMutex;
+static void* workersDone;
+static volatile cc_bool workersStop;
+
+/* Caches recent sponge check results, since nearby water blocks often flow into the same blocks */
+#define SPONGE_CACHE_SIZE 1024
+struct SpongeCache {
+	int keys[SPONGE_CACHE_SIZE];
+	cc_bool nearby[SPONGE_CACHE_SIZE];
+};
+
+static cc_bool Physics_CachedNearSponge(struct SpongeCache* cache, int index, int x, int y, int z) {
+	int i = index & (SPONGE_CACHE_SIZE - 1);
+	if (cache->keys[i] == index) return cache->nearby[i];
+
+	cache->keys[i]   = index;
+	cache->nearby[i] = Physics_NearSponge(x, y, z);
+	return cache->nearby[i];
+}
+
+/* Evaluates the sponge checks for the neighbours of a water block */
+static int Physics_CheckSponges(struct SpongeCache* cache, int index) {
+	int x, y, z, sponges = 0;
+	BlockID block;
+	World_Unpack(index, x, y, z);
+
+	block = Physics_GetBlock(index);
+	if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) return 0;
+
+#define Physics_CheckSponge(cond, i, xx, yy, zz, n) \
+	if (cond && Physics_WaterCanFlowInto(Physics_GetBlock(i))) {\
+		sponges |= SPONGE_CHECKED(n);\
+		if (Physics_CachedNearSponge(cache, i, xx, yy, zz)) sponges |= SPONGE_NEARBY(n);\
+	}
+
+	Physics_CheckSponge(x > 0,          index - 1,           x - 1, y,     z,     0);
+	Physics_CheckSponge(x < World.MaxX, index + 1,           x + 1, y,     z,     1);
+	Physics_CheckSponge(z > 0,          index - World.Width, x,     y,     z - 1, 2);
+	Physics_CheckSponge(z < World.MaxZ, index + World.Width, x,     y,     z + 1, 3);
+	Physics_CheckSponge(y > 0,          index - World.OneY,  x,     y - 1, z,     4);
+	return sponges;
+}
+
+/* Checks sponges for batches of water blocks until there are none left, shared between the main thread and worker threads */
+static void Physics_CheckBatches(void) {
+	struct SpongeCache cache;
+	cc_uint32 item;
+	int i, beg, end;
+	Mem_Set(cache.keys, 0xFF, sizeof(cache.keys));
+
+	for (;;) {
+		Mutex_Lock(workersMutex);
+		{
+			beg = nextItem;
+			nextItem += PHYSICS_BATCH_SIZE;
+		}
+		Mutex_Unlock(workersMutex);
+
+		if (beg >= itemsCount) return;
+		end = min(beg + PHYSICS_BATCH_SIZE, itemsCount);
+
+		for (i = beg; i < end; i++) {
+			item = tickItems[i];
+			tickSponges[i] = item >= PHYSICS_ONE_DELAY ? 0 : Physics_CheckSponges(&cache, (int)(item & PHYSICS_POS_MASK));
+		}
+	}
+}
+
+static void PhysicsWorker_Run(void) {
+	int id;
+	Mutex_Lock(workersMutex);
+	{
+		id = workersStarted++;
+	}
+	Mutex_Unlock(workersMutex);
+
+	for (;;) {
+		Waitable_Wait(workerWaitables[id]);
+		if (workersStop) return;
+		Physics_CheckBatches();
+
+		Mutex_Lock(workersMutex);
+		{
+			busyWorkers--;
+		}
+		Mutex_Unlock(workersMutex);
+		Waitable_Signal(workersDone);
+	}
+}
+
+static cc_bool Physics_AllocTickItems(int count) {
+	cc_uint32* items;
+	cc_uint16* sponges;
+	if (count <= tickItemsCapacity) return true;
+
+	items = (cc_uint32*)Mem_TryRealloc(tickItems, count, sizeof(cc_uint32));
+	if (!items) return false;
+	tickItems = items;
+
+	sponges = (cc_uint16*)Mem_TryRealloc(tickSponges, count, sizeof(cc_uint16));
+	if (!sponges) return false;
+	tickSponges = sponges;
+
+	tickItemsCapacity = count;
+	return true;
+}
+
+static void Physics_FreeTickItems(void) {
+	Mem_Free(tickItems);
+	Mem_Free(tickSponges);
+	tickItems   = NULL;
+	tickSponges = NULL;
+	tickItemsCapacity = 0;
+}
+
+/* Ticks water blocks using worker threads to check sponges, returning false if not worth doing so */
+static cc_bool Physics_TickWaterParallel(void) {
+	int i, busy, index, count = waterQ.count;
+	cc_uint32 item;
+	BlockID block;
+
+	if (!workersCount || count < PHYSICS_PARALLEL_MIN) return false;
+	if (!Physics_AllocTickItems(count)) return false;
+
+	for (i = 0; i < count; i++) {
+		tickItems[i] = TickQueue_Dequeue(&waterQ);
+	}
+
+	nextItem    = 0;
+	itemsCount  = count;
+	busyWorkers = workersCount;
+	for (i = 0; i < workersCount; i++) Waitable_Signal(workerWaitables[i]);
+	Physics_CheckBatches();
+
+	for (;;) {
+		Mutex_Lock(workersMutex);
+		{
+			busy = busyWorkers;
+		}
+		Mutex_Unlock(workersMutex);
+
+		if (!busy) break;
+		Waitable_Wait(workersDone);
+	}
+
+	/* Same behaviour as Physics_CheckItem */
+	for (i = 0; i < count; i++) {
+		item = tickItems[i];
+		if (item >= PHYSICS_ONE_DELAY) {
+			TickQueue_Enqueue(&waterQ, item - PHYSICS_ONE_DELAY); continue;
+		}
+
+		index = (int)(item & PHYSICS_POS_MASK);
+		TickQueue_Unschedule(&waterQ, index);
+		block = Physics_GetBlock(index);
+		if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
+		Physics_SpreadWater(index, tickSponges[i]);
+	}
+	return true;
 }
 
+static void StartWorkers(void) {
+	int i, count = Options_GetInt(OPT_PHYSICS_THREADS, 0, MAX_PHYSICS_WORKERS, 2);
+	if (!count) return;
+
+	workersMutex = Mutex_Create();
+	workersDone  = Waitable_Create();
+	workersStop  = false;
+	workersStarted = 0;
+
+	for (i = 0; i < count; i++) {
+		workerWaitables[i] = Waitable_Create();
+		workerThreads[i]   = Thread_Create(PhysicsWorker_Run);
+		Thread_Start2(workerThreads[i], PhysicsWorker_Run);
+	}
+	workersCount = count;
+}
+
+static void StopWorkers(void) {
+	int i;
+	if (!workersCount) return;
+
+	workersStop = true;
+	for (i = 0; i < workersCount; i++) Waitable_Signal(workerWaitables[i]);
+
+	for (i = 0; i < workersCount; i++) {
+		Thread_Join(workerThreads[i]);
+		Waitable_Free(workerWaitables[i]);
+	}
+	workersCount = 0;
+
+	Mutex_Free(workersMutex);
+	Waitable_Free(workersDone);
+}
+#else
+static cc_bool Physics_TickWaterParallel(void) { return false; }
+static void Physics_FreeTickItems(void) { }
+
+static void StartWorkers(void) { }
+static void StopWorkers(void)  { }
+#endif
+
 static void Physics_TickWater(void) {
 	int i, count = waterQ.count;
+	if (Physics_TickWaterParallel()) return;
+
 	for (i = 0; i < count; i++) {
 		int index;
 		if (Physics_CheckItem(&waterQ, &index)) {
-			BlockID block = World.Blocks[index];
+			BlockID block = Physics_GetBlock(index);
 			if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
-			Physics_ActivateWater(index, block);
+			Physics_SpreadWater(index, 0);
 		}
 	}
 }
@@ -445,9 +754,9 @@ static void Physics_DeleteSponge(int index, BlockID block) {
 					if (!World_Contains(xx, yy, zz)) continue;
 
 					index = World_Pack(xx, yy, zz);
-					block = World.Blocks[index];
+					block = Physics_GetBlock(index);
 					if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
-						TickQueue_Enqueue(&waterQ, index | PHYSICS_ONE_DELAY);
+						TickQueue_Schedule(&waterQ, index, PHYSICS_ONE_DELAY);
 					}
 				}
 			}
@@ -461,7 +770,7 @@ static void Physics_HandleSlab(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 	if (index < World.OneY) return;
 
-	if (World.Blocks[index - World.OneY] != BLOCK_SLAB) return;
+	if (Physics_GetBlock(index - World.OneY) != BLOCK_SLAB) return;
 	Game_UpdateBlock(x, y,     z, BLOCK_AIR);
 	Game_UpdateBlock(x, y - 1, z, BLOCK_DOUBLE_SLAB);
 }
@@ -471,7 +780,7 @@ static void Physics_HandleCobblestoneSlab(int index, BlockID block) {
 	World_Unpack(index, x, y, z);
 	if (index < World.OneY) return;
 
-	if (World.Blocks[index - World.OneY] != BLOCK_COBBLE_SLAB) return;
+	if (Physics_GetBlock(index - World.OneY) != BLOCK_COBBLE_SLAB) return;
 	Game_UpdateBlock(x, y,     z, BLOCK_AIR);
 	Game_UpdateBlock(x, y - 1, z, BLOCK_COBBLE);
 }
@@ -504,7 +813,7 @@ static void Physics_HandleTnt(int index, BlockID block) {
 				if (!World_Contains(xx, yy, zz)) continue;
 				index = World_Pack(xx, yy, zz);
 
-				block = World.Blocks[index];
+				block = Physics_GetBlock(index);
 				if (BlocksTNT(block)) continue;
 
 				Game_UpdateBlock(xx, yy, zz, BLOCK_AIR);
@@ -519,6 +828,7 @@ void Physics_Init(void) {
 	Physics.Enabled = Options_GetBool(OPT_BLOCK_PHYSICS, true);
 	TickQueue_Init(&lavaQ);
 	TickQueue_Init(&waterQ);
+	StartWorkers();
 
 	Physics.OnPlace[BLOCK_SAND]        = Physics_DoFalling;
 	Physics.OnPlace[BLOCK_GRAVEL]      = Physics_DoFalling;
@@ -559,10 +869,14 @@ void Physics_Init(void) {
 
 void Physics_Free(void) {
 	Event_Unregister_(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
+	StopWorkers();
+	Physics_FreeTickItems();
+	TickQueue_FreePending(&lavaQ);
+	TickQueue_FreePending(&waterQ);
 }
 
 void Physics_Tick(void) {
-	if (!Physics.Enabled || !World.Blocks) return;
+	if (!Physics.Enabled || !World_HasBlocks()) return;
 
 	/*if ((tickCount % 5) == 0) {*/
 	Physics_TickLava();
@@ -571,3 +885,6 @@ void Physics_Tick(void) {
 	physics_tickCount++;
 	Physics_TickRandomBlocks();
 }
+
+int Physics_QueuedCount(void) { return lavaQ.count + waterQ.count; }
+void Physics_SetSeed(int seed) { Random_Seed(&physics_rnd, seed); }
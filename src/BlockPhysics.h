@@ -26,4 +26,8 @@ void Physics_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now);
 void Physics_Init(void);
 void Physics_Free(void);
 void Physics_Tick(void);
+/* Returns the number of lava and water blocks waiting to be ticked. */
+int Physics_QueuedCount(void);
+/* Reseeds the random number generator used for random block ticks and tree growth. */
+void Physics_SetSeed(int seed);
 #endif
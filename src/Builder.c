@@ -20,23 +20,8 @@ int Builder_SidesLevel, Builder_EdgeLevel;
 /* Packs an index into the 18x18x18 chunk array. Coordinates range from -1 to 16. */
 #define Builder_PackChunk(xx, yy, zz) (((yy) + 1) * EXTCHUNK_SIZE_2 + ((zz) + 1) * EXTCHUNK_SIZE + ((xx) + 1))
 
-static BlockID* Builder_Chunk;
-static cc_uint8* Builder_Counts;
-static int* Builder_BitFlags;
-static int Builder_X, Builder_Y, Builder_Z;
-static BlockID Builder_Block;
-static int Builder_ChunkIndex;
-static cc_bool Builder_FullBright;
-static int Builder_ChunkEndX, Builder_ChunkEndZ;
 static int Builder_Offsets[FACE_COUNT] = { -1,1, -EXTCHUNK_SIZE,EXTCHUNK_SIZE, -EXTCHUNK_SIZE_2,EXTCHUNK_SIZE_2 };
 
-static int (*Builder_StretchXLiquid)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
-static int (*Builder_StretchX)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static int (*Builder_StretchZ)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static void (*Builder_RenderBlock)(int countsIndex, int x, int y, int z);
-static void (*Builder_PrePrepareChunk)(void);
-static void (*Builder_PostPrepareChunk)(void);
-
 /* Contains state for vertices for a portion of a chunk mesh (vertices that are in a 1D atlas) */
 struct Builder1DPart {
 	struct VertexTextured* fVertices[FACE_COUNT];
@@ -44,10 +29,51 @@ struct Builder1DPart {
 	int sCount, sOffset, sAdvance;
 };
 
-/* Part builder data, for both normal and translucent parts.
-The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
-static struct Builder1DPart Builder_Parts[ATLAS1D_MAX_ATLASES * 2];
-static struct VertexTextured* Builder_Vertices;
+/* Contains all the state needed to build the mesh of a single chunk. */
+/* NOTE: Each thread building chunk meshes must use its own context */
+struct BuilderCtx {
+	BlockID* chunk;
+	cc_uint8* counts;
+	int* bitFlags;
+	int x, y, z;
+	BlockID block;
+	int chunkIndex;
+	cc_bool fullBright;
+	int chunkEndX, chunkEndY, chunkEndZ;
+	/* Part builder data, for both normal and translucent parts.
+	The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
+	struct Builder1DPart parts[ATLAS1D_MAX_ATLASES * 2];
+	struct VertexTextured* vertices;
+	struct _DrawerData drawer;
+	RNGState spriteRng;
+	cc_bool allAir;
+	/* Faces of the chunk that can be seen through the chunk from each face */
+	cc_uint8 connected[FACE_COUNT];
+	/* Number of rows each face was merged with along its texture's V axis, minus 1 */
+	/* NOTE: Only used by the greedy mesh builder */
+	cc_uint8 rows[CHUNK_SIZE_3 * FACE_COUNT];
+	cc_bool mergeRows;
+	/* Vertices are written into this buffer when building on a background thread */
+	struct VertexTextured* buffer;
+	int bufferCount;
+	/* State used by the advanced (smooth lighting) mesh builder */
+	struct {
+		Vec3 minBB, maxBB;
+		int initBitFlags, baseOffset;
+		float x1, y1, z1, x2, y2, z2;
+		PackedCol lerp[5], lerpX[5], lerpZ[5], lerpY[5];
+		cc_bool tinted;
+	} adv;
+};
+/* Context used when building chunk meshes on the main thread */
+static struct BuilderCtx mainCtx;
+
+static int (*Builder_StretchXLiquid)(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
+static int (*Builder_StretchX)(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+static int (*Builder_StretchZ)(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+static void (*Builder_RenderBlock)(struct BuilderCtx* ctx, int countsIndex, int x, int y, int z);
+static void (*Builder_PrePrepareChunk)(struct BuilderCtx* ctx);
+static void (*Builder_PostPrepareChunk)(struct BuilderCtx* ctx);
 
 static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	int i, count = part->sCount;
@@ -55,23 +81,23 @@ static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	return count;
 }
 
-static int Builder1DPart_CalcOffsets(struct Builder1DPart* part, int offset) {
+static int Builder1DPart_CalcOffsets(struct BuilderCtx* ctx, struct Builder1DPart* part, int offset) {
 	int i;
 	part->sOffset  = offset;
 	part->sAdvance = part->sCount >> 2;
 
 	offset += part->sCount;
 	for (i = 0; i < FACE_COUNT; i++) {
-		part->fVertices[i] = &Builder_Vertices[offset];
+		part->fVertices[i] = &ctx->vertices[offset];
 		offset += part->fCount[i];
 	}
 	return offset;
 }
 
-static int Builder_TotalVerticesCount(void) {
+static int Builder_TotalVerticesCount(struct BuilderCtx* ctx) {
 	int i, count = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES * 2; i++) {
-		count += Builder1DPart_VerticesCount(&Builder_Parts[i]);
+		count += Builder1DPart_VerticesCount(&ctx->parts[i]);
 	}
 	return count;
 }
@@ -80,28 +106,28 @@ static int Builder_TotalVerticesCount(void) {
 /*########################################################################################################################*
 *----------------------------------------------------Base mesh builder----------------------------------------------------*
 *#########################################################################################################################*/
-static void AddSpriteVertices(BlockID block) {
+static void AddSpriteVertices(struct BuilderCtx* ctx, BlockID block) {
 	int i = Atlas1D_Index(Block_Tex(block, FACE_XMAX));
-	struct Builder1DPart* part = &Builder_Parts[i];
+	struct Builder1DPart* part = &ctx->parts[i];
 	part->sCount += 4 * 4;
 }
 
-static void AddVertices(BlockID block, Face face) {
+static void AddVertices(struct BuilderCtx* ctx, BlockID block, Face face) {
 	int baseOffset = (Blocks.Draw[block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
 	int i = Atlas1D_Index(Block_Tex(block, face));
-	struct Builder1DPart* part = &Builder_Parts[baseOffset + i];
+	struct Builder1DPart* part = &ctx->parts[baseOffset + i];
 	part->fCount[face] += 4;
 }
 
 #ifdef CC_BUILD_GL11
-static void BuildPartVbs(struct ChunkPartInfo* info) {
+static void BuildPartVbs(struct BuilderCtx* ctx, struct ChunkPartInfo* info) {
 	/* Sprites vertices are stored before chunk face sides */
 	int i, count, offset = info->Offset + info->SpriteCount;
 	for (i = 0; i < FACE_COUNT; i++) {
 		count = info->Counts[i];
 
 		if (count) {
-			info->Vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+			info->Vbs[i] = Gfx_CreateVb2(&ctx->vertices[offset], VERTEX_FORMAT_TEXTURED, count);
 			offset += count;
 		} else {
 			info->Vbs[i] = 0;
@@ -111,14 +137,14 @@ static void BuildPartVbs(struct ChunkPartInfo* info) {
 	count  = info->SpriteCount;
 	offset = info->Offset;
 	if (count) {
-		info->Vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+		info->Vbs[i] = Gfx_CreateVb2(&ctx->vertices[offset], VERTEX_FORMAT_TEXTURED, count);
 	} else {
 		info->Vbs[i] = 0;
 	}
 }
 #endif
 
-static void SetPartInfo(struct Builder1DPart* part, int* offset, struct ChunkPartInfo* info, cc_bool* hasParts) {
+static void SetPartInfo(struct BuilderCtx* ctx, struct Builder1DPart* part, int* offset, struct ChunkPartInfo* info, cc_bool* hasParts) {
 	int vCount = Builder1DPart_VerticesCount(part);
 	info->Offset = -1;
 	if (!vCount) return;
@@ -136,12 +162,12 @@ static void SetPartInfo(struct Builder1DPart* part, int* offset, struct ChunkPar
 	info->SpriteCount       = part->sCount;
 
 #ifdef CC_BUILD_GL11
-	BuildPartVbs(info);
+	BuildPartVbs(ctx, info);
 #endif
 }
 
 
-static void PrepareChunk(int x1, int y1, int z1) {
+static void PrepareChunk(struct BuilderCtx* ctx, int x1, int y1, int z1) {
 	int xMax = min(World.Width,  x1 + CHUNK_SIZE);
 	int yMax = min(World.Height, y1 + CHUNK_SIZE);
 	int zMax = min(World.Length, z1 + CHUNK_SIZE);
@@ -150,89 +176,75 @@ static void PrepareChunk(int x1, int y1, int z1) {
 	BlockID b;
 	int x, y, z, xx, yy, zz;
 
-#ifdef OCCLUSION
-	int flags = ComputeOcclusion();
-#endif
-#ifdef DEBUG_OCCLUSION
-	FastColour col = new FastColour(60, 60, 60, 255);
-	if (flags & 1) col.R = 255; /* x */
-	if (flags & 4) col.G = 255; /* y */
-	if (flags & 2) col.B = 255; /* z */
-	map.Sunlight = map.Shadowlight = col;
-	map.SunlightXSide = map.ShadowlightXSide = col;
-	map.SunlightZSide = map.ShadowlightZSide = col;
-	map.SunlightYBottom = map.ShadowlightYBottom = col;
-#endif
-	
 	for (y = y1, yy = 0; y < yMax; y++, yy++) {
 		for (z = z1, zz = 0; z < zMax; z++, zz++) {
 			cIndex = Builder_PackChunk(0, yy, zz);
 
 			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				b = Builder_Chunk[cIndex];
+				b = ctx->chunk[cIndex];
 				if (Blocks.Draw[b] == DRAW_GAS) continue;
 				index = Builder_PackCount(xx, yy, zz);
 
 				/* Sprites can't be stretched, nor can then be they hidden by other blocks. */
 				/* Note sprites are drawn using DrawSprite and not with any of the DrawXFace. */
-				if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(b); continue; }
+				if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(ctx, b); continue; }
 
-				Builder_X = x; Builder_Y = y; Builder_Z = z;
-				Builder_FullBright = Blocks.FullBright[b];
+				ctx->x = x; ctx->y = y; ctx->z = z;
+				ctx->fullBright = Blocks.FullBright[b];
 				tileIdx = b * BLOCK_COUNT;
 				/* All of these function calls are inlined as they can be called tens of millions to hundreds of millions of times. */
 
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(x == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - 1]] & (1 << FACE_XMIN)) != 0)) {
-					Builder_Counts[index] = 0;
+					(x != 0 && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex - 1]] & (1 << FACE_XMIN)) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMIN);
+					ctx->counts[index] = Builder_StretchZ(ctx, index, x, y, z, cIndex, b, FACE_XMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(x == World.MaxX && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != World.MaxX && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + 1]] & (1 << FACE_XMAX)) != 0)) {
-					Builder_Counts[index] = 0;
+					(x != World.MaxX && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex + 1]] & (1 << FACE_XMAX)) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMAX);
+					ctx->counts[index] = Builder_StretchZ(ctx, index, x, y, z, cIndex, b, FACE_XMAX);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(z == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE]] & (1 << FACE_ZMIN)) != 0)) {
-					Builder_Counts[index] = 0;
+					(z != 0 && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex - EXTCHUNK_SIZE]] & (1 << FACE_ZMIN)) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_ZMIN);
+					ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_ZMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(z == World.MaxZ && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != World.MaxZ && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE]] & (1 << FACE_ZMAX)) != 0)) {
-					Builder_Counts[index] = 0;
+					(z != World.MaxZ && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex + EXTCHUNK_SIZE]] & (1 << FACE_ZMAX)) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_ZMAX);
+					ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_ZMAX);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 || y == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE_2]] & (1 << FACE_YMIN)) != 0) {
-					Builder_Counts[index] = 0;
+				if (ctx->counts[index] == 0 || y == 0 ||
+					(Blocks.Hidden[tileIdx + ctx->chunk[cIndex - EXTCHUNK_SIZE_2]] & (1 << FACE_YMIN)) != 0) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMIN);
+					ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_YMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE_2]] & (1 << FACE_YMAX)) != 0) {
-					Builder_Counts[index] = 0;
+				if (ctx->counts[index] == 0 ||
+					(Blocks.Hidden[tileIdx + ctx->chunk[cIndex + EXTCHUNK_SIZE_2]] & (1 << FACE_YMAX)) != 0) {
+					ctx->counts[index] = 0;
 				} else if (b < BLOCK_WATER || b > BLOCK_STILL_LAVA) {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMAX);
+					ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_YMAX);
 				} else {
-					Builder_Counts[index] = Builder_StretchXLiquid(index, x, y, z, cIndex, b);
+					ctx->counts[index] = Builder_StretchXLiquid(ctx, index, x, y, z, cIndex, b);
 				}
 			}
 		}
@@ -251,20 +263,54 @@ for (yy = -1; yy < 17; ++yy) {\
 			block    = get_block;\
 			allAir   = allAir   && Blocks.Draw[block] == DRAW_GAS;\
 			allSolid = allSolid && Blocks.FullOpaque[block];\
-			Builder_Chunk[cIndex] = block;\
+			ctx->chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+#ifdef CC_BUILD_PALETTEDWORLD
+/* Checks whether the chunk and all of its neighbours are in sections that consist of a single block */
+/* If so, whether the chunk is all air or all solid can be determined without reading every block */
+static cc_bool ReadUniformSections(int x1, int y1, int z1, cc_bool* allAir, cc_bool* allSolid) {
+	const struct WorldSection* s;
+	int cx = x1 >> CHUNK_SHIFT, cy = y1 >> CHUNK_SHIFT, cz = z1 >> CHUNK_SHIFT;
+	int x, y, z;
+	BlockID block;
+
+	for (y = cy - 1; y <= cy + 1; y++)
+		for (z = cz - 1; z <= cz + 1; z++)
+			for (x = cx - 1; x <= cx + 1; x++)
+	{
+		s = &World.Sections[World_ChunkPack(x, y, z)];
+		if (s->Data) return false;
+
+		block     = s->Block;
+		*allAir   = *allAir   && Blocks.Draw[block] == DRAW_GAS;
+		*allSolid = *allSolid && Blocks.FullOpaque[block];
+	}
+	return *allAir || *allSolid;
+}
+#endif
+
+static cc_bool ReadChunkData(struct BuilderCtx* ctx, int x1, int y1, int z1, cc_bool* outAllAir) {
+#ifndef CC_BUILD_PALETTEDWORLD
 	BlockRaw* blocks = World.Blocks;
 	BlockRaw* blocks2;
+#endif
 	cc_bool allAir = true, allSolid = true;
 	int index, cIndex;
 	BlockID block;
 	int xx, yy, zz, y;
 
-#ifndef EXTENDED_BLOCKS
+#if defined CC_BUILD_PALETTEDWORLD
+	if (ReadUniformSections(x1, y1, z1, &allAir, &allSolid)) {
+		*outAllAir = allAir;
+		return allSolid;
+	}
+
+	allAir = true; allSolid = true;
+	ReadChunkBody(World_GetBlock(x1 + xx, y, z1 + zz));
+#elif !defined EXTENDED_BLOCKS
 	ReadChunkBody(blocks[index]);
 #else
 	if (World.IDMask <= 0xFF) {
@@ -300,20 +346,24 @@ for (yy = -1; yy < 17; ++yy) {\
 \
 			block  = get_block;\
 			allAir = allAir && Blocks.Draw[block] == DRAW_GAS;\
-			Builder_Chunk[cIndex] = block;\
+			ctx->chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+static cc_bool ReadBorderChunkData(struct BuilderCtx* ctx, int x1, int y1, int z1, cc_bool* outAllAir) {
+#ifndef CC_BUILD_PALETTEDWORLD
 	BlockRaw* blocks = World.Blocks;
 	BlockRaw* blocks2;
+#endif
 	cc_bool allAir = true;
 	int index, cIndex;
 	BlockID block;
 	int xx, yy, zz, x, y, z;
 
-#ifndef EXTENDED_BLOCKS
+#if defined CC_BUILD_PALETTEDWORLD
+	ReadBorderChunkBody(World_GetBlock(x, y, z));
+#elif !defined EXTENDED_BLOCKS
 	ReadBorderChunkBody(blocks[index]);
 #else
 	if (World.IDMask <= 0xFF) {
@@ -328,7 +378,74 @@ static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
 	return false;
 }
 
-static cc_bool BuildChunk(int x1, int y1, int z1, struct ChunkInfo* info) {
+static cc_bool Builder_AllocBuffer(struct BuilderCtx* ctx, int count) {
+	struct VertexTextured* ptr;
+	if (count <= ctx->bufferCount) return true;
+
+	ptr = (struct VertexTextured*)Mem_TryRealloc(ctx->buffer, count, sizeof(struct VertexTextured));
+	if (!ptr) return false;
+
+	ctx->buffer      = ptr;
+	ctx->bufferCount = count;
+	return true;
+}
+
+#define Connectivity_Fill(face, atEdge, offset) \
+if (atEdge) { \
+	faces |= 1 << face; \
+} else if (!filled[i + offset] && !Blocks.FullOpaque[ctx->chunk[cIndex + Builder_Offsets[face]]]) { \
+	filled[i + offset] = true; queue[tail++] = i + offset; \
+}
+
+/* Calculates which faces of the chunk can be seen from each face of the chunk, by flood filling */
+/*  through all the blocks in the chunk which are not fully opaque (e.g. air, glass, water) */
+static void CalcConnectivity(struct BuilderCtx* ctx, int x1, int y1, int z1) {
+	cc_uint8  filled[CHUNK_SIZE_3];
+	cc_uint16 queue[CHUNK_SIZE_3];
+	int maxX = ctx->chunkEndX - x1 - 1;
+	int maxY = ctx->chunkEndY - y1 - 1;
+	int maxZ = ctx->chunkEndZ - z1 - 1;
+	int start, head, tail, faces, face;
+	int i, cIndex, xx, yy, zz;
+
+	Mem_Set(ctx->connected, 0, FACE_COUNT);
+	Mem_Set(filled,         0, CHUNK_SIZE_3);
+
+	for (start = 0; start < CHUNK_SIZE_3; start++) {
+		xx = start & CHUNK_MASK; zz = (start >> 4) & CHUNK_MASK; yy = start >> 8;
+
+		if (filled[start] || xx > maxX || yy > maxY || zz > maxZ) continue;
+		if (Blocks.FullOpaque[ctx->chunk[Builder_PackChunk(xx, yy, zz)]]) continue;
+
+		filled[start] = true;
+		queue[0] = start;
+		head = 0; tail = 1; faces = 0;
+
+		while (head < tail) {
+			i  = queue[head++];
+			xx = i & CHUNK_MASK; zz = (i >> 4) & CHUNK_MASK; yy = i >> 8;
+			cIndex = Builder_PackChunk(xx, yy, zz);
+
+			Connectivity_Fill(FACE_XMIN, xx == 0,    -1);
+			Connectivity_Fill(FACE_XMAX, xx == maxX,  1);
+			Connectivity_Fill(FACE_ZMIN, zz == 0,    -CHUNK_SIZE);
+			Connectivity_Fill(FACE_ZMAX, zz == maxZ,  CHUNK_SIZE);
+			Connectivity_Fill(FACE_YMIN, yy == 0,    -CHUNK_SIZE_2);
+			Connectivity_Fill(FACE_YMAX, yy == maxY,  CHUNK_SIZE_2);
+		}
+
+		/* All the faces this region touches can be seen from each other */
+		for (face = 0; face < FACE_COUNT; face++) {
+			if (faces & (1 << face)) ctx->connected[face] |= faces;
+		}
+	}
+}
+
+/* Builds the mesh of vertices for the chunk whose minimum corner is at the given coordinates */
+/* If info is NULL, vertices are written into ctx->buffer (i.e. for background threads) */
+/* Otherwise, vertices are written directly into the vertex buffer of the given chunk */
+/* Returns number of vertices in the mesh, or -1 if ctx->buffer could not be allocated */
+static int BuildChunk(struct BuilderCtx* ctx, int x1, int y1, int z1, struct ChunkInfo* info) {
 	BlockID chunk[EXTCHUNK_SIZE_3]; 
 	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
 	int bitFlags[EXTCHUNK_SIZE_3];
@@ -338,10 +455,10 @@ static cc_bool BuildChunk(int x1, int y1, int z1, struct ChunkInfo* info) {
 	int cIndex, index;
 	int x, y, z, xx, yy, zz;
 
-	Builder_Chunk  = chunk;
-	Builder_Counts = counts;
-	Builder_BitFlags = bitFlags;
-	Builder_PrePrepareChunk();
+	ctx->chunk  = chunk;
+	ctx->counts = counts;
+	ctx->bitFlags = bitFlags;
+	Builder_PrePrepareChunk(ctx);
 	
 	onBorder = 
 		x1 == 0 || y1 == 0 || z1 == 0   || x1 + CHUNK_SIZE >= World.Width ||
@@ -350,36 +467,44 @@ static cc_bool BuildChunk(int x1, int y1, int z1, struct ChunkInfo* info) {
 	if (onBorder) {
 		/* less optimal case here */
 		Mem_Set(chunk, BLOCK_AIR, EXTCHUNK_SIZE_3 * sizeof(BlockID));
-		allSolid = ReadBorderChunkData(x1, y1, z1, &allAir);
+		allSolid = ReadBorderChunkData(ctx, x1, y1, z1, &allAir);
 	} else {
-		allSolid = ReadChunkData(x1, y1, z1, &allAir);
+		allSolid = ReadChunkData(ctx, x1, y1, z1, &allAir);
 	}
 
-	info->AllAir = allAir;
-	if (allAir || allSolid) return false;
-	Lighting.LightHint(x1 - 1, z1 - 1);
+	ctx->allAir = allAir;
+	if (allAir)   { Mem_Set(ctx->connected, CHUNK_CONNECTED_ALL, FACE_COUNT); return 0; }
+	if (allSolid) { Mem_Set(ctx->connected, 0,                   FACE_COUNT); return 0; }
+	/* Builder_QueueChunk already calculates light hint for background threads */
+	if (info) Lighting.LightHint(x1 - 1, z1 - 1);
 
 	Mem_Set(counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
 	xMax = min(World.Width,  x1 + CHUNK_SIZE);
 	yMax = min(World.Height, y1 + CHUNK_SIZE);
 	zMax = min(World.Length, z1 + CHUNK_SIZE);
 
-	Builder_ChunkEndX = xMax; Builder_ChunkEndZ = zMax;
-	PrepareChunk(x1, y1, z1);
+	ctx->chunkEndX = xMax; ctx->chunkEndY = yMax; ctx->chunkEndZ = zMax;
+	CalcConnectivity(ctx, x1, y1, z1);
+	PrepareChunk(ctx, x1, y1, z1);
 
-	totalVerts = Builder_TotalVerticesCount();
-	if (!totalVerts) return false;
+	totalVerts = Builder_TotalVerticesCount(ctx);
+	if (!totalVerts) return 0;
 
+	if (!info) {
+		if (!Builder_AllocBuffer(ctx, totalVerts + 1)) return -1;
+		ctx->vertices = ctx->buffer;
+	} else {
 #ifndef CC_BUILD_GL11
-	/* add an extra element to fix crashing on some GPUs */
-	Builder_Vertices = (struct VertexTextured*)Gfx_RecreateAndLockVb(&info->Vb,
-													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
+		/* add an extra element to fix crashing on some GPUs */
+		ctx->vertices = (struct VertexTextured*)Gfx_RecreateAndLockVb(&info->Vb,
+														VERTEX_FORMAT_TEXTURED, totalVerts + 1);
 #else
-	/* NOTE: Relies on assumption vb is ignored by GL11 Gfx_LockVb implementation */
-	Builder_Vertices = (struct VertexTextured*)Gfx_LockVb(0, 
-													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
+		/* NOTE: Relies on assumption vb is ignored by GL11 Gfx_LockVb implementation */
+		ctx->vertices = (struct VertexTextured*)Gfx_LockVb(0, 
+														VERTEX_FORMAT_TEXTURED, totalVerts + 1);
 #endif
-	Builder_PostPrepareChunk();
+	}
+	Builder_PostPrepareChunk(ctx);
 	/* now render the chunk */
 
 	for (y = y1, yy = 0; y < yMax; y++, yy++) {
@@ -387,31 +512,29 @@ static cc_bool BuildChunk(int x1, int y1, int z1, struct ChunkInfo* info) {
 			cIndex = Builder_PackChunk(0, yy, zz);
 
 			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				Builder_Block = chunk[cIndex];
-				if (Blocks.Draw[Builder_Block] == DRAW_GAS) continue;
+				ctx->block = chunk[cIndex];
+				if (Blocks.Draw[ctx->block] == DRAW_GAS) continue;
 
 				index = Builder_PackCount(xx, yy, zz);
-				Builder_ChunkIndex = cIndex;
-				Builder_RenderBlock(index, x, y, z);
+				ctx->chunkIndex = cIndex;
+				Builder_RenderBlock(ctx, index, x, y, z);
 			}
 		}
 	}
 
 #ifndef CC_BUILD_GL11
-	Gfx_UnlockVb(info->Vb);
+	if (info) Gfx_UnlockVb(info->Vb);
 #endif
-	return true;
+	return totalVerts;
 }
 
-void Builder_MakeChunk(struct ChunkInfo* info) {
+/* Updates the parts of the given chunk to refer to the mesh just built using the given context */
+static void SetChunkParts(struct BuilderCtx* ctx, struct ChunkInfo* info) {
 	int x = info->CentreX - 8, y = info->CentreY - 8, z = info->CentreZ - 8;
-	cc_bool hasMesh, hasNorm, hasTran;
+	cc_bool hasNorm, hasTran;
 	int partsIndex;
 	int i, j, curIdx, offset;
 
-	hasMesh = BuildChunk(x, y, z, info);
-	if (!hasMesh) return;
-
 	partsIndex = World_ChunkPack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
 	offset  = 0;
 	hasNorm = false;
@@ -421,8 +544,8 @@ void Builder_MakeChunk(struct ChunkInfo* info) {
 		j = i + ATLAS1D_MAX_ATLASES;
 		curIdx = partsIndex + i * World.ChunksCount;
 
-		SetPartInfo(&Builder_Parts[i], &offset, &MapRenderer_PartsNormal[curIdx],      &hasNorm);
-		SetPartInfo(&Builder_Parts[j], &offset, &MapRenderer_PartsTranslucent[curIdx], &hasTran);
+		SetPartInfo(ctx, &ctx->parts[i], &offset, &MapRenderer_PartsNormal[curIdx],      &hasNorm);
+		SetPartInfo(ctx, &ctx->parts[j], &offset, &MapRenderer_PartsTranslucent[curIdx], &hasTran);
 	}
 
 	if (hasNorm) {
@@ -431,40 +554,46 @@ void Builder_MakeChunk(struct ChunkInfo* info) {
 	if (hasTran) {
 		info->TranslucentParts = &MapRenderer_PartsTranslucent[partsIndex];
 	}
+}
 
-#ifdef OCCLUSION
-	if (info.NormalParts != null || info.TranslucentParts != null)
-		info.occlusionFlags = (cc_uint8)ComputeOcclusion();
-#endif
+int Builder_MakeChunk(struct ChunkInfo* info) {
+	int x = info->CentreX - 8, y = info->CentreY - 8, z = info->CentreZ - 8;
+	struct BuilderCtx* ctx = &mainCtx;
+	int totalVerts;
+
+	totalVerts   = BuildChunk(ctx, x, y, z, info);
+	info->AllAir = ctx->allAir;
+	Mem_Copy(info->Connected, ctx->connected, FACE_COUNT);
+	if (totalVerts > 0) SetChunkParts(ctx, info);
+	return totalVerts;
 }
 
-static cc_bool Builder_OccludedLiquid(int chunkIndex) {
+static cc_bool Builder_OccludedLiquid(struct BuilderCtx* ctx, int chunkIndex) {
 	chunkIndex += EXTCHUNK_SIZE_2; /* Checking y above */
 	return
-		Blocks.FullOpaque[Builder_Chunk[chunkIndex]]
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
+		Blocks.FullOpaque[ctx->chunk[chunkIndex]]
+		&& Blocks.Draw[ctx->chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex - 1]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex + 1]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
 }
 
-static void DefaultPrePrepateChunk(void) {
-	Mem_Set(Builder_Parts, 0, sizeof(Builder_Parts));
+static void DefaultPrePrepateChunk(struct BuilderCtx* ctx) {
+	Mem_Set(ctx->parts, 0, sizeof(ctx->parts));
 }
 
-static void DefaultPostStretchChunk(void) {
+static void DefaultPostStretchChunk(struct BuilderCtx* ctx) {
 	int i, j, offset;
 	offset = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES; i++) {
 		j = i + ATLAS1D_MAX_ATLASES;
 
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[i], offset);
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[j], offset);
+		offset = Builder1DPart_CalcOffsets(ctx, &ctx->parts[i], offset);
+		offset = Builder1DPart_CalcOffsets(ctx, &ctx->parts[j], offset);
 	}
 }
 
-static RNGState spriteRng;
-static void Builder_DrawSprite(int x, int y, int z) {
+static void Builder_DrawSprite(struct BuilderCtx* ctx, int x, int y, int z) {
 	struct Builder1DPart* part;
 	struct VertexTextured v;
 	cc_uint8 offsetType;
@@ -483,54 +612,54 @@ static void Builder_DrawSprite(int x, int y, int z) {
 
 #define s_u1 0.0f
 #define s_u2 UV2_Scale
-	loc = Block_Tex(Builder_Block, FACE_XMAX);
+	loc = Block_Tex(ctx->block, FACE_XMAX);
 	v1  = Atlas1D_RowId(loc) * Atlas1D.InvTileSize;
 	v2  = v1 + Atlas1D.InvTileSize * UV2_Scale;
 
-	offsetType = Blocks.SpriteOffset[Builder_Block];
+	offsetType = Blocks.SpriteOffset[ctx->block];
 	if (offsetType >= 6 && offsetType <= 7) {
-		Random_Seed(&spriteRng, (x + 1217 * z) & 0x7fffffff);
-		valX = Random_Range(&spriteRng, -3, 3 + 1) / 16.0f;
-		valY = Random_Range(&spriteRng, 0,  3 + 1) / 16.0f;
-		valZ = Random_Range(&spriteRng, -3, 3 + 1) / 16.0f;
+		Random_Seed(&ctx->spriteRng, (x + 1217 * z) & 0x7fffffff);
+		valX = Random_Range(&ctx->spriteRng, -3, 3 + 1) / 16.0f;
+		valY = Random_Range(&ctx->spriteRng, 0,  3 + 1) / 16.0f;
+		valZ = Random_Range(&ctx->spriteRng, -3, 3 + 1) / 16.0f;
 
 		x1 += valX - 1.7f/16.0f; x2 += valX + 1.7f/16.0f;
 		z1 += valZ - 1.7f/16.0f; z2 += valZ + 1.7f/16.0f;
 		if (offsetType == 7) { y1 -= valY; y2 -= valY; }
 	}
 	
-	bright = Blocks.FullBright[Builder_Block];
-	part   = &Builder_Parts[Atlas1D_Index(loc)];
+	bright = Blocks.FullBright[ctx->block];
+	part   = &ctx->parts[Atlas1D_Index(loc)];
 	v.Col  = bright ? PACKEDCOL_WHITE : Lighting.Color_Sprite_Fast(x, y, z);
-	Block_Tint(v.Col, Builder_Block);
+	Block_Tint(v.Col, ctx->block);
 
 	/* Draw Z axis */
 	index = part->sOffset;
-	v.X = x1; v.Y = y1; v.Z = z1; v.U = s_u2; v.V = v2; Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x2;           v.Z = z2; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x1; v.Y = y1; v.Z = z1; v.U = s_u2; v.V = v2; ctx->vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; ctx->vertices[index + 1] = v;
+	v.X = x2;           v.Z = z2; v.U = s_u1;           ctx->vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; ctx->vertices[index + 3] = v;
 
 	/* Draw Z axis mirrored */
 	index += part->sAdvance;
-	v.X = x2; v.Y = y1; v.Z = z2; v.U = s_u2;           Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x1;           v.Z = z1; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x2; v.Y = y1; v.Z = z2; v.U = s_u2;           ctx->vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; ctx->vertices[index + 1] = v;
+	v.X = x1;           v.Z = z1; v.U = s_u1;           ctx->vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; ctx->vertices[index + 3] = v;
 
 	/* Draw X axis */
 	index += part->sAdvance;
-	v.X = x1; v.Y = y1; v.Z = z2; v.U = s_u2;           Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x2;           v.Z = z1; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x1; v.Y = y1; v.Z = z2; v.U = s_u2;           ctx->vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; ctx->vertices[index + 1] = v;
+	v.X = x2;           v.Z = z1; v.U = s_u1;           ctx->vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; ctx->vertices[index + 3] = v;
 
 	/* Draw X axis mirrored */
 	index += part->sAdvance;
-	v.X = x2; v.Y = y1; v.Z = z1; v.U = s_u2;           Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x1;           v.Z = z2; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x2; v.Y = y1; v.Z = z1; v.U = s_u2;           ctx->vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; ctx->vertices[index + 1] = v;
+	v.X = x1;           v.Z = z2; v.U = s_u1;           ctx->vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; ctx->vertices[index + 3] = v;
 
 	part->sOffset += 4;
 }
@@ -560,72 +689,74 @@ static PackedCol Normal_LightColor(int x, int y, int z, Face face, BlockID block
 	return 0; /* should never happen */
 }
 
-static cc_bool Normal_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
+static cc_bool Normal_CanStretch(struct BuilderCtx* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = ctx->chunk[chunkIndex];
 
-	if (cur != initial || Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
-	if (Builder_FullBright) return true;
+	if (cur != initial || Block_IsFaceHidden(cur, ctx->chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
+	if (ctx->fullBright) return true;
 
-	return Normal_LightColor(Builder_X, Builder_Y, Builder_Z, face, initial) == Normal_LightColor(x, y, z, face, cur);
+	return Normal_LightColor(ctx->x, ctx->y, ctx->z, face, initial) == Normal_LightColor(x, y, z, face, cur);
 }
 
-static int NormalBuilder_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int NormalBuilder_StretchXLiquid(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(ctx, chunkIndex)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int NormalBuilder_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchX(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int NormalBuilder_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchZ(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (z < ctx->chunkEndZ && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static void NormalBuilder_RenderBlock(int index, int x, int y, int z) {	
+/* Draws the visible faces of the current block */
+/* If rows is non-NULL, it contains how many extra rows each face was merged with */
+static void Normal_DrawBlock(struct BuilderCtx* ctx, int index, int x, int y, int z, const cc_uint8* rows) {
 	/* counters */
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
@@ -641,93 +772,97 @@ static void NormalBuilder_RenderBlock(int index, int x, int y, int z) {
 	PackedCol col;
 	int offset;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[ctx->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(ctx, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->counts[index + FACE_XMIN];
+	count_XMax = ctx->counts[index + FACE_XMAX];
+	count_ZMin = ctx->counts[index + FACE_ZMIN];
+	count_ZMax = ctx->counts[index + FACE_ZMAX];
+	count_YMin = ctx->counts[index + FACE_YMIN];
+	count_YMax = ctx->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	fullBright = Blocks.FullBright[Builder_Block];
-	baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	lightFlags = Blocks.LightOffset[Builder_Block];
+	fullBright = Blocks.FullBright[ctx->block];
+	baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	lightFlags = Blocks.LightOffset[ctx->block];
 
-	Drawer.MinBB = Blocks.MinBB[Builder_Block]; Drawer.MinBB.Y = 1.0f - Drawer.MinBB.Y;
-	Drawer.MaxBB = Blocks.MaxBB[Builder_Block]; Drawer.MaxBB.Y = 1.0f - Drawer.MaxBB.Y;
+	ctx->drawer.MinBB = Blocks.MinBB[ctx->block]; ctx->drawer.MinBB.Y = 1.0f - ctx->drawer.MinBB.Y;
+	ctx->drawer.MaxBB = Blocks.MaxBB[ctx->block]; ctx->drawer.MaxBB.Y = 1.0f - ctx->drawer.MaxBB.Y;
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	Drawer.X1 = x + min.X; Drawer.Y1 = y + min.Y; Drawer.Z1 = z + min.Z;
-	Drawer.X2 = x + max.X; Drawer.Y2 = y + max.Y; Drawer.Z2 = z + max.Z;
+	min = Blocks.RenderMinBB[ctx->block]; max = Blocks.RenderMaxBB[ctx->block];
+	ctx->drawer.X1 = x + min.X; ctx->drawer.Y1 = y + min.Y; ctx->drawer.Z1 = z + min.Z;
+	ctx->drawer.X2 = x + max.X; ctx->drawer.Y2 = y + max.Y; ctx->drawer.Z2 = z + max.Z;
 
-	Drawer.Tinted  = Blocks.Tinted[Builder_Block];
-	Drawer.TintCol = Blocks.FogCol[Builder_Block];
+	ctx->drawer.Tinted  = Blocks.Tinted[ctx->block];
+	ctx->drawer.TintCol = Blocks.FogCol[ctx->block];
 
 	if (count_XMin) {
-		loc    = Block_Tex(Builder_Block, FACE_XMIN);
+		loc    = Block_Tex(ctx->block, FACE_XMIN);
 		offset = (lightFlags >> FACE_XMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			x >= offset ? Lighting.Color_XSide_Fast(x - offset, y, z) : Env.SunXSide;
-		Drawer_XMin(count_XMin, col, loc, &part->fVertices[FACE_XMIN]);
+		Drawer_XMinEx(&ctx->drawer, count_XMin, rows ? rows[index + FACE_XMIN] + 1 : 1, col, loc, &part->fVertices[FACE_XMIN]);
 	}
 
 	if (count_XMax) {
-		loc    = Block_Tex(Builder_Block, FACE_XMAX);
+		loc    = Block_Tex(ctx->block, FACE_XMAX);
 		offset = (lightFlags >> FACE_XMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			x <= (World.MaxX - offset) ? Lighting.Color_XSide_Fast(x + offset, y, z) : Env.SunXSide;
-		Drawer_XMax(count_XMax, col, loc, &part->fVertices[FACE_XMAX]);
+		Drawer_XMaxEx(&ctx->drawer, count_XMax, rows ? rows[index + FACE_XMAX] + 1 : 1, col, loc, &part->fVertices[FACE_XMAX]);
 	}
 
 	if (count_ZMin) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMIN);
+		loc    = Block_Tex(ctx->block, FACE_ZMIN);
 		offset = (lightFlags >> FACE_ZMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			z >= offset ? Lighting.Color_ZSide_Fast(x, y, z - offset) : Env.SunZSide;
-		Drawer_ZMin(count_ZMin, col, loc, &part->fVertices[FACE_ZMIN]);
+		Drawer_ZMinEx(&ctx->drawer, count_ZMin, rows ? rows[index + FACE_ZMIN] + 1 : 1, col, loc, &part->fVertices[FACE_ZMIN]);
 	}
 
 	if (count_ZMax) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMAX);
+		loc    = Block_Tex(ctx->block, FACE_ZMAX);
 		offset = (lightFlags >> FACE_ZMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			z <= (World.MaxZ - offset) ? Lighting.Color_ZSide_Fast(x, y, z + offset) : Env.SunZSide;
-		Drawer_ZMax(count_ZMax, col, loc, &part->fVertices[FACE_ZMAX]);
+		Drawer_ZMaxEx(&ctx->drawer, count_ZMax, rows ? rows[index + FACE_ZMAX] + 1 : 1, col, loc, &part->fVertices[FACE_ZMAX]);
 	}
 
 	if (count_YMin) {
-		loc    = Block_Tex(Builder_Block, FACE_YMIN);
+		loc    = Block_Tex(ctx->block, FACE_YMIN);
 		offset = (lightFlags >> FACE_YMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE : Lighting.Color_YMin_Fast(x, y - offset, z);
-		Drawer_YMin(count_YMin, col, loc, &part->fVertices[FACE_YMIN]);
+		Drawer_YMinEx(&ctx->drawer, count_YMin, rows ? rows[index + FACE_YMIN] + 1 : 1, col, loc, &part->fVertices[FACE_YMIN]);
 	}
 
 	if (count_YMax) {
-		loc    = Block_Tex(Builder_Block, FACE_YMAX);
+		loc    = Block_Tex(ctx->block, FACE_YMAX);
 		offset = (lightFlags >> FACE_YMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE : Lighting.Color_YMax_Fast(x, y + offset, z);
-		Drawer_YMax(count_YMax, col, loc, &part->fVertices[FACE_YMAX]);
+		Drawer_YMaxEx(&ctx->drawer, count_YMax, rows ? rows[index + FACE_YMAX] + 1 : 1, col, loc, &part->fVertices[FACE_YMAX]);
 	}
 }
 
+static void NormalBuilder_RenderBlock(struct BuilderCtx* ctx, int index, int x, int y, int z) {
+	Normal_DrawBlock(ctx, index, x, y, z, NULL);
+}
+
 static void Builder_SetDefault(void) {
 	Builder_StretchXLiquid = NULL;
 	Builder_StretchX       = NULL;
@@ -747,15 +882,103 @@ static void NormalBuilder_SetActive(void) {
 }
 
 
+/*########################################################################################################################*
+*--------------------------------------------------Greedy mesh builder----------------------------------------------------*
+*#########################################################################################################################*/
+/* Extends the normal mesh builder to also merge each run of stretched faces with the runs in */
+/*  following rows, so that e.g. a 16x16 area of floor becomes 1 quad instead of 16 quads */
+/* NOTE: This relies on textures also repeating along the V axis, which only happens */
+/*  when each 1D atlas contains just one tile (see Atlas_Update1D in TexturePack.c) */
+cc_bool Builder_GreedyMeshing;
+
+/* Whether faces of the given block can be merged with faces in following rows */
+static cc_bool Greedy_CanMergeRows(BlockID block, Face face) {
+	Vec3 min = Blocks.MinBB[block], max = Blocks.MaxBB[block];
+	if (!(Blocks.CanStretch[block] & (1 << face))) return false;
+
+	/* Faces of partial blocks (e.g. slabs) would have gaps between each row */
+	if (face == FACE_YMIN || face == FACE_YMAX) return min.Z == 0.0f && max.Z == 1.0f;
+	return min.Y == 0.0f && max.Y == 1.0f;
+}
+
+/* Merges the run of count faces starting at the given coordinates with as many following rows as possible */
+/* Returns the number of rows that were merged into the run */
+static int Greedy_MergeRows(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face, int count) {
+	int countStep, chunkStep, rowCountStep, rowChunkStep, maxRows;
+	int dx = 0, dz = 0, rowY = 0, rowZ = 0;
+	int rows, i;
+	if (count == 0 || !ctx->mergeRows || !Greedy_CanMergeRows(block, face)) return 0;
+
+	/* X faces are stretched along Z, all other faces are stretched along X */
+	if (face == FACE_XMIN || face == FACE_XMAX) {
+		countStep = CHUNK_SIZE * FACE_COUNT; chunkStep = EXTCHUNK_SIZE; dz = 1;
+	} else {
+		countStep = FACE_COUNT;              chunkStep = 1;             dx = 1;
+	}
+
+	/* Rows follow along Z for Y faces, and along Y for all other faces */
+	if (face == FACE_YMIN || face == FACE_YMAX) {
+		rowCountStep = CHUNK_SIZE * FACE_COUNT;   rowChunkStep = EXTCHUNK_SIZE;   rowZ = 1;
+		maxRows      = ctx->chunkEndZ - z;
+	} else {
+		rowCountStep = CHUNK_SIZE_2 * FACE_COUNT; rowChunkStep = EXTCHUNK_SIZE_2; rowY = 1;
+		maxRows      = ctx->chunkEndY - y;
+	}
+
+	for (rows = 0; rows + 1 < maxRows; rows++) {
+		countIndex += rowCountStep; chunkIndex += rowChunkStep;
+		y += rowY; z += rowZ;
+
+		for (i = 0; i < count; i++) {
+			if (!ctx->counts[countIndex + i * countStep]) return rows;
+			if (!Normal_CanStretch(ctx, block, chunkIndex + i * chunkStep, x + i * dx, y, z + i * dz, face)) return rows;
+		}
+		for (i = 0; i < count; i++) {
+			ctx->counts[countIndex + i * countStep] = 0;
+		}
+	}
+	return rows;
+}
+
+static int GreedyBuilder_StretchXLiquid(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+	ctx->rows[countIndex] = 0;
+	return NormalBuilder_StretchXLiquid(ctx, countIndex, x, y, z, chunkIndex, block);
+}
+
+static int GreedyBuilder_StretchX(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+	int count = NormalBuilder_StretchX(ctx, countIndex, x, y, z, chunkIndex, block, face);
+	ctx->rows[countIndex] = Greedy_MergeRows(ctx, countIndex, x, y, z, chunkIndex, block, face, count);
+	return count;
+}
+
+static int GreedyBuilder_StretchZ(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+	int count = NormalBuilder_StretchZ(ctx, countIndex, x, y, z, chunkIndex, block, face);
+	ctx->rows[countIndex] = Greedy_MergeRows(ctx, countIndex, x, y, z, chunkIndex, block, face, count);
+	return count;
+}
+
+static void GreedyBuilder_RenderBlock(struct BuilderCtx* ctx, int index, int x, int y, int z) {
+	Normal_DrawBlock(ctx, index, x, y, z, ctx->rows);
+}
+
+static void GreedyBuilder_PrePrepareChunk(struct BuilderCtx* ctx) {
+	DefaultPrePrepateChunk(ctx);
+	ctx->mergeRows = Atlas1D.TilesPerAtlas == 1;
+}
+
+static void GreedyBuilder_SetActive(void) {
+	Builder_SetDefault();
+	Builder_StretchXLiquid  = GreedyBuilder_StretchXLiquid;
+	Builder_StretchX        = GreedyBuilder_StretchX;
+	Builder_StretchZ        = GreedyBuilder_StretchZ;
+	Builder_RenderBlock     = GreedyBuilder_RenderBlock;
+	Builder_PrePrepareChunk = GreedyBuilder_PrePrepareChunk;
+}
+
+
 /*########################################################################################################################*
 *-------------------------------------------------Advanced mesh builder---------------------------------------------------*
 *#########################################################################################################################*/
-static Vec3 adv_minBB, adv_maxBB;
-static int adv_initBitFlags, adv_baseOffset;
-static int* adv_bitFlags;
-static float adv_x1, adv_y1, adv_z1, adv_x2, adv_y2, adv_z2;
-static PackedCol adv_lerp[5], adv_lerpX[5], adv_lerpZ[5], adv_lerpY[5];
-static cc_bool adv_tinted;
 
 enum ADV_MASK {
 	/* z-1 cube points */
@@ -780,7 +1003,7 @@ enum ADV_MASK {
 /* - bit 0 set: Y-1 is in light */
 /* - bit 1 set: Y   is in light */
 /* - bit 2 set: Y+1 is in light */
-static int Adv_Lit(int x, int y, int z, int cIndex) {
+static int Adv_Lit(struct BuilderCtx* ctx, int x, int y, int z, int cIndex) {
 	int flags, offset, lightFlags;
 	BlockID block;
 	if (y < 0 || y >= World.Height) return LIT_M1 | LIT_CC | LIT_P1; /* all faces lit */
@@ -791,7 +1014,7 @@ static int Adv_Lit(int x, int y, int z, int cIndex) {
 	}
 
 	flags = 0;
-	block = Builder_Chunk[cIndex];
+	block = ctx->chunk[cIndex];
 	lightFlags = Blocks.LightOffset[block];
 
 	/* TODO using LIGHT_FLAG_SHADES_FROM_BELOW is wrong here, */
@@ -809,26 +1032,26 @@ static int Adv_Lit(int x, int y, int z, int cIndex) {
 	flags |= Lighting.IsLit_Fast(x, (y + 1) - offset, z) ? LIT_P1 : 0;
 
 	/* If a block is fullbright, it should also look as if that spot is lit */
-	if (Blocks.FullBright[Builder_Chunk[cIndex - 324]]) flags |= LIT_M1;
+	if (Blocks.FullBright[ctx->chunk[cIndex - 324]]) flags |= LIT_M1;
 	if (Blocks.FullBright[block])                       flags |= LIT_CC;
-	if (Blocks.FullBright[Builder_Chunk[cIndex + 324]]) flags |= LIT_P1;
+	if (Blocks.FullBright[ctx->chunk[cIndex + 324]]) flags |= LIT_P1;
 	
 	return flags;
 }
 
-static int Adv_ComputeLightFlags(int x, int y, int z, int cIndex) {
-	if (Builder_FullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
+static int Adv_ComputeLightFlags(struct BuilderCtx* ctx, int x, int y, int z, int cIndex) {
+	if (ctx->fullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
 
 	return
-		Adv_Lit(x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
-		Adv_Lit(x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
-		Adv_Lit(x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
-		Adv_Lit(x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
-		Adv_Lit(x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
-		Adv_Lit(x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
-		Adv_Lit(x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
-		Adv_Lit(x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
-		Adv_Lit(x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
+		Adv_Lit(ctx, x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
+		Adv_Lit(ctx, x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
+		Adv_Lit(ctx, x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
+		Adv_Lit(ctx, x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
+		Adv_Lit(ctx, x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
+		Adv_Lit(ctx, x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
+		Adv_Lit(ctx, x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
+		Adv_Lit(ctx, x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
+		Adv_Lit(ctx, x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
 }
 
 static int adv_masks[FACE_COUNT] = {
@@ -859,384 +1082,384 @@ static int adv_masks[FACE_COUNT] = {
 };
 
 
-static cc_bool Adv_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
-	adv_bitFlags[chunkIndex] = Adv_ComputeLightFlags(x, y, z, chunkIndex);
+static cc_bool Adv_CanStretch(struct BuilderCtx* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = ctx->chunk[chunkIndex];
+	ctx->bitFlags[chunkIndex] = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
 
 	return cur == initial
-		&& !Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)
-		&& (adv_initBitFlags == adv_bitFlags[chunkIndex]
+		&& !Block_IsFaceHidden(cur, ctx->chunk[chunkIndex + Builder_Offsets[face]], face)
+		&& (ctx->adv.initBitFlags == ctx->bitFlags[chunkIndex]
 		/* Check that this face is either fully bright or fully in shadow */
-		&& (adv_initBitFlags == 0 || (adv_initBitFlags & adv_masks[face]) == adv_masks[face]));
+		&& (ctx->adv.initBitFlags == 0 || (ctx->adv.initBitFlags & adv_masks[face]) == adv_masks[face]));
 }
 
-static int Adv_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int Adv_StretchXLiquid(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
+	ctx->adv.initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->adv.initBitFlags;
 
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(ctx, chunkIndex)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int Adv_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchX(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	ctx->adv.initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->adv.initBitFlags;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int Adv_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchZ(struct BuilderCtx* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	ctx->adv.initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->adv.initBitFlags;
 
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (z < ctx->chunkEndZ && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
 
 #define Adv_CountBits(F, a, b, c, d) (((F >> a) & 1) + ((F >> b) & 1) + ((F >> c) & 1) + ((F >> d) & 1))
 
-static void Adv_DrawXMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMIN);
+static void Adv_DrawXMin(struct BuilderCtx* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.Z, u2 = (count - 1) + adv_maxBB.Z * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->adv.minBB.Z, u2 = (count - 1) + ctx->adv.maxBB.Z * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xM1_yP1_zCC, xM1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xM1_yP1_zCC, xM1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->adv.lerpX[aY0_Z0], col1_0 = ctx->fullBright ? white : ctx->adv.lerpX[aY1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->adv.lerpX[aY1_Z1], col0_1 = ctx->fullBright ? white : ctx->adv.lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->adv.tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_XMIN];
-	v.X = adv_x1;
+	v.X = ctx->adv.x1;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.Y = adv_y2; v.Z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.Z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
-		v.Y = adv_y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.Y = ctx->adv.y2; v.Z = ctx->adv.z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.Y = ctx->adv.y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.Z = ctx->adv.z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.Y = ctx->adv.y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.Y = adv_y2; v.Z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		              v.Z = adv_z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.Z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.Y = ctx->adv.y2; v.Z = ctx->adv.z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		              v.Z = ctx->adv.z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
+		v.Y = ctx->adv.y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.Z = ctx->adv.z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
 	}
 	part->fVertices[FACE_XMIN] = vertices;
 }
 
-static void Adv_DrawXMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMAX);
+static void Adv_DrawXMax(struct BuilderCtx* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.Z), u2 = (1 - adv_maxBB.Z) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->adv.minBB.Z), u2 = (1 - ctx->adv.maxBB.Z) * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xP1_yP1_zCC, xP1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xP1_yP1_zCC, xP1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->adv.lerpX[aY0_Z0], col1_0 = ctx->fullBright ? white : ctx->adv.lerpX[aY1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->adv.lerpX[aY1_Z1], col0_1 = ctx->fullBright ? white : ctx->adv.lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->adv.tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_XMAX];
-	v.X = adv_x2;
+	v.X = ctx->adv.x2;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.Y = adv_y2; v.Z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		              v.Z = adv_z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.Z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.Y = ctx->adv.y2; v.Z = ctx->adv.z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		              v.Z = ctx->adv.z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.Y = ctx->adv.y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.Z = ctx->adv.z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
 	} else {
-		v.Y = adv_y2; v.Z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.Z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		v.Y = adv_y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.Y = ctx->adv.y2; v.Z = ctx->adv.z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.Y = ctx->adv.y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.Z = ctx->adv.z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.Y = ctx->adv.y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_XMAX] = vertices;
 }
 
-static void Adv_DrawZMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMIN);
+static void Adv_DrawZMin(struct BuilderCtx* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.X), u2 = (1 - adv_maxBB.X) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->adv.minBB.X), u2 = (1 - ctx->adv.maxBB.X) * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->adv.lerpZ[aX0_Y0], col1_0 = ctx->fullBright ? white : ctx->adv.lerpZ[aX1_Y0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->adv.lerpZ[aX1_Y1], col0_1 = ctx->fullBright ? white : ctx->adv.lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->adv.tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_ZMIN];
-	v.Z = adv_z1;
+	v.Z = ctx->adv.z1;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.X = adv_x2 + (count - 1); v.Y = adv_y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.Y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1); v.Y = ctx->adv.y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.Y = ctx->adv.y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.X = adv_x1;               v.Y = adv_y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
-		                            v.Y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.Y = adv_y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x1;               v.Y = ctx->adv.y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
+		                            v.Y = ctx->adv.y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.Y = ctx->adv.y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_ZMIN] = vertices;
 }
 
-static void Adv_DrawZMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMAX);
+static void Adv_DrawZMax(struct BuilderCtx* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.X, u2 = (count - 1) + adv_maxBB.X * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->adv.minBB.X, u2 = (count - 1) + ctx->adv.maxBB.X * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->adv.lerpZ[aX1_Y1], col1_0 = ctx->fullBright ? white : ctx->adv.lerpZ[aX1_Y0];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->adv.lerpZ[aX0_Y0], col0_1 = ctx->fullBright ? white : ctx->adv.lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->adv.tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_ZMAX];
-	v.Z = adv_z2;
+	v.Z = ctx->adv.z2;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.X = adv_x1;               v.Y = adv_y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
-		                            v.Y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.Y = adv_y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x1;               v.Y = ctx->adv.y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
+		                            v.Y = ctx->adv.y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.Y = ctx->adv.y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.X = adv_x2 + (count - 1); v.Y = adv_y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.Y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1); v.Y = ctx->adv.y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.Y = ctx->adv.y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_ZMAX] = vertices;
 }
 
-static void Adv_DrawYMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMIN);
+static void Adv_DrawYMin(struct BuilderCtx* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.X, u2 = (count - 1) + adv_maxBB.X * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.Z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->adv.minBB.X, u2 = (count - 1) + ctx->adv.maxBB.X * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.minBB.Z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_1 = Builder_FullBright ? white : adv_lerpY[aX0_Z1], col1_1 = Builder_FullBright ? white : adv_lerpY[aX1_Z1];
-	PackedCol col1_0 = Builder_FullBright ? white : adv_lerpY[aX1_Z0], col0_0 = Builder_FullBright ? white : adv_lerpY[aX0_Z0];
+	PackedCol col0_1 = ctx->fullBright ? white : ctx->adv.lerpY[aX0_Z1], col1_1 = ctx->fullBright ? white : ctx->adv.lerpY[aX1_Z1];
+	PackedCol col1_0 = ctx->fullBright ? white : ctx->adv.lerpY[aX1_Z0], col0_0 = ctx->fullBright ? white : ctx->adv.lerpY[aX0_Z0];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->adv.tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_YMIN];
-	v.Y = adv_y1;
+	v.Y = ctx->adv.y1;
 	if (aX0_Z1 + aX1_Z0 > aX0_Z0 + aX1_Z1) {
-		v.X = adv_x2 + (count - 1); v.Z = adv_z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.Z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1); v.Z = ctx->adv.z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.Z = ctx->adv.z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	} else {
-		v.X = adv_x1;               v.Z = adv_z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
-		                            v.Z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.Z = adv_z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x1;               v.Z = ctx->adv.z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
+		                            v.Z = ctx->adv.z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.Z = ctx->adv.z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
 	}
 	part->fVertices[FACE_YMIN] = vertices;
 }
 
-static void Adv_DrawYMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMAX);
+static void Adv_DrawYMax(struct BuilderCtx* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.X, u2 = (count - 1) + adv_maxBB.X * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.Z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->adv.minBB.X, u2 = (count - 1) + ctx->adv.maxBB.X * UV2_Scale;
+	float v1 = vOrigin + ctx->adv.minBB.Z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->adv.maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->adv.baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerp[aX0_Z0], col1_0 = Builder_FullBright ? white : adv_lerp[aX1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerp[aX1_Z1], col0_1 = Builder_FullBright ? white : adv_lerp[aX0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->adv.lerp[aX0_Z0], col1_0 = ctx->fullBright ? white : ctx->adv.lerp[aX1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->adv.lerp[aX1_Z1], col0_1 = ctx->fullBright ? white : ctx->adv.lerp[aX0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->adv.tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_YMAX];
-	v.Y = adv_y2;
+	v.Y = ctx->adv.y2;
 	if (aX0_Z0 + aX1_Z1 > aX0_Z1 + aX1_Z0) {
-		v.X = adv_x2 + (count - 1); v.Z = adv_z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.Z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1); v.Z = ctx->adv.z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.Z = ctx->adv.z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.X = adv_x1;               v.Z = adv_z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
-		                            v.Z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.Z = adv_z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.X = ctx->adv.x1;               v.Z = ctx->adv.z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
+		                            v.Z = ctx->adv.z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.X = ctx->adv.x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.Z = ctx->adv.z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_YMAX] = vertices;
 }
 
-static void Adv_RenderBlock(int index, int x, int y, int z) {
+static void Adv_RenderBlock(struct BuilderCtx* ctx, int index, int x, int y, int z) {
 	Vec3 min, max;
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[ctx->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(ctx, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->counts[index + FACE_XMIN];
+	count_XMax = ctx->counts[index + FACE_XMAX];
+	count_ZMin = ctx->counts[index + FACE_ZMIN];
+	count_ZMax = ctx->counts[index + FACE_ZMAX];
+	count_YMin = ctx->counts[index + FACE_YMIN];
+	count_YMax = ctx->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	Builder_FullBright = Blocks.FullBright[Builder_Block];
-	adv_baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	adv_tinted     = Blocks.Tinted[Builder_Block];
+	ctx->fullBright = Blocks.FullBright[ctx->block];
+	ctx->adv.baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	ctx->adv.tinted     = Blocks.Tinted[ctx->block];
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	adv_x1 = x + min.X; adv_y1 = y + min.Y; adv_z1 = z + min.Z;
-	adv_x2 = x + max.X; adv_y2 = y + max.Y; adv_z2 = z + max.Z;
+	min = Blocks.RenderMinBB[ctx->block]; max = Blocks.RenderMaxBB[ctx->block];
+	ctx->adv.x1 = x + min.X; ctx->adv.y1 = y + min.Y; ctx->adv.z1 = z + min.Z;
+	ctx->adv.x2 = x + max.X; ctx->adv.y2 = y + max.Y; ctx->adv.z2 = z + max.Z;
 
-	adv_minBB = Blocks.MinBB[Builder_Block]; adv_maxBB = Blocks.MaxBB[Builder_Block];
-	adv_minBB.Y = 1.0f - adv_minBB.Y; adv_maxBB.Y = 1.0f - adv_maxBB.Y;
+	ctx->adv.minBB = Blocks.MinBB[ctx->block]; ctx->adv.maxBB = Blocks.MaxBB[ctx->block];
+	ctx->adv.minBB.Y = 1.0f - ctx->adv.minBB.Y; ctx->adv.maxBB.Y = 1.0f - ctx->adv.maxBB.Y;
 
-	if (count_XMin) Adv_DrawXMin(count_XMin);
-	if (count_XMax) Adv_DrawXMax(count_XMax);
-	if (count_ZMin) Adv_DrawZMin(count_ZMin);
-	if (count_ZMax) Adv_DrawZMax(count_ZMax);
-	if (count_YMin) Adv_DrawYMin(count_YMin);
-	if (count_YMax) Adv_DrawYMax(count_YMax);
+	if (count_XMin) Adv_DrawXMin(ctx, count_XMin);
+	if (count_XMax) Adv_DrawXMax(ctx, count_XMax);
+	if (count_ZMin) Adv_DrawZMin(ctx, count_ZMin);
+	if (count_ZMax) Adv_DrawZMax(ctx, count_ZMax);
+	if (count_YMin) Adv_DrawYMin(ctx, count_YMin);
+	if (count_YMax) Adv_DrawYMax(ctx, count_YMax);
 }
 
-static void Adv_PrePrepareChunk(void) {
+static void Adv_PrePrepareChunk(struct BuilderCtx* ctx) {
 	int i;
-	DefaultPrePrepateChunk();
-	adv_bitFlags = Builder_BitFlags;
+	DefaultPrePrepateChunk(ctx);
+	ctx->bitFlags = ctx->bitFlags;
 
 	for (i = 0; i <= 4; i++) {
-		adv_lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
-		adv_lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
-		adv_lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
-		adv_lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
+		ctx->adv.lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
+		ctx->adv.lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
+		ctx->adv.lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
+		ctx->adv.lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
 	}
 }
 
@@ -1250,13 +1473,265 @@ static void AdvBuilder_SetActive(void) {
 }
 
 
+/*########################################################################################################################*
+*--------------------------------------------------Background mesh building-----------------------------------------------*
+*#########################################################################################################################*/
+int Builder_WorkersCount;
+/* Cooperatively threaded platforms can't build meshes in parallel, and low memory platforms can't afford the contexts */
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_LOWMEM
+#define BUILDER_MAX_WORKERS 16
+/* Max number of chunks that can be queued/in progress per worker */
+#define BUILDER_JOBS_PER_WORKER 8
+
+enum BuilderJobState { JOB_FREE, JOB_PENDING, JOB_BUSY, JOB_DONE };
+struct BuilderJob {
+	struct BuilderCtx ctx;
+	struct ChunkInfo* info;
+	int x, y, z;
+	int totalVerts; /* Result of BuildChunk */
+	int state, generation;
+	cc_uint32 sequence; /* Jobs are processed in the order they were queued */
+};
+
+static struct BuilderJob* jobs;
+static int jobsCount, busyJobs, jobsGeneration;
+static cc_uint32 jobsSequence;
+static void* workerThreads[BUILDER_MAX_WORKERS];
+static void* jobsMutex;
+static void* workerWaitable;
+static void* idleWaitable;
+static volatile cc_bool workersStop;
+
+/* Returns the oldest job in the given state, or NULL if no jobs are in that state */
+static struct BuilderJob* FindOldestJob(int state) {
+	struct BuilderJob* oldest = NULL;
+	int i;
+
+	for (i = 0; i < jobsCount; i++) {
+		if (jobs[i].state != state) continue;
+		if (oldest && (cc_int32)(jobs[i].sequence - oldest->sequence) >= 0) continue;
+		oldest = &jobs[i];
+	}
+	return oldest;
+}
+
+static void BuilderWorker_Run(void) {
+	struct BuilderJob* job;
+	cc_bool morePending;
+
+	for (;;) {
+		Mutex_Lock(jobsMutex);
+		{
+			job = workersStop ? NULL : FindOldestJob(JOB_PENDING);
+			if (job) { job->state = JOB_BUSY; busyJobs++; }
+			morePending = job && FindOldestJob(JOB_PENDING) != NULL;
+		}
+		Mutex_Unlock(jobsMutex);
+
+		if (workersStop) {
+			/* Waitable only wakes up one thread, so need to wake up the next worker */
+			Waitable_Signal(workerWaitable); return;
+		}
+		/* Block until the main thread queues more chunks to build */
+		if (!job) { Waitable_Wait(workerWaitable); continue; }
+		if (morePending) Waitable_Signal(workerWaitable);
+
+		job->totalVerts = BuildChunk(&job->ctx, job->x, job->y, job->z, NULL);
+
+		Mutex_Lock(jobsMutex);
+		{
+			/* Builder_CancelChunks was called while this job was being built */
+			job->state = job->generation == jobsGeneration ? JOB_DONE : JOB_FREE;
+			busyJobs--;
+		}
+		Mutex_Unlock(jobsMutex);
+		Waitable_Signal(idleWaitable);
+	}
+}
+
+static void UploadChunk(struct BuilderJob* job) {
+	struct BuilderCtx* ctx  = &job->ctx;
+	struct ChunkInfo* info  = job->info;
+#ifndef CC_BUILD_GL11
+	struct VertexTextured* data;
+#endif
+
+	if (job->totalVerts < 0) {
+		/* Out of memory on background thread, so just try again on main thread */
+		Builder_MakeChunk(info); return;
+	}
+
+	info->AllAir = ctx->allAir;
+	Mem_Copy(info->Connected, ctx->connected, FACE_COUNT);
+	if (!job->totalVerts) return;
+
+#ifndef CC_BUILD_GL11
+	/* add an extra element to fix crashing on some GPUs */
+	data = (struct VertexTextured*)Gfx_RecreateAndLockVb(&info->Vb,
+												VERTEX_FORMAT_TEXTURED, job->totalVerts + 1);
+	Mem_Copy(data, ctx->vertices, job->totalVerts * sizeof(struct VertexTextured));
+	Gfx_UnlockVb(info->Vb);
+#endif
+	SetChunkParts(ctx, info);
+}
+
+cc_bool Builder_QueueChunk(struct ChunkInfo* info) {
+	struct BuilderJob* job;
+	int i;
+	if (!Builder_WorkersCount) return false;
+
+	Mutex_Lock(jobsMutex);
+	{
+		for (i = 0, job = NULL; i < jobsCount; i++) {
+			if (jobs[i].state == JOB_FREE) { job = &jobs[i]; break; }
+		}
+	}
+	Mutex_Unlock(jobsMutex);
+	if (!job) return false;
+
+	/* NOTE: Only the main thread takes free jobs, so job is guaranteed to still be free */
+	job->info = info;
+	job->x    = info->CentreX - 8;
+	job->y    = info->CentreY - 8;
+	job->z    = info->CentreZ - 8;
+	/* Lighting state is only safe to update from the main thread */
+	Lighting.LightHint(job->x - 1, job->z - 1);
+
+	Mutex_Lock(jobsMutex);
+	{
+		job->state      = JOB_PENDING;
+		job->generation = jobsGeneration;
+		job->sequence   = jobsSequence++;
+	}
+	Mutex_Unlock(jobsMutex);
+
+	info->Building = true;
+	Waitable_Signal(workerWaitable);
+	return true;
+}
+
+int Builder_FinishChunks(Builder_ChunkCallback beforeUpload, Builder_ChunkCallback afterUpload) {
+	struct BuilderJob* job;
+	int finished = 0;
+	if (!Builder_WorkersCount) return 0;
+
+	for (;;) {
+		Mutex_Lock(jobsMutex);
+		{
+			job = FindOldestJob(JOB_DONE);
+		}
+		Mutex_Unlock(jobsMutex);
+		if (!job) break;
+
+		job->info->Building = false;
+		beforeUpload(job->info);
+		UploadChunk(job);
+		afterUpload(job->info);
+		finished++;
+
+		Mutex_Lock(jobsMutex);
+		{
+			job->state = JOB_FREE;
+		}
+		Mutex_Unlock(jobsMutex);
+	}
+	return finished;
+}
+
+void Builder_CancelChunks(void) {
+	int i, busy;
+	if (!Builder_WorkersCount) return;
+
+	Mutex_Lock(jobsMutex);
+	{
+		jobsGeneration++;
+		for (i = 0; i < jobsCount; i++) {
+			if (jobs[i].state == JOB_FREE) continue;
+			jobs[i].info->Building = false;
+			/* Busy jobs are freed by the worker thread once it finishes building */
+			if (jobs[i].state != JOB_BUSY) jobs[i].state = JOB_FREE;
+		}
+	}
+	Mutex_Unlock(jobsMutex);
+
+	/* World or lighting state may be about to be freed, so must wait until workers stop using it */
+	for (;;) {
+		Mutex_Lock(jobsMutex);
+		{
+			busy = busyJobs;
+		}
+		Mutex_Unlock(jobsMutex);
+
+		if (!busy) break;
+		Waitable_WaitFor(idleWaitable, 10);
+	}
+}
+
+static void StartWorkers(void) {
+	int i, count = Options_GetInt(OPT_BUILDER_THREADS, 0, BUILDER_MAX_WORKERS, 2);
+	if (!count) return;
+
+	jobsCount = count * BUILDER_JOBS_PER_WORKER;
+	jobs      = (struct BuilderJob*)Mem_TryAllocCleared(jobsCount, sizeof(struct BuilderJob));
+	if (!jobs) { jobsCount = 0; return; }
+
+	jobsMutex      = Mutex_Create();
+	workerWaitable = Waitable_Create();
+	idleWaitable   = Waitable_Create();
+
+	for (i = 0; i < count; i++) {
+		workerThreads[i] = Thread_Create(BuilderWorker_Run);
+		Thread_Start2(workerThreads[i], BuilderWorker_Run);
+	}
+	Builder_WorkersCount = count;
+}
+
+static void StopWorkers(void) {
+	int i;
+	if (!Builder_WorkersCount) return;
+
+	Builder_CancelChunks();
+	workersStop = true;
+	Waitable_Signal(workerWaitable);
+
+	for (i = 0; i < Builder_WorkersCount; i++) {
+		Thread_Join(workerThreads[i]);
+	}
+	Builder_WorkersCount = 0;
+
+	for (i = 0; i < jobsCount; i++) {
+		Mem_Free(jobs[i].ctx.buffer);
+	}
+	Mem_Free(jobs);
+	jobs      = NULL;
+	jobsCount = 0;
+
+	Mutex_Free(jobsMutex);
+	Waitable_Free(workerWaitable);
+	Waitable_Free(idleWaitable);
+}
+#else
+cc_bool Builder_QueueChunk(struct ChunkInfo* info) { return false; }
+int Builder_FinishChunks(Builder_ChunkCallback beforeUpload, Builder_ChunkCallback afterUpload) { return 0; }
+void Builder_CancelChunks(void) { }
+
+static void StartWorkers(void) { }
+static void StopWorkers(void)  { }
+#endif
+
+
 /*########################################################################################################################*
 *---------------------------------------------------Builder interface-----------------------------------------------------*
 *#########################################################################################################################*/
 cc_bool Builder_SmoothLighting;
 void Builder_ApplyActive(void) {
+	/* Don't change the mesh builder while background threads might be using it */
+	Builder_CancelChunks();
+
 	if (Builder_SmoothLighting) {
 		AdvBuilder_SetActive();
+	} else if (Builder_GreedyMeshing) {
+		GreedyBuilder_SetActive();
 	} else {
 		NormalBuilder_SetActive();
 	}
@@ -1271,7 +1746,13 @@ static void OnInit(void) {
 	Builder_Offsets[FACE_YMAX] =  EXTCHUNK_SIZE_2;
 
 	if (!Game_ClassicMode) Builder_SmoothLighting = Options_GetBool(OPT_SMOOTH_LIGHTING, false);
+	Builder_GreedyMeshing = Options_GetBool(OPT_GREEDY_MESHING, false);
 	Builder_ApplyActive();
+	StartWorkers();
+}
+
+static void OnFree(void) {
+	StopWorkers();
 }
 
 static void OnNewMapLoaded(void) {
@@ -1281,7 +1762,7 @@ static void OnNewMapLoaded(void) {
 
 struct IGameComponent Builder_Component = {
 	OnInit, /* Init */
-	NULL, /* Free */
+	OnFree, /* Free */
 	NULL, /* Reset */
 	NULL, /* OnNewMap */
 	OnNewMapLoaded /* OnNewMapLoaded */
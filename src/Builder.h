@@ -6,6 +6,10 @@ Converts a 16x16x16 chunk into a mesh of vertices
   NormalMeshBuilder:
     Implements a simple chunk mesh builder, where each block face is a single colour
     (whatever lighting engine returns as light colour for given block face at given coordinates)
+  GreedyMeshBuilder:
+    Same as NormalMeshBuilder, but also merges faces into rectangles along both texture axes
+  Meshes can also be built by a pool of background threads, with only the final
+    vertex buffer upload being performed on the main thread
 
 Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 */
@@ -16,9 +20,26 @@ extern struct IGameComponent Builder_Component;
 extern int Builder_SidesLevel, Builder_EdgeLevel;
 /* Whether smooth/advanced lighting mesh builder is used. */
 extern cc_bool Builder_SmoothLighting;
+/* Whether greedy mesh builder is used. (when smooth lighting is not used) */
+extern cc_bool Builder_GreedyMeshing;
 
 /* Builds the mesh of vertices for the given chunk. */
-void Builder_MakeChunk(struct ChunkInfo* info);
+/* Returns the number of vertices in the built mesh. */
+int Builder_MakeChunk(struct ChunkInfo* info);
+
+/* Number of background threads that build chunk meshes. (0 if meshes are only built on the main thread) */
+extern int Builder_WorkersCount;
+typedef void (*Builder_ChunkCallback)(struct ChunkInfo* info);
+/* Queues the given chunk to have its mesh built on a background thread. */
+/* NOTE: Returns false if too many chunks are already queued, so try again later. */
+cc_bool Builder_QueueChunk(struct ChunkInfo* info);
+/* Uploads the meshes of chunks that have finished being built on background threads. */
+/* beforeUpload is called just before a chunk's mesh is replaced, afterUpload just after. */
+/* Returns the number of chunks whose meshes were uploaded. */
+int  Builder_FinishChunks(Builder_ChunkCallback beforeUpload, Builder_ChunkCallback afterUpload);
+/* Discards all chunks that are queued or being built on background threads. */
+/* NOTE: Blocks until background threads have finished building their current chunks. */
+void Builder_CancelChunks(void);
 
 void Builder_ApplyActive(void);
 #endif
@@ -18,6 +18,8 @@
 #include "TexturePack.h"
 #include "Options.h"
 #include "Drawer2D.h"
+#include "Screens.h"
+#include "Profiler.h"
  
 static char status[5][STRING_SIZE];
 static char bottom[3][STRING_SIZE];
@@ -500,6 +502,50 @@ static struct ChatCommand ClearDeniedCommand = {
 	}
 };
 
+static void ProfilerCommand_Dump(void) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct DateTime now;
+	cc_result res;
+
+	if (!Profiler.Enabled) {
+		Chat_AddRaw("&e/client profiler: &cProfiler must be shown first."); return;
+	}
+	if (!Utils_EnsureDirectory("traces")) return;
+	DateTime_CurrentLocal(&now);
+
+	String_InitArray(path, pathBuffer);
+	String_Format3(&path, "traces/trace_%p4-%p2-%p2", &now.year, &now.month, &now.day);
+	String_Format3(&path, "-%p2-%p2-%p2.json", &now.hour, &now.minute, &now.second);
+
+	res = Profiler_WriteTrace(&path);
+	if (res) { Logger_SysWarn2(res, "writing trace to", &path); return; }
+	Chat_Add1("&e/client profiler: &fSaved trace as %s", &path);
+}
+
+static void ProfilerCommand_Execute(const cc_string* args, int argsCount) {
+	if (!argsCount) {
+		if (Profiler.Enabled) { ProfilerOverlay_Hide(); } else { ProfilerOverlay_Show(); }
+	} else if (String_CaselessEqualsConst(args, "show")) {
+		ProfilerOverlay_Show();
+	} else if (String_CaselessEqualsConst(args, "hide")) {
+		ProfilerOverlay_Hide();
+	} else if (String_CaselessEqualsConst(args, "dump")) {
+		ProfilerCommand_Dump();
+	} else {
+		Chat_Add1("&e/client profiler: &cUnrecognised argument &f\"%s\"&c.", args);
+	}
+}
+
+static struct ChatCommand ProfilerCommand = {
+	"Profiler", ProfilerCommand_Execute,
+	COMMAND_FLAG_UNSPLIT_ARGS,
+	{
+		"&a/client profiler [show/hide/dump]",
+		"&eShows how long each part of recent frames took to process.",
+		"&bdump: &eSaves recent timings to traces folder in Chrome trace format",
+	}
+};
+
 
 /*########################################################################################################################*
 *-------------------------------------------------------CuboidCommand-----------------------------------------------------*
@@ -510,10 +556,24 @@ static cc_bool cuboid_persist, cuboid_hooked, cuboid_hasMark1;
 static const cc_string cuboid_msg = String_FromConst("&eCuboid: &fPlace or delete a block.");
 static const cc_string yes_string = String_FromConst("yes");
 
+#define CUBOID_BATCH_SIZE 256
+/* Updates a batch of blocks in one go, then informs server connection of each block change */
+static void CuboidCommand_ApplyBatch(const int* indices, const BlockID* blocks, const BlockID* olds, int count) {
+	int i, x, y, z;
+	Game_UpdateBlocks(indices, blocks, count);
+
+	for (i = 0; i < count; i++) {
+		World_Unpack(indices[i], x, y, z);
+		Server.SendBlock(x, y, z, olds[i], blocks[i]);
+	}
+}
+
 static void CuboidCommand_DoCuboid(void) {
+	int indices[CUBOID_BATCH_SIZE];
+	BlockID blocks[CUBOID_BATCH_SIZE], olds[CUBOID_BATCH_SIZE];
 	IVec3 min, max;
 	BlockID toPlace;
-	int x, y, z;
+	int x, y, z, count = 0;
 
 	IVec3_Min(&min, &cuboid_mark1, &cuboid_mark2);
 	IVec3_Max(&max, &cuboid_mark1, &cuboid_mark2);
@@ -526,10 +586,17 @@ static void CuboidCommand_DoCuboid(void) {
 	for (y = min.Y; y <= max.Y; y++) {
 		for (z = min.Z; z <= max.Z; z++) {
 			for (x = min.X; x <= max.X; x++) {
-				Game_ChangeBlock(x, y, z, toPlace);
+				indices[count] = World_Pack(x, y, z);
+				olds[count]    = World_GetBlock(x, y, z);
+				blocks[count]  = toPlace;
+				if (++count < CUBOID_BATCH_SIZE) continue;
+
+				CuboidCommand_ApplyBatch(indices, blocks, olds, count);
+				count = 0;
 			}
 		}
 	}
+	if (count) CuboidCommand_ApplyBatch(indices, blocks, olds, count);
 }
 
 static void CuboidCommand_BlockChanged(void* obj, IVec3 coords, BlockID old, BlockID now) {
@@ -792,6 +859,7 @@ static void OnInit(void) {
 	Commands_Register(&TeleportCommand);
 	Commands_Register(&ClearDeniedCommand);
 	Commands_Register(&BlockEditCommand);
+	Commands_Register(&ProfilerCommand);
 
 #if defined CC_BUILD_MOBILE || defined CC_BUILD_WEB
 	/* Better to not log chat by default on mobile/web, */
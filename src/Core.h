@@ -334,6 +334,32 @@ typedef cc_uint8  cc_bool;
 #endif
 #endif
 
+#ifdef CC_BUILD_BENCH
+	/* Benchmark builds run without a window, GPU, or audio device, */
+	/*  so swap out the platform's backends for headless/software ones */
+	#undef  CC_BUILD_X11
+	#undef  CC_BUILD_XINPUT2
+	#undef  CC_BUILD_WINGUI
+	#undef  CC_BUILD_COCOA
+	#undef  CC_BUILD_CARBON
+	#undef  CC_BUILD_SDL
+	#undef  CC_BUILD_EGL
+	#undef  CC_BUILD_GL
+	#undef  CC_BUILD_GLMODERN
+	#undef  CC_BUILD_GLES
+	#undef  CC_BUILD_D3D9
+	#undef  CC_BUILD_D3D11
+	#undef  CC_BUILD_OPENAL
+	#undef  CC_BUILD_WINMM
+	#undef  CC_BUILD_CURL
+	#undef  CC_BUILD_WININET
+	#define CC_BUILD_HEADLESS
+	#define CC_BUILD_SOFTGPU
+	#define CC_BUILD_HTTPCLIENT
+	#define CC_BUILD_NOMUSIC
+	#define CC_BUILD_NOSOUNDS
+#endif
+
 
 #ifndef CC_BUILD_LOWMEM
 #define EXTENDED_BLOCKS
@@ -151,8 +151,6 @@ enum INFLATE_STATE_ {
 #define Inflate_AlignBits(state) cc_uint32 alignSkip = state->NumBits & 7; Inflate_ConsumeBits(state, alignSkip);
 /* Ensures there are 'bitsCount' bits, or returns if not */
 #define Inflate_EnsureBits(state, bitsCount) while (state->NumBits < bitsCount) { if (!state->AvailIn) return; Inflate_GetByte(state); }
-/* Ensures there are 'bitsCount' bits */
-#define Inflate_UNSAFE_EnsureBits(state, bitsCount) while (state->NumBits < bitsCount) { Inflate_GetByte(state); }
 /* Peeks then consumes given bits */
 #define Inflate_ReadBits(state, bitsCount) Inflate_PeekBits(state, bitsCount); Inflate_ConsumeBits(state, bitsCount);
 /* Sets to given result and sets state to DONE */
@@ -296,44 +294,54 @@ static int Huffman_Decode(struct InflateState* state, struct HuffmanTable* table
 	return -1;
 }
 
+/* Reads 8 bytes as a little endian 64 bit integer */
+/* NOTE: Compilers usually merge this into a single load instruction */
+#define Inflate_ReadU64(p) (\
+	 (cc_uint64)(p)[0]        | ((cc_uint64)(p)[1] <<  8) | ((cc_uint64)(p)[2] << 16) | ((cc_uint64)(p)[3] << 24) |\
+	((cc_uint64)(p)[4] << 32) | ((cc_uint64)(p)[5] << 40) | ((cc_uint64)(p)[6] << 48) | ((cc_uint64)(p)[7] << 56))
+
+/* Tops up a 64 bit buffer to hold 56 to 63 bits, without any branches or per byte loop */
+/* Bytes past the last whole byte consumed are ORed in again by the next refill, which is */
+/*  harmless since they hold exactly the same bits. Requires at least 8 bytes of input. */
+#define Inflate_Refill64(bitBuf, numBits, in) \
+	bitBuf  |= Inflate_ReadU64(in) << numBits;\
+	in      += (63 - numBits) >> 3;\
+	numBits |= 56;
+
 /* Inline the common <= 9 bits case */
-#define Huffman_UNSAFE_Decode(state, table, result) \
+#define Huffman_Decode64(table, result) \
 {\
-	Inflate_UNSAFE_EnsureBits(state, INFLATE_MAX_BITS);\
-	packed = table.Fast[Inflate_PeekBits(state, INFLATE_FAST_BITS)];\
+	packed = table.Fast[bitBuf & ((1 << INFLATE_FAST_BITS) - 1)];\
 	if (packed >= 0) {\
 		consumedBits = packed >> INFLATE_FAST_BITS;\
-		Inflate_ConsumeBits(state, consumedBits);\
 		result = packed & 0x1FF;\
 	} else {\
-		result = Huffman_UNSAFE_Decode_Slow(state, &table);\
+		result = Huffman_Decode64_Slow(&table, (cc_uint32)bitBuf, &consumedBits);\
 	}\
+	bitBuf >>= consumedBits; numBits -= consumedBits;\
 }
 
-static int Huffman_UNSAFE_Decode_Slow(struct InflateState* state, struct HuffmanTable* table) {
+/* Decodes a codeword longer than INFLATE_FAST_BITS. Returns -1 if the codeword is invalid. */
+static int Huffman_Decode64_Slow(struct HuffmanTable* table, cc_uint32 bits, int* consumedBits) {
 	cc_uint32 i, j, codeword;
 	int offset;
 
 	/* Slow, bit by bit lookup. Need to reverse order for huffman. */
-	codeword = Inflate_PeekBits(state,       INFLATE_FAST_BITS);
+	codeword = bits & ((1 << INFLATE_FAST_BITS) - 1);
 	codeword = Huffman_ReverseBits(codeword, INFLATE_FAST_BITS);
 
 	for (i = INFLATE_FAST_BITS + 1, j = INFLATE_FAST_BITS; i < INFLATE_MAX_BITS; i++, j++) {
-		codeword = (codeword << 1) | ((state->Bits >> j) & 1);
+		codeword = (codeword << 1) | ((bits >> j) & 1);
 
 		if (codeword < table->EndCodewords[i]) {
 			offset = table->FirstOffsets[i] + (codeword - table->FirstCodewords[i]);
-			Inflate_ConsumeBits(state, i);
+			*consumedBits = i;
 			return table->Values[offset];
 		}
 	}
 
-	Inflate_Fail(state, INF_ERR_INVALID_CODE);
-	/* Need to exit the fast decode loop */
-	/* TODO: This means a few garbage bytes can get written */
-	/* to the output, but it probably doesn't matter */
-	state->AvailIn = 0;
-	return 0;
+	*consumedBits = 0;
+	return -1;
 }
 
 void Inflate_Init2(struct InflateState* state, struct Stream* source) {
@@ -391,65 +399,114 @@ static const cc_uint8 codelens_order[INFLATE_MAX_CODELENS] = {
 
 static void Inflate_InflateFast(struct InflateState* s) {
 	/* huffman variables */
-	cc_uint32 lit, len, dist;
-	cc_uint32 bits, lenIdx, distIdx;
+	int lit, distIdx;
+	cc_uint32 len, dist, bits, lenIdx;
 	int packed, consumedBits;
 
+	/* bit buffer variables */
+	/* A local 64 bit buffer means one refill covers a whole length + distance pair */
+	/* (at most 15 + 5 + 15 + 13 = 48 bits), or several literals in a row */
+	cc_uint64 bitBuf;
+	cc_uint32 numBits, pushBack;
+	cc_uint8* in;
+	cc_uint8* inStart;
+	cc_uint8* inEnd;
+
 	/* window variables */
 	cc_uint8* window;
-	cc_uint32 i, curIdx, startIdx;
+	cc_uint8* src;
+	cc_uint8* dst;
+	cc_uint32 i, curIdx, startIdx, availOut;
 	cc_uint32 copyStart, copyLen, partLen;
 
 	window = s->Window;
 	curIdx = s->WindowIndex;
 	copyStart = s->WindowIndex;
 	copyLen   = 0;
+	availOut  = s->AvailOut;
+
+	bitBuf  = s->Bits;
+	numBits = s->NumBits;
+	in      = s->NextIn;
+	inStart = s->NextIn;
+	inEnd   = s->NextIn + s->AvailIn;
 
 #define INFLATE_FAST_COPY_MAX (INFLATE_WINDOW_SIZE - INFLATE_FASTINF_OUT)
-	while (s->AvailOut >= INFLATE_FASTINF_OUT && s->AvailIn >= INFLATE_FASTINF_IN && copyLen < INFLATE_FAST_COPY_MAX) {
-		Huffman_UNSAFE_Decode(s, s->Table.Lits, lit);
+	while (availOut >= INFLATE_FASTINF_OUT && copyLen < INFLATE_FAST_COPY_MAX) {
+		if (numBits < 48) {
+			if (inEnd - in < 8) break;
+			Inflate_Refill64(bitBuf, numBits, in);
+		}
+		Huffman_Decode64(s->Table.Lits, lit);
 
-		if (lit <= 256) {
-			if (lit < 256) {
-				window[curIdx] = (cc_uint8)lit;
-				s->AvailOut--; copyLen++;
-				curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+		if (lit < 256) {
+			window[curIdx] = (cc_uint8)lit;
+			availOut--; copyLen++;
+			curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+
+			continue;
+		} else if (lit == 256) {
+			s->State = Inflate_NextBlockState(s);
+			break;
+		} else if (lit < 0) {
+			Inflate_Fail(s, INF_ERR_INVALID_CODE);
+			break;
+		}
+
+		lenIdx = lit - 257;
+		bits = len_bits[lenIdx];
+		len  = len_base[lenIdx] + (cc_uint32)(bitBuf & ((1UL << bits) - 1));
+		bitBuf >>= bits; numBits -= bits;
+
+		Huffman_Decode64(s->TableDists, distIdx);
+		if (distIdx < 0) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; }
+
+		bits = dist_bits[distIdx];
+		dist = dist_base[distIdx] + (cc_uint32)(bitBuf & ((1UL << bits) - 1));
+		bitBuf >>= bits; numBits -= bits;
+
+		/* Window infinitely repeats like ...xyz|uvwxyz|uvwxyz|uvw... */
+		/* If start and end don't cross a boundary, can avoid masking index */
+		startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
+		if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
+			src = &window[startIdx];
+			dst = &window[curIdx];
+
+			if (dist >= len && len >= 32) {
+				/* Source and destination don't overlap */
+				Mem_Copy(dst, src, len);
+			} else if (dist == 1) {
+				/* Run of the same byte, very common in map data */
+				Mem_Set(dst, *src, len);
 			} else {
-				s->State = Inflate_NextBlockState(s);
-				break;
-			}
-		} else {
-			lenIdx = lit - 257;
-			bits = len_bits[lenIdx];
-			Inflate_UNSAFE_EnsureBits(s, bits);
-			len  = len_base[lenIdx] + Inflate_ReadBits(s, bits);
-
-			Huffman_UNSAFE_Decode(s, s->TableDists, distIdx);
-			bits = dist_bits[distIdx];
-			Inflate_UNSAFE_EnsureBits(s, bits);
-			dist = dist_base[distIdx] + Inflate_ReadBits(s, bits);
-	
-			/* Window infinitely repeats like ...xyz|uvwxyz|uvwxyz|uvw... */
-			/* If start and end don't cross a boundary, can avoid masking index */
-			startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
-			if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
-				cc_uint8* src = &window[startIdx]; 
-				cc_uint8* dst = &window[curIdx];
-
-				for (i = 0; i < (len & ~0x3); i += 4) {
-					*dst++ = *src++; *dst++ = *src++; *dst++ = *src++; *dst++ = *src++;
+				for (i = 0; i < (len & ~0x7); i += 8) {
+					dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3];
+					dst[4] = src[4]; dst[5] = src[5]; dst[6] = src[6]; dst[7] = src[7];
+					dst += 8; src += 8;
 				}
 				for (; i < len; i++) { *dst++ = *src++; }
-			} else {
-				for (i = 0; i < len; i++) {
-					window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
-				}
 			}
-			curIdx = (curIdx + len) & INFLATE_WINDOW_MASK;
-			s->AvailOut -= len; copyLen += len;
+		} else {
+			for (i = 0; i < len; i++) {
+				window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
+			}
 		}
+		curIdx = (curIdx + len) & INFLATE_WINDOW_MASK;
+		availOut -= len; copyLen += len;
 	}
 
+	/* Give back any whole bytes that were buffered but not consumed */
+	pushBack = numBits >> 3;
+	if (pushBack > (cc_uint32)(in - inStart)) pushBack = (cc_uint32)(in - inStart);
+	in      -= pushBack;
+	numBits -= pushBack << 3;
+
+	s->Bits     = (cc_uint32)(bitBuf & (((cc_uint64)1 << numBits) - 1));
+	s->NumBits  = numBits;
+	s->NextIn   = in;
+	s->AvailIn  = (cc_uint32)(inEnd - in);
+	s->AvailOut = availOut;
+
 	s->WindowIndex = curIdx;
 	if (!copyLen) return;
 
@@ -784,12 +841,26 @@ static const cc_uint16 deflate_dist[31] = {
 	1025,1537,2049,3073,4097,6145,8193,12289,16385,24577,UInt16_MaxValue
 };
 
+/* Match finder settings for each compression level */
+/* (values are similar to those used by zlib for levels 1, 6 and 9) */
+static const struct DeflateConfig {
+	cc_uint16 maxChain; /* Maximum number of previous matches to look at */
+	cc_uint16 goodLen;  /* Only look at 1/4 as many matches once a match is at least this long */
+	cc_uint16 lazyLen;  /* Check if the next byte has a longer match, when match is shorter than this */
+	cc_uint16 niceLen;  /* Stop looking for a longer match once a match is at least this long */
+	cc_bool insertAll;  /* Whether to insert every byte of a match into the hash chains */
+} deflate_configs[DEFLATE_LEVEL_COUNT] = {
+	{    4,  4,   0,  16, false }, /* DEFLATE_LEVEL_FAST   */
+	{  128,  8,  16, 128, true  }, /* DEFLATE_LEVEL_NORMAL */
+	{ 1024, 32, 258, 258, true  }  /* DEFLATE_LEVEL_BEST   */
+};
+
 /* Pushes given bits, but does not write them */
 #define Deflate_PushBits(state, value, bits) state->Bits |= (value) << state->NumBits; state->NumBits += (bits);
 /* Pushes bits of the huffman codeword bits for the given literal, but does not write them */
 #define Deflate_PushLit(state, value) Deflate_PushBits(state, state->LitsCodewords[value], state->LitsLens[value])
-/* Pushes given bits (reversing for huffman code), but does not write them */
-#define Deflate_PushHuff(state, value, bits) Deflate_PushBits(state, Huffman_ReverseBits(value, bits), bits)
+/* Pushes bits of the huffman codeword bits for the given distance, but does not write them */
+#define Deflate_PushDist(state, value) Deflate_PushBits(state, state->DistsCodewords[value], state->DistsLens[value])
 /* Writes given byte to output */
 #define Deflate_WriteByte(state) *state->NextOut++ = state->Bits; state->AvailOut--; state->Bits >>= 8; state->NumBits -= 8;
 /* Flushes bits in buffer to output buffer */
@@ -797,6 +868,8 @@ static const cc_uint16 deflate_dist[31] = {
 
 #define MIN_MATCH_LEN 3
 #define MAX_MATCH_LEN 258
+/* Symbols with this bit set are a match length, and are followed by the distance */
+#define DEFLATE_SYMBOL_MATCH 0x100
 
 /* Number of bytes that match (are the same) from a and b */
 static int Deflate_MatchLen(cc_uint8* a, cc_uint8* b, int maxLen) {
@@ -807,29 +880,43 @@ static int Deflate_MatchLen(cc_uint8* a, cc_uint8* b, int maxLen) {
 
 /* Hashes 3 bytes of data */
 static cc_uint32 Deflate_Hash(cc_uint8* src) {
-	return (cc_uint32)((src[0] << 8) ^ (src[1] << 4) ^ (src[2])) & DEFLATE_HASH_MASK;
+	cc_uint32 key = src[0] | (src[1] << 8) | ((cc_uint32)src[2] << 16);
+	return (cc_uint32)(key * 2654435761U) >> (32 - DEFLATE_HASH_BITS);
 }
 
-/* Writes a literal to state->Output */
-static void Deflate_Lit(struct DeflateState* state, int lit) {
-	Deflate_PushLit(state, lit);
-	Deflate_FlushBits(state);
-}
+/* Index of the length code for each (length - 3) */
+static cc_uint8 deflate_lenCodes[256];
+/* Index of the distance code for (distance - 1) below 256, then for ((distance - 1) >> 7) */
+static cc_uint8 deflate_distCodes[512];
+static cc_bool deflate_codesInited;
 
-/* Writes a length-distance pair to state->Output */
-static void Deflate_LenDist(struct DeflateState* state, int len, int dist) {
-	int j;
-	/* TODO: Do we actually need the if (len_bits[j]) ????????? does writing 0 bits matter??? */
+static void Deflate_InitCodes(void) {
+	int i, j;
+	for (i = 0, j = 0; i < 256; i++) {
+		if (i + MIN_MATCH_LEN >= deflate_len[j + 1]) j++;
+		deflate_lenCodes[i] = j;
+	}
 
-	for (j = 0; len >= deflate_len[j + 1]; j++);
-	Deflate_PushLit(state, j + 257);
-	if (len_bits[j]) { Deflate_PushBits(state, len - deflate_len[j], len_bits[j]); }
-	Deflate_FlushBits(state);
+	for (i = 0, j = 0; i < 256; i++) {
+		if (i + 1 >= deflate_dist[j + 1]) j++;
+		deflate_distCodes[i] = j;
+	}
+	for (i = 2, j = 0; i < 256; i++) {
+		for (j = 0; (i << 7) + 1 >= deflate_dist[j + 1]; j++);
+		deflate_distCodes[256 + i] = j;
+	}
+	deflate_codesInited = true;
+}
 
-	for (j = 0; dist >= deflate_dist[j + 1]; j++);
-	Deflate_PushHuff(state, j, 5);
-	if (dist_bits[j]) { Deflate_PushBits(state, dist - deflate_dist[j], dist_bits[j]); }
-	Deflate_FlushBits(state);
+#define Deflate_LenCode(len)   deflate_lenCodes[(len) - MIN_MATCH_LEN]
+#define Deflate_DistCode(dist) ((dist) <= 256 ? deflate_distCodes[(dist) - 1] : deflate_distCodes[256 + (((dist) - 1) >> 7)])
+
+/* Writes any pending output data to the destination stream */
+static cc_result Deflate_FlushOutput(struct DeflateState* state) {
+	cc_result res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
+	state->NextOut  = state->Output;
+	state->AvailOut = DEFLATE_OUT_SIZE;
+	return res;
 }
 
 /* Moves "current block" to "previous block", adjusting state if needed. */
@@ -847,20 +934,45 @@ static void Deflate_MoveBlock(struct DeflateState* state) {
 	}
 }
 
-/* Compresses current block of data */
-static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
-	cc_uint32 hash, nextHash;
-	int bestLen, maxLen, matchLen, depth;
-	int bestPos, pos, nextPos;
-	cc_uint16 oldHead;
+/* Inserts the given position into the hash chains */
+#define Deflate_Insert(state, input, pos, hash) \
+	hash = Deflate_Hash(&input[pos]);\
+	state->Prev[pos]  = state->Head[hash];\
+	state->Head[hash] = pos;
+
+/* Finds the longest match for the data at 'cur' */
+static int Deflate_LongestMatch(struct DeflateState* state, int pos, cc_uint8* cur, int maxLen, int bestLen, int* bestPos) {
+	const struct DeflateConfig* cfg = &deflate_configs[state->Level];
+	cc_uint8* input = state->Input;
+	int depth, maxDepth, matchLen;
+	if (bestLen >= maxLen) return bestLen;
+
+	maxDepth = cfg->maxChain;
+	if (bestLen >= cfg->goodLen) maxDepth >>= 2;
+
+	for (depth = 0; pos != 0 && depth < maxDepth; depth++) {
+		/* Quickly skip matches which can't possibly be longer */
+		if (input[pos + bestLen] == cur[bestLen]) {
+			matchLen = Deflate_MatchLen(&input[pos], cur, maxLen);
+			if (matchLen > bestLen) {
+				bestLen = matchLen; *bestPos = pos;
+				if (bestLen >= cfg->niceLen || bestLen >= maxLen) break;
+			}
+		}
+		pos = state->Prev[pos];
+	}
+	return bestLen;
+}
+
+/* Converts the current block of data into a list of literals and length/distance pairs */
+static int Deflate_FindMatches(struct DeflateState* state, int len) {
+	const struct DeflateConfig* cfg = &deflate_configs[state->Level];
+	cc_uint16* symbols = state->Symbols;
+	int bestLen, maxLen, bestPos, nextPos;
+	cc_uint32 hash;
+	int i, pos, count = 0;
 	cc_uint8* input;
 	cc_uint8* cur;
-	cc_result res;
-
-	if (!state->WroteHeader) {
-		state->WroteHeader = true;
-		Deflate_PushBits(state, 3, 3); /* final block TRUE, block type FIXED */
-	}
 
 	/* Based off descriptions from http://www.gzip.org/algorithm.txt and
 	https://github.com/nothings/stb/blob/master/stb_image_write.h */
@@ -870,67 +982,353 @@ static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
 	/* Compress current block of data */
 	/* Use > instead of >=, because also try match at one byte after current */
 	while (len > MIN_MATCH_LEN) {
-		hash   = Deflate_Hash(cur);
-		maxLen = min(len, MAX_MATCH_LEN);
-
-		bestLen = MIN_MATCH_LEN - 1; /* Match must be at least 3 bytes */
+		maxLen  = min(len, MAX_MATCH_LEN);
 		bestPos = 0;
+		pos     = (int)(cur - input);
 
 		/* Find longest match starting at this byte */
-		/* Only explore up to 5 previous matches, to avoid slow performance */
-		/* (i.e prefer quickly saving maps/screenshots to completely optimal filesize) */
-		pos = state->Head[hash];
-		for (depth = 0; pos != 0 && depth < 5; depth++) {
-			matchLen = Deflate_MatchLen(&input[pos], cur, maxLen);
-			if (matchLen > bestLen) { bestLen = matchLen; bestPos = pos; }
-			pos = state->Prev[pos];
-		}
+		/* Match must be at least 3 bytes */
+		hash    = Deflate_Hash(cur);
+		bestLen = Deflate_LongestMatch(state, state->Head[hash], cur, maxLen, MIN_MATCH_LEN - 1, &bestPos);
 
 		/* Insert this entry into the hash chain */
-		pos = (int)(cur - input);
-		oldHead = state->Head[hash];
+		state->Prev[pos]  = state->Head[hash];
 		state->Head[hash] = pos;
-		state->Prev[pos]  = oldHead;
 
 		/* Lazy evaluation: Find longest match starting at next byte */
 		/* If that's longer than the longest match at current byte, throwaway this match */
-		if (bestPos) {
-			nextHash = Deflate_Hash(cur + 1);
-			nextPos  = state->Head[nextHash];
-			maxLen   = min(len - 1, MAX_MATCH_LEN);
-
-			for (depth = 0; nextPos != 0 && depth < 5; depth++) {
-				matchLen = Deflate_MatchLen(&input[nextPos], cur + 1, maxLen);
-				if (matchLen > bestLen) { bestPos = 0; break; }
-				nextPos = state->Prev[nextPos];
-			}
+		if (bestPos && bestLen < cfg->lazyLen) {
+			nextPos = 0;
+			Deflate_LongestMatch(state, state->Head[Deflate_Hash(cur + 1)], cur + 1,
+								min(len - 1, MAX_MATCH_LEN), bestLen, &nextPos);
+			if (nextPos) bestPos = 0;
 		}
 
 		if (bestPos) {
-			Deflate_LenDist(state, bestLen, pos - bestPos);
+			symbols[count++] = DEFLATE_SYMBOL_MATCH | (bestLen - MIN_MATCH_LEN);
+			symbols[count++] = pos - bestPos;
+
+			/* Remaining bytes of the match are only inserted when going for better compression */
+			if (cfg->insertAll) {
+				for (i = 1; i < bestLen && i < len - (MIN_MATCH_LEN - 1); i++) {
+					Deflate_Insert(state, input, pos + i, hash);
+				}
+			}
 			len -= bestLen; cur += bestLen;
 		} else {
-			Deflate_Lit(state, *cur);
+			symbols[count++] = *cur;
 			len--; cur++;
 		}
-
-		/* leave room for a few bytes and literals at end */
-		if (state->AvailOut >= 20) continue;
-		res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
-		state->NextOut  = state->Output;
-		state->AvailOut = DEFLATE_OUT_SIZE;
-		if (res) return res;
 	}
 
 	/* literals for last few bytes */
 	while (len > 0) {
-		Deflate_Lit(state, *cur);
+		symbols[count++] = *cur;
 		len--; cur++;
 	}
+	return count;
+}
 
-	res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
-	state->NextOut  = state->Output;
-	state->AvailOut = DEFLATE_OUT_SIZE;
+
+/*########################################################################################################################*
+*-------------------------------------------------Deflate huffman encoding------------------------------------------------*
+*#########################################################################################################################*/
+struct DeflateSymFreq { int key, value; };
+
+/* Computes optimal huffman code lengths for the given frequencies, limited to maxBits */
+/* Based off the in-place algorithm by Moffat and Katajainen, as used in miniz */
+static void Deflate_CalcLengths(const int* freqs, int count, int maxBits, cc_uint8* lens) {
+	struct DeflateSymFreq syms[INFLATE_MAX_LITS], tmp;
+	int numCodes[32];
+	int root, leaf, next, avbl, used, depth;
+	int i, j, n = 0;
+	cc_uint32 total;
+
+	for (i = 0; i < count; i++) {
+		lens[i] = 0;
+		if (!freqs[i]) continue;
+		syms[n].key = freqs[i]; syms[n].value = i; n++;
+	}
+	/* Some decoders don't accept a code with only one codeword */
+	for (i = 0; n < 2 && i < count; i++) {
+		if (freqs[i]) continue;
+		syms[n].key = 1; syms[n].value = i; n++;
+	}
+
+	/* Sort by ascending frequency */
+	for (i = 1; i < n; i++) {
+		tmp = syms[i];
+		for (j = i; j > 0 && syms[j - 1].key > tmp.key; j--) { syms[j] = syms[j - 1]; }
+		syms[j] = tmp;
+	}
+
+	/* Compute parent pointers, then depths of internal nodes, then depths of leaves */
+	syms[0].key += syms[1].key;
+	root = 0; leaf = 2;
+	for (next = 1; next < n - 1; next++) {
+		if (leaf >= n || syms[root].key < syms[leaf].key) {
+			syms[next].key = syms[root].key; syms[root++].key = next;
+		} else {
+			syms[next].key = syms[leaf++].key;
+		}
+
+		if (leaf >= n || (root < next && syms[root].key < syms[leaf].key)) {
+			syms[next].key += syms[root].key; syms[root++].key = next;
+		} else {
+			syms[next].key += syms[leaf++].key;
+		}
+	}
+
+	syms[n - 2].key = 0;
+	for (next = n - 3; next >= 0; next--) { syms[next].key = syms[syms[next].key].key + 1; }
+
+	avbl = 1; used = depth = 0; root = n - 2; next = n - 1;
+	while (avbl > 0) {
+		while (root >= 0 && syms[root].key == depth) { used++; root--; }
+		while (avbl > used) { syms[next--].key = depth; avbl--; }
+		avbl = 2 * used; depth++; used = 0;
+	}
+
+	/* Limit code lengths to maxBits, by moving codes down the tree until it is complete again */
+	for (i = 0; i < Array_Elems(numCodes); i++) numCodes[i] = 0;
+	for (i = 0; i < n; i++) { numCodes[min(syms[i].key, 31)]++; }
+
+	for (i = maxBits + 1; i < Array_Elems(numCodes); i++) numCodes[maxBits] += numCodes[i];
+	for (i = maxBits, total = 0; i > 0; i--) total += (cc_uint32)numCodes[i] << (maxBits - i);
+
+	while (total != (1UL << maxBits)) {
+		numCodes[maxBits]--;
+		for (i = maxBits - 1; i > 0; i--) {
+			if (!numCodes[i]) continue;
+			numCodes[i]--; numCodes[i + 1] += 2; break;
+		}
+		total--;
+	}
+
+	/* Rarest values get the longest codes */
+	for (i = maxBits, j = 0; i > 0; i--) {
+		for (next = numCodes[i]; next > 0; next--) { lens[syms[j++].value] = i; }
+	}
+}
+
+/* Constructs a huffman encoding table (for values to codewords) */
+static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
+	int i, j, offset, codeword;
+	struct HuffmanTable table;
+
+	/* NOTE: Can ignore since lens table is always valid */
+	(void)Huffman_Build(&table, lens, count);
+	for (i = 0; i < INFLATE_MAX_BITS; i++) {
+		if (!table.EndCodewords[i]) continue;
+		count = table.EndCodewords[i] - table.FirstCodewords[i];
+
+		for (j = 0; j < count; j++) {
+			offset   = table.Values[table.FirstOffsets[i] + j];
+			codeword = table.FirstCodewords[i] + j;
+			bitlens[offset]   = i;
+			codewords[offset] = Huffman_ReverseBits(codeword, i);
+		}
+	}
+}
+
+/* Run length encodes the code lengths of the literal and distance codes */
+/* Each output entry is a code length symbol, and the value of its extra bits */
+static int Deflate_EncodeLengths(const cc_uint8* lens, int count, cc_uint8* syms, cc_uint8* extra) {
+	int i = 0, n = 0, run, cur, part;
+
+	while (i < count) {
+		cur = lens[i];
+		for (run = 1; i + run < count && lens[i + run] == cur; run++) { }
+		i += run;
+
+		if (cur == 0) {
+			for (; run >= 11; run -= part) {
+				part = min(run, 138);
+				syms[n] = 18; extra[n++] = part - 11;
+			}
+			if (run >= 3) {
+				syms[n] = 17; extra[n++] = run - 3; run = 0;
+			}
+		} else {
+			syms[n] = cur; extra[n++] = 0; run--;
+			for (; run >= 3; run -= part) {
+				part = min(run, 6);
+				syms[n] = 16; extra[n++] = part - 3;
+			}
+		}
+
+		for (; run > 0; run--) { syms[n] = cur; extra[n++] = 0; }
+	}
+	return n;
+}
+
+/* Number of bits used to encode the symbols with the given code lengths */
+static cc_uint32 Deflate_CodesSize(const int* freqs, const cc_uint8* lens, int count) {
+	cc_uint32 size = 0;
+	int i;
+	for (i = 0; i < count; i++) { size += freqs[i] * lens[i]; }
+	return size;
+}
+
+static const cc_uint8 codelens_bits[INFLATE_MAX_CODELENS] = { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,2,3,7 };
+
+/* Writes a block with no compression at all */
+static cc_result Deflate_WriteStored(struct DeflateState* state, const cc_uint8* data, int len) {
+	int part;
+	cc_result res;
+
+	/* Stored blocks start on a byte boundary */
+	if (state->NumBits & 7) { Deflate_PushBits(state, 0, 8 - (state->NumBits & 7)); }
+	Deflate_FlushBits(state);
+	Deflate_PushBits(state, len & 0xFFFF, 16);  Deflate_FlushBits(state);
+	Deflate_PushBits(state, ~len & 0xFFFF, 16); Deflate_FlushBits(state);
+
+	while (len) {
+		if (!state->AvailOut && (res = Deflate_FlushOutput(state))) return res;
+		part = min(len, (int)state->AvailOut);
+
+		Mem_Copy(state->NextOut, data, part);
+		state->NextOut  += part; state->AvailOut -= part;
+		data += part; len -= part;
+	}
+	return 0;
+}
+
+/* Writes the huffman encoded literals and length/distance pairs */
+static cc_result Deflate_WriteSymbols(struct DeflateState* state, int count) {
+	cc_uint16* symbols = state->Symbols;
+	int i, j, sym, len, dist;
+	cc_result res;
+
+	for (i = 0; i < count; i++) {
+		sym = symbols[i];
+
+		if (sym & DEFLATE_SYMBOL_MATCH) {
+			len  = (sym & 0xFF) + MIN_MATCH_LEN;
+			dist = symbols[++i];
+
+			j = Deflate_LenCode(len);
+			Deflate_PushLit(state, j + 257);
+			if (len_bits[j]) { Deflate_PushBits(state, len - deflate_len[j], len_bits[j]); }
+			Deflate_FlushBits(state);
+
+			j = Deflate_DistCode(dist);
+			Deflate_PushDist(state, j);
+			Deflate_FlushBits(state);
+			if (dist_bits[j]) { Deflate_PushBits(state, dist - deflate_dist[j], dist_bits[j]); }
+		} else {
+			Deflate_PushLit(state, sym);
+		}
+		Deflate_FlushBits(state);
+
+		/* leave room for a few bytes and literals at end */
+		if (state->AvailOut >= 20) continue;
+		if ((res = Deflate_FlushOutput(state))) return res;
+	}
+
+	/* Write huffman encoded "literal 256" to terminate symbols */
+	Deflate_PushLit(state, 256);
+	Deflate_FlushBits(state);
+	return 0;
+}
+
+/* Writes the current block, using whichever of stored, fixed or dynamic huffman encoding is smallest */
+static cc_result Deflate_WriteBlock(struct DeflateState* state, const cc_uint8* data, int len, int count, cc_bool final) {
+	int litFreqs[INFLATE_MAX_LITS], distFreqs[INFLATE_MAX_DISTS], lenFreqs[INFLATE_MAX_CODELENS];
+	cc_uint8 lens[INFLATE_MAX_LITS_DISTS], lenLens[INFLATE_MAX_CODELENS];
+	cc_uint8 rleSyms[INFLATE_MAX_LITS_DISTS], rleExtra[INFLATE_MAX_LITS_DISTS];
+	cc_uint32 extraSize, fixedSize, dynamicSize, storedSize;
+	int i, j, dist, numLits, numDists, numLens, numRle;
+	cc_uint16 lenCodewords[INFLATE_MAX_CODELENS];
+	cc_uint8 lenBitlens[INFLATE_MAX_CODELENS];
+	cc_uint16* symbols = state->Symbols;
+	cc_result res;
+
+	Mem_Set(litFreqs,  0, sizeof(litFreqs));
+	Mem_Set(distFreqs, 0, sizeof(distFreqs));
+	Mem_Set(lenFreqs,  0, sizeof(lenFreqs));
+	litFreqs[256] = 1;
+	extraSize     = 0;
+
+	for (i = 0; i < count; i++) {
+		if (!(symbols[i] & DEFLATE_SYMBOL_MATCH)) { litFreqs[symbols[i]]++; continue; }
+
+		j = deflate_lenCodes[symbols[i] & 0xFF];
+		litFreqs[j + 257]++; extraSize += len_bits[j];
+		dist = symbols[++i];
+		j = Deflate_DistCode(dist);
+		distFreqs[j]++;      extraSize += dist_bits[j];
+	}
+
+	/* Work out how large the block would be with each type of encoding */
+	fixedSize  = 3 + extraSize + Deflate_CodesSize(litFreqs, fixed_lits, 286) + Deflate_CodesSize(distFreqs, fixed_dists, 30);
+	storedSize = 3 + 7 + 32 + len * 8;
+
+	Deflate_CalcLengths(litFreqs,  286, 15, lens);
+	Deflate_CalcLengths(distFreqs, 30,  15, lens + 286);
+	dynamicSize = 3 + extraSize + Deflate_CodesSize(litFreqs, lens, 286) + Deflate_CodesSize(distFreqs, lens + 286, 30);
+
+	for (numLits  = 286; numLits  > 257 && !lens[numLits - 1];        numLits--)  { }
+	for (numDists = 30;  numDists > 1   && !lens[286 + numDists - 1]; numDists--) { }
+	/* Ranges may overlap, but destination is always before source so copying forwards is safe */
+	for (i = 0; i < numDists; i++) { lens[numLits + i] = lens[286 + i]; }
+
+	numRle = Deflate_EncodeLengths(lens, numLits + numDists, rleSyms, rleExtra);
+	for (i = 0; i < numRle; i++) { lenFreqs[rleSyms[i]]++; }
+	Deflate_CalcLengths(lenFreqs, INFLATE_MAX_CODELENS, 7, lenLens);
+
+	for (numLens = INFLATE_MAX_CODELENS; numLens > 4 && !lenLens[codelens_order[numLens - 1]]; numLens--) { }
+	dynamicSize += 5 + 5 + 4 + numLens * 3;
+	for (i = 0; i < numRle; i++) { dynamicSize += lenLens[rleSyms[i]] + codelens_bits[rleSyms[i]]; }
+
+	if (storedSize <= fixedSize && storedSize <= dynamicSize) {
+		Deflate_PushBits(state, final, 3); /* block type STORED */
+		return Deflate_WriteStored(state, data, len);
+	}
+
+	if (fixedSize <= dynamicSize) {
+		Deflate_PushBits(state, final | (1 << 1), 3); /* block type FIXED */
+		Deflate_BuildTable(fixed_lits,  INFLATE_MAX_LITS,  state->LitsCodewords,  state->LitsLens);
+		Deflate_BuildTable(fixed_dists, INFLATE_MAX_DISTS, state->DistsCodewords, state->DistsLens);
+		return Deflate_WriteSymbols(state, count);
+	}
+
+	Deflate_PushBits(state, final | (2 << 1), 3); /* block type DYNAMIC */
+	Deflate_PushBits(state, numLits  - 257, 5);
+	Deflate_PushBits(state, numDists - 1,   5);
+	Deflate_PushBits(state, numLens  - 4,   4);
+	Deflate_FlushBits(state);
+
+	for (i = 0; i < numLens; i++) {
+		Deflate_PushBits(state, lenLens[codelens_order[i]], 3);
+		Deflate_FlushBits(state);
+	}
+	if ((res = Deflate_FlushOutput(state))) return res;
+
+	Deflate_BuildTable(lenLens, INFLATE_MAX_CODELENS, lenCodewords, lenBitlens);
+	for (i = 0; i < numRle; i++) {
+		j = rleSyms[i];
+		Deflate_PushBits(state, lenCodewords[j], lenBitlens[j]);
+		if (codelens_bits[j]) { Deflate_PushBits(state, rleExtra[i], codelens_bits[j]); }
+		Deflate_FlushBits(state);
+
+		if (state->AvailOut >= 20) continue;
+		if ((res = Deflate_FlushOutput(state))) return res;
+	}
+
+	Deflate_BuildTable(lens,           numLits,  state->LitsCodewords,  state->LitsLens);
+	Deflate_BuildTable(lens + numLits, numDists, state->DistsCodewords, state->DistsLens);
+	return Deflate_WriteSymbols(state, count);
+}
+
+/* Compresses current block of data */
+static cc_result Deflate_FlushBlock(struct DeflateState* state, int len, cc_bool final) {
+	cc_result res;
+	int count = Deflate_FindMatches(state, len);
+
+	res = Deflate_WriteBlock(state, state->Input + DEFLATE_BLOCK_SIZE, len, count, final);
+	if (res) return res;
+	res = Deflate_FlushOutput(state);
 
 	Deflate_MoveBlock(state);
 	return res;
@@ -958,26 +1356,22 @@ static cc_result Deflate_StreamWrite(struct Stream* stream, const cc_uint8* data
 		data += len;
 
 		if (state->InputPosition == DEFLATE_BUFFER_SIZE) {
-			res = Deflate_FlushBlock(state, DEFLATE_BLOCK_SIZE);
+			res = Deflate_FlushBlock(state, DEFLATE_BLOCK_SIZE, false);
 			if (res) return res;
 		}
 	}
 	return 0;
 }
 
-/* Flushes any buffered data, then writes terminating symbol */
+/* Flushes any buffered data as the final block */
 static cc_result Deflate_StreamClose(struct Stream* stream) {
 	struct DeflateState* state;
 	cc_result res;
 
 	state = (struct DeflateState*)stream->Meta.Inflate;
-	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE);
+	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE, true);
 	if (res) return res;
 
-	/* Write huffman encoded "literal 256" to terminate symbols */
-	Deflate_PushLit(state, 256);
-	Deflate_FlushBits(state);
-
 	/* In case last byte still has a few extra bits */
 	if (state->NumBits) {
 		while (state->NumBits < 8) { Deflate_PushBits(state, 0, 1); }
@@ -987,26 +1381,6 @@ static cc_result Deflate_StreamClose(struct Stream* stream) {
 	return Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
 }
 
-/* Constructs a huffman encoding table (for values to codewords) */
-static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
-	int i, j, offset, codeword;
-	struct HuffmanTable table;
-
-	/* NOTE: Can ignore since lens table is not user controlled */
-	(void)Huffman_Build(&table, lens, count);
-	for (i = 0; i < INFLATE_MAX_BITS; i++) {
-		if (!table.EndCodewords[i]) continue;
-		count = table.EndCodewords[i] - table.FirstCodewords[i];
-
-		for (j = 0; j < count; j++) {
-			offset   = table.Values[table.FirstOffsets[i] + j];
-			codeword = table.FirstCodewords[i] + j;
-			bitlens[offset]   = i;
-			codewords[offset] = Huffman_ReverseBits(codeword, i);
-		}
-	}
-}
-
 void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying) {
 	Stream_Init(stream);
 	stream->Meta.Inflate = state;
@@ -1021,11 +1395,15 @@ void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struc
 	state->NextOut  = state->Output;
 	state->AvailOut = DEFLATE_OUT_SIZE;
 	state->Dest     = underlying;
-	state->WroteHeader = false;
+	state->Level    = DEFLATE_LEVEL_NORMAL;
+	if (!deflate_codesInited) Deflate_InitCodes();
 
 	Mem_Set(state->Head, 0, sizeof(state->Head));
 	Mem_Set(state->Prev, 0, sizeof(state->Prev));
-	Deflate_BuildTable(fixed_lits, INFLATE_MAX_LITS, state->LitsCodewords, state->LitsLens);
+}
+
+void Deflate_SetLevel(struct DeflateState* state, int level) {
+	state->Level = level;
 }
 
 
@@ -35,4 +35,15 @@ CC_API void Drawer_ZMax(int count, PackedCol col, TextureLoc texLoc, struct Vert
 CC_API void Drawer_YMin(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
 /* Draws maximum Y face of the cuboid. (i.e. at Y2) */
 CC_API void Drawer_YMax(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+
+/* Variants of the above functions that use the given state instead of the global Drawer state. */
+/* NOTE: Used by the chunk mesh builder, which may draw from multiple threads at once. */
+/* rows is how many blocks the face also spans along the texture's V axis. */
+/* NOTE: rows > 1 only works when each 1D atlas contains only one tile. */
+void Drawer_XMinEx(struct _DrawerData* d, int count, int rows, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void Drawer_XMaxEx(struct _DrawerData* d, int count, int rows, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void Drawer_ZMinEx(struct _DrawerData* d, int count, int rows, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void Drawer_ZMaxEx(struct _DrawerData* d, int count, int rows, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void Drawer_YMinEx(struct _DrawerData* d, int count, int rows, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void Drawer_YMaxEx(struct _DrawerData* d, int count, int rows, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
 #endif
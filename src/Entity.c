@@ -20,6 +20,7 @@
 #include "Options.h"
 #include "Errors.h"
 #include "Utils.h"
+#include "TexturePack.h"
 #include "EntityRenderers.h"
 
 const char* const NameMode_Names[NAME_MODE_COUNT]   = { "None", "Hovered", "All", "AllHovered", "AllUnscaled" };
@@ -146,6 +147,7 @@ void Entity_UpdateModelBounds(struct Entity* e) {
 	Vec3_Mul3By(&e->Size,          &e->ModelScale);
 	Vec3_Mul3By(&e->ModelAABB.Min, &e->ModelScale);
 	Vec3_Mul3By(&e->ModelAABB.Max, &e->ModelScale);
+	Entities_MarkMoved();
 }
 
 cc_bool Entity_TouchesAny(struct AABB* bounds, Entity_TouchesCondition condition) {
@@ -201,6 +203,110 @@ cc_bool Entity_TouchesAnyWater(struct Entity* e) {
 }
 
 
+/*########################################################################################################################*
+*--------------------------------------------------------Skin cache-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Recently used skin textures are kept even after no entities are using them anymore, */
+/*  so that skins don't need to be decoded again when an entity with that skin reappears */
+#define SKIN_CACHE_SIZE 32
+static struct CachedSkin {
+	char skin[STRING_SIZE];
+	GfxResourceID texID;
+	float uScale, vScale;
+	cc_uint8 skinType;
+	cc_uint32 lastUsed;
+} skinCache[SKIN_CACHE_SIZE];
+static cc_uint32 skinCacheTime;
+
+static struct CachedSkin* SkinCache_Find(const cc_string* skin) {
+	cc_string cached;
+	int i;
+
+	for (i = 0; i < SKIN_CACHE_SIZE; i++) 
+	{
+		if (!skinCache[i].texID) continue;
+		cached = String_FromRawArray(skinCache[i].skin);
+		if (String_Equals(&cached, skin)) return &skinCache[i];
+	}
+	return NULL;
+}
+
+static cc_bool SkinCache_Has(GfxResourceID texID) {
+	int i;
+	for (i = 0; i < SKIN_CACHE_SIZE; i++) 
+	{
+		if (skinCache[i].texID == texID) return true;
+	}
+	return false;
+}
+
+/* Removes the given texture from the cache, without deleting it */
+static void SkinCache_Remove(GfxResourceID texID) {
+	int i;
+	if (!texID) return;
+
+	for (i = 0; i < SKIN_CACHE_SIZE; i++) 
+	{
+		if (skinCache[i].texID == texID) skinCache[i].texID = 0;
+	}
+}
+
+static cc_bool SkinCache_IsUsed(GfxResourceID texID) {
+	int i;
+	for (i = 0; i < ENTITIES_MAX_COUNT; i++) 
+	{
+		if (Entities.List[i] && Entities.List[i]->TextureId == texID) return true;
+	}
+	return false;
+}
+
+/* Removes the given entry, deleting its texture if no entities are using it */
+static void SkinCache_Evict(struct CachedSkin* entry) {
+	if (!entry->texID) return;
+
+	if (SkinCache_IsUsed(entry->texID)) {
+		entry->texID = 0;
+	} else {
+		Gfx_DeleteTexture(&entry->texID);
+	}
+}
+
+static void SkinCache_Add(struct Entity* e) {
+	struct CachedSkin* entry;
+	cc_string skin;
+	int i;
+	if (!e->TextureId) return;
+
+	skin  = String_FromRawArray(e->SkinRaw);
+	entry = SkinCache_Find(&skin);
+
+	/* Replace least recently used skin if not already cached */
+	if (!entry) {
+		entry = &skinCache[0];
+		for (i = 1; i < SKIN_CACHE_SIZE && entry->texID; i++) 
+		{
+			if (!skinCache[i].texID || skinCache[i].lastUsed < entry->lastUsed) entry = &skinCache[i];
+		}
+		SkinCache_Evict(entry);
+	}
+
+	String_CopyToRawArray(entry->skin, &skin);
+	entry->texID    = e->TextureId;
+	entry->uScale   = e->uScale;
+	entry->vScale   = e->vScale;
+	entry->skinType = e->SkinType;
+	entry->lastUsed = ++skinCacheTime;
+}
+
+static void SkinCache_Clear(void) {
+	int i;
+	for (i = 0; i < SKIN_CACHE_SIZE; i++) 
+	{
+		SkinCache_Evict(&skinCache[i]);
+	}
+}
+
+
 /*########################################################################################################################*
 *------------------------------------------------------Entity skins-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -289,7 +395,7 @@ static void Entity_ClearHat(struct Bitmap* bmp, cc_uint8 skinType) {
 }
 
 /* Ensures skin is a power of two size, resizing if needed. */
-static cc_result EnsurePow2Skin(struct Entity* e, struct Bitmap* bmp) {
+static cc_result EnsurePow2Skin(struct Bitmap* bmp) {
 	struct Bitmap scaled;
 	cc_uint32 stride;
 	int width, height;
@@ -301,9 +407,6 @@ static cc_result EnsurePow2Skin(struct Entity* e, struct Bitmap* bmp) {
 
 	Bitmap_TryAllocate(&scaled, width, height);
 	if (!scaled.scan0) return ERR_OUT_OF_MEMORY;
-
-	e->uScale = (float)bmp->width  / width;
-	e->vScale = (float)bmp->height / height;
 	stride = bmp->width * 4;
 
 	for (y = 0; y < bmp->height; y++) {
@@ -317,25 +420,31 @@ static cc_result EnsurePow2Skin(struct Entity* e, struct Bitmap* bmp) {
 	return 0;
 }
 
-static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct Stream* src, cc_string* skin) {
+/* Prepares a decoded skin for use as a texture. (called on the background decoding thread) */
+static cc_result ProcessSkin(struct Bitmap* bmp, int clearHat) {
 	cc_result res;
-	if ((res = Png_Decode(bmp, src))) return res;
+	if ((res = EnsurePow2Skin(bmp))) return res;
 
+	if (clearHat) Entity_ClearHat(bmp, Utils_CalcSkinType(bmp));
+	return 0;
+}
+
+static void ApplySkin(struct Entity* e, struct PngDecodeResult* result, cc_string* skin) {
+	struct Bitmap* bmp = &result->bmp;
+	SkinCache_Remove(e->TextureId);
 	Gfx_DeleteTexture(&e->TextureId);
 	Entity_SetSkinAll(e, true);
-	if ((res = EnsurePow2Skin(e, bmp))) return res;
+
+	e->uScale   = (float)result->srcWidth  / bmp->width;
+	e->vScale   = (float)result->srcHeight / bmp->height;
 	e->SkinType = Utils_CalcSkinType(bmp);
 
 	if (!Gfx_CheckTextureSize(bmp->width, bmp->height)) {
 		Chat_Add1("&cSkin %s is too large", skin);
 	} else {
-		if (e->Model->flags & MODEL_FLAG_CLEAR_HAT) 
-			Entity_ClearHat(bmp, e->SkinType);
-
 		Gfx_RecreateTexture(&e->TextureId, bmp, TEXTURE_FLAG_MANAGED, false);
 		Entity_SetSkinAll(e, false);
 	}
-	return 0;
 }
 
 static void LogInvalidSkin(cc_result res, const cc_string* skin, const cc_uint8* data, int size) {
@@ -351,53 +460,142 @@ static void LogInvalidSkin(cc_result res, const cc_string* skin, const cc_uint8*
 	Logger_WarnFunc(&msg);
 }
 
+/* Attempts to use the decoded skin texture from the skin cache */
+static cc_bool Entity_UseMemCachedSkin(struct Entity* e, const cc_string* skin) {
+	struct CachedSkin* entry = SkinCache_Find(skin);
+	if (!entry) return false;
+
+	e->TextureId = entry->texID;
+	e->SkinType  = entry->skinType;
+	e->uScale    = entry->uScale;
+	e->vScale    = entry->vScale;
+	entry->lastUsed = ++skinCacheTime;
+
+	Entity_SetSkinAll(e, false);
+	return true;
+}
+
+/* Starts decoding the skin from the skin cache in texturecache folder */
+static cc_bool Entity_DecodeCachedSkin(struct Entity* e, const cc_string* url) {
+	struct Stream stream;
+	cc_uint8* data = NULL;
+	cc_uint32 size = 0;
+	cc_result res;
+	if (!TextureCache_OpenSkin(url, &stream)) return false;
+
+	res = stream.Length(&stream, &size);
+	if (!res && size) {
+		data = (cc_uint8*)Mem_TryAlloc(size, 1);
+		res  = data ? Stream_Read(&stream, data, size) : ERR_OUT_OF_MEMORY;
+	}
+
+	if (!res && size) {
+		e->_skinReqID = PngDecoder_AddOwned(data, size, ProcessSkin, e->Model->flags & MODEL_FLAG_CLEAR_HAT);
+	} else {
+		Mem_Free(data);
+	}
+
+	/* No point logging error for closing readonly file */
+	(void)stream.Close(&stream);
+	return !res && size;
+}
+
+static void Entity_CheckDownloadedSkin(struct Entity* e, const cc_string* url, cc_bool useCache) {
+	struct HttpRequest item;
+	if (!Http_GetResult(e->_skinReqID, &item)) return;
+
+	if (!item.success) {
+		/* Keep using cached skin if it is unchanged (304) or couldn't be checked */
+		if (e->TextureId && (item.statusCode == 304 || item.result)) {
+			Entity_SetSkinAll(e, false);
+		} else {
+			SkinCache_Remove(e->TextureId);
+			Gfx_DeleteTexture(&e->TextureId);
+			Entity_SetSkinAll(e, true);
+		}
+	} else {
+		if (useCache && Png_Detect(item.data, item.size)) TextureCache_AddSkin(url, &item);
+
+		e->_skinReqID     = PngDecoder_Add(item.data, item.size, ProcessSkin, e->Model->flags & MODEL_FLAG_CLEAR_HAT);
+		e->SkinFetchState = SKIN_FETCH_DECODING;
+	}
+	HttpRequest_Free(&item);
+}
+
+static void Entity_CheckDecodedSkin(struct Entity* e, cc_string* skin, const cc_string* url, cc_bool useCache) {
+	struct PngDecodeResult result;
+	cc_string lastModified, etag;
+	cc_bool cached = e->SkinFetchState == SKIN_FETCH_DECODING_CACHED;
+	cc_uint8 flags = useCache ? HTTP_FLAG_LOW_PRIORITY : HTTP_FLAG_NOCACHE;
+	if (!PngDecoder_GetResult(e->_skinReqID, &result)) return;
+
+	if (!result.res) {
+		ApplySkin(e, &result, skin);
+		if (useCache) SkinCache_Add(e);
+	} else if (!cached) {
+		LogInvalidSkin(result.res, skin, result.data, result.size);
+		/* Keep using cached skin if the redownloaded skin is invalid */
+		Entity_SetSkinAll(e, !e->TextureId);
+	}
+	PngDecodeResult_Free(&result);
+	if (!cached) return;
+
+	/* Show the cached skin straight away, but still check if the skin has changed since */
+	if (e->TextureId) {
+		TextureCache_GetSkinTags(url, &lastModified, &etag);
+		e->_skinReqID = Http_AsyncGetDataEx(url, flags, &lastModified, &etag, NULL);
+	} else {
+		e->_skinReqID = Http_AsyncGetData(url, flags);
+	}
+	e->SkinFetchState = SKIN_FETCH_DOWNLOADING;
+}
+
 static void Entity_CheckSkin(struct Entity* e) {
+	cc_string url; char urlBuffer[URL_MAX_SIZE];
 	struct Entity* first;
-	struct HttpRequest item;
-	struct Stream mem;
-	struct Bitmap bmp;
 	cc_string skin;
-	cc_uint8 flags;
-	cc_result res;
+	cc_bool useCache;
 
 	/* Don't check skin if don't have to */
 	if (!e->Model->usesSkin) return;
 	if (e->SkinFetchState == SKIN_FETCH_COMPLETED) return;
 	skin = String_FromRawArray(e->SkinRaw);
 
+	/* Local player's skin is always redownloaded, in case user has just changed it */
+	useCache = e != &LocalPlayer_Instance.Base;
+	String_InitArray(url, urlBuffer);
+	Http_GetSkinUrl(&skin, &url);
+
 	if (!e->SkinFetchState) {
 		first = Entity_FirstOtherWithSameSkinAndFetchedSkin(e);
-		flags = e == &LocalPlayer_Instance.Base ? HTTP_FLAG_NOCACHE : 0;
 
-		if (!first) {
-			e->_skinReqID     = Http_AsyncGetSkin(&skin, flags);
-			e->SkinFetchState = SKIN_FETCH_DOWNLOADING;
-		} else {
+		if (first) {
 			Entity_CopySkin(e, first);
 			e->SkinFetchState = SKIN_FETCH_COMPLETED;
 			return;
 		}
-	}
+		if (useCache && Entity_UseMemCachedSkin(e, &skin)) return;
 
-	if (!Http_GetResult(e->_skinReqID, &item)) return;
+		if (useCache && Entity_DecodeCachedSkin(e, &url)) {
+			e->SkinFetchState = SKIN_FETCH_DECODING_CACHED;
+		} else {
+			e->_skinReqID     = Http_AsyncGetData(&url, useCache ? HTTP_FLAG_LOW_PRIORITY : HTTP_FLAG_NOCACHE);
+			e->SkinFetchState = SKIN_FETCH_DOWNLOADING;
+		}
+	}
 
-	if (!item.success) { 
-		Entity_SetSkinAll(e, true);
+	if (e->SkinFetchState == SKIN_FETCH_DOWNLOADING) {
+		Entity_CheckDownloadedSkin(e, &url, useCache);
 	} else {
-		Stream_ReadonlyMemory(&mem, item.data, item.size);
-
-		if ((res = ApplySkin(e, &bmp, &mem, &skin))) {
-			LogInvalidSkin(res, &skin, item.data, item.size);
-		}
-		Mem_Free(bmp.scan0);
+		Entity_CheckDecodedSkin(e, &skin, &url, useCache);
 	}
-	HttpRequest_Free(&item);
 }
 
 /* Returns true if no other entities are sharing this skin texture */
 static cc_bool CanDeleteTexture(struct Entity* except) {
 	int i;
 	if (!except->TextureId) return false;
+	if (SkinCache_Has(except->TextureId)) return false;
 
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
 		if (!Entities.List[i] || Entities.List[i] == except)  continue;
@@ -407,6 +605,8 @@ static cc_bool CanDeleteTexture(struct Entity* except) {
 }
 
 CC_NOINLINE static void DeleteSkin(struct Entity* e) {
+	if (e->SkinFetchState == SKIN_FETCH_DECODING || e->SkinFetchState == SKIN_FETCH_DECODING_CACHED)
+		PngDecoder_Cancel(e->_skinReqID);
 	if (CanDeleteTexture(e)) Gfx_DeleteTexture(&e->TextureId);
 
 	Entity_ResetSkin(e);
@@ -438,6 +638,194 @@ void Entity_LerpAngles(struct Entity* e, float t) {
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------------Entities grid-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Entities are indexed by which columns of ENTITYGRID_CELL_SIZE x ENTITYGRID_CELL_SIZE blocks they overlap, */
+/*  so that finding entities near a point or along a ray only needs to check a few entities */
+#define ENTITYGRID_CELL_SIZE 4.0f
+#define ENTITYGRID_BUCKETS 512
+/* Entities overlapping more cells than this are instead always checked */
+#define ENTITYGRID_MAX_CELLS 16
+#define ENTITYGRID_MAX_NODES (ENTITIES_MAX_COUNT * ENTITYGRID_MAX_CELLS)
+/* Cell coordinates are limited to this, to avoid integer overflow */
+#define ENTITYGRID_MAX_COORD 262144.0f
+#define ENTITYGRID_NONE 0xFFFF
+
+struct EntityGridNode { int cellX, cellZ; cc_uint16 next; EntityID id; };
+static struct EntityGridNode grid_nodes[ENTITYGRID_MAX_NODES];
+static cc_uint16 grid_buckets[ENTITYGRID_BUCKETS];
+static int grid_nodesCount;
+/* Entities which were too large (or too far away) to store in cells */
+static EntityID grid_large[ENTITIES_MAX_COUNT];
+static int grid_largeCount;
+/* Range of cells that contain at least one entity */
+static int grid_minX, grid_minZ, grid_maxX, grid_maxZ;
+/* Whether any entity has moved since the grid was last rebuilt */
+static cc_bool grid_dirty = true;
+/* Used to avoid checking an entity more than once per query */
+static cc_uint32 grid_visited[ENTITIES_MAX_COUNT], grid_query;
+
+static int EntityGrid_Hash(int cellX, int cellZ) {
+	return (int)(((cc_uint32)cellX * 73856093u) ^ ((cc_uint32)cellZ * 19349663u)) & (ENTITYGRID_BUCKETS - 1);
+}
+
+/* Calculates the area on the X/Z axes that the given entity may be in until its next tick */
+/* NOTE: Includes the entity's rotated picking bounds, since entities can be picked anywhere within them */
+static void EntityGrid_CalcArea(struct Entity* e, float* minX, float* minZ, float* maxX, float* maxZ) {
+	struct AABB* bb = &e->ModelAABB;
+	float x, y, z, radius;
+
+	x = max(Math_AbsF(bb->Min.X), Math_AbsF(bb->Max.X));
+	y = max(Math_AbsF(bb->Min.Y), Math_AbsF(bb->Max.Y));
+	z = max(Math_AbsF(bb->Min.Z), Math_AbsF(bb->Max.Z));
+	radius = Math_SqrtF(x * x + y * y + z * z) + 0.5f;
+
+	*minX = min(e->Position.X, min(e->prev.pos.X, e->next.pos.X)) - radius;
+	*minZ = min(e->Position.Z, min(e->prev.pos.Z, e->next.pos.Z)) - radius;
+	*maxX = max(e->Position.X, max(e->prev.pos.X, e->next.pos.X)) + radius;
+	*maxZ = max(e->Position.Z, max(e->prev.pos.Z, e->next.pos.Z)) + radius;
+}
+
+/* Calculates the range of cells that the given area overlaps, returning false if area is too large */
+static cc_bool EntityGrid_CalcCells(float minX, float minZ, float maxX, float maxZ, int* cells) {
+	/* NOTE: Written this way so that NaN coordinates fail the checks too */
+	if (!(minX >= -ENTITYGRID_MAX_COORD && maxX <= ENTITYGRID_MAX_COORD)) return false;
+	if (!(minZ >= -ENTITYGRID_MAX_COORD && maxZ <= ENTITYGRID_MAX_COORD)) return false;
+
+	cells[0] = Math_Floor(minX / ENTITYGRID_CELL_SIZE);
+	cells[1] = Math_Floor(minZ / ENTITYGRID_CELL_SIZE);
+	cells[2] = Math_Floor(maxX / ENTITYGRID_CELL_SIZE);
+	cells[3] = Math_Floor(maxZ / ENTITYGRID_CELL_SIZE);
+	return true;
+}
+
+static void EntityGrid_Insert(EntityID id) {
+	float minX, minZ, maxX, maxZ;
+	int cells[4], x, z, hash;
+	struct EntityGridNode* node;
+
+	EntityGrid_CalcArea(Entities.List[id], &minX, &minZ, &maxX, &maxZ);
+	if (!EntityGrid_CalcCells(minX, minZ, maxX, maxZ, cells) ||
+		(cells[2] - cells[0] + 1) * (cells[3] - cells[1] + 1) > ENTITYGRID_MAX_CELLS) {
+		grid_large[grid_largeCount++] = id; return;
+	}
+
+	grid_minX = min(grid_minX, cells[0]); grid_maxX = max(grid_maxX, cells[2]);
+	grid_minZ = min(grid_minZ, cells[1]); grid_maxZ = max(grid_maxZ, cells[3]);
+
+	for (z = cells[1]; z <= cells[3]; z++) 
+	{
+		for (x = cells[0]; x <= cells[2]; x++) 
+		{
+			hash = EntityGrid_Hash(x, z);
+			node = &grid_nodes[grid_nodesCount];
+			node->cellX = x; node->cellZ = z;
+			node->id    = id;
+			node->next  = grid_buckets[hash];
+
+			grid_buckets[hash] = (cc_uint16)grid_nodesCount++;
+		}
+	}
+}
+
+/* Rebuilds the grid from the current state of all entities, if any entity has moved */
+static void EntityGrid_Update(void) {
+	int i;
+	if (!grid_dirty) return;
+	grid_dirty = false;
+
+	for (i = 0; i < ENTITYGRID_BUCKETS; i++) grid_buckets[i] = ENTITYGRID_NONE;
+	grid_nodesCount = 0;
+	grid_largeCount = 0;
+	grid_minX = Int32_MaxValue; grid_maxX = Int32_MinValue;
+	grid_minZ = Int32_MaxValue; grid_maxZ = Int32_MinValue;
+
+	for (i = 0; i < ENTITIES_MAX_COUNT; i++) 
+	{
+		if (Entities.List[i]) EntityGrid_Insert((EntityID)i);
+	}
+}
+
+static void EntityGrid_BeginQuery(void) {
+	EntityGrid_Update();
+	grid_query++;
+
+	/* Wrapped around, so have to reset visited entities */
+	if (grid_query) return;
+	Mem_Set(grid_visited, 0, sizeof(grid_visited));
+	grid_query = 1;
+}
+
+/* Adds entities in the given cell to the list of entities, skipping already found entities */
+static int EntityGrid_AddCell(int cellX, int cellZ, EntityID* ids, int count) {
+	struct EntityGridNode* node;
+	int i = grid_buckets[EntityGrid_Hash(cellX, cellZ)];
+
+	for (; i != ENTITYGRID_NONE; i = node->next)
+	{
+		node = &grid_nodes[i];
+		if (node->cellX != cellX || node->cellZ != cellZ) continue;
+		if (grid_visited[node->id] == grid_query)         continue;
+
+		grid_visited[node->id] = grid_query;
+		ids[count++] = node->id;
+	}
+	return count;
+}
+
+static int EntityGrid_AddLarge(EntityID* ids, int count) {
+	int i;
+	for (i = 0; i < grid_largeCount; i++) 
+	{
+		grid_visited[grid_large[i]] = grid_query;
+		ids[count++] = grid_large[i];
+	}
+	return count;
+}
+
+void Entities_MarkMoved(void) { grid_dirty = true; }
+
+int Entities_FindNear(float minX, float minZ, float maxX, float maxZ, EntityID* ids) {
+	int cells[4], x, z, i, j, count;
+	EntityID id;
+	EntityGrid_BeginQuery();
+	count = EntityGrid_AddLarge(ids, 0);
+
+	if (EntityGrid_CalcCells(minX, minZ, maxX, maxZ, cells)) {
+		cells[0] = max(cells[0], grid_minX); cells[2] = min(cells[2], grid_maxX);
+		cells[1] = max(cells[1], grid_minZ); cells[3] = min(cells[3], grid_maxZ);
+
+		for (z = cells[1]; z <= cells[3]; z++) 
+		{
+			for (x = cells[0]; x <= cells[2]; x++) 
+			{
+				count = EntityGrid_AddCell(x, z, ids, count);
+			}
+		}
+	} else {
+		/* Area is too large for the grid, so just check every entity */
+		count = 0;
+		for (i = 0; i < ENTITIES_MAX_COUNT; i++) 
+		{
+			if (Entities.List[i]) ids[count++] = (EntityID)i;
+		}
+	}
+
+	/* Insertion sort, so entities are always checked in the same order */
+	for (i = 1; i < count; i++) 
+	{
+		id = ids[i];
+		for (j = i; j > 0 && ids[j - 1] > id; j--) 
+		{
+			ids[j] = ids[j - 1];
+		}
+		ids[j] = id;
+	}
+	return count;
+}
+
+
 /*########################################################################################################################*
 *--------------------------------------------------------Entities---------------------------------------------------------*
 *#########################################################################################################################*/
@@ -449,24 +837,64 @@ void Entities_Tick(struct ScheduledTask* task) {
 	{
 		if (!Entities.List[i]) continue;
 		Entities.List[i]->VTABLE->Tick(Entities.List[i], task->interval);
+		Entities_MarkMoved();
 	}
 }
 
+/* Squared distance from the camera beyond which entity models are not rendered */
+static float entities_maxDistSq;
+static cc_bool Entities_InRenderDistance(struct Entity* e) {
+	return Model_RenderDistance(e) <= entities_maxDistSq;
+}
+
+static cc_uintptr Entities_SkinKey(struct Entity* e) {
+	return (cc_uintptr)(e->Model->usesHumanSkin ? e->TextureId : e->MobTextureId);
+}
+
+/* Entities using the same model and skin are rendered one after another, */
+/*  which lets Model_Render merge them together into fewer draw calls */
+static cc_bool Entities_RenderBefore(struct Entity* a, struct Entity* b) {
+	if (a->Model != b->Model) return (cc_uintptr)a->Model < (cc_uintptr)b->Model;
+	return Entities_SkinKey(a) < Entities_SkinKey(b);
+}
+
 void Entities_RenderModels(double delta, float t) {
-	int i;
-	Gfx_SetAlphaTest(true);
-	
+	struct Entity* order[ENTITIES_MAX_COUNT];
+	struct Entity* e;
+	int i, j, count = 0, dist;
+
+	dist = Game_ViewDistance;
+	if (Entities.MaxRenderDistance) dist = min(dist, Entities.MaxRenderDistance);
+	entities_maxDistSq = (float)dist * dist;
+
+	/* Insertion sort, since there are only a small number of entities */
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) 
 	{
-		if (!Entities.List[i]) continue;
-		Entities.List[i]->VTABLE->RenderModel(Entities.List[i], delta, t);
+		if (!(e = Entities.List[i])) continue;
+
+		for (j = count; j > 0 && Entities_RenderBefore(e, order[j - 1]); j--) 
+		{
+			order[j] = order[j - 1];
+		}
+		order[j] = e;
+		count++;
+	}
+
+	Gfx_SetAlphaTest(true);
+	Model_BeginBatch();
+
+	for (i = 0; i < count; i++) 
+	{
+		order[i]->VTABLE->RenderModel(order[i], delta, t);
 	}
+	Model_EndBatch();
 	Gfx_SetAlphaTest(false);
 }
 
 static void Entities_ContextLost(void* obj) {
 	struct Entity* entity;
 	int i;
+	if (!Gfx.ManagedTextures) SkinCache_Clear();
 
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) 
 	{
@@ -489,6 +917,7 @@ void Entities_Remove(EntityID id) {
 	Event_RaiseInt(&EntityEvents.Removed, id);
 	e->VTABLE->Despawn(e);
 	Entities.List[id] = NULL;
+	Entities_MarkMoved();
 
 	/* TODO: Move to EntityEvents.Removed callback instead */
 	if (TabList_EntityLinked_Get(id)) {
@@ -497,23 +926,83 @@ void Entities_Remove(EntityID id) {
 	}
 }
 
+/* Checks if the ray intersects any of the given entities closer than the closest entity found so far */
+static void Entities_PickAny(Vec3 origin, Vec3 dir, EntityID* ids, int count, float* closestDist, EntityID* targetId) {
+	float t0, t1;
+	int i;
+
+	for (i = 0; i < count; i++) 
+	{
+		if (ids[i] == ENTITIES_SELF_ID) continue; /* because we don't want to pick against local player */
+		if (!Intersection_RayIntersectsRotatedBox(origin, dir, Entities.List[ids[i]], &t0, &t1)) continue;
+
+		/* Lowest ID wins ties, since entities used to be checked in ID order */
+		if (t0 < *closestDist || (t0 == *closestDist && ids[i] < *targetId)) {
+			*closestDist = t0;
+			*targetId    = ids[i];
+		}
+	}
+}
+
+/* Calculates where the ray enters and leaves the cells containing entities */
+static cc_bool EntityGrid_ClipRay(float origin, float dir, int minCell, int maxCell, float* tEnter, float* tExit) {
+	float lo = minCell * ENTITYGRID_CELL_SIZE, hi = (maxCell + 1) * ENTITYGRID_CELL_SIZE;
+	float ta, tb, tmp;
+
+	if (dir == 0.0f) return origin >= lo && origin <= hi;
+	ta = (lo - origin) / dir;
+	tb = (hi - origin) / dir;
+	if (ta > tb) { tmp = ta; ta = tb; tb = tmp; }
+
+	*tEnter = max(*tEnter, ta);
+	*tExit  = min(*tExit,  tb);
+	return *tEnter <= *tExit;
+}
+
 EntityID Entities_GetClosest(struct Entity* src) {
 	Vec3 eyePos = Entity_GetEyePosition(src);
 	Vec3 dir = Vec3_GetDirVector(src->Yaw * MATH_DEG2RAD, src->Pitch * MATH_DEG2RAD);
 	float closestDist = MATH_POS_INF;
 	EntityID targetId = ENTITIES_SELF_ID;
+	EntityID ids[ENTITIES_MAX_COUNT];
 
-	float t0, t1;
-	int i;
+	float t, tEnter, tExit, nextX, nextZ, deltaX, deltaZ;
+	int cellX, cellZ, stepX, stepZ, count;
 
-	for (i = 0; i < ENTITIES_SELF_ID; i++) { /* because we don't want to pick against local player */
-		struct Entity* entity = Entities.List[i];
-		if (!entity) continue;
+	EntityGrid_BeginQuery();
+	count = EntityGrid_AddLarge(ids, 0);
+	Entities_PickAny(eyePos, dir, ids, count, &closestDist, &targetId);
+
+	tEnter = 0.0f; tExit = MATH_POS_INF;
+	if (!EntityGrid_ClipRay(eyePos.X, dir.X, grid_minX, grid_maxX, &tEnter, &tExit)) return targetId;
+	if (!EntityGrid_ClipRay(eyePos.Z, dir.Z, grid_minZ, grid_maxZ, &tEnter, &tExit)) return targetId;
 
-		if (Intersection_RayIntersectsRotatedBox(eyePos, dir, entity, &t0, &t1) && t0 < closestDist) {
-			closestDist = t0;
-			targetId = (EntityID)i;
+	cellX = Math_Floor((eyePos.X + dir.X * tEnter) / ENTITYGRID_CELL_SIZE);
+	cellZ = Math_Floor((eyePos.Z + dir.Z * tEnter) / ENTITYGRID_CELL_SIZE);
+	Math_Clamp(cellX, grid_minX, grid_maxX);
+	Math_Clamp(cellZ, grid_minZ, grid_maxZ);
+
+	/* Walk through the cells in the order the ray passes through them */
+	stepX  = dir.X >= 0.0f ? 1 : -1;
+	stepZ  = dir.Z >= 0.0f ? 1 : -1;
+	deltaX = dir.X ? ENTITYGRID_CELL_SIZE / Math_AbsF(dir.X) : MATH_POS_INF;
+	deltaZ = dir.Z ? ENTITYGRID_CELL_SIZE / Math_AbsF(dir.Z) : MATH_POS_INF;
+	nextX  = dir.X ? ((cellX + (stepX > 0)) * ENTITYGRID_CELL_SIZE - eyePos.X) / dir.X : MATH_POS_INF;
+	nextZ  = dir.Z ? ((cellZ + (stepZ > 0)) * ENTITYGRID_CELL_SIZE - eyePos.Z) / dir.Z : MATH_POS_INF;
+
+	for (;;) 
+	{
+		count = EntityGrid_AddCell(cellX, cellZ, ids, 0);
+		Entities_PickAny(eyePos, dir, ids, count, &closestDist, &targetId);
+
+		if (nextX < nextZ) {
+			t = nextX; nextX += deltaX; cellX += stepX;
+		} else {
+			t = nextZ; nextZ += deltaZ; cellZ += stepZ;
 		}
+		/* Any entities in later cells are further away than the closest entity */
+		if (t > tExit || t > closestDist || t == MATH_POS_INF) break;
+		if (cellX < grid_minX || cellX > grid_maxX || cellZ < grid_minZ || cellZ > grid_maxZ) break;
 	}
 	return targetId;
 }
@@ -677,6 +1166,7 @@ static void LocalPlayer_InputUp(void* obj, int key) {
 static void LocalPlayer_SetLocation(struct Entity* e, struct LocationUpdate* update) {
 	struct LocalPlayer* p = (struct LocalPlayer*)e;
 	LocalInterpComp_SetLocation(&p->Interp, update);
+	Entities_MarkMoved();
 }
 
 static void LocalPlayer_Tick(struct Entity* e, double delta) {
@@ -987,6 +1477,7 @@ struct NetPlayer NetPlayers_List[ENTITIES_SELF_ID];
 static void NetPlayer_SetLocation(struct Entity* e, struct LocationUpdate* update) {
 	struct NetPlayer* p = (struct NetPlayer*)e;
 	NetInterpComp_SetLocation(&p->Interp, update, e);
+	Entities_MarkMoved();
 }
 
 static void NetPlayer_Tick(struct Entity* e, double delta) {
@@ -1002,7 +1493,8 @@ static void NetPlayer_RenderModel(struct Entity* e, double deltaTime, float t) {
 	Entity_LerpAngles(e, t);
 
 	AnimatedComp_GetCurrent(e, t);
-	e->ShouldRender = Model_ShouldRender(e);
+	/* Distance check is cheaper than frustum culling, so do it first */
+	e->ShouldRender = Entities_InRenderDistance(e) && Model_ShouldRender(e);
 	if (e->ShouldRender) Model_Render(e->Model, e);
 }
 
@@ -1042,6 +1534,7 @@ static void Entities_Init(void) {
 	Entities.ShadowsMode = Options_GetEnum(OPT_ENTITY_SHADOW, SHADOW_MODE_NONE,
 		ShadowMode_Names, Array_Elems(ShadowMode_Names));
 	if (Game_ClassicMode) Entities.ShadowsMode = SHADOW_MODE_NONE;
+	Entities.MaxRenderDistance = Options_GetInt(OPT_ENTITY_RENDER_DIST, 0, 4096, 0);
 
 	Entities.List[ENTITIES_SELF_ID] = &LocalPlayer_Instance.Base;
 	LocalPlayer_Init();
@@ -1049,6 +1542,8 @@ static void Entities_Init(void) {
 
 static void Entities_Free(void) {
 	int i;
+	SkinCache_Clear();
+
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) 
 	{
 		Entities_Remove((EntityID)i);
@@ -78,6 +78,10 @@ struct EntityVTABLE {
 #define SKIN_FETCH_DOWNLOADING 1
 /* Skin was downloaded or copied from another entity with the same skin. */
 #define SKIN_FETCH_COMPLETED   2
+/* Downloaded skin is being decoded on a background thread */
+#define SKIN_FETCH_DECODING    3
+/* Skin from the skin cache is being decoded on a background thread */
+#define SKIN_FETCH_DECODING_CACHED 4
 
 /* true to restrict model scale (needed for local player, giant model collisions are too costly) */
 #define ENTITY_FLAG_MODEL_RESTRICTED_SCALE 0x01
@@ -159,6 +163,9 @@ void Entity_LerpAngles(struct Entity* e, float t);
 CC_VAR extern struct _EntitiesData {
 	struct Entity* List[ENTITIES_MAX_COUNT];
 	cc_uint8 NamesMode, ShadowsMode;
+	/* Maximum distance from the camera that entity models are rendered at */
+	/* NOTE: 0 means entities are only limited by view distance */
+	int MaxRenderDistance;
 } Entities;
 
 /* Ticks all entities */
@@ -169,6 +176,13 @@ void Entities_RenderModels(double delta, float t);
 void Entities_Remove(EntityID id);
 /* Gets the ID of the closest entity to the given entity */
 EntityID Entities_GetClosest(struct Entity* src);
+/* Marks that entities have moved, so the grid used to quickly find entities must be rebuilt */
+/* NOTE: Must be called after changing an entity's position without using SetLocation */
+void Entities_MarkMoved(void);
+/* Finds entities which might be within the given area on the X/Z axes, returning the number found */
+/* NOTE: Entities found are not necessarily within the area, so callers must still check them */
+/* NOTE: ids must have room for ENTITIES_MAX_COUNT entries, and is sorted in increasing order */
+int Entities_FindNear(float minX, float minZ, float maxX, float maxZ, EntityID* ids);
 
 #define TABLIST_MAX_NAMES 256
 /* Data for all entries in tab list */
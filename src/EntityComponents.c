@@ -1034,15 +1034,20 @@ float PhysicsComp_CalcJumpVelocity(float jumpHeight) {
 }
 
 void PhysicsComp_DoEntityPush(struct Entity* entity) {
+	EntityID ids[ENTITIES_MAX_COUNT];
 	struct Entity* other;
 	cc_bool yIntersects;
 	Vec3 dir;
 	float dist, pushStrength;
-	int id;
+	int i, count;
 	dir.Y = 0.0f;
 
-	for (id = 0; id < ENTITIES_MAX_COUNT; id++) {
-		other = Entities.List[id];
+	/* Only entities within 1 block can push */
+	count = Entities_FindNear(entity->Position.X - 1.0f, entity->Position.Z - 1.0f,
+							  entity->Position.X + 1.0f, entity->Position.Z + 1.0f, ids);
+
+	for (i = 0; i < count; i++) {
+		other = Entities.List[ids[i]];
 		if (!other || other == entity) continue;
 		if (!other->Model->pushes)     continue;
 
@@ -1480,6 +1480,32 @@ static cc_result MCLevel_Load(struct Stream* stream) {
 /*########################################################################################################################*
 *--------------------------------------------------ClassicWorld export----------------------------------------------------*
 *#########################################################################################################################*/
+#ifdef CC_BUILD_PALETTEDWORLD
+/* Writes the lower (shift of 0) or upper (shift of 8) 8 bits of every block in the world */
+static cc_result WriteWorldBlocks(struct Stream* stream, int shift) {
+	cc_uint8 buffer[8192];
+	int i, x = 0, y = 0, z = 0, bIndex = 0;
+	cc_result res;
+
+	for (i = 0; i < World.Volume; i++)
+	{
+		buffer[bIndex++] = (cc_uint8)(World_GetBlock(x, y, z) >> shift);
+		/* Same order as World_Pack */
+		if (++x == World.Width) {
+			x = 0;
+			if (++z == World.Length) { z = 0; y++; }
+		}
+		if (bIndex < sizeof(buffer)) continue;
+
+		if ((res = Stream_Write(stream, buffer, sizeof(buffer)))) return res;
+		bIndex = 0;
+	}
+
+	if (bIndex == 0) return 0;
+	return Stream_Write(stream, buffer, bIndex);
+}
+#endif
+
 static cc_uint8* Cw_WriteColor(cc_uint8* data, const char* name, PackedCol color) {
 	data = Nbt_WriteDict(data, name);
 	{
@@ -1598,9 +1624,21 @@ cc_result Cw_Save(struct Stream* stream) {
 	cur = Nbt_WriteArray(cur, "BlockArray", World.Volume);
 
 	if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
+#ifdef CC_BUILD_PALETTEDWORLD
+	if ((res = WriteWorldBlocks(stream, 0)))                       return res;
+#else
 	if ((res = Stream_Write(stream, World.Blocks, World.Volume)))  return res;
+#endif
 
-#ifdef EXTENDED_BLOCKS
+#if defined CC_BUILD_PALETTEDWORLD && defined EXTENDED_BLOCKS
+	if (World.IDMask > 0xFF) {
+		cur = buffer;
+		cur = Nbt_WriteArray(cur, "BlockArray2", World.Volume);
+
+		if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
+		if ((res = WriteWorldBlocks(stream, 8)))                       return res;
+	}
+#elif defined EXTENDED_BLOCKS
 	if (World.Blocks != World.Blocks2) {
 		cur = buffer;
 		cur = Nbt_WriteArray(cur, "BlockArray2", World.Volume);
@@ -1706,7 +1744,11 @@ cc_result Schematic_Save(struct Stream* stream) {
 		Stream_SetU32_BE(&tmp[74], World.Volume);
 	}
 	if ((res = Stream_Write(stream, tmp, sizeof(sc_begin)))) return res;
+#ifdef CC_BUILD_PALETTEDWORLD
+	if ((res = WriteWorldBlocks(stream, 0)))                      return res;
+#else
 	if ((res = Stream_Write(stream, World.Blocks, World.Volume))) return res;
+#endif
 
 	Mem_Copy(tmp, sc_data, sizeof(sc_data));
 	{
@@ -39,6 +39,7 @@
 #include "SystemFonts.h"
 #include "Formats.h"
 #include "EntityRenderers.h"
+#include "Profiler.h"
 
 struct _GameData Game;
 cc_uint64 Game_FrameStart;
@@ -199,6 +200,27 @@ void Game_UpdateBlock(int x, int y, int z, BlockID block) {
 	MapRenderer_OnBlockChanged(x, y, z, block);
 }
 
+void Game_UpdateBlocks(const int* indices, const BlockID* blocks, int count) {
+	cc_bool batchLighting = Lighting_CanBatchChanges();
+	BlockID old, block;
+	int i, x, y, z;
+
+	for (i = 0; i < count; i++) {
+		World_Unpack(indices[i], x, y, z);
+		old   = World_GetBlock(x, y, z);
+		block = blocks[i];
+		World_SetBlock(x, y, z, block);
+
+		if (Weather_Heightmap) {
+			EnvRenderer_OnBlockChanged(x, y, z, old, block);
+		}
+		if (!batchLighting) Lighting.OnBlockChanged(x, y, z, old, block);
+		/* Chunks that are already marked as needing to be rebuilt are ignored */
+		MapRenderer_OnBlockChanged(x, y, z, block);
+	}
+	if (batchLighting) Lighting.OnBlocksChanged(indices, count);
+}
+
 void Game_ChangeBlock(int x, int y, int z, BlockID block) {
 	BlockID old = World_GetBlock(x, y, z);
 	Game_UpdateBlock(x, y, z, block);
@@ -469,12 +491,20 @@ static void UpdateViewMatrix(void) {
 	FrustumCulling_CalcFrustumEquations(&Gfx.Projection, &Gfx.View);
 }
 
+static void Game_RenderTranslucent(double delta) {
+	Profiler_Begin(PROFILER_RENDER_TRANSLUCENT);
+	MapRenderer_RenderTranslucent(delta);
+	Profiler_End(PROFILER_RENDER_TRANSLUCENT);
+}
+
 static void Game_Render3D(double delta, float t) {
 	Vec3 pos;
 	if (EnvRenderer_ShouldRenderSkybox()) EnvRenderer_RenderSkybox();
 
 	AxisLinesRenderer_Render();
+	Profiler_Begin(PROFILER_ENTITIES);
 	Entities_RenderModels(delta, t);
+	Profiler_End(PROFILER_ENTITIES);
 	EntityNames_Render();
 
 	Particles_Render(t);
@@ -482,8 +512,13 @@ static void Game_Render3D(double delta, float t) {
 	EnvRenderer_RenderSky();
 	EnvRenderer_RenderClouds();
 
+	Profiler_Begin(PROFILER_MAP_UPDATE);
 	MapRenderer_Update(delta);
+	Profiler_End(PROFILER_MAP_UPDATE);
+
+	Profiler_Begin(PROFILER_RENDER_NORMAL);
 	MapRenderer_RenderNormal(delta);
+	Profiler_End(PROFILER_RENDER_NORMAL);
 	EnvRenderer_RenderMapSides();
 
 	EntityShadows_Render();
@@ -494,11 +529,11 @@ static void Game_Render3D(double delta, float t) {
 	/* Render water over translucent blocks when under the water outside the map for proper alpha blending */
 	pos = Camera.CurrentPos;
 	if (pos.Y < Env.EdgeHeight && (pos.X < 0 || pos.Z < 0 || pos.X > World.Width || pos.Z > World.Length)) {
-		MapRenderer_RenderTranslucent(delta);
+		Game_RenderTranslucent(delta);
 		EnvRenderer_RenderMapEdges();
 	} else {
 		EnvRenderer_RenderMapEdges();
-		MapRenderer_RenderTranslucent(delta);
+		Game_RenderTranslucent(delta);
 	}
 
 	/* Need to render again over top of translucent block, as the selection outline */
@@ -573,6 +608,12 @@ void Game_TakeScreenshot(void) {
 #endif
 }
 
+/* NOTE: Time spent in Gfx_EndFrame is excluded, as it includes waiting for VSync/FPS limit */
+static void Game_EndProfiledFrame(void) {
+	Profiler_End(PROFILER_FRAME);
+	Profiler_EndFrame();
+}
+
 static void Game_RenderFrame(double delta) {
 	struct ScheduledTask entTask;
 	float t;
@@ -593,6 +634,7 @@ static void Game_RenderFrame(double delta) {
 	}
 
 	Gfx_BeginFrame();
+	Profiler_Begin(PROFILER_FRAME);
 	Gfx_BindIb(Gfx_defaultIb);
 	Game.Time += delta;
 	Game_Vertices = 0;
@@ -604,7 +646,9 @@ static void Game_RenderFrame(double delta) {
 		InputHandler_SetFOV(Camera.ZoomFov);
 	}
 
+	Profiler_Begin(PROFILER_TASKS);
 	PerformScheduledTasks(delta);
+	Profiler_End(PROFILER_TASKS);
 	entTask = tasks[entTaskI];
 	t = (float)(entTask.accumulator / entTask.interval);
 	LocalPlayer_SetInterpPosition(t);
@@ -615,7 +659,7 @@ static void Game_RenderFrame(double delta) {
 	UpdateViewMatrix();
 
 	/* TODO: Not calling Gfx_EndFrame doesn't work with Direct3D9 */
-	if (WindowInfo.Inactive) return;
+	if (WindowInfo.Inactive) { Game_EndProfiledFrame(); return; }
 	Gfx_Clear();
 
 	Gfx_LoadMatrix(MATRIX_PROJECTION, &Gfx.Projection);
@@ -628,10 +672,13 @@ static void Game_RenderFrame(double delta) {
 	}
 
 	Gfx_Begin2D(Game.Width, Game.Height);
+	Profiler_Begin(PROFILER_GUI);
 	Gui_RenderGui(delta);
+	Profiler_End(PROFILER_GUI);
 	Gfx_End2D();
 
 	if (Game_ScreenshotRequested) Game_TakeScreenshot();
+	Game_EndProfiledFrame();
 	Gfx_EndFrame();
 }
 
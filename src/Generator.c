@@ -7,6 +7,11 @@
 #include "Utils.h"
 #include "Game.h"
 #include "Window.h"
+#include "Options.h"
+#if defined __SSE2__
+#include <emmintrin.h>
+#define NOISE_SSE2
+#endif
 
 const struct MapGenerator* Gen_Active;
 BlockRaw* Gen_Blocks;
@@ -77,6 +82,7 @@ static void Gen_Run(void) {
 cc_bool Gen_IsDone(void) { return gen_done; }
 #endif
 
+static void Gen_LoadThreads(void);
 static void Gen_Reset(void) {
 	Gen_CurrentProgress = 0.0f;
 	Gen_CurrentState    = "";
@@ -85,6 +91,7 @@ static void Gen_Reset(void) {
 
 void Gen_Start(void) {
 	Gen_Reset();
+	Gen_LoadThreads();
 	Gen_Blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
 
 	if (!Gen_Blocks || !Gen_Active->Prepare()) {
@@ -96,6 +103,93 @@ void Gen_Start(void) {
 }
 
 
+/*########################################################################################################################*
+*---------------------------------------------------Generator threads-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Passes where each column only depends on its own X/Z can be split into slabs of rows */
+/*  along the Z axis, which are then handed out to any thread that is free to generate them */
+#define GEN_SLAB_ROWS 8
+#define GEN_MAX_THREADS 16
+typedef void (*Gen_SlabFunc)(int zBeg, int zEnd);
+
+static Gen_SlabFunc slabFunc;
+static int gen_threads, slabNext, slabRowsDone;
+
+#ifdef CC_BUILD_COOPTHREADED
+static void Gen_LoadThreads(void) { gen_threads = 0; }
+#else
+static void* slabMutex;
+
+static void Gen_LoadThreads(void) {
+	gen_threads = Options_GetInt(OPT_GEN_THREADS, 0, GEN_MAX_THREADS, 3);
+}
+
+static void Gen_RunSlabWorker(void) {
+	int zBeg, zEnd, rows = 0;
+	for (;;)
+	{
+		Mutex_Lock(slabMutex);
+		{
+			/* Progress is only updated while holding the lock, so it never moves backwards */
+			slabRowsDone += rows;
+			Gen_CurrentProgress = (float)slabRowsDone / World.Length;
+
+			zBeg      = slabNext;
+			slabNext += GEN_SLAB_ROWS;
+		}
+		Mutex_Unlock(slabMutex);
+
+		if (zBeg >= World.Length) return;
+		zEnd = min(zBeg + GEN_SLAB_ROWS, World.Length);
+		rows = zEnd - zBeg;
+		slabFunc(zBeg, zEnd);
+	}
+}
+
+static void Gen_RunSlabsParallel(void) {
+	void* threads[GEN_MAX_THREADS];
+	int i;
+	slabMutex = Mutex_Create();
+
+	for (i = 0; i < gen_threads; i++)
+	{
+		threads[i] = Thread_Create(Gen_RunSlabWorker);
+		Thread_Start2(threads[i], Gen_RunSlabWorker);
+	}
+	/* Generator thread also helps out generating slabs */
+	Gen_RunSlabWorker();
+
+	for (i = 0; i < gen_threads; i++)
+	{
+		Thread_Join(threads[i]);
+	}
+	Mutex_Free(slabMutex);
+	slabMutex = NULL;
+}
+#endif
+
+/* Calls func for every slab of rows in the world, possibly across multiple threads */
+/* NOTE: func must only access columns within its slab, and must not use rnd */
+static void Gen_RunSlabs(Gen_SlabFunc func) {
+	int z;
+	slabFunc = func;
+	slabNext = 0;
+	slabRowsDone = 0;
+
+#ifndef CC_BUILD_COOPTHREADED
+	if (gen_threads && World.Length > GEN_SLAB_ROWS) {
+		Gen_RunSlabsParallel(); return;
+	}
+#endif
+
+	for (z = 0; z < World.Length; z += GEN_SLAB_ROWS)
+	{
+		Gen_CurrentProgress = (float)z / World.Length;
+		func(z, min(z + GEN_SLAB_ROWS, World.Length));
+	}
+}
+
+
 /*########################################################################################################################*
 *-----------------------------------------------------Flatgrass gen-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -157,6 +251,7 @@ static void ImprovedNoise_Init(cc_uint8* p, RNGState* rnd) {
 	}
 }
 
+#ifndef NOISE_SSE2
 static float ImprovedNoise_Calc(const cc_uint8* p, float x, float y) {
 	int xFloor, yFloor, X, Y;
 	float u, v;
@@ -194,6 +289,73 @@ static float ImprovedNoise_Calc(const cc_uint8* p, float x, float y) {
 	return c1 + v * (c2 - c1);
 }
 
+static void ImprovedNoise_Calc4(const cc_uint8* p, const float* xs, const float* ys, float* res) {
+	int i;
+	for (i = 0; i < 4; i++) res[i] = ImprovedNoise_Calc(p, xs[i], ys[i]);
+}
+#else
+/* Grad values for each hash, unpacked from xFlags/yFlags */
+static const float noise_gradX[16] = { 1,-1, 1,-1, 1,-1, 1,-1, 0, 0, 0, 0, 1, 0,-1, 0 };
+static const float noise_gradY[16] = { 1, 1,-1,-1, 0, 0, 0, 0, 1,-1, 1,-1, 1,-1, 1,-1 };
+#define Noise_Mul(a, b) _mm_mul_ps(a, b)
+#define Noise_Add(a, b) _mm_add_ps(a, b)
+#define Noise_Sub(a, b) _mm_sub_ps(a, b)
+
+#define Noise_LoadGrad(hash, gx, gy, i) \
+	h = (hash) & 0xF; gx[i] = noise_gradX[h]; gy[i] = noise_gradY[h];
+
+/* Calculates ImprovedNoise_Calc for 4 points at once */
+/* NOTE: Operations are performed in exactly the same order as ImprovedNoise_Calc, */
+/*  so that the results are always identical to calculating each point individually */
+static void ImprovedNoise_Calc4(const cc_uint8* p, const float* xs, const float* ys, float* res) {
+	float gx22[4], gy22[4], gx12[4], gy12[4];
+	float gx21[4], gy21[4], gx11[4], gy11[4];
+	int xFloor[4], yFloor[4];
+	__m128 x, y, x1, y1, u, v, one;
+	__m128 g22, g12, c1, g21, g11, c2;
+	__m128i xf, yf;
+	int A, B, X, Y, h, i;
+
+	x  = _mm_loadu_ps(xs);
+	y  = _mm_loadu_ps(ys);
+	/* x >= 0 ? (int)x : (int)x - 1 */
+	xf = _mm_add_epi32(_mm_cvttps_epi32(x), _mm_castps_si128(_mm_cmpnge_ps(x, _mm_setzero_ps())));
+	yf = _mm_add_epi32(_mm_cvttps_epi32(y), _mm_castps_si128(_mm_cmpnge_ps(y, _mm_setzero_ps())));
+	_mm_storeu_si128((__m128i*)xFloor, xf);
+	_mm_storeu_si128((__m128i*)yFloor, yf);
+
+	x = Noise_Sub(x, _mm_cvtepi32_ps(xf));
+	y = Noise_Sub(y, _mm_cvtepi32_ps(yf));
+
+	for (i = 0; i < 4; i++)
+	{
+		X = xFloor[i] & 0xFF; Y = yFloor[i] & 0xFF;
+		A = p[X] + Y; B = p[X + 1] + Y;
+
+		Noise_LoadGrad(p[p[A]],     gx22, gy22, i);
+		Noise_LoadGrad(p[p[B]],     gx12, gy12, i);
+		Noise_LoadGrad(p[p[A + 1]], gx21, gy21, i);
+		Noise_LoadGrad(p[p[B + 1]], gx11, gy11, i);
+	}
+
+	u = Noise_Mul(Noise_Mul(Noise_Mul(x, x), x), Noise_Add(Noise_Mul(x, Noise_Sub(Noise_Mul(x, _mm_set1_ps(6)), _mm_set1_ps(15))), _mm_set1_ps(10)));
+	v = Noise_Mul(Noise_Mul(Noise_Mul(y, y), y), Noise_Add(Noise_Mul(y, Noise_Sub(Noise_Mul(y, _mm_set1_ps(6)), _mm_set1_ps(15))), _mm_set1_ps(10)));
+	one = _mm_set1_ps(1);
+	x1  = Noise_Sub(x, one);
+	y1  = Noise_Sub(y, one);
+
+	g22 = Noise_Add(Noise_Mul(_mm_loadu_ps(gx22), x),  Noise_Mul(_mm_loadu_ps(gy22), y));
+	g12 = Noise_Add(Noise_Mul(_mm_loadu_ps(gx12), x1), Noise_Mul(_mm_loadu_ps(gy12), y));
+	c1  = Noise_Add(g22, Noise_Mul(u, Noise_Sub(g12, g22)));
+
+	g21 = Noise_Add(Noise_Mul(_mm_loadu_ps(gx21), x),  Noise_Mul(_mm_loadu_ps(gy21), y1));
+	g11 = Noise_Add(Noise_Mul(_mm_loadu_ps(gx11), x1), Noise_Mul(_mm_loadu_ps(gy11), y1));
+	c2  = Noise_Add(g21, Noise_Mul(u, Noise_Sub(g11, g21)));
+
+	_mm_storeu_ps(res, Noise_Add(c1, Noise_Mul(v, Noise_Sub(c2, c1))));
+}
+#endif
+
 
 struct OctaveNoise { cc_uint8 p[8][NOISE_TABLE_SIZE]; int octaves; };
 static void OctaveNoise_Init(struct OctaveNoise* n, RNGState* rnd, int octaves) {
@@ -205,17 +367,20 @@ static void OctaveNoise_Init(struct OctaveNoise* n, RNGState* rnd, int octaves)
 	}
 }
 
-static float OctaveNoise_Calc(const struct OctaveNoise* n, float x, float y) {
+static void OctaveNoise_Calc4(const struct OctaveNoise* n, const float* x, const float* y, float* sum) {
 	float amplitude = 1, freq = 1;
-	float sum = 0;
-	int i;
+	float xs[4], ys[4], res[4];
+	int i, j;
+	for (j = 0; j < 4; j++) sum[j] = 0;
 
 	for (i = 0; i < n->octaves; i++) {
-		sum += ImprovedNoise_Calc(n->p[i], x * freq, y * freq) * amplitude;
+		for (j = 0; j < 4; j++) { xs[j] = x[j] * freq; ys[j] = y[j] * freq; }
+		ImprovedNoise_Calc4(n->p[i], xs, ys, res);
+
+		for (j = 0; j < 4; j++) sum[j] += res[j] * amplitude;
 		amplitude *= 2.0f;
 		freq *= 0.5f;
 	}
-	return sum;
 }
 
 
@@ -225,9 +390,13 @@ static void CombinedNoise_Init(struct CombinedNoise* n, RNGState* rnd, int octav
 	OctaveNoise_Init(&n->noise2, rnd, octaves2);
 }
 
-static float CombinedNoise_Calc(const struct CombinedNoise* n, float x, float y) {
-	float offset = OctaveNoise_Calc(&n->noise2, x, y);
-	return OctaveNoise_Calc(&n->noise1, x + offset, y);
+static void CombinedNoise_Calc4(const struct CombinedNoise* n, const float* x, const float* y, float* res) {
+	float offset[4], xs[4];
+	int j;
+	OctaveNoise_Calc4(&n->noise2, x, y, offset);
+
+	for (j = 0; j < 4; j++) xs[j] = x[j] + offset[j];
+	OctaveNoise_Calc4(&n->noise1, xs, y, res);
 }
 
 
@@ -300,37 +469,62 @@ static void NotchyGen_FloodFill(int index, BlockRaw block) {
 }
 
 
-static void NotchyGen_CreateHeightmap(void) {
-	float hLow, hHigh, height;
-	int hIndex = 0, adjHeight;
-	int x, z;
-	struct CombinedNoise n1, n2;
-	struct OctaveNoise n3;
+/* Fills in the X coordinates of 4 columns starting at x, and the Z coordinate for each */
+static void NotchyGen_Columns4(int x, int z, float* xs, float* zs) {
+	int j;
+	for (j = 0; j < 4; j++) { xs[j] = (float)(x + j); zs[j] = (float)z; }
+}
 
-	CombinedNoise_Init(&n1, &rnd, 8, 8);
-	CombinedNoise_Init(&n2, &rnd, 8, 8);	
-	OctaveNoise_Init(&n3, &rnd, 6);
+static struct CombinedNoise heightNoise1, heightNoise2;
+static struct OctaveNoise   heightNoise3;
 
-	Gen_CurrentState = "Building heightmap";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
+static void NotchyGen_HeightmapSlab(int zBeg, int zEnd) {
+	float xs[4], zs[4], xs2[4], zs2[4];
+	float low[4], high[4], sel[4];
+	float hLow, hHigh, height;
+	int x, z, j;
+
+	/* Columns are calculated 4 at a time, with any extra columns past the end being discarded */
+	for (z = zBeg; z < zEnd; z++) {
+		for (x = 0; x < World.Width; x += 4) {
+			NotchyGen_Columns4(x, z, xs, zs);
+			for (j = 0; j < 4; j++) { xs2[j] = xs[j] * 1.3f; zs2[j] = zs[j] * 1.3f; }
+
+			CombinedNoise_Calc4(&heightNoise1, xs2, zs2, low);
+			OctaveNoise_Calc4(&heightNoise3,   xs,  zs,  sel);
+			if (sel[0] <= 0 || sel[1] <= 0 || sel[2] <= 0 || sel[3] <= 0) {
+				CombinedNoise_Calc4(&heightNoise2, xs2, zs2, high);
+			}
 
-		for (x = 0; x < World.Width; x++) {
-			hLow   = CombinedNoise_Calc(&n1, x * 1.3f, z * 1.3f) / 6 - 4;
-			height = hLow;
+			for (j = 0; j < 4 && x + j < World.Width; j++) {
+				hLow   = low[j] / 6 - 4;
+				height = hLow;
 
-			if (OctaveNoise_Calc(&n3, (float)x, (float)z) <= 0) {
-				hHigh = CombinedNoise_Calc(&n2, x * 1.3f, z * 1.3f) / 5 + 6;
-				height = max(hLow, hHigh);
+				if (sel[j] <= 0) {
+					hHigh  = high[j] / 5 + 6;
+					height = max(hLow, hHigh);
+				}
+
+				height *= 0.5f;
+				if (height < 0) height *= 0.8f;
+				heightmap[z * World.Width + x + j] = (int)(height + waterLevel);
 			}
+		}
+	}
+}
+
+static void NotchyGen_CreateHeightmap(void) {
+	int i, count = World.Width * World.Length;
 
-			height *= 0.5f;
-			if (height < 0) height *= 0.8f;
+	CombinedNoise_Init(&heightNoise1, &rnd, 8, 8);
+	CombinedNoise_Init(&heightNoise2, &rnd, 8, 8);	
+	OctaveNoise_Init(&heightNoise3,   &rnd, 6);
 
-			adjHeight = (int)(height + waterLevel);
-			minHeight = min(adjHeight, minHeight);
-			heightmap[hIndex++] = adjHeight;
-		}
+	Gen_CurrentState = "Building heightmap";
+	Gen_RunSlabs(NotchyGen_HeightmapSlab);
+
+	for (i = 0; i < count; i++) {
+		minHeight = min(heightmap[i], minHeight);
 	}
 }
 
@@ -363,43 +557,53 @@ static int NotchyGen_CreateStrataFast(void) {
 	return max(stoneHeight, 1);
 }
 
-static void NotchyGen_CreateStrata(void) {
-	int dirtThickness, dirtHeight;
-	int minStoneY, stoneHeight;
-	int hIndex = 0, maxY = World.MaxY, index = 0;
-	int x, y, z;
-	struct OctaveNoise n;
-
-	/* Try to bulk fill bottom of the map if possible */
-	minStoneY = NotchyGen_CreateStrataFast();
-	OctaveNoise_Init(&n, &rnd, 8);
-
-	Gen_CurrentState = "Creating strata";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
-
-		for (x = 0; x < World.Width; x++) {
-			dirtThickness = (int)(OctaveNoise_Calc(&n, (float)x, (float)z) / 24 - 4);
-			dirtHeight    = heightmap[hIndex++];
-			stoneHeight   = dirtHeight + dirtThickness;
-
-			stoneHeight = min(stoneHeight, maxY);
-			dirtHeight  = min(dirtHeight,  maxY);
+static struct OctaveNoise strataNoise;
+static int strataMinStoneY;
 
-			index = World_Pack(x, minStoneY, z);
-			for (y = minStoneY; y <= stoneHeight; y++) {
-				Gen_Blocks[index] = BLOCK_STONE; index += World.OneY;
-			}
+static void NotchyGen_StrataSlab(int zBeg, int zEnd) {
+	int dirtThickness, dirtHeight;
+	int minStoneY = strataMinStoneY, stoneHeight;
+	int maxY = World.MaxY, index;
+	float xs[4], zs[4], noise[4];
+	int x, y, z, j;
+
+	for (z = zBeg; z < zEnd; z++) {
+		for (x = 0; x < World.Width; x += 4) {
+			NotchyGen_Columns4(x, z, xs, zs);
+			OctaveNoise_Calc4(&strataNoise, xs, zs, noise);
+
+			for (j = 0; j < 4 && x + j < World.Width; j++) {
+				dirtThickness = (int)(noise[j] / 24 - 4);
+				dirtHeight    = heightmap[z * World.Width + x + j];
+				stoneHeight   = dirtHeight + dirtThickness;
+
+				stoneHeight = min(stoneHeight, maxY);
+				dirtHeight  = min(dirtHeight,  maxY);
+
+				index = World_Pack(x + j, minStoneY, z);
+				for (y = minStoneY; y <= stoneHeight; y++) {
+					Gen_Blocks[index] = BLOCK_STONE; index += World.OneY;
+				}
 
-			stoneHeight = max(stoneHeight, 0);
-			index = World_Pack(x, (stoneHeight + 1), z);
-			for (y = stoneHeight + 1; y <= dirtHeight; y++) {
-				Gen_Blocks[index] = BLOCK_DIRT; index += World.OneY;
+				stoneHeight = max(stoneHeight, 0);
+				index = World_Pack(x + j, (stoneHeight + 1), z);
+				for (y = stoneHeight + 1; y <= dirtHeight; y++) {
+					Gen_Blocks[index] = BLOCK_DIRT; index += World.OneY;
+				}
 			}
 		}
 	}
 }
 
+static void NotchyGen_CreateStrata(void) {
+	/* Try to bulk fill bottom of the map if possible */
+	strataMinStoneY = NotchyGen_CreateStrataFast();
+	OctaveNoise_Init(&strataNoise, &rnd, 8);
+
+	Gen_CurrentState = "Creating strata";
+	Gen_RunSlabs(NotchyGen_StrataSlab);
+}
+
 static void NotchyGen_CarveCaves(void) {
 	int cavesCount, caveLen;
 	float caveX, caveY, caveZ;
@@ -540,36 +744,59 @@ static void NotchyGen_FloodFillLava(void) {
 	}
 }
 
-static void NotchyGen_CreateSurfaceLayer(void) {	
-	int hIndex = 0, index;
-	BlockRaw above;
-	int x, y, z;
-	struct OctaveNoise n1, n2;
+static struct OctaveNoise sandNoise, gravelNoise;
 
-	OctaveNoise_Init(&n1, &rnd, 8);
-	OctaveNoise_Init(&n2, &rnd, 8);
+static void NotchyGen_SurfaceSlab(int zBeg, int zEnd) {
+	float xs[4], zs[4], sand[4], gravel[4];
+	BlockRaw above[4];
+	int index[4];
+	cc_bool anySand, anyGravel;
+	int x, y, z, j;
 
-	Gen_CurrentState = "Creating surface";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
+	for (z = zBeg; z < zEnd; z++) {
+		for (x = 0; x < World.Width; x += 4) {
+			anySand = false; anyGravel = false;
+
+			for (j = 0; j < 4; j++) {
+				above[j] = BLOCK_STONE;
+				if (x + j >= World.Width) continue;
+
+				y = heightmap[z * World.Width + x + j];
+				if (y < 0 || y >= World.Height) continue;
 
-		for (x = 0; x < World.Width; x++) {
-			y = heightmap[hIndex++];
-			if (y < 0 || y >= World.Height) continue;
+				index[j] = World_Pack(x + j, y, z);
+				above[j] = y >= World.MaxY ? BLOCK_AIR : Gen_Blocks[index[j] + World.OneY];
 
-			index = World_Pack(x, y, z);
-			above = y >= World.MaxY ? BLOCK_AIR : Gen_Blocks[index + World.OneY];
+				anyGravel |= above[j] == BLOCK_STILL_WATER;
+				anySand   |= above[j] == BLOCK_AIR && y <= waterLevel;
+			}
 
-			/* TODO: update heightmap */
-			if (above == BLOCK_STILL_WATER && (OctaveNoise_Calc(&n2, (float)x, (float)z) > 12)) {
-				Gen_Blocks[index] = BLOCK_GRAVEL;
-			} else if (above == BLOCK_AIR) {
-				Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(&n1, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
+			/* Noise is only needed by columns that might become gravel or sand */
+			NotchyGen_Columns4(x, z, xs, zs);
+			if (anyGravel) OctaveNoise_Calc4(&gravelNoise, xs, zs, gravel);
+			if (anySand)   OctaveNoise_Calc4(&sandNoise,   xs, zs, sand);
+
+			for (j = 0; j < 4; j++) {
+				/* TODO: update heightmap */
+				if (above[j] == BLOCK_STILL_WATER && gravel[j] > 12) {
+					Gen_Blocks[index[j]] = BLOCK_GRAVEL;
+				} else if (above[j] == BLOCK_AIR) {
+					y = heightmap[z * World.Width + x + j];
+					Gen_Blocks[index[j]] = (y <= waterLevel && sand[j] > 8) ? BLOCK_SAND : BLOCK_GRASS;
+				}
 			}
 		}
 	}
 }
 
+static void NotchyGen_CreateSurfaceLayer(void) {
+	OctaveNoise_Init(&sandNoise,   &rnd, 8);
+	OctaveNoise_Init(&gravelNoise, &rnd, 8);
+
+	Gen_CurrentState = "Creating surface";
+	Gen_RunSlabs(NotchyGen_SurfaceSlab);
+}
+
 static void NotchyGen_PlantFlowers(void) {
 	int numPatches;
 	BlockRaw block;
@@ -736,10 +963,15 @@ const struct MapGenerator NotchyGen = {
 *#########################################################################################################################*/
 BlockRaw* Tree_Blocks;
 RNGState* Tree_Rnd;
+#ifdef CC_BUILD_PALETTEDWORLD
+/* Tree_Blocks is NULL when growing trees in an already loaded world */
+#define Tree_GetBlock(x, y, z) (Tree_Blocks ? Tree_Blocks[World_Pack(x, y, z)] : (BlockRaw)World_GetBlock(x, y, z))
+#else
+#define Tree_GetBlock(x, y, z) Tree_Blocks[World_Pack(x, y, z)]
+#endif
 
 cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 	int baseHeight = treeHeight - 4;
-	int index;
 	int x, y, z;
 
 	/* check tree base */
@@ -748,8 +980,7 @@ cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 			for (x = treeX - 1; x <= treeX + 1; x++) {
 
 				if (!World_Contains(x, y, z)) return false;
-				index = World_Pack(x, y, z);
-				if (Tree_Blocks[index] != BLOCK_AIR) return false;
+				if (Tree_GetBlock(x, y, z) != BLOCK_AIR) return false;
 			}
 		}
 	}
@@ -760,8 +991,7 @@ cc_bool TreeGen_CanGrow(int treeX, int treeY, int treeZ, int treeHeight) {
 			for (x = treeX - 2; x <= treeX + 2; x++) {
 
 				if (!World_Contains(x, y, z)) return false;
-				index = World_Pack(x, y, z);
-				if (Tree_Blocks[index] != BLOCK_AIR) return false;
+				if (Tree_GetBlock(x, y, z) != BLOCK_AIR) return false;
 			}
 		}
 	}
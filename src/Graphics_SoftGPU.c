@@ -3,6 +3,10 @@
 #include "_GraphicsBase.h"
 #include "Errors.h"
 #include "Window.h"
+#if defined __SSE2__
+#include <emmintrin.h>
+#define SOFTGPU_SSE2
+#endif
 
 static cc_bool faceCulling;
 static int width, height; 
@@ -23,6 +27,13 @@ static cc_bool depthTest  = true;
 static cc_bool depthWrite = true;
 static GfxResourceID white_square;
 
+static void StartWorkers(void);
+static void StopWorkers(void);
+static void FlushTriangles(void);
+static void DiscardTriangles(void);
+static void FreeTileBins(void);
+static void FreeRasteriser(void);
+
 void Gfx_RestoreState(void) {
 	InitDefaultResources();
 
@@ -44,17 +55,21 @@ void Gfx_Create(void) {
 	Gfx.Created      = true;
 	
 	Gfx_RestoreState();
+	StartWorkers();
 }
 
 static void DestroyBuffers(void) {
+	FlushTriangles();
 	Window_FreeFramebuffer(&fb_bmp);
 	Mem_Free(depthBuffer);
 	depthBuffer = NULL;
 }
 
 void Gfx_Free(void) { 
+	StopWorkers();
 	Gfx_FreeState();
 	DestroyBuffers();
+	FreeRasteriser();
 }
 
 
@@ -66,6 +81,7 @@ typedef struct CCTexture {
 static CCTexture* curTexture;
 static BitmapCol* curTexPixels;
 static int curTexWidth, curTexHeight;
+static cc_bool drawStateDirty = true;
 		
 void Gfx_BindTexture(GfxResourceID texId) {
 	if (!texId) texId = white_square;
@@ -75,11 +91,16 @@ void Gfx_BindTexture(GfxResourceID texId) {
 	curTexPixels = tex->pixels;
 	curTexWidth  = tex->width;
 	curTexHeight = tex->height;
+	drawStateDirty = true;
 }
 		
 void Gfx_DeleteTexture(GfxResourceID* texId) {
 	GfxResourceID data = *texId;
-	if (data) Mem_Free(data);
+	if (!data) return;
+
+	/* Binned triangles might still reference the texture */
+	FlushTriangles();
+	Mem_Free(data);
 	*texId = NULL;
 }
 		
@@ -96,6 +117,7 @@ static GfxResourceID Gfx_AllocTexture(struct Bitmap* bmp, cc_uint8 flags, cc_boo
 void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, int rowWidth, cc_bool mipmaps) {
 	CCTexture* tex = (CCTexture*)texId;
 	cc_uint32* dst = (tex->pixels + x) + y * tex->width;
+	FlushTriangles();
 	CopyTextureData(dst, tex->width * 4, part, rowWidth << 2);
 }
 
@@ -111,11 +133,39 @@ void Gfx_DisableMipmaps(void) { }
 /*########################################################################################################################*
 *------------------------------------------------------State management---------------------------------------------------*
 *#########################################################################################################################*/
-void Gfx_SetFog(cc_bool enabled)    { }
-void Gfx_SetFogCol(PackedCol col)   { }
-void Gfx_SetFogDensity(float value) { }
-void Gfx_SetFogEnd(float value)     { }
-void Gfx_SetFogMode(FogFunc func)   { }
+static PackedCol gfx_fogColor;
+static float gfx_fogEnd = -1.0f, gfx_fogDensity = -1.0f;
+static int gfx_fogMode  = -1;
+
+void Gfx_SetFog(cc_bool enabled) {
+	gfx_fogEnabled = enabled;
+	drawStateDirty = true;
+}
+
+void Gfx_SetFogCol(PackedCol color) {
+	if (color == gfx_fogColor) return;
+	gfx_fogColor   = color;
+	drawStateDirty = true;
+}
+
+void Gfx_SetFogDensity(float value) { gfx_fogDensity = value; }
+void Gfx_SetFogEnd(float value)     { gfx_fogEnd     = value; }
+void Gfx_SetFogMode(FogFunc func)   { gfx_fogMode    = func;  }
+
+/* Calculates how much of the original colour remains after fog, same as fixed function OpenGL */
+/* NOTE: Like OpenGL, this is calculated per vertex then interpolated (perspective correctly) */
+static float CalcFog(float depth) {
+	float f;
+	if (gfx_fogMode == FOG_LINEAR) {
+		f = (gfx_fogEnd - depth) / gfx_fogEnd;
+	} else if (gfx_fogMode == FOG_EXP) {
+		f = (float)Math_Exp2(-gfx_fogDensity * depth * 1.44269504f);
+	} else {
+		f = gfx_fogDensity * depth;
+		f = (float)Math_Exp2(-f * f * 1.44269504f);
+	}
+	return max(0.0f, min(1.0f, f));
+}
 
 void Gfx_SetFaceCulling(cc_bool enabled) {
 	faceCulling = enabled;
@@ -123,19 +173,23 @@ void Gfx_SetFaceCulling(cc_bool enabled) {
 
 void Gfx_SetAlphaTest(cc_bool enabled) {
 	alphaTest = enabled;
+	drawStateDirty = true;
 }
 
 void Gfx_SetAlphaBlending(cc_bool enabled) {
 	alphaBlending = enabled;
+	drawStateDirty = true;
 }
 
 void Gfx_SetAlphaArgBlend(cc_bool enabled) { }
 
 void Gfx_Clear(void) {
 	int i, size = width * height;
+	/* Anything drawn before the clear would just be overwritten */
+	DiscardTriangles();
 
 	for (i = 0; i < size; i++) colorBuffer[i] = clearColor;
-	for (i = 0; i < size; i++) depthBuffer[i] = 1.0f;
+	for (i = 0; i < size; i++) depthBuffer[i] = 0.0f;
 }
 
 void Gfx_ClearCol(PackedCol color) {
@@ -149,16 +203,19 @@ void Gfx_ClearCol(PackedCol color) {
 
 void Gfx_SetDepthTest(cc_bool enabled) {
 	depthTest = enabled;
+	drawStateDirty = true;
 }
 
 void Gfx_SetDepthWrite(cc_bool enabled) {
 	depthWrite = enabled;
+	drawStateDirty = true;
 }
 
 void Gfx_SetColWriteMask(cc_bool r, cc_bool g, cc_bool b, cc_bool a) { }
 
 void Gfx_DepthOnlyRendering(cc_bool depthOnly) {
 	colWrite = !depthOnly;
+	drawStateDirty = true;
 }
 
 
@@ -282,145 +339,658 @@ typedef struct Vector4 { float X, Y, Z, W; } Vector4;
 typedef struct Vector3 { float X, Y, Z; } Vector3;
 typedef struct Vector2 { float X, Y; } Vector2;
 
-static void TransformVertex(int index, Vector4* frag, Vector2* uv, PackedCol* color) {
-	// TODO: avoid the multiply, just add down in DrawTriangles
+/* Triangles are first transformed, clipped and set up, then binned into the screen tiles they overlap. */
+/* The tiles are rasterised later (at the end of the frame, or when a texture is about to change), */
+/*  with each tile drawn by only one thread. Within a tile, triangles are drawn in submission order. */
+#define TILE_SHIFT 6
+#define TILE_SIZE  (1 << TILE_SHIFT)
+/* Max triangles binned before they are rasterised, to bound memory usage */
+#define MAX_BINNED_TRIS 32768
+/* Vertices too far outside the viewport are clipped, so screen coordinates stay small enough for floats */
+#define GUARD_BAND 16.0f
+
+/* State that affects how pixels of a triangle are drawn */
+typedef struct DrawState {
+	BitmapCol* texPixels;
+	int texWidth, texHeight, texShift;
+	cc_bool textured, alphaTest, alphaBlending;
+	cc_bool depthTest, depthWrite, colWrite;
+	cc_bool fog;
+	BitmapCol fogColor;
+} DrawState;
+
+/* A triangle ready to be rasterised, with all values being linear functions of screen position */
+/*  i.e. value(x, y) = A * x + B * y + C, evaluated at pixel centres */
+typedef struct BinnedTriangle {
+	int minX, minY, maxX, maxY;
+	float edgeA[3], edgeB[3], edgeC[3];
+	float edgeMin[3]; /* 0 for top-left edges, otherwise tiny bias so pixels on the edge are excluded */
+	float zA, zB, zC; /* 1/W */
+	float uA, uB, uC; /* U/W */
+	float vA, vB, vC; /* V/W */
+	float fogA, fogB, fogC; /* fog factor/W */
+	BitmapCol color;
+	int state;
+} BinnedTriangle;
+
+typedef struct TileBin { int* tris; int count, capacity; } TileBin;
+
+typedef struct ClipVertex { float x, y, z, w, u, v; } ClipVertex;
+
+static BinnedTriangle* binnedTris;
+static int binnedTrisCount;
+static DrawState* drawStates;
+static int drawStatesCount, drawStatesCapacity;
+
+static TileBin* tileBins;
+static int tilesX, tilesY, tilesCount;
+
+static void TransformVertex(int index, ClipVertex* vertex, PackedCol* color) {
 	char* ptr = (char*)gfx_vertices + index * gfx_stride;
 	Vector3* pos = (Vector3*)ptr;
 
-	Vector4 coord;
-	coord.X = pos->X * mvp.row1.X + pos->Y * mvp.row2.X + pos->Z * mvp.row3.X + mvp.row4.X;
-	coord.Y = pos->X * mvp.row1.Y + pos->Y * mvp.row2.Y + pos->Z * mvp.row3.Y + mvp.row4.Y;
-	coord.Z = pos->X * mvp.row1.Z + pos->Y * mvp.row2.Z + pos->Z * mvp.row3.Z + mvp.row4.Z;
-	coord.W = pos->X * mvp.row1.W + pos->Y * mvp.row2.W + pos->Z * mvp.row3.W + mvp.row4.W;
-
-	frag->X = vp_hwidth  * (1 + coord.X / coord.W);
-	frag->Y = vp_hheight * (1 - coord.Y / coord.W);
-	frag->Z = coord.Z / coord.W;
-	frag->W = 1.0f    / coord.W;
+	vertex->x = pos->X * mvp.row1.X + pos->Y * mvp.row2.X + pos->Z * mvp.row3.X + mvp.row4.X;
+	vertex->y = pos->X * mvp.row1.Y + pos->Y * mvp.row2.Y + pos->Z * mvp.row3.Y + mvp.row4.Y;
+	vertex->z = pos->X * mvp.row1.Z + pos->Y * mvp.row2.Z + pos->Z * mvp.row3.Z + mvp.row4.Z;
+	vertex->w = pos->X * mvp.row1.W + pos->Y * mvp.row2.W + pos->Z * mvp.row3.W + mvp.row4.W;
 
 	if (gfx_format != VERTEX_FORMAT_TEXTURED) {
 		struct VertexColoured* v = (struct VertexColoured*)ptr;
-		*color = v->Col;
+		*color    = v->Col;
+		vertex->u = 0; vertex->v = 0;
 	} else {
 		struct VertexTextured* v = (struct VertexTextured*)ptr;
-		*color = v->Col;
-		uv->X  = v->U + texOffsetX;
-		uv->Y  = v->V + texOffsetY;
+		*color    = v->Col;
+		vertex->u = v->U + texOffsetX;
+		vertex->v = v->V + texOffsetY;
 	}
 }
 	
-static int MultiplyColours(PackedCol vColor, BitmapCol tColor) {
-	int a1 = PackedCol_A(vColor), a2 = BitmapCol_A(tColor);
-	int a  = ( a1 * a2 ) / 255;
-	int r1 = PackedCol_R(vColor), r2 = BitmapCol_R(tColor);
-	int r  = ( r1 * r2 ) / 255;
-	int g1 = PackedCol_G(vColor), g2 = BitmapCol_G(tColor);
-	int g  = ( g1 * g2 ) / 255;
-	int b1 = PackedCol_B(vColor), b2 = BitmapCol_B(tColor);
-	int b  = ( b1 * b2 ) / 255;
-	return PackedCol_Make(r, g, b, a);
-}
-
-static void DrawTriangle(Vector4 frag1, Vector4 frag2, Vector4 frag3,
-						Vector2 uv1, Vector2 uv2, Vector2 uv3, PackedCol color) {
-	int x1 = (int)frag1.X, y1 = (int)frag1.Y;
-	int x2 = (int)frag2.X, y2 = (int)frag2.Y;
-	int x3 = (int)frag3.X, y3 = (int)frag3.Y;
-	int minX = min(x1, min(x2, x3));
-	int minY = min(y1, min(y2, y3));
-	int maxX = max(x1, max(x2, x3));
-	int maxY = max(y1, max(y2, y3));
-
-	// TODO backface culling
-
-	// Reject triangles completely outside
-	if (minX < 0 && maxX < 0 || minX >= width  && maxX >= width ) return;
-	if (minY < 0 && maxY < 0 || minY >= height && maxY >= height) return;
-
-	// Perform scissoring
-	//minX = max(minX, 0); maxX = min(maxX, sc_maxX);
-	//minY = max(minY, 0); maxY = min(maxY, sc_maxY);
-	// TODO why doesn't this work 
-
-	// NOTE: W in frag variables below is actually 1/W 
-
-	float factor = 1.0f / ((y2 - y3) * (x1 - x3) + (x3 - x2) * (y1 - y3));
-	for (int y = minY; y <= maxY; y++) {
-		for (int x = minX; x <= maxX; x++) {
-			if (x < 0 || y < 0 || x >= width || y >= height) return;
-
-			float ic0 = ((y2 - y3) * (x - x3) + (x3 - x2) * (y - y3)) * factor;
-			if (ic0 < 0 || ic0 > 1) continue;
-			float ic1 = ((y3 - y1) * (x - x3) + (x1 - x3) * (y - y3)) * factor;
-			if (ic1 < 0 || ic1 > 1) continue;
-			float ic2 = 1.0f - ic0 - ic1;
-			if (ic2 < 0 || ic2 > 1) continue;
-
-			int index = y * width + x;
-			float w = 1 / (ic0 * frag1.W + ic1 * frag2.W + ic2 * frag3.W);
-
-			if (depthTest && w <= depthBuffer[index]) continue;
-			if (depthWrite) depthBuffer[index] = w;
-			if (!colWrite)  continue;
-
-			PackedCol fragColor = color;
-			if (gfx_format == VERTEX_FORMAT_TEXTURED) {
-				float u = (ic0 * uv1.X * frag1.W + ic1 * uv2.X * frag2.W + ic2 * uv3.X * frag3.W) * w;
-				float v = (ic0 * uv1.Y * frag1.W + ic1 * uv2.Y * frag2.W + ic2 * uv3.Y * frag3.W) * w;
-				int texX = (int)(Math_AbsF(u - Math_Floor(u)) * curTexWidth);
-				int texY = (int)(Math_AbsF(v - Math_Floor(v)) * curTexHeight);
-				int texIndex = texY * curTexWidth + texX;
-
-				fragColor = MultiplyColours(fragColor, curTexPixels[texIndex]);
-			}
+/*########################################################################################################################*
+*----------------------------------------------------------Binning--------------------------------------------------------*
+*#########################################################################################################################*/
+static void DiscardTriangles(void) {
+	for (int i = 0; i < tilesCount; i++) tileBins[i].count = 0;
+	binnedTrisCount = 0;
+	drawStatesCount = 0;
+	drawStateDirty  = true;
+}
+
+static void FreeTileBins(void) {
+	for (int i = 0; i < tilesCount; i++) Mem_Free(tileBins[i].tris);
+	Mem_Free(tileBins);
+	tileBins   = NULL;
+	tilesCount = 0;
+}
 
-			int R = PackedCol_R(fragColor);
-			int G = PackedCol_G(fragColor);
-			int B = PackedCol_B(fragColor);
-			int A = PackedCol_A(fragColor);
+static void FreeRasteriser(void) {
+	FreeTileBins();
+	Mem_Free(binnedTris);
+	Mem_Free(drawStates);
 
-			if (alphaBlending) {
-				PackedCol dst = colorBuffer[index];
-				int dstR = BitmapCol_R(dst);
-				int dstG = BitmapCol_G(dst);
-				int dstB = BitmapCol_B(dst);
+	binnedTris = NULL;
+	drawStates = NULL;
+	drawStatesCapacity = 0;
+}
 
-				R = (R * A) / 255 + (dstR * (255 - A)) / 255;
-				G = (G * A) / 255 + (dstG * (255 - A)) / 255;
-				B = (B * A) / 255 + (dstB * (255 - A)) / 255;
+static void AllocTileBins(void) {
+	tilesX     = (width  + TILE_SIZE - 1) >> TILE_SHIFT;
+	tilesY     = (height + TILE_SIZE - 1) >> TILE_SHIFT;
+	tilesCount = tilesX * tilesY;
+	tileBins   = (TileBin*)Mem_AllocCleared(tilesCount, sizeof(TileBin), "tile bins");
+
+	if (!binnedTris) binnedTris = (BinnedTriangle*)Mem_Alloc(MAX_BINNED_TRIS, sizeof(BinnedTriangle), "binned triangles");
+}
+
+static int CurrentDrawState(void) {
+	DrawState* st;
+	if (!drawStateDirty) return drawStatesCount - 1;
+
+	if (drawStatesCount == drawStatesCapacity) {
+		drawStatesCapacity = max(64, drawStatesCapacity * 2);
+		drawStates = (DrawState*)Mem_Realloc(drawStates, drawStatesCapacity, sizeof(DrawState), "draw states");
+	}
+	st = &drawStates[drawStatesCount++];
+
+	st->texPixels     = curTexPixels;
+	st->texWidth      = curTexWidth;
+	st->texHeight     = curTexHeight;
+	st->texShift      = Math_ilog2(curTexWidth);
+	st->textured      = gfx_format == VERTEX_FORMAT_TEXTURED;
+	st->alphaTest     = alphaTest;
+	st->alphaBlending = alphaBlending;
+	st->depthTest     = depthTest;
+	st->depthWrite    = depthWrite;
+	st->colWrite      = colWrite;
+	st->fog           = gfx_fogEnabled;
+	st->fogColor      = BitmapCol_Make(PackedCol_R(gfx_fogColor), PackedCol_G(gfx_fogColor), PackedCol_B(gfx_fogColor), 0);
+
+	drawStateDirty = false;
+	return drawStatesCount - 1;
+}
+
+static void BinTriangle(int index) {
+	BinnedTriangle* tri = &binnedTris[index];
+	int x1 = tri->minX >> TILE_SHIFT, y1 = tri->minY >> TILE_SHIFT;
+	int x2 = tri->maxX >> TILE_SHIFT, y2 = tri->maxY >> TILE_SHIFT;
+
+	for (int y = y1; y <= y2; y++) {
+		for (int x = x1; x <= x2; x++) {
+			TileBin* bin = &tileBins[y * tilesX + x];
+
+			if (bin->count == bin->capacity) {
+				bin->capacity = max(256, bin->capacity * 2);
+				bin->tris = (int*)Mem_Realloc(bin->tris, bin->capacity, 4, "tile bin");
 			}
-			if (alphaTest && A < 0x80) continue;
+			bin->tris[bin->count++] = index;
+		}
+	}
+}
+
+/* Whether the edge from a to b is a top or left edge, for a clockwise (on screen) triangle */
+#define IsTopLeftEdge(A, B) ((A) > 0 || ((A) == 0 && (B) > 0))
+
+static void SetupTriangle(const ClipVertex* v0, const ClipVertex* v1, const ClipVertex* v2, PackedCol color) {
+	float x0, y0, x1, y1, x2, y2, area, invArea;
+	float z0, z1, z2, u0, u1, u2, w0, w1, w2;
+	const ClipVertex* tmp;
+	BinnedTriangle* tri;
+
+	/* Project into screen space */
+	x0 = vp_hwidth * (1 + v0->x / v0->w); y0 = vp_hheight * (1 - v0->y / v0->w);
+	x1 = vp_hwidth * (1 + v1->x / v1->w); y1 = vp_hheight * (1 - v1->y / v1->w);
+	x2 = vp_hwidth * (1 + v2->x / v2->w); y2 = vp_hheight * (1 - v2->y / v2->w);
+
+	area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+	/* Front faces are counter clockwise in clip space, but Y is flipped in screen space */
+	if (faceCulling && area > 0) return;
+	if (area == 0) return;
+
+	/* Make all triangles clockwise on screen */
+	if (area < 0) {
+		tmp = v1; v1 = v2; v2 = tmp;
+		x1 = vp_hwidth * (1 + v1->x / v1->w); y1 = vp_hheight * (1 - v1->y / v1->w);
+		x2 = vp_hwidth * (1 + v2->x / v2->w); y2 = vp_hheight * (1 - v2->y / v2->w);
+		area = -area;
+	}
+
+	int minX = Math_Floor(min(x0, min(x1, x2)));
+	int minY = Math_Floor(min(y0, min(y1, y2)));
+	int maxX = Math_Ceil(max(x0, max(x1, x2)));
+	int maxY = Math_Ceil(max(y0, max(y1, y2)));
+
+	/* Reject triangles completely outside */
+	if (maxX < 0 || minX > sc_maxX || maxY < 0 || minY > sc_maxY) return;
+	if (binnedTrisCount == MAX_BINNED_TRIS) FlushTriangles();
+
+	tri = &binnedTris[binnedTrisCount];
+	tri->minX  = max(minX, 0); tri->maxX = min(maxX, sc_maxX);
+	tri->minY  = max(minY, 0); tri->maxY = min(maxY, sc_maxY);
+	tri->color = BitmapCol_Make(PackedCol_R(color), PackedCol_G(color), PackedCol_B(color), PackedCol_A(color));
+	tri->state = CurrentDrawState();
+
+	/* Edge functions, where edge i is opposite vertex i */
+	tri->edgeA[0] = y1 - y2; tri->edgeB[0] = x2 - x1; tri->edgeC[0] = -(tri->edgeA[0] * x1 + tri->edgeB[0] * y1);
+	tri->edgeA[1] = y2 - y0; tri->edgeB[1] = x0 - x2; tri->edgeC[1] = -(tri->edgeA[1] * x2 + tri->edgeB[1] * y2);
+	tri->edgeA[2] = y0 - y1; tri->edgeB[2] = x1 - x0; tri->edgeC[2] = -(tri->edgeA[2] * x0 + tri->edgeB[2] * y0);
+
+	for (int i = 0; i < 3; i++) {
+		tri->edgeMin[i] = IsTopLeftEdge(tri->edgeA[i], tri->edgeB[i]) ? 0.0f : 1e-30f;
+	}
+
+	/* Barycentric weight of vertex i is edge[i] / area, so attributes are linear in screen space too */
+	/* 1/W, U/W and V/W are interpolated, which gives perspective correct texturing */
+	invArea = 1.0f / area;
+	w0 = 1.0f / v0->w; w1 = 1.0f / v1->w; w2 = 1.0f / v2->w;
+
+#define SetupPlane(a, b, c, val0, val1, val2) \
+	a = (tri->edgeA[0] * val0 + tri->edgeA[1] * val1 + tri->edgeA[2] * val2) * invArea;\
+	b = (tri->edgeB[0] * val0 + tri->edgeB[1] * val1 + tri->edgeB[2] * val2) * invArea;\
+	c = (tri->edgeC[0] * val0 + tri->edgeC[1] * val1 + tri->edgeC[2] * val2) * invArea;
+
+	z0 = w0; z1 = w1; z2 = w2;
+	SetupPlane(tri->zA, tri->zB, tri->zC, z0, z1, z2);
+	u0 = v0->u * w0; u1 = v1->u * w1; u2 = v2->u * w2;
+	SetupPlane(tri->uA, tri->uB, tri->uC, u0, u1, u2);
+	u0 = v0->v * w0; u1 = v1->v * w1; u2 = v2->v * w2;
+	SetupPlane(tri->vA, tri->vB, tri->vC, u0, u1, u2);
+
+	if (gfx_fogEnabled) {
+		u0 = CalcFog(v0->w) * w0; u1 = CalcFog(v1->w) * w1; u2 = CalcFog(v2->w) * w2;
+		SetupPlane(tri->fogA, tri->fogB, tri->fogC, u0, u1, u2);
+	}
+
+	BinTriangle(binnedTrisCount++);
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------Clipping-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Signed distance from each clip plane, where >= 0 is inside */
+static float ClipDistance(const ClipVertex* v, int plane) {
+	switch (plane) {
+	case 0: return v->z + v->w; /* near plane */
+	case 1: return GUARD_BAND * v->w - v->x;
+	case 2: return GUARD_BAND * v->w + v->x;
+	case 3: return GUARD_BAND * v->w - v->y;
+	}
+	return GUARD_BAND * v->w + v->y;
+}
+#define CLIP_PLANES 5
+
+static int ClipPolygon(ClipVertex* src, int count, ClipVertex* dst, int plane) {
+	int i, n = 0;
+
+	for (i = 0; i < count; i++) {
+		ClipVertex* a = &src[i];
+		ClipVertex* b = &src[(i + 1) % count];
+		float da = ClipDistance(a, plane);
+		float db = ClipDistance(b, plane);
+
+		if (da >= 0) dst[n++] = *a;
+		if ((da >= 0) == (db >= 0)) continue;
+
+		/* Edge crosses the plane, so add the intersection point */
+		float t = da / (da - db);
+		dst[n].x = a->x + (b->x - a->x) * t;
+		dst[n].y = a->y + (b->y - a->y) * t;
+		dst[n].z = a->z + (b->z - a->z) * t;
+		dst[n].w = a->w + (b->w - a->w) * t;
+		dst[n].u = a->u + (b->u - a->u) * t;
+		dst[n].v = a->v + (b->v - a->v) * t;
+		n++;
+	}
+	return n;
+}
+
+static void DrawTriangle(ClipVertex* v0, ClipVertex* v1, ClipVertex* v2, PackedCol color) {
+	ClipVertex bufferA[3 + CLIP_PLANES], bufferB[3 + CLIP_PLANES];
+	ClipVertex* src = bufferA;
+	ClipVertex* dst = bufferB;
+	ClipVertex* tmp;
+	int plane, outside = 0, count = 3;
+
+	for (plane = 0; plane < CLIP_PLANES; plane++) {
+		int out = 0;
+		if (ClipDistance(v0, plane) < 0) out++;
+		if (ClipDistance(v1, plane) < 0) out++;
+		if (ClipDistance(v2, plane) < 0) out++;
+
+		if (out == 3) return; /* Completely outside this plane */
+		if (out) outside |= 1 << plane;
+	}
+
+	if (!outside) { SetupTriangle(v0, v1, v2, color); return; }
+	src[0] = *v0; src[1] = *v1; src[2] = *v2;
+
+	for (plane = 0; plane < CLIP_PLANES; plane++) {
+		if (!(outside & (1 << plane))) continue;
+		count = ClipPolygon(src, count, dst, plane);
+		if (count < 3) return;
+		tmp = src; src = dst; dst = tmp;
+	}
+
+	for (int i = 1; i < count - 1; i++) {
+		SetupTriangle(&src[0], &src[i], &src[i + 1], color);
+	}
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Rasterising------------------------------------------------------*
+*#########################################################################################################################*/
+/* Pixels are shaded in blocks of 4 horizontally adjacent pixels, using SSE2 when available. */
+/* The scalar path performs exactly the same arithmetic per pixel, so both produce identical output. */
+/* NOTE: x * y / 255 is computed as (p + 1 + (p >> 8)) >> 8 where p = x * y, which is exact for 8 bit x and y */
+#define Div255(p) (((p) + 1 + ((p) >> 8)) >> 8)
+
+typedef struct RowSetup {
+	float e0, e1, e2, z, uw, vw, fw; /* values at x = 0 for this row */
+} RowSetup;
+
+static int BlendChannels(BitmapCol src, BitmapCol srcFactor, BitmapCol dst, BitmapCol dstFactor) {
+	int r = Div255(BitmapCol_R(src) * BitmapCol_R(srcFactor)) + Div255(BitmapCol_R(dst) * BitmapCol_R(dstFactor));
+	int g = Div255(BitmapCol_G(src) * BitmapCol_G(srcFactor)) + Div255(BitmapCol_G(dst) * BitmapCol_G(dstFactor));
+	int b = Div255(BitmapCol_B(src) * BitmapCol_B(srcFactor)) + Div255(BitmapCol_B(dst) * BitmapCol_B(dstFactor));
+	int a = Div255(BitmapCol_A(src) * BitmapCol_A(srcFactor)) + Div255(BitmapCol_A(dst) * BitmapCol_A(dstFactor));
+	return BitmapCol_Make(r, g, b, a);
+}
+
+/* Copies an 8 bit value into all 4 channels */
+#define REPLICATE(x)  ((x) * 0x01010101U)
+#define RGB_ONLY(col) ((col) & ~BITMAPCOLOR_A_MASK)
+
+static void ShadePixel(const BinnedTriangle* tri, const DrawState* st, const RowSetup* row, int x, int index) {
+	float px = x + 0.5f;
+	BitmapCol col, factor;
+	float z, w, u, v, t;
+	int texX, texY, a, f;
+
+	if (row->e0 + tri->edgeA[0] * px < tri->edgeMin[0]) return;
+	if (row->e1 + tri->edgeA[1] * px < tri->edgeMin[1]) return;
+	if (row->e2 + tri->edgeA[2] * px < tri->edgeMin[2]) return;
+
+	/* Depth buffer stores 1/W, so nearer pixels have larger values */
+	z = row->z + tri->zA * px;
+	if (st->depthTest && z < depthBuffer[index]) return;
+	w   = (st->textured || st->fog) ? 1.0f / z : 0.0f;
+	col = tri->color;
+
+	if (st->textured) {
+		u = (row->uw + tri->uA * px) * w;
+		v = (row->vw + tri->vA * px) * w;
+
+		t = (float)(int)u; if (t > u) t -= 1.0f;
+		texX = (int)((u - t) * st->texWidth)  & (st->texWidth  - 1);
+		t = (float)(int)v; if (t > v) t -= 1.0f;
+		texY = (int)((v - t) * st->texHeight) & (st->texHeight - 1);
+
+		col = BlendChannels(col, st->texPixels[(texY << st->texShift) + texX], 0, 0);
+	}
+	if (st->alphaTest && BitmapCol_A(col) < 0x80) return;
+
+	if (st->fog) {
+		f = (int)(max(0.0f, min(1.0f, (row->fw + tri->fogA * px) * w)) * 255.0f);
+		factor = RGB_ONLY(REPLICATE(f)) | BITMAPCOLOR_A_MASK;
+		col    = BlendChannels(col, factor, st->fogColor, RGB_ONLY(REPLICATE(255 - f)));
+	}
 
-			colorBuffer[index] = BitmapCol_Make(R, G, B, 0xFF);
+	if (st->depthWrite) depthBuffer[index] = z;
+	if (!st->colWrite)  return;
+
+	if (st->alphaBlending) {
+		a   = BitmapCol_A(col);
+		col = BlendChannels(col, REPLICATE(a), colorBuffer[index], REPLICATE(255 - a));
+	}
+	colorBuffer[index] = col | BITMAPCOLOR_A_MASK;
+}
+
+#if defined SOFTGPU_SSE2
+/* Computes x * y / 255 for each 8 bit channel */
+static CC_INLINE __m128i MulDiv255(__m128i x, __m128i y) {
+	__m128i zero = _mm_setzero_si128(), one = _mm_set1_epi16(1);
+	__m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(x, zero), _mm_unpacklo_epi8(y, zero));
+	__m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(x, zero), _mm_unpackhi_epi8(y, zero));
+
+	lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+	hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+	return _mm_packus_epi16(lo, hi);
+}
+
+/* Copies the low byte of each 32 bit lane into all 4 bytes of that lane */
+static CC_INLINE __m128i Replicate(__m128i x) {
+	x = _mm_or_si128(x, _mm_slli_epi32(x, 8));
+	return _mm_or_si128(x, _mm_slli_epi32(x, 16));
+}
+
+/* Floors and wraps texture coordinates to [0, size) */
+static CC_INLINE __m128i WrapCoords(__m128 coord, float size, int mask) {
+	__m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(coord));
+	t = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, coord), _mm_set1_ps(1.0f)));
+	
+	coord = _mm_mul_ps(_mm_sub_ps(coord, t), _mm_set1_ps(size));
+	return _mm_and_si128(_mm_cvttps_epi32(coord), _mm_set1_epi32(mask));
+}
+
+static void ShadeBlock(const BinnedTriangle* tri, const DrawState* st, const RowSetup* row, int x, int index) {
+	__m128 px = _mm_add_ps(_mm_set1_ps(x + 0.5f), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+	__m128 mask, z, w, u, v, f, oldZ;
+	__m128i col, factor, dst, imask, a, texX, texY;
+	int texIndex[4];
+	BitmapCol* tex;
+
+	mask = _mm_cmpge_ps(_mm_add_ps(_mm_set1_ps(row->e0), _mm_mul_ps(_mm_set1_ps(tri->edgeA[0]), px)), _mm_set1_ps(tri->edgeMin[0]));
+	mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_set1_ps(row->e1), _mm_mul_ps(_mm_set1_ps(tri->edgeA[1]), px)), _mm_set1_ps(tri->edgeMin[1])));
+	mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_set1_ps(row->e2), _mm_mul_ps(_mm_set1_ps(tri->edgeA[2]), px)), _mm_set1_ps(tri->edgeMin[2])));
+	if (!_mm_movemask_ps(mask)) return;
+
+	/* Depth buffer stores 1/W, so nearer pixels have larger values */
+	z    = _mm_add_ps(_mm_set1_ps(row->z), _mm_mul_ps(_mm_set1_ps(tri->zA), px));
+	oldZ = _mm_loadu_ps(&depthBuffer[index]);
+	if (st->depthTest) {
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(z, oldZ));
+		if (!_mm_movemask_ps(mask)) return;
+	}
+	w   = _mm_div_ps(_mm_set1_ps(1.0f), z);
+	col = _mm_set1_epi32(tri->color);
+
+	if (st->textured) {
+		u = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(row->uw), _mm_mul_ps(_mm_set1_ps(tri->uA), px)), w);
+		v = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(row->vw), _mm_mul_ps(_mm_set1_ps(tri->vA), px)), w);
+
+		texX = WrapCoords(u, (float)st->texWidth,  st->texWidth  - 1);
+		texY = WrapCoords(v, (float)st->texHeight, st->texHeight - 1);
+		_mm_storeu_si128((__m128i*)texIndex, _mm_add_epi32(_mm_sll_epi32(texY, _mm_cvtsi32_si128(st->texShift)), texX));
+
+		tex = st->texPixels;
+		col = MulDiv255(col, _mm_setr_epi32(tex[texIndex[0]], tex[texIndex[1]], tex[texIndex[2]], tex[texIndex[3]]));
+	}
+	imask = _mm_castps_si128(mask);
+
+	if (st->alphaTest) {
+		a     = _mm_and_si128(_mm_srli_epi32(col, BITMAPCOLOR_A_SHIFT), _mm_set1_epi32(0xFF));
+		imask = _mm_and_si128(imask, _mm_cmpgt_epi32(a, _mm_set1_epi32(0x7F)));
+		if (!_mm_movemask_epi8(imask)) return;
+	}
+
+	if (st->fog) {
+		f = _mm_add_ps(_mm_set1_ps(row->fw), _mm_mul_ps(_mm_set1_ps(tri->fogA), px));
+		f = _mm_max_ps(_mm_set1_ps(0.0f), _mm_min_ps(_mm_set1_ps(1.0f), _mm_mul_ps(f, w)));
+		factor = Replicate(_mm_cvttps_epi32(_mm_mul_ps(f, _mm_set1_ps(255.0f))));
+
+		col = _mm_add_epi8(
+			MulDiv255(col, _mm_or_si128(factor, _mm_set1_epi32(BITMAPCOLOR_A_MASK))),
+			MulDiv255(_mm_set1_epi32(st->fogColor), _mm_andnot_si128(factor, _mm_set1_epi32(RGB_ONLY(~0U)))));
+	}
+
+	if (st->depthWrite) {
+		z = _mm_or_ps(_mm_and_ps(_mm_castsi128_ps(imask), z), _mm_andnot_ps(_mm_castsi128_ps(imask), oldZ));
+		_mm_storeu_ps(&depthBuffer[index], z);
+	}
+	if (!st->colWrite) return;
+	dst = _mm_loadu_si128((__m128i*)&colorBuffer[index]);
+
+	if (st->alphaBlending) {
+		a   = Replicate(_mm_and_si128(_mm_srli_epi32(col, BITMAPCOLOR_A_SHIFT), _mm_set1_epi32(0xFF)));
+		col = _mm_add_epi8(MulDiv255(col, a), MulDiv255(dst, _mm_xor_si128(a, _mm_set1_epi32(-1))));
+	}
+	col = _mm_or_si128(col, _mm_set1_epi32(BITMAPCOLOR_A_MASK));
+	col = _mm_or_si128(_mm_and_si128(imask, col), _mm_andnot_si128(imask, dst));
+	_mm_storeu_si128((__m128i*)&colorBuffer[index], col);
+}
+#endif
+
+static void RasteriseTriangle(const BinnedTriangle* tri, int tileX, int tileY) {
+	const DrawState* st = &drawStates[tri->state];
+	int x1 = max(tri->minX, tileX), x2 = min(tri->maxX, tileX + TILE_SIZE - 1);
+	int y1 = max(tri->minY, tileY), y2 = min(tri->maxY, tileY + TILE_SIZE - 1);
+	RowSetup row;
+	int x;
+
+	for (int y = y1; y <= y2; y++) {
+		float py = y + 0.5f;
+		int index = y * width;
+
+		row.e0 = tri->edgeB[0] * py + tri->edgeC[0];
+		row.e1 = tri->edgeB[1] * py + tri->edgeC[1];
+		row.e2 = tri->edgeB[2] * py + tri->edgeC[2];
+		row.z  = tri->zB   * py + tri->zC;
+		row.uw = tri->uB   * py + tri->uC;
+		row.vw = tri->vB   * py + tri->vC;
+		row.fw = tri->fogB * py + tri->fogC;
+		x = x1;
+
+#if defined SOFTGPU_SSE2
+		/* Blocks are only used when all 4 pixels are inside the triangle's bounds */
+		for (; x + 3 <= x2; x += 4) {
+			ShadeBlock(tri, st, &row, x, index + x);
+		}
+#endif
+		for (; x <= x2; x++) {
+			ShadePixel(tri, st, &row, x, index + x);
+		}
+	}
+}
+
+static void RasteriseTile(int tile) {
+	TileBin* bin = &tileBins[tile];
+	int tileX = (tile % tilesX) << TILE_SHIFT;
+	int tileY = (tile / tilesX) << TILE_SHIFT;
+
+	for (int i = 0; i < bin->count; i++) {
+		RasteriseTriangle(&binnedTris[bin->tris[i]], tileX, tileY);
+	}
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Rasteriser threads--------------------------------------------------*
+*#########################################################################################################################*/
+/* Cooperatively threaded platforms can't rasterise in parallel */
+#if !defined CC_BUILD_COOPTHREADED
+#define MAX_RASTER_WORKERS 16
+static void* workerThreads[MAX_RASTER_WORKERS];
+static void* workerWaitables[MAX_RASTER_WORKERS];
+static int workersCount, workersStarted, busyWorkers, nextTile;
+static void* workersMutex;
+static void* workersDone;
+static volatile cc_bool workersStop;
+
+/* Rasterises tiles until there are none left, shared between the main thread and worker threads */
+static void RasteriseTiles(void) {
+	int tile;
+
+	for (;;) {
+		Mutex_Lock(workersMutex);
+		{
+			tile = nextTile++;
 		}
+		Mutex_Unlock(workersMutex);
+
+		if (tile >= tilesCount) return;
+		if (tileBins[tile].count) RasteriseTile(tile);
 	}
 }
 
+static void RasterWorker_Run(void) {
+	int id;
+	Mutex_Lock(workersMutex);
+	{
+		id = workersStarted++;
+	}
+	Mutex_Unlock(workersMutex);
+
+	for (;;) {
+		Waitable_Wait(workerWaitables[id]);
+		if (workersStop) return;
+		RasteriseTiles();
+
+		Mutex_Lock(workersMutex);
+		{
+			busyWorkers--;
+		}
+		Mutex_Unlock(workersMutex);
+		Waitable_Signal(workersDone);
+	}
+}
+
+static void FlushTriangles(void) {
+	int i, busy;
+	if (!binnedTrisCount) return;
+
+	if (!workersCount) {
+		for (i = 0; i < tilesCount; i++) RasteriseTile(i);
+		DiscardTriangles(); return;
+	}
+
+	nextTile    = 0;
+	busyWorkers = workersCount;
+	for (i = 0; i < workersCount; i++) Waitable_Signal(workerWaitables[i]);
+	RasteriseTiles();
+
+	for (;;) {
+		Mutex_Lock(workersMutex);
+		{
+			busy = busyWorkers;
+		}
+		Mutex_Unlock(workersMutex);
+
+		if (!busy) break;
+		Waitable_Wait(workersDone);
+	}
+	DiscardTriangles();
+}
+
+static void StartWorkers(void) {
+	int i, count = Options_GetInt(OPT_SOFTGPU_THREADS, 0, MAX_RASTER_WORKERS, 3);
+	if (!count) return;
+
+	workersMutex = Mutex_Create();
+	workersDone  = Waitable_Create();
+	workersStop  = false;
+	workersStarted = 0;
+
+	for (i = 0; i < count; i++) {
+		workerWaitables[i] = Waitable_Create();
+		workerThreads[i]   = Thread_Create(RasterWorker_Run);
+		Thread_Start2(workerThreads[i], RasterWorker_Run);
+	}
+	workersCount = count;
+}
+
+static void StopWorkers(void) {
+	int i;
+	if (!workersCount) return;
+
+	workersStop = true;
+	for (i = 0; i < workersCount; i++) Waitable_Signal(workerWaitables[i]);
+
+	for (i = 0; i < workersCount; i++) {
+		Thread_Join(workerThreads[i]);
+		Waitable_Free(workerWaitables[i]);
+	}
+	workersCount = 0;
+
+	Mutex_Free(workersMutex);
+	Waitable_Free(workersDone);
+}
+#else
+static void FlushTriangles(void) {
+	for (int i = 0; i < tilesCount; i++) RasteriseTile(i);
+	DiscardTriangles();
+}
+
+static void StartWorkers(void) { }
+static void StopWorkers(void)  { }
+#endif
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Drawing----------------------------------------------------------*
+*#########################################################################################################################*/
 void DrawQuads(int startVertex, int verticesCount) {
-	Vector4 frag[4];
-	Vector2 uv[4];
+	ClipVertex vertices[4];
 	PackedCol color[4];
 	int j = startVertex;
 
 	// 4 vertices = 1 quad = 2 triangles
 	for (int i = 0; i < verticesCount / 4; i++, j += 4)
 	{
-		TransformVertex(j + 0, &frag[0], &uv[0], &color[0]);
-		TransformVertex(j + 1, &frag[1], &uv[1], &color[1]);
-		TransformVertex(j + 2, &frag[2], &uv[2], &color[2]);
-		TransformVertex(j + 3, &frag[3], &uv[3], &color[3]);
-
-		DrawTriangle(frag[0], frag[1], frag[2], 
-					uv[0], uv[1], uv[2], color[0]);
+		TransformVertex(j + 0, &vertices[0], &color[0]);
+		TransformVertex(j + 1, &vertices[1], &color[1]);
+		TransformVertex(j + 2, &vertices[2], &color[2]);
+		TransformVertex(j + 3, &vertices[3], &color[3]);
 
-		DrawTriangle(frag[2], frag[3], frag[0],
-					uv[2], uv[3], uv[0], color[2]);
+		DrawTriangle(&vertices[0], &vertices[1], &vertices[2], color[0]);
+		DrawTriangle(&vertices[2], &vertices[3], &vertices[0], color[2]);
 	}
 }
 
 void Gfx_SetVertexFormat(VertexFormat fmt) {
 	gfx_format = fmt;
 	gfx_stride = strideSizes[fmt];
+	drawStateDirty = true;
 }
 
 void Gfx_DrawVb_Lines(int verticesCount) { } /* TODO */
@@ -453,6 +1023,7 @@ void Gfx_BeginFrame(void) { }
 
 void Gfx_EndFrame(void) {
 	Rect2D r = { 0, 0, width, height };
+	FlushTriangles();
 	Window_DrawFramebuffer(r);
 }
 
@@ -463,6 +1034,7 @@ void Gfx_SetFpsLimit(cc_bool vsync, float minFrameMs) {
 
 void Gfx_OnWindowResize(void) {
 	if (depthBuffer) DestroyBuffers();
+	FreeTileBins();
 
 	fb_bmp.width  = width  = Game.Width;
 	fb_bmp.height = height = Game.Height;
@@ -476,6 +1048,7 @@ void Gfx_OnWindowResize(void) {
 	Window_AllocFramebuffer(&fb_bmp);
 	depthBuffer = Mem_Alloc(width * height, 4, "depth buffer");
 	colorBuffer = fb_bmp.scan0;
+	AllocTileBins();
 }
 
 void Gfx_GetApiInfo(cc_string* info) {
@@ -199,6 +199,7 @@ enum GuiPriority {
 	GUI_PRIORITY_INVENTORY  = 20,
 	GUI_PRIORITY_TABLIST    = 17,
 	GUI_PRIORITY_CHAT       = 15,
+	GUI_PRIORITY_PROFILER   = 12,
 	GUI_PRIORITY_HUD        = 10,
 	GUI_PRIORITY_LOADING    =  5
 };
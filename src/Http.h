@@ -12,8 +12,13 @@ struct ScheduledTask;
 struct StringsBuffer;
 
 #define URL_MAX_SIZE (STRING_SIZE * 2)
+/* Request is processed before all other requests (e.g. texture packs) */
 #define HTTP_FLAG_PRIORITY 0x01
 #define HTTP_FLAG_NOCACHE  0x02
+/* Request is processed after normal requests (e.g. skins of other players) */
+#define HTTP_FLAG_LOW_PRIORITY    0x04
+/* Request is processed after all other requests (e.g. country flags) */
+#define HTTP_FLAG_LOWEST_PRIORITY 0x08
 
 extern struct IGameComponent Http_Component;
 
@@ -42,6 +47,7 @@ struct HttpRequest {
 	char lastModified[STRING_SIZE]; /* Time item cached at (if at all) */
 	char etag[STRING_SIZE];         /* ETag of cached item (if any) */
 	cc_uint8 requestType;           /* See the various REQUEST_TYPE_ */
+	cc_uint8 priority;              /* Requests with lower values are processed first */
 	cc_bool success;                /* Whether Result is 0, status is 200, and data is not NULL */
 	struct StringsBuffer* cookies;  /* Cookie list sent in requests. May be modified by the response. */
 };
@@ -49,6 +55,9 @@ struct HttpRequest {
 /* Frees all dynamically allocated data from a HTTP request */
 void HttpRequest_Free(struct HttpRequest* request);
 
+/* Gets the URL a skin is downloaded from. */
+/* If skinName is a URL, that URL is used. (if not, SKIN_SERVER/[skinName].png is used) */
+void Http_GetSkinUrl(const cc_string* skinName, cc_string* dst);
 /* Aschronously performs a http GET request to download a skin. */
 /* If url is a skin, downloads from there. (if not, downloads from SKIN_SERVER/[skinName].png) */
 int Http_AsyncGetSkin(const cc_string* skinName, cc_uint8 flags);
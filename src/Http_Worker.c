@@ -1,18 +1,42 @@
 #include "Core.h"
 #ifndef CC_BUILD_WEB
 #include "_HttpBase.h"
+#include "Errors.h"
+/* Maximum number of requests that can be processed at the same time */
+#if defined CC_BUILD_ANDROID
+	/* Android backend stores the current request in global state */
+	#define HTTP_MAX_WORKERS 1
+#else
+	#define HTTP_MAX_WORKERS 8
+#endif
+
+#if defined CC_BUILD_LOWMEM
+	#define HTTP_DEF_WORKERS 1
+#else
+	#define HTTP_DEF_WORKERS 4
+#endif
+
+struct HttpWorker {
+	void* thread;
+	/* Request currently being processed by this worker (NULL if none) */
+	struct HttpRequest* request;
+	/* Copy of the request from before it was processed */
+	struct HttpRequest* original;
+};
+static struct HttpWorker http_workers[HTTP_MAX_WORKERS];
+static int http_workersCount, http_workersStarted;
+
 static void* workerWaitable;
-static void* workerThread;
+/* NOTE: Also protects the state of all workers */
 static void* pendingMutex;
 static struct RequestList pendingReqs;
-
-static void* curRequestMutex;
-static struct HttpRequest http_curRequest;
-static volatile int http_curProgress = HTTP_PROGRESS_NOT_WORKING_ON;
+/* Requests for the same data as a request that is currently being processed */
+/*  (these receive a copy of that request's response once it has completed) */
+static struct RequestList waitingReqs;
 
 /* Allocates initial data buffer to store response contents */
 static void Http_BufferInit(struct HttpRequest* req) {
-	http_curProgress = 0;
+	req->progress  = 0;
 	req->_capacity = req->contentLength ? req->contentLength : 1;
 	req->data      = (cc_uint8*)Mem_Alloc(req->_capacity, 1, "http data");
 	req->size      = 0;
@@ -30,7 +54,7 @@ static void Http_BufferEnsure(struct HttpRequest* req, cc_uint32 amount) {
 /* Increases size and updates current progress */
 static void Http_BufferExpanded(struct HttpRequest* req, cc_uint32 read) {
 	req->size += read;
-	if (req->contentLength) http_curProgress = (int)(100.0f * req->size / req->contentLength);
+	if (req->contentLength) req->progress = (int)(100.0f * req->size / req->contentLength);
 }
 
 
@@ -41,13 +65,7 @@ static void Http_BufferExpanded(struct HttpRequest* req, cc_uint32 read) {
 static void Http_BeginRequest(struct HttpRequest* req, cc_string* url) {
 	Http_GetUrl(req, url);
 	Platform_Log2("Fetching %s (type %b)", url, &req->requestType);
-
-	Mutex_Lock(curRequestMutex);
-	{
-		HttpRequest_Copy(&http_curRequest, req);
-		http_curProgress = HTTP_PROGRESS_MAKING_REQUEST;
-	}
-	Mutex_Unlock(curRequestMutex);
+	req->progress = HTTP_PROGRESS_MAKING_REQUEST;
 }
 
 static void Http_ParseCookie(struct HttpRequest* req, const cc_string* value) {
@@ -121,24 +139,66 @@ static void Http_SetRequestHeaders(struct HttpRequest* req) {
 	Http_AddHeader(req, "Cookie", &cookies);
 }
 
-/* TODO: Rewrite to use a local variable instead */
-static cc_string* Http_GetUserAgent_UNSAFE(void) {
-	static char userAgentBuffer[STRING_SIZE];
-	static cc_string userAgent;
-
-	String_InitArray(userAgent, userAgentBuffer);
-	String_AppendConst(&userAgent, GAME_APP_NAME);
-	String_AppendConst(&userAgent, Platform_AppNameSuffix);
-	return &userAgent;
+static void Http_GetUserAgent(cc_string* dst) {
+	String_AppendConst(dst, GAME_APP_NAME);
+	String_AppendConst(dst, Platform_AppNameSuffix);
 }
 
 static void Http_SignalWorker(void) { Waitable_Signal(workerWaitable); }
 
-/* Adds a req to the list of pending requests, waking up worker thread if needed */
+static cc_bool Http_RawEquals(char* a, char* b, int length) {
+	cc_string strA = String_FromRaw(a, length);
+	cc_string strB = String_FromRaw(b, length);
+	return String_Equals(&strA, &strB);
+}
+
+/* Whether the two requests will always receive the same response */
+static cc_bool Http_IsSameRequest(struct HttpRequest* a, struct HttpRequest* b) {
+	if (a->requestType != REQUEST_TYPE_GET || b->requestType != REQUEST_TYPE_GET) return false;
+	/* Cookies may get changed by the response */
+	if (a->cookies || b->cookies) return false;
+
+	return Http_RawEquals(a->url,  b->url,  URL_MAX_SIZE)
+		&& Http_RawEquals(a->etag, b->etag, STRING_SIZE)
+		&& Http_RawEquals(a->lastModified, b->lastModified, STRING_SIZE);
+}
+
+/* Finds the worker currently processing the same request as the given request */
+static struct HttpWorker* Http_FindSameWorker(struct HttpRequest* req) {
+	struct HttpRequest* cur;
+	int i;
+
+	for (i = 0; i < http_workersCount; i++) 
+	{
+		cur = http_workers[i].original;
+		if (cur && Http_IsSameRequest(cur, req)) return &http_workers[i];
+	}
+	return NULL;
+}
+
+/* Whether any worker is processing a request using the same cookies as the given request */
+/*  (such requests must be processed one after another, since responses can modify cookies) */
+static cc_bool Http_IsCookiesInUse(struct HttpRequest* req) {
+	int i;
+	if (!req->cookies) return false;
+
+	for (i = 0; i < http_workersCount; i++) 
+	{
+		if (!http_workers[i].original) continue;
+		if (http_workers[i].original->cookies == req->cookies) return true;
+	}
+	return false;
+}
+
+/* Adds a req to the list of pending requests, waking up a worker thread if needed */
 static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags) {
 	Mutex_Lock(pendingMutex);
 	{	
-		RequestList_Append(&pendingReqs, req, flags);
+		if (Http_FindSameWorker(req)) {
+			RequestList_Append(&waitingReqs, req, flags);
+		} else {
+			RequestList_Append(&pendingReqs, req, flags);
+		}
 	}
 	Mutex_Unlock(pendingMutex);
 	Http_SignalWorker();
@@ -161,20 +221,38 @@ cc_bool Http_GetResult(int reqID, struct HttpRequest* item) {
 }
 
 cc_bool Http_GetCurrent(int* reqID, int* progress) {
-	Mutex_Lock(curRequestMutex);
+	struct HttpRequest* cur;
+	int i;
+	*reqID    = 0;
+	*progress = HTTP_PROGRESS_NOT_WORKING_ON;
+
+	Mutex_Lock(pendingMutex);
 	{
-		*reqID    = http_curRequest.id;
-		*progress = http_curProgress;
+		for (i = 0; i < http_workersCount; i++) 
+		{
+			if (!(cur = http_workers[i].request)) continue;
+			*reqID    = cur->id;
+			*progress = cur->progress;
+			break;
+		}
 	}
-	Mutex_Unlock(curRequestMutex);
+	Mutex_Unlock(pendingMutex);
 	return *reqID != 0;
 }
 
 int Http_CheckProgress(int reqID) {
-	int curReqID, progress;
-	Http_GetCurrent(&curReqID, &progress);
+	struct HttpRequest* cur;
+	int i, progress = HTTP_PROGRESS_NOT_WORKING_ON;
 
-	if (reqID != curReqID) progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	Mutex_Lock(pendingMutex);
+	{
+		for (i = 0; i < http_workersCount; i++) 
+		{
+			cur = http_workers[i].request;
+			if (cur && cur->id == reqID) progress = cur->progress;
+		}
+	}
+	Mutex_Unlock(pendingMutex);
 	return progress;
 }
 
@@ -182,6 +260,7 @@ void Http_ClearPending(void) {
 	Mutex_Lock(pendingMutex);
 	{
 		RequestList_Free(&pendingReqs);
+		RequestList_Free(&waitingReqs);
 	}
 	Mutex_Unlock(pendingMutex);
 }
@@ -190,6 +269,7 @@ void Http_TryCancel(int reqID) {
 	Mutex_Lock(pendingMutex);
 	{
 		RequestList_TryFree(&pendingReqs, reqID);
+		RequestList_TryFree(&waitingReqs, reqID);
 	}
 	Mutex_Unlock(pendingMutex);
 
@@ -293,8 +373,31 @@ static cc_bool LoadCurlFuncs(void) {
 	return success;
 }
 
-static CURL* curl;
 static cc_bool curlSupported, curlVerbose;
+/* Easy handles that are not currently being used by a worker */
+/*  (kept around, since each handle reuses its connections to servers) */
+static CURL* curl_handles[HTTP_MAX_WORKERS];
+static int curl_handlesCount;
+static void* curl_handlesMutex;
+
+/* Each worker must use a separate easy handle, since handles can't be used by multiple threads at once */
+static CURL* Curl_Acquire(void) {
+	CURL* curl = NULL;
+	Mutex_Lock(curl_handlesMutex);
+	{
+		if (curl_handlesCount) curl = curl_handles[--curl_handlesCount];
+	}
+	Mutex_Unlock(curl_handlesMutex);
+	return curl ? curl : _curl_easy_init();
+}
+
+static void Curl_Release(CURL* curl) {
+	Mutex_Lock(curl_handlesMutex);
+	{
+		curl_handles[curl_handlesCount++] = curl;
+	}
+	Mutex_Unlock(curl_handlesMutex);
+}
 
 static cc_bool HttpBackend_DescribeError(cc_result res, cc_string* dst) {
 	const char* err;
@@ -315,8 +418,11 @@ static void HttpBackend_Init(void) {
 	res = _curl_global_init(CURL_GLOBAL_DEFAULT);
 	if (res) { Logger_SimpleWarn(res, "initing curl"); return; }
 
-	curl = _curl_easy_init();
-	if (!curl) { Logger_SimpleWarn(res, "initing curl_easy"); return; }
+	curl_handles[0] = _curl_easy_init();
+	if (!curl_handles[0]) { Logger_SimpleWarn(res, "initing curl_easy"); return; }
+
+	curl_handlesCount = 1;
+	curl_handlesMutex = Mutex_Create();
 
 	curlSupported = true;
 	curlVerbose = Options_GetBool("curl-verbose", false);
@@ -358,7 +464,7 @@ static size_t Http_ProcessData(char *buffer, size_t size, size_t nitems, void* u
 }
 
 /* Sets general curl options for a request */
-static void Http_SetCurlOpts(struct HttpRequest* req) {
+static void Http_SetCurlOpts(CURL* curl, struct HttpRequest* req) {
 	_curl_easy_setopt(curl, CURLOPT_USERAGENT,      GAME_APP_NAME);
 	_curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
 	_curl_easy_setopt(curl, CURLOPT_MAXREDIRS,      20L);
@@ -378,14 +484,16 @@ static void Http_SetCurlOpts(struct HttpRequest* req) {
 static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 	char urlStr[NATIVE_STR_LEN];
 	void* post_data = req->data;
+	CURL* curl;
 	CURLcode res;
 	if (!curlSupported) return ERR_NOT_SUPPORTED;
+	if (!(curl = Curl_Acquire())) return ERR_OUT_OF_MEMORY;
 
 	req->meta = NULL;
 	Http_SetRequestHeaders(req);
 	_curl_easy_setopt(curl, CURLOPT_HTTPHEADER, req->meta);
 
-	Http_SetCurlOpts(req);
+	Http_SetCurlOpts(curl, req);
 	String_EncodeUtf8(urlStr, url);
 	_curl_easy_setopt(curl, CURLOPT_URL, urlStr);
 
@@ -410,10 +518,10 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 	/* TODO stackalloc instead and then copy to dynamic array later? */
 	/*  probably not worth the extra complexity though */
 
-	req->_capacity   = 0;
-	http_curProgress = HTTP_PROGRESS_FETCHING_DATA;
+	req->_capacity = 0;
+	req->progress  = HTTP_PROGRESS_FETCHING_DATA;
 	res = _curl_easy_perform(curl);
-	http_curProgress = 100;
+	req->progress  = 100;
 
 	/* Free error string if it isn't needed */
 	if (req->error && !req->error[0]) {
@@ -425,6 +533,7 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 	/* can free now that request has finished */
 	Mem_Free(post_data);
 	_curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, NULL);
+	Curl_Release(curl);
 	return res;
 }
 #elif defined CC_BUILD_HTTPCLIENT
@@ -561,12 +670,15 @@ static void HttpConnection_Close(struct HttpConnection* conn) {
 /*########################################################################################################################*
 *-----------------------------------------------------Connection Pool-----------------------------------------------------*
 *#########################################################################################################################*/
+/* NOTE: Must have more entries than HTTP_MAX_WORKERS, so there is always an unused entry */
 static struct ConnectionPoolEntry {
 	struct HttpConnection conn;
 	cc_string addr;
 	char addrBuffer[STRING_SIZE];
 	cc_bool https;
+	cc_bool inUse; /* Whether a worker is currently using this connection */
 } connection_pool[10];
+static void* connection_poolMutex;
 
 static cc_result ConnectionPool_Insert(int i, struct HttpConnection** conn, const struct HttpUrl* url) {
 	struct ConnectionPoolEntry* e = &connection_pool[i];
@@ -578,31 +690,67 @@ static cc_result ConnectionPool_Insert(int i, struct HttpConnection** conn, cons
 	return HttpConnection_Open(&e->conn, url);
 }
 
-static cc_result ConnectionPool_Open(struct HttpConnection** conn, const struct HttpUrl* url) {
+/* Finds an unused entry in the pool to use for the given url, and then marks it as in use */
+static int ConnectionPool_Find(const struct HttpUrl* url, cc_bool* reuse) {
 	struct ConnectionPoolEntry* e;
-	int i;
+	int i, start;
+	*reuse = true;
 
 	for (i = 0; i < Array_Elems(connection_pool); i++)
 	{
 		e = &connection_pool[i];
-		if (e->conn.valid && e->https == url->https && String_Equals(&e->addr, &url->address)) {
-			*conn = &connection_pool[i].conn;
-			return 0;
-		}
+		if (!e->inUse && e->conn.valid && e->https == url->https && String_Equals(&e->addr, &url->address)) return i;
 	}
+	*reuse = false;
 
 	for (i = 0; i < Array_Elems(connection_pool); i++)
 	{
 		e = &connection_pool[i];
-		if (!e->conn.valid) return ConnectionPool_Insert(i, conn, url);
+		if (!e->inUse && !e->conn.valid) return i;
 	}
 
 	/* TODO: Should we be consistent in which entry gets evicted? */
-	i = (cc_uint8)Stopwatch_Measure() % Array_Elems(connection_pool);
+	start = (cc_uint8)Stopwatch_Measure() % Array_Elems(connection_pool);
+	for (i = start; connection_pool[i].inUse; ) 
+	{
+		i = (i + 1) % Array_Elems(connection_pool);
+	}
+	return i;
+}
+
+static cc_result ConnectionPool_Open(struct HttpConnection** conn, const struct HttpUrl* url) {
+	cc_bool reuse;
+	int i;
+
+	Mutex_Lock(connection_poolMutex);
+	{
+		i = ConnectionPool_Find(url, &reuse);
+		connection_pool[i].inUse = true;
+	}
+	Mutex_Unlock(connection_poolMutex);
+
+	if (reuse) {
+		*conn = &connection_pool[i].conn;
+		return 0;
+	}
+
 	HttpConnection_Close(&connection_pool[i].conn);
 	return ConnectionPool_Insert(i, conn, url);
 }
 
+/* Allows the given connection to be reused by other requests */
+static void ConnectionPool_Release(struct HttpConnection* conn) {
+	int i;
+	Mutex_Lock(connection_poolMutex);
+	{
+		for (i = 0; i < Array_Elems(connection_pool); i++)
+		{
+			if (&connection_pool[i].conn == conn) connection_pool[i].inUse = false;
+		}
+	}
+	Mutex_Unlock(connection_poolMutex);
+}
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------HttpClient-------------------------------------------------------*
@@ -650,13 +798,17 @@ static void HttpClient_Serialise(struct HttpClientState* state) {
 
 	struct HttpRequest* req = state->req;
 	cc_string* buffer = (cc_string*)req->meta;
+	cc_string userAgent; char userAgentBuffer[STRING_SIZE];
+
+	String_InitArray(userAgent, userAgentBuffer);
+	Http_GetUserAgent(&userAgent);
 	/* TODO move to other functions */
 	/* Write request message headers */
 	String_Format2(buffer, "%c %s HTTP/1.1\r\n",
 					verbs[req->requestType], &state->url.resource);
 
 	Http_AddHeader(req, "Host",       &state->url.address);
-	Http_AddHeader(req, "User-Agent", Http_GetUserAgent_UNSAFE());
+	Http_AddHeader(req, "User-Agent", &userAgent);
 	if (req->data) String_Format1(buffer, "Content-Length: %i\r\n", &req->size);
 
 	Http_SetRequestHeaders(req);
@@ -675,8 +827,8 @@ static cc_result HttpClient_SendRequest(struct HttpClientState* state) {
 	cc_uint32 wrote;
 
 	String_InitArray(inputMsg, inputBuffer);
-	state->req->meta = &inputMsg;
-	http_curProgress = HTTP_PROGRESS_FETCHING_DATA;
+	state->req->meta     = &inputMsg;
+	state->req->progress = HTTP_PROGRESS_FETCHING_DATA;
 	HttpClient_Serialise(state);
 
 	/* TODO check that wrote is >= inputMsg.length */
@@ -908,6 +1060,7 @@ static cc_result HttpClient_HandleRedirect(struct HttpClientState* state) {
 *#########################################################################################################################*/
 static void HttpBackend_Init(void) {
 	SSLBackend_Init(httpsVerify);
+	connection_poolMutex = Mutex_Create();
 	//httpOnly = true; // TODO: insecure
 }
 
@@ -926,14 +1079,14 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* urlStr) {
 
 	for (;;) {
 		res = ConnectionPool_Open(&state.conn, &state.url);
-		if (res) { HttpConnection_Close(state.conn); return res; }
-
-		res = HttpClient_SendRequest(&state);
-		if (res) { HttpConnection_Close(state.conn); return res; }
+		if (!res) res = HttpClient_SendRequest(&state);
+		if (res) { HttpConnection_Close(state.conn); ConnectionPool_Release(state.conn); return res; }
 
 		res = HttpClient_ParseResponse(&state);
-		http_curProgress = 100;
-		if (state.autoClose) HttpConnection_Close(state.conn);
+		req->progress = 100;
+		/* Connection is in an unknown state after errors, so can't be reused */
+		if (res || state.autoClose) HttpConnection_Close(state.conn);
+		ConnectionPool_Release(state.conn);
 
 		if (res || !HttpClient_IsRedirect(req)) break;
 		if (redirects >= 20) return HTTP_ERR_REDIRECTS;
@@ -1008,10 +1161,13 @@ struct HttpCacheEntry {
 	cc_string Address; /* Address of server. (e.g. "classicube.net") */
 	cc_uint16 Port;    /* Port server is listening on. (e.g 80) */
 	cc_bool Https;     /* Whether HTTPS or just HTTP protocol. */
+	cc_uint8 Users;    /* Number of workers currently making requests using this connection */
 	char _addressBuffer[STRING_SIZE + 1];
 };
+/* NOTE: Must have more entries than HTTP_MAX_WORKERS, so there is always an unused entry */
 #define HTTP_CACHE_ENTRIES 10
 static struct HttpCacheEntry http_cache[HTTP_CACHE_ENTRIES];
+static void* http_cacheMutex;
 static HINTERNET hInternet;
 
 /* Converts characters to UTF8, then calls Http_URlEncode on them. */
@@ -1067,6 +1223,7 @@ static cc_result HttpCache_Insert(int i, struct HttpCacheEntry* e) {
 	if (!conn) return GetLastError();
 
 	e->Handle     = conn;
+	e->Users      = 1;
 	http_cache[i] = *e;
 
 	/* otherwise address buffer points to stack buffer */
@@ -1074,15 +1231,16 @@ static cc_result HttpCache_Insert(int i, struct HttpCacheEntry* e) {
 	return 0;
 }
 
-/* Finds or inserts the given entry into the cache */
-static cc_result HttpCache_Lookup(struct HttpCacheEntry* e) {
+/* Finds or inserts the given entry into the cache, and then marks it as in use */
+static cc_result HttpCache_Find(struct HttpCacheEntry* e) {
 	struct HttpCacheEntry* c;
 	int i;
 
 	for (i = 0; i < HTTP_CACHE_ENTRIES; i++) {
 		c = &http_cache[i];
-		if (c->Https == e->Https && String_Equals(&c->Address, &e->Address) && c->Port == e->Port) {
+		if (c->Handle && c->Https == e->Https && String_Equals(&c->Address, &e->Address) && c->Port == e->Port) {
 			e->Handle = c->Handle;
+			c->Users++;
 			return 0;
 		}
 	}
@@ -1092,12 +1250,43 @@ static cc_result HttpCache_Lookup(struct HttpCacheEntry* e) {
 		return HttpCache_Insert(i, e);
 	}
 
+	/* Closing a connection that another worker is using would abort its request */
 	/* TODO: Should we be consistent in which entry gets evicted? */
 	i = (cc_uint8)Stopwatch_Measure() % HTTP_CACHE_ENTRIES;
+	while (http_cache[i].Users) 
+	{
+		i = (i + 1) % HTTP_CACHE_ENTRIES;
+	}
+
 	_InternetCloseHandle(http_cache[i].Handle);
+	http_cache[i].Handle = NULL;
 	return HttpCache_Insert(i, e);
 }
 
+/* NOTE: WinINet connection handles can be used by multiple threads, but the cache can't */
+static cc_result HttpCache_Lookup(struct HttpCacheEntry* e) {
+	cc_result res;
+	Mutex_Lock(http_cacheMutex);
+	{
+		res = HttpCache_Find(e);
+	}
+	Mutex_Unlock(http_cacheMutex);
+	return res;
+}
+
+/* Allows the given connection to be evicted from the cache again */
+static void HttpCache_Release(HINTERNET conn) {
+	int i;
+	Mutex_Lock(http_cacheMutex);
+	{
+		for (i = 0; i < HTTP_CACHE_ENTRIES; i++)
+		{
+			if (http_cache[i].Handle == conn && http_cache[i].Users) http_cache[i].Users--;
+		}
+	}
+	Mutex_Unlock(http_cacheMutex);
+}
+
 static void* wininet_lib;
 static cc_bool HttpBackend_DescribeError(cc_result res, cc_string* dst) {
 	return Platform_DescribeErrorExt(res, dst, wininet_lib);
@@ -1116,6 +1305,7 @@ static void HttpBackend_Init(void) {
 	static const cc_string wininet = String_FromConst("wininet.dll");
 	DynamicLib_LoadAll(&wininet, funcs, Array_Elems(funcs), &wininet_lib);
 	if (!wininet_lib) return;
+	http_cacheMutex = Mutex_Create();
 
 	/* TODO: Should we use INTERNET_OPEN_TYPE_PRECONFIG instead? */
 	hInternet = _InternetOpenA(GAME_APP_NAME, INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
@@ -1132,7 +1322,7 @@ static void Http_AddHeader(struct HttpRequest* req, const char* key, const cc_st
 }
 
 /* Creates and sends a HTTP request */
-static cc_result Http_StartRequest(struct HttpRequest* req, cc_string* url) {
+static cc_result Http_StartRequest(struct HttpRequest* req, cc_string* url, HINTERNET* conn) {
 	static const char* verbs[3] = { "GET", "HEAD", "POST" };
 	struct HttpCacheEntry entry;
 	cc_string path; char pathBuffer[URL_MAX_SIZE + 1];
@@ -1146,6 +1336,7 @@ static cc_result Http_StartRequest(struct HttpRequest* req, cc_string* url) {
 
 	if (!wininet_lib) return ERR_NOT_SUPPORTED;
 	if ((res = HttpCache_Lookup(&entry))) return res;
+	*conn = entry.Handle;
 
 	flags = INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_NO_UI | INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_COOKIES;
 	if (entry.Https) flags |= INTERNET_FLAG_SECURE;
@@ -1202,18 +1393,18 @@ static cc_result Http_DownloadData(struct HttpRequest* req, HINTERNET handle) {
 		Http_BufferExpanded(req, read);
 	}
 
- 	http_curProgress = 100;
+ 	req->progress = 100;
 	return 0;
 }
 
-static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
+static cc_result Http_PerformRequest(struct HttpRequest* req, cc_string* url, HINTERNET* conn) {
 	HINTERNET handle;
-	cc_result res = Http_StartRequest(req, url);
+	cc_result res = Http_StartRequest(req, url, conn);
 	HttpRequest_Free(req);
 	if (res) return res;
 
 	handle = req->meta;
-	http_curProgress = HTTP_PROGRESS_FETCHING_DATA;
+	req->progress = HTTP_PROGRESS_FETCHING_DATA;
 	res = Http_ProcessHeaders(req, handle);
 	if (res) { _InternetCloseHandle(handle); return res; }
 
@@ -1224,6 +1415,14 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 
 	return _InternetCloseHandle(handle) ? 0 : GetLastError();
 }
+
+static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
+	HINTERNET conn = NULL;
+	cc_result res  = Http_PerformRequest(req, url, &conn);
+
+	if (conn) HttpCache_Release(conn);
+	return res;
+}
 #elif defined CC_BUILD_ANDROID
 /*########################################################################################################################*
 *-----------------------------------------------------Android backend-----------------------------------------------------*
@@ -1325,6 +1524,7 @@ static cc_result Http_SetData(JNIEnv* env, struct HttpRequest* req) {
 }
 
 static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
+	cc_string userAgent; char userAgentBuffer[STRING_SIZE];
 	JNIEnv* env;
 	jint res;
 
@@ -1332,14 +1532,16 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 	if ((res = Http_InitReq(env, req, url))) return res;
 	java_req = req;
 
+	String_InitArray(userAgent, userAgentBuffer);
+	Http_GetUserAgent(&userAgent);
 	Http_SetRequestHeaders(req);
-	Http_AddHeader(req, "User-Agent", Http_GetUserAgent_UNSAFE());
+	Http_AddHeader(req, "User-Agent", &userAgent);
 	if (req->data && (res = Http_SetData(env, req))) return res;
 
-	req->_capacity   = 0;
-	http_curProgress = HTTP_PROGRESS_FETCHING_DATA;
+	req->_capacity = 0;
+	req->progress  = HTTP_PROGRESS_FETCHING_DATA;
 	res = JavaSCall_Int(env, JAVA_httpPerform, NULL);
-	http_curProgress = 100;
+	req->progress  = 100;
 	return res;
 }
 #elif defined CC_BUILD_CFNETWORK
@@ -1400,6 +1602,7 @@ static cc_result ParseResponseHeaders(struct HttpRequest* req, CFReadStreamRef s
 
 static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
     static CFStringRef verbs[] = { CFSTR("GET"), CFSTR("HEAD"), CFSTR("POST") };
+    cc_string userAgent; char userAgentBuffer[STRING_SIZE];
     cc_bool gotHeaders = false;
     char tmp[NATIVE_STR_LEN];
     CFHTTPMessageRef request;
@@ -1416,8 +1619,10 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
     
     request = CFHTTPMessageCreateRequest(NULL, verbs[req->requestType], urlRef, kCFHTTPVersion1_1);
     req->meta = request;
+    String_InitArray(userAgent, userAgentBuffer);
+    Http_GetUserAgent(&userAgent);
     Http_SetRequestHeaders(req);
-    Http_AddHeader(req, "User-Agent", Http_GetUserAgent_UNSAFE());
+    Http_AddHeader(req, "User-Agent", &userAgent);
     CFRelease(urlRef);
     
     if (req->data && req->size) {
@@ -1462,32 +1667,78 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 }
 #endif
 
-static void ClearCurrentRequest(void) {
-	Mutex_Lock(curRequestMutex);
+/* Removes the next request that can be processed from the list of pending requests */
+static cc_bool Http_TakePending(struct HttpRequest* req) {
+	int i, j;
+
+	for (i = 0; i < pendingReqs.count; i++)
 	{
-		http_curRequest.id = 0;
-		http_curProgress   = HTTP_PROGRESS_NOT_WORKING_ON;
+		if (Http_IsCookiesInUse(&pendingReqs.entries[i])) continue;
+		HttpRequest_Copy(req, &pendingReqs.entries[i]);
+		RequestList_RemoveAt(&pendingReqs, i);
+
+		/* Other pending requests for the same data can just reuse the response to this request */
+		for (j = pendingReqs.count - 1; j >= 0; j--)
+		{
+			if (!Http_IsSameRequest(&pendingReqs.entries[j], req)) continue;
+			RequestList_Append(&waitingReqs, &pendingReqs.entries[j], 0);
+			RequestList_RemoveAt(&pendingReqs, j);
+		}
+		return true;
+	}
+	return false;
+}
+
+/* Gives a copy of the response to the given request to all the requests waiting on it */
+static void Http_FinishWaiting(struct HttpRequest* original, struct HttpRequest* req) {
+	struct HttpRequest copy;
+	int i;
+
+	for (i = 0; i < waitingReqs.count; )
+	{
+		if (!Http_IsSameRequest(&waitingReqs.entries[i], original)) { i++; continue; }
+
+		HttpRequest_Copy(&copy, req);
+		copy.id    = waitingReqs.entries[i].id;
+		copy.error = NULL;
+		RequestList_RemoveAt(&waitingReqs, i);
+
+		if (req->data) {
+			copy.data = (cc_uint8*)Mem_TryAlloc(req->size, 1);
+			if (copy.data) Mem_Copy(copy.data, req->data, req->size);
+			if (!copy.data) copy.result = ERR_OUT_OF_MEMORY;
+		}
+		Http_FinishRequest(&copy);
 	}
-	Mutex_Unlock(curRequestMutex);
 }
 
 static void WorkerLoop(void) {
 	char urlBuffer[URL_MAX_SIZE]; cc_string url;
-	struct HttpRequest request;
+	struct HttpRequest request, original;
+	struct HttpWorker* worker;
 	cc_bool hasRequest;
 	cc_uint64 beg, end;
 	int elapsed;
 
-	for (;;) {
-		hasRequest = false;
+	Mutex_Lock(pendingMutex);
+	{
+		worker = &http_workers[http_workersStarted++];
+	}
+	Mutex_Unlock(pendingMutex);
 
+	for (;;) {
 		Mutex_Lock(pendingMutex);
 		{
-			if (pendingReqs.count) {
-				HttpRequest_Copy(&request, &pendingReqs.entries[0]);
-				hasRequest = true;
-				RequestList_RemoveAt(&pendingReqs, 0);
+			hasRequest = Http_TakePending(&request);
+			/* Backend may change request (e.g. ETag), so keep a copy for finding duplicate requests */
+			if (hasRequest) HttpRequest_Copy(&original, &request);
+
+			if (hasRequest) {
+				worker->request  = &request;
+				worker->original = &original;
 			}
+			/* Wake up another worker to start on the next request */
+			if (hasRequest && pendingReqs.count) Http_SignalWorker();
 		}
 		Mutex_Unlock(pendingMutex);
 
@@ -1509,8 +1760,16 @@ static void WorkerLoop(void) {
 		Platform_Log4("HTTP: result %i (http %i) in %i ms (%i bytes)",
 					&request.result, &request.statusCode, &elapsed, &request.size);
 
-		Http_FinishRequest(&request);
-		ClearCurrentRequest();
+		Mutex_Lock(pendingMutex);
+		{
+			/* Must be done before request is finished, since its data may be freed after that */
+			Http_FinishWaiting(&original, &request);
+			Http_FinishRequest(&request);
+
+			worker->request  = NULL;
+			worker->original = NULL;
+		}
+		Mutex_Unlock(pendingMutex);
 	}
 }
 
@@ -1519,20 +1778,25 @@ static void WorkerLoop(void) {
 *-----------------------------------------------------Http component------------------------------------------------------*
 *#########################################################################################################################*/
 static void Http_Init(void) {
+	int i;
 	Http_InitCommon();
 	/* Http component gets initialised multiple times on Android */
-	if (workerThread) return;
+	if (http_workersCount) return;
 
 	HttpBackend_Init();
 	workerWaitable = Waitable_Create();
 	RequestList_Init(&pendingReqs);
+	RequestList_Init(&waitingReqs);
 	RequestList_Init(&processedReqs);
 
-	pendingMutex    = Mutex_Create();
-	processedMutex  = Mutex_Create();
-	curRequestMutex = Mutex_Create();
-	workerThread    = Thread_Create(WorkerLoop);
+	pendingMutex   = Mutex_Create();
+	processedMutex = Mutex_Create();
+	http_workersCount = Options_GetInt(OPT_HTTP_WORKERS, 1, HTTP_MAX_WORKERS, HTTP_DEF_WORKERS);
 
-	Thread_Start2(workerThread, WorkerLoop);
+	for (i = 0; i < http_workersCount; i++) 
+	{
+		http_workers[i].thread = Thread_Create(WorkerLoop);
+		Thread_Start2(http_workers[i].thread, WorkerLoop);
+	}
 }
-#endif
\ No newline at end of file
+#endif
@@ -1289,7 +1289,7 @@ static void ServersScreen_Tick(struct LScreen* s_) {
 	LScreen_Tick(s_);
 
 	count = FetchFlagsTask.count;
-	LWebTask_Tick(&FetchFlagsTask.Base, NULL);
+	FetchFlagsTask_Tick();
 	if (count != FetchFlagsTask.count) LBackend_TableFlagAdded(&s->table);
 
 	if (!FetchServersTask.Base.working) return;
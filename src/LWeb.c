@@ -602,16 +602,27 @@ static void FetchFlagsTask_Scale(struct Bitmap* bmp) {
 
 static void FetchFlagsTask_DownloadNext(void);
 static void FetchFlagsTask_Handle(cc_uint8* data, cc_uint32 len) {
-	struct Flag* flag = &flags[FetchFlagsTask.count];
-	struct Stream s;
-	cc_result res;
+	FetchFlagsTask.decodeID = PngDecoder_Add(data, len, NULL, 0);
+}
+
+void FetchFlagsTask_Tick(void) {
+	struct PngDecodeResult result;
+	struct Flag* flag;
+
+	LWebTask_Tick(&FetchFlagsTask.Base, NULL);
+	if (!FetchFlagsTask.decodeID) return;
+	if (!PngDecoder_GetResult(FetchFlagsTask.decodeID, &result)) return;
 
-	Stream_ReadonlyMemory(&s, data, len);
-	res = Png_Decode(&flag->bmp, &s);
-	if (res) Logger_SysWarn(res, "decoding flag");
+	flag = &flags[FetchFlagsTask.count];
+	if (result.res) Logger_SysWarn(result.res, "decoding flag");
+	flag->bmp  = result.bmp;
 	flag->meta = NULL;
+	/* Flag now owns the bitmap */
+	result.bmp.scan0 = NULL;
+	PngDecodeResult_Free(&result);
 
 	FetchFlagsTask_Scale(&flag->bmp);
+	FetchFlagsTask.decodeID = 0;
 	FetchFlagsTask.count++;
 	FetchFlagsTask_DownloadNext();
 }
@@ -621,6 +632,7 @@ static void FetchFlagsTask_DownloadNext(void) {
 	String_InitArray(url, urlBuffer);
 
 	if (FetchFlagsTask.Base.working)        return;
+	if (FetchFlagsTask.decodeID)            return;
 	if (FetchFlagsTask.count == flagsCount) return;
 
 	LWebTask_Reset(&FetchFlagsTask.Base);
@@ -628,7 +640,7 @@ static void FetchFlagsTask_DownloadNext(void) {
 			&flags[FetchFlagsTask.count].country[0], &flags[FetchFlagsTask.count].country[1]);
 
 	FetchFlagsTask.Base.Handle = FetchFlagsTask_Handle;
-	FetchFlagsTask.Base.reqID  = Http_AsyncGetData(&url, 0);
+	FetchFlagsTask.Base.reqID  = Http_AsyncGetData(&url, HTTP_FLAG_LOWEST_PRIORITY);
 }
 
 static void FetchFlagsTask_Ensure(void) {
@@ -675,6 +687,8 @@ void Flags_Free(void) {
 	for (i = 0; i < FetchFlagsTask.count; i++) {
 		Mem_Free(flags[i].bmp.scan0);
 	}
+	PngDecoder_Cancel(FetchFlagsTask.decodeID);
+	FetchFlagsTask.decodeID = 0;
 
     flagsCount = 0;
     FetchFlagsTask.count = 0;
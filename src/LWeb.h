@@ -122,10 +122,14 @@ extern struct FetchFlagsData {
 	struct LWebTask Base;
 	/* Number of flags downloaded. */
 	int count;
+	/* ID of the flag currently being decoded, 0 if none. */
+	int decodeID;
 } FetchFlagsTask;
 
 /* Asynchronously downloads the flag associated with the given server's country. */
 void FetchFlagsTask_Add(const struct ServerInfo* server);
+/* Checks whether the current flag has finished downloading and decoding. */
+void FetchFlagsTask_Tick(void);
 /* Gets the country flag associated with the given server's country. */
 struct Flag* Flags_Get(const struct ServerInfo* server);
 /* Frees all flag bitmaps. */
@@ -32,7 +32,9 @@ static int ClassicLighting_CalcHeightAt(int x, int maxY, int z, int hIndex) {
 	BlockID block;
 	int y, offset;
 
-#ifndef EXTENDED_BLOCKS
+#if defined CC_BUILD_PALETTEDWORLD
+	ClassicLighting_CalcBody(World_GetBlock(x, y, z));
+#elif !defined EXTENDED_BLOCKS
 	ClassicLighting_CalcBody(World.Blocks[i]);
 #else
 	if (World.IDMask <= 0xFF) {
@@ -153,7 +155,9 @@ static cc_bool ClassicLighting_NeedsNeighour(BlockID block, int i, int minY, int
 	BlockID other;
 	cc_bool affected;
 
-#ifndef EXTENDED_BLOCKS
+#if defined CC_BUILD_PALETTEDWORLD
+	ClassicLighting_NeedsNeighourBody(World_GetRawBlock(i));
+#elif !defined EXTENDED_BLOCKS
 	ClassicLighting_NeedsNeighourBody(World.Blocks[i]);
 #else
 	if (World.IDMask <= 0xFF) {
@@ -243,6 +247,79 @@ static void ClassicLighting_OnBlockChanged(int x, int y, int z, BlockID oldBlock
 	ClassicLighting_RefreshAffected(x, y, z, newBlock, lightH + 1, newHeight);
 }
 
+/* Max number of changed blocks that are processed at once */
+#define LIGHTING_BATCH_SIZE 256
+/* Size of the hash table of changed columns, must be a power of two larger than LIGHTING_BATCH_SIZE */
+#define LIGHTING_COLUMNS_SIZE 512
+struct LightingColumn { int hIndex, oldHeight, newHeight, maxY; };
+
+static struct LightingColumn* ClassicLighting_FindColumn(struct LightingColumn* columns, int hIndex) {
+	int i = hIndex & (LIGHTING_COLUMNS_SIZE - 1);
+
+	while (columns[i].hIndex != hIndex && columns[i].hIndex != -1) {
+		i = (i + 1) & (LIGHTING_COLUMNS_SIZE - 1);
+	}
+	return &columns[i];
+}
+
+/* Rather than incrementally updating the heightmap for every changed block (which may result in */
+/*  rescanning the same column multiple times), each changed column is only rescanned once */
+static void ClassicLighting_UpdateBatch(const int* indices, int count) {
+	struct LightingColumn columns[LIGHTING_COLUMNS_SIZE];
+	struct LightingColumn* col;
+	int used[LIGHTING_BATCH_SIZE];
+	int i, usedCount = 0;
+	int x, y, z, hIndex, lightH, maxY;
+
+	for (i = 0; i < LIGHTING_COLUMNS_SIZE; i++) { columns[i].hIndex = -1; }
+
+	for (i = 0; i < count; i++) {
+		World_Unpack(indices[i], x, y, z);
+		hIndex = Lighting_Pack(x, z);
+		lightH = classic_heightmap[hIndex];
+		/* Column never had meshes for any of its chunks built, so nothing to do (see ClassicLighting_OnBlockChanged) */
+		if (lightH == HEIGHT_UNCALCULATED) continue;
+
+		col = ClassicLighting_FindColumn(columns, hIndex);
+		if (col->hIndex == -1) {
+			col->hIndex    = hIndex;
+			col->oldHeight = lightH;
+			col->maxY      = y;
+			used[usedCount++] = (int)(col - columns);
+		} else {
+			col->maxY = max(col->maxY, y);
+		}
+	}
+
+	for (i = 0; i < usedCount; i++) {
+		col = &columns[used[i]];
+		x   = col->hIndex % World.Width;
+		z   = col->hIndex / World.Width;
+
+		/* Blocks above both the old light height and all of the changed blocks can't block light */
+		/* (+1 since a block that shades from below has a light height 1 less than its Y) */
+		maxY = max(col->oldHeight + 1, col->maxY);
+		maxY = min(maxY, World.MaxY);
+		col->newHeight = ClassicLighting_CalcHeightAt(x, maxY, z, col->hIndex);
+	}
+
+	for (i = 0; i < count; i++) {
+		World_Unpack(indices[i], x, y, z);
+		col = ClassicLighting_FindColumn(columns, Lighting_Pack(x, z));
+		if (col->hIndex == -1) continue;
+
+		ClassicLighting_RefreshAffected(x, y, z, World_GetBlock(x, y, z), 
+										col->oldHeight + 1, col->newHeight + 1);
+	}
+}
+
+static void ClassicLighting_OnBlocksChanged(const int* indices, int count) {
+	int i;
+	for (i = 0; i < count; i += LIGHTING_BATCH_SIZE) {
+		ClassicLighting_UpdateBatch(indices + i, min(count - i, LIGHTING_BATCH_SIZE));
+	}
+}
+
 
 /*########################################################################################################################*
 *---------------------------------------------------Lighting heightmap----------------------------------------------------*
@@ -320,7 +397,9 @@ static cc_bool Heightmap_CalculateCoverage(int x1, int z1, int xCount, int zCoun
 	int mapIndex, hIndex, baseIndex, index;
 	int x, y, z;
 
-#ifndef EXTENDED_BLOCKS
+#if defined CC_BUILD_PALETTEDWORLD
+	Heightmap_CalculateBody(World_GetBlock(x1 + x, y, z1 + z));
+#elif !defined EXTENDED_BLOCKS
 	Heightmap_CalculateBody(World.Blocks[mapIndex]);
 #else
 	if (World.IDMask <= 0xFF) {
@@ -375,11 +454,12 @@ static void ClassicLighting_AllocState(void) {
 }
 
 static void ClassicLighting_SetActive(void) {
-	Lighting.OnBlockChanged = ClassicLighting_OnBlockChanged;
-	Lighting.Refresh        = ClassicLighting_Refresh;
-	Lighting.IsLit          = ClassicLighting_IsLit;
-	Lighting.Color          = ClassicLighting_Color;
-	Lighting.Color_XSide    = ClassicLighting_Color_XSide;
+	Lighting.OnBlockChanged  = ClassicLighting_OnBlockChanged;
+	Lighting.OnBlocksChanged = ClassicLighting_OnBlocksChanged;
+	Lighting.Refresh         = ClassicLighting_Refresh;
+	Lighting.IsLit           = ClassicLighting_IsLit;
+	Lighting.Color           = ClassicLighting_Color;
+	Lighting.Color_XSide     = ClassicLighting_Color_XSide;
 
 	Lighting.IsLit_Fast        = ClassicLighting_IsLit_Fast;
 	Lighting.Color_Sprite_Fast = ClassicLighting_Color_Sprite_Fast;
@@ -397,6 +477,12 @@ static void ClassicLighting_SetActive(void) {
 /*########################################################################################################################*
 *---------------------------------------------------Lighting component----------------------------------------------------*
 *#########################################################################################################################*/
+cc_bool Lighting_CanBatchChanges(void) {
+	if (!Lighting.OnBlocksChanged) return false;
+	/* Classic batch handler would update the wrong state for another engine's OnBlockChanged */
+	return Lighting.OnBlocksChanged != ClassicLighting_OnBlocksChanged
+		|| Lighting.OnBlockChanged  == ClassicLighting_OnBlockChanged;
+}
 
 static void OnInit(void)         { ClassicLighting_SetActive(); }
 static void OnReset(void)        { Lighting.FreeState(); }
@@ -48,5 +48,16 @@ CC_VAR extern struct _Lighting {
 	PackedCol (*Color_YMin_Fast)(int x, int y, int z);
 	PackedCol (*Color_XSide_Fast)(int x, int y, int z);
 	PackedCol (*Color_ZSide_Fast)(int x, int y, int z);
+
+	/* Called after multiple blocks were changed at once to update internal lighting state. */
+	/* NOTE: Unlike OnBlockChanged, the world has already been updated to contain all the new blocks. */
+	/* NOTE: Implementations ***MUST*** mark all chunks affected by this lighting change as needing to be refreshed. */
+	/* NOTE: Lighting engines that replace OnBlockChanged should also replace this (or set it to NULL), */
+	/*  otherwise OnBlockChanged is called for each block instead (see Lighting_CanBatchChanges) */
+	void (*OnBlocksChanged)(const int* indices, int count);
 } Lighting;
+
+/* Returns whether OnBlocksChanged can be used to update lighting for many changed blocks at once. */
+/* False when OnBlocksChanged is NULL, or when a plugin replaced only OnBlockChanged of classic lighting. */
+cc_bool Lighting_CanBatchChanges(void);
 #endif
@@ -46,6 +46,21 @@ static cc_uint32* distances;
 static int maxChunkUpdates;
 /* Cached number of chunks in the world */
 static int chunksCount;
+/* Indices of chunks that were marked as needing to be rebuilt since the last frame */
+static int* dirtyChunks;
+/* Number of actually used indices in the dirtyChunks array */
+static int dirtyCount;
+
+/* Whether chunks that can't be seen from the camera's chunk are culled */
+static cc_bool occlusionCulling;
+/* Whether chunk occlusion needs to be recalculated */
+static cc_bool occlusionDirty;
+/* Chunk that a breadth first search visits, and how it got there */
+struct VisitNode { int index; cc_uint8 from, dirs; };
+/* Queue for the breadth first search of visible chunks. (each chunk can be entered once per face) */
+static struct VisitNode* visitQueue;
+/* Faces each chunk has been entered through during the breadth first search of visible chunks */
+static cc_uint8* visitedFaces;
 
 static void ChunkInfo_Reset(struct ChunkInfo* chunk, int x, int y, int z) {
 	chunk->CentreX = x + HALF_CHUNK_SIZE; chunk->CentreY = y + HALF_CHUNK_SIZE; 
@@ -56,8 +71,10 @@ static void ChunkInfo_Reset(struct ChunkInfo* chunk, int x, int y, int z) {
 
 	chunk->Visible = true;        chunk->Empty = false;
 	chunk->PendingDelete = false; chunk->AllAir = false;
+	chunk->Building = false;      chunk->Occluded = false;
 	chunk->DrawXMin = false; chunk->DrawXMax = false; chunk->DrawZMin = false;
 	chunk->DrawZMax = false; chunk->DrawYMin = false; chunk->DrawYMax = false;
+	Mem_Set(chunk->Connected, CHUNK_CONNECTED_ALL, FACE_COUNT);
 
 	chunk->NormalParts      = NULL;
 	chunk->TranslucentParts = NULL;
@@ -203,9 +220,6 @@ void MapRenderer_RenderNormal(double delta) {
 
 	CheckWeather(delta);
 	Gfx_SetAlphaTest(false);
-#if DEBUG_OCCLUSION
-	DebugPickedPos();
-#endif
 }
 
 #define DrawTranslucentFaces(minFace, maxFace) \
@@ -314,10 +328,6 @@ static void DeleteChunk(struct ChunkInfo* info) {
 #endif
 
 	info->Empty = false; info->AllAir = false;
-#ifdef OCCLUSION
-	info.OcclusionFlags = 0;
-	info.OccludedFlags = 0;
-#endif
 
 	if (info->NormalParts) {
 		ptr = info->NormalParts;
@@ -344,16 +354,15 @@ static void DeleteChunk(struct ChunkInfo* info) {
 	}
 }
 
-/* Builds the mesh (hence vertex buffer) for the given chunk, and updates internal state */
-static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
+/* Updates internal state after the mesh for the given chunk has been built */
+static void OnChunkBuilt(struct ChunkInfo* info) {
 	struct ChunkPartInfo* ptr;
 	int i;
 
 	Game.ChunkUpdates++;
-	(*chunkUpdates)++;
-	info->PendingDelete = false;
-	Builder_MakeChunk(info);
-
+	occlusionDirty = true;
+	/* Chunk was changed again while being built on a background thread */
+	if (info->PendingDelete) Mem_Set(info->Connected, CHUNK_CONNECTED_ALL, FACE_COUNT);
 	if (!info->NormalParts && !info->TranslucentParts) {
 		info->Empty = true; return;
 	}
@@ -373,6 +382,24 @@ static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
 	}
 }
 
+/* Builds the mesh (hence vertex buffer) for the given chunk, and updates internal state */
+/* NOTE: If background threads are used, the mesh is instead built over the next few frames */
+static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
+	if (Builder_WorkersCount) {
+		/* Keep drawing the old mesh until the new mesh has been built */
+		if (!Builder_QueueChunk(info)) return;
+		info->PendingDelete = false;
+		(*chunkUpdates)++;
+		return;
+	}
+
+	DeleteChunk(info);
+	(*chunkUpdates)++;
+	info->PendingDelete = false;
+	Builder_MakeChunk(info);
+	OnChunkBuilt(info);
+}
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Chunks mangagement---------------------------------------------------*
@@ -388,11 +415,18 @@ static void FreeChunks(void) {
 	Mem_Free(sortedChunks);
 	Mem_Free(renderChunks);
 	Mem_Free(distances);
+	Mem_Free(visitQueue);
+	Mem_Free(visitedFaces);
+	Mem_Free(dirtyChunks);
 
 	mapChunks    = NULL;
 	sortedChunks = NULL;
 	renderChunks = NULL;
 	distances    = NULL;
+	visitQueue   = NULL;
+	visitedFaces = NULL;
+	dirtyChunks  = NULL;
+	dirtyCount   = 0;
 }
 
 static void AllocateParts(void) {
@@ -409,6 +443,9 @@ static void AllocateChunks(void) {
 	sortedChunks = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*), "sorted chunk info");
 	renderChunks = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*), "render chunk info");
 	distances    = (cc_uint32*)Mem_Alloc(chunksCount, 4, "chunk distances");
+	visitQueue   = (struct VisitNode*)Mem_Alloc(chunksCount * (FACE_COUNT + 1), sizeof(struct VisitNode), "chunk visit queue");
+	visitedFaces = (cc_uint8*)Mem_Alloc(chunksCount, 1, "chunk visited faces");
+	dirtyChunks  = (int*)Mem_Alloc(chunksCount, sizeof(int), "dirty chunks");
 }
 
 static void ResetPartFlags(void) {
@@ -431,6 +468,7 @@ static void ResetPartCounts(void) {
 
 static void InitChunks(void) {
 	int x, y, z, index = 0;
+	dirtyCount = 0;
 	for (z = 0; z < World.Length; z += CHUNK_SIZE) {
 		for (y = 0; y < World.Height; y += CHUNK_SIZE) {
 			for (x = 0; x < World.Width; x += CHUNK_SIZE) {
@@ -446,6 +484,7 @@ static void InitChunks(void) {
 
 static void ResetChunks(void) {
 	int x, y, z, index = 0;
+	dirtyCount = 0;
 	for (z = 0; z < World.Length; z += CHUNK_SIZE) {
 		for (y = 0; y < World.Height; y += CHUNK_SIZE) {
 			for (x = 0; x < World.Width; x += CHUNK_SIZE) {
@@ -469,8 +508,9 @@ static void DeleteChunks(void) {
 void MapRenderer_Refresh(void) {
 	int oldCount;
 	chunkPos = IVec3_MaxValue();
+	Builder_CancelChunks();
 
-	if (mapChunks && World.Blocks) {
+	if (mapChunks && World_HasBlocks()) {
 		DeleteChunks();
 		ResetChunks();
 
@@ -491,7 +531,7 @@ static void RefreshBorderChunks(int maxHeight) {
 	cc_bool onBorder;
 
 	chunkPos = IVec3_MaxValue();
-	if (!mapChunks || !World.Blocks) return;
+	if (!mapChunks || !World_HasBlocks()) return;
 
 	for (cz = 0; cz < World.ChunksZ; cz++) {
 		for (cy = 0; cy < World.ChunksY; cy++) {
@@ -507,6 +547,101 @@ static void RefreshBorderChunks(int maxHeight) {
 }
 
 
+/*########################################################################################################################*
+*----------------------------------------------------Occlusion culling----------------------------------------------------*
+*#########################################################################################################################*/
+/* Chunks are occluded when they can't be seen from the chunk the camera is in (e.g. caves behind solid terrain) */
+/* This is calculated using a breadth first search outwards from the camera's chunk, where the search only */
+/*  passes through a chunk from one face to another if the chunk's blocks allow seeing between those faces */
+static int visitCount;
+
+static void VisitChunk(int cx, int cy, int cz, int from, int dirs) {
+	int index = World_ChunkPack(cx, cy, cz);
+	struct VisitNode* node;
+
+	if (visitedFaces[index] & (1 << from)) return;
+	visitedFaces[index] |= 1 << from;
+	mapChunks[index].Occluded = false;
+
+	node = &visitQueue[visitCount++];
+	node->index = index;
+	node->from  = from;
+	node->dirs  = dirs;
+}
+
+/* Starts the search from chunks on the map boundary, when the camera is outside the map */
+static void VisitBoundaryChunks(IVec3 pos) {
+	int cx, cy, cz;
+	int maxX = World.ChunksX - 1, maxY = World.ChunksY - 1, maxZ = World.ChunksZ - 1;
+
+	for (cz = 0; cz <= maxZ; cz++) {
+		for (cy = 0; cy <= maxY; cy++) {
+			if (pos.X < 0)    VisitChunk(0,    cy, cz, FACE_XMIN, 1 << FACE_XMAX);
+			if (pos.X > maxX) VisitChunk(maxX, cy, cz, FACE_XMAX, 1 << FACE_XMIN);
+		}
+	}
+	for (cz = 0; cz <= maxZ; cz++) {
+		for (cx = 0; cx <= maxX; cx++) {
+			if (pos.Y < 0)    VisitChunk(cx, 0,    cz, FACE_YMIN, 1 << FACE_YMAX);
+			if (pos.Y > maxY) VisitChunk(cx, maxY, cz, FACE_YMAX, 1 << FACE_YMIN);
+		}
+	}
+	for (cy = 0; cy <= maxY; cy++) {
+		for (cx = 0; cx <= maxX; cx++) {
+			if (pos.Z < 0)    VisitChunk(cx, cy, 0,    FACE_ZMIN, 1 << FACE_ZMAX);
+			if (pos.Z > maxZ) VisitChunk(cx, cy, maxZ, FACE_ZMAX, 1 << FACE_ZMIN);
+		}
+	}
+}
+
+static void CalcOcclusion(void) {
+	struct VisitNode node;
+	struct ChunkInfo* info;
+	IVec3 pos;
+	int i, face, cx, cy, cz;
+
+	for (i = 0; i < chunksCount; i++) {
+		mapChunks[i].Occluded = occlusionCulling;
+	}
+	if (!occlusionCulling) return;
+
+	Mem_Set(visitedFaces, 0, chunksCount);
+	visitCount = 0;
+
+	IVec3_Floor(&pos, &Camera.CurrentPos);
+	pos.X >>= CHUNK_SHIFT; pos.Y >>= CHUNK_SHIFT; pos.Z >>= CHUNK_SHIFT;
+
+	if (pos.X >= 0 && pos.Y >= 0 && pos.Z >= 0 && 
+		pos.X < World.ChunksX && pos.Y < World.ChunksY && pos.Z < World.ChunksZ) {
+		/* Every face of the camera's chunk can be seen */
+		VisitChunk(pos.X, pos.Y, pos.Z, FACE_COUNT, 0);
+	} else {
+		VisitBoundaryChunks(pos);
+	}
+
+	for (i = 0; i < visitCount; i++) {
+		node = visitQueue[i];
+		info = &mapChunks[node.index];
+		cx = info->CentreX >> CHUNK_SHIFT; cy = info->CentreY >> CHUNK_SHIFT; cz = info->CentreZ >> CHUNK_SHIFT;
+
+		for (face = 0; face < FACE_COUNT; face++) {
+			/* Never travel back towards the camera */
+			if (node.dirs & (1 << (face ^ 1))) continue;
+			if (node.from != FACE_COUNT && !(info->Connected[node.from] & (1 << face))) continue;
+
+			switch (face) {
+			case FACE_XMIN: if (cx > 0)                 VisitChunk(cx - 1, cy, cz, FACE_XMAX, node.dirs | (1 << face)); break;
+			case FACE_XMAX: if (cx < World.ChunksX - 1) VisitChunk(cx + 1, cy, cz, FACE_XMIN, node.dirs | (1 << face)); break;
+			case FACE_ZMIN: if (cz > 0)                 VisitChunk(cx, cy, cz - 1, FACE_ZMAX, node.dirs | (1 << face)); break;
+			case FACE_ZMAX: if (cz < World.ChunksZ - 1) VisitChunk(cx, cy, cz + 1, FACE_ZMIN, node.dirs | (1 << face)); break;
+			case FACE_YMIN: if (cy > 0)                 VisitChunk(cx, cy - 1, cz, FACE_YMAX, node.dirs | (1 << face)); break;
+			case FACE_YMAX: if (cy < World.ChunksY - 1) VisitChunk(cx, cy + 1, cz, FACE_YMIN, node.dirs | (1 << face)); break;
+			}
+		}
+	}
+}
+
+
 /*########################################################################################################################*
 *--------------------------------------------------Chunks updating/sorting------------------------------------------------*
 *#########################################################################################################################*/
@@ -553,12 +688,11 @@ static int UpdateChunksAndVisibility(int* chunkUpdates) {
 		}
 		noData |= info->PendingDelete;
 
-		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget) {
-			DeleteChunk(info);
+		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget && !info->Building) {
 			BuildChunk(info, chunkUpdates);
 		}
 
-		info->Visible = distSqr <= renderDistSqr &&
+		info->Visible = !info->Occluded && distSqr <= renderDistSqr &&
 			FrustumCulling_SphereInFrustum(info->CentreX, info->CentreY, info->CentreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
 		if (info->Visible && !info->Empty) { renderChunks[j] = info; j++; }
 	}
@@ -586,12 +720,11 @@ static int UpdateChunksStill(int* chunkUpdates) {
 		}
 		noData |= info->PendingDelete;
 
-		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget) {
-			DeleteChunk(info);
+		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget && !info->Building) {
 			BuildChunk(info, chunkUpdates);
 
 			/* only need to update the visibility of chunks in range. */
-			info->Visible = distSqr <= renderDistSqr &&
+			info->Visible = !info->Occluded && distSqr <= renderDistSqr &&
 				FrustumCulling_SphereInFrustum(info->CentreX, info->CentreY, info->CentreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
 			if (info->Visible && !info->Empty) { renderChunks[j] = info; j++; }
 		} else if (info->Visible) {
@@ -601,19 +734,50 @@ static int UpdateChunksStill(int* chunkUpdates) {
 	return j;
 }
 
+/* Rebuilds chunks changed since the last frame before any other chunks, so changes show up */
+/*  as soon as possible. (e.g. blocks placed by the player) */
+/* NOTE: Each chunk is only rebuilt once, regardless of how many blocks in it were changed */
+static void UpdateDirtyChunks(int* chunkUpdates) {
+	struct ChunkInfo* info;
+	int i, dx, dy, dz;
+
+	for (i = 0; i < dirtyCount && *chunkUpdates < chunksTarget; i++) {
+		info = &mapChunks[dirtyChunks[i]];
+		/* Chunk might have already been rebuilt, or is still being built on a background thread */
+		/* In the latter case, chunk is just rebuilt later by UpdateChunksAndVisibility/UpdateChunksStill */
+		if (!info->PendingDelete || info->Building) continue;
+
+		dx = info->CentreX - chunkPos.X; dy = info->CentreY - chunkPos.Y; dz = info->CentreZ - chunkPos.Z;
+		if (dx * dx + dy * dy + dz * dz > buildDistSquared) continue;
+		BuildChunk(info, chunkUpdates);
+	}
+	dirtyCount = 0;
+}
+
 static void UpdateChunks(double delta) {
 	struct LocalPlayer* p;
 	cc_bool samePos;
-	int chunkUpdates = 0;
+	int chunkUpdates = 0, chunksBuilt;
 
 	/* Build more chunks if 30 FPS or over, otherwise slowdown */
 	chunksTarget += delta < CHUNK_TARGET_TIME ? 1 : -1; 
 	Math_Clamp(chunksTarget, 4, maxChunkUpdates);
 
+	/* Upload meshes of chunks which background threads have finished building */
+	chunksBuilt = Builder_FinishChunks(DeleteChunk, OnChunkBuilt);
+	UpdateDirtyChunks(&chunkUpdates);
+
 	p = &LocalPlayer_Instance;
 	samePos = Vec3_Equals(&Camera.CurrentPos, &lastCamPos)
 		&& p->Base.Pitch == lastPitch && p->Base.Yaw == lastYaw;
 
+	/* NOTE: This is also always the case when chunks were built by UpdateDirtyChunks */
+	if (occlusionDirty) {
+		CalcOcclusion();
+		/* Visibility of every chunk needs to be recalculated */
+		occlusionDirty = false; samePos = false;
+	}
+
 	renderChunksCount = samePos ?
 		UpdateChunksStill(&chunkUpdates) :
 		UpdateChunksAndVisibility(&chunkUpdates);
@@ -622,7 +786,7 @@ static void UpdateChunks(double delta) {
 	lastPitch  = p->Base.Pitch;
 	lastYaw    = p->Base.Yaw;
 
-	if (!samePos || chunkUpdates) ResetPartFlags();
+	if (!samePos || chunkUpdates || chunksBuilt) ResetPartFlags();
 }
 
 static void SortMapChunks(int left, int right) {
@@ -681,7 +845,7 @@ static void UpdateSortOrder(void) {
 
 	SortMapChunks(0, chunksCount - 1);
 	ResetPartFlags();
-	/*SimpleOcclusionCulling();*/
+	occlusionDirty = true;
 }
 
 void MapRenderer_Update(double delta) {
@@ -690,18 +854,41 @@ void MapRenderer_Update(double delta) {
 	UpdateChunks(delta);
 }
 
+int MapRenderer_UnbuiltChunks(void) {
+	struct ChunkInfo* info;
+	int i, count = 0;
+	if (!mapChunks) return 0;
+
+	for (i = 0; i < chunksCount; i++) {
+		info = &mapChunks[i];
+		if (info->Empty) continue;
+
+		if (info->Building || info->PendingDelete || (!info->NormalParts && !info->TranslucentParts)) count++;
+	}
+	return count;
+}
+
 
 /*########################################################################################################################*
 *---------------------------------------------------------General---------------------------------------------------------*
 *#########################################################################################################################*/
-void MapRenderer_RefreshChunk(int cx, int cy, int cz) {
-	struct ChunkInfo* info;
-	if (cx < 0 || cy < 0 || cz < 0 || cx >= World.ChunksX || cy >= World.ChunksY || cz >= World.ChunksZ) return;
-
-	info = &mapChunks[World_ChunkPack(cx, cy, cz)];
+static void RefreshChunk(struct ChunkInfo* info) {
 	if (info->AllAir) return; /* do not recreate chunks completely air */
-	info->Empty         = false;
+	info->Empty = false;
+	/* Already marked as needing to be rebuilt */
+	if (info->PendingDelete) return;
+
 	info->PendingDelete = true;
+	if (dirtyCount < chunksCount) dirtyChunks[dirtyCount++] = (int)(info - mapChunks);
+
+	/* Chunk might be visible through until its mesh is rebuilt */
+	Mem_Set(info->Connected, CHUNK_CONNECTED_ALL, FACE_COUNT);
+	occlusionDirty = true;
+}
+
+void MapRenderer_RefreshChunk(int cx, int cy, int cz) {
+	if (cx < 0 || cy < 0 || cz < 0 || cx >= World.ChunksX || cy >= World.ChunksY || cz >= World.ChunksZ) return;
+	RefreshChunk(&mapChunks[World_ChunkPack(cx, cy, cz)]);
 }
 
 void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block) {
@@ -710,8 +897,7 @@ void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block) {
 
 	chunk = &mapChunks[World_ChunkPack(cx, cy, cz)];
 	chunk->AllAir &= Blocks.Draw[block] == DRAW_GAS;
-	/* TODO: Don't lookup twice, refresh directly using chunk pointer */
-	MapRenderer_RefreshChunk(cx, cy, cz);
+	RefreshChunk(chunk);
 }
 
 static void OnEnvVariableChanged(void* obj, int envVar) {
@@ -749,11 +935,12 @@ static void OnVisibilityChanged(void* obj) {
 	lastCamPos = Vec3_BigPos();
 	CalcViewDists();
 }
-static void DeleteChunks_(void* obj) { DeleteChunks(); }
+static void DeleteChunks_(void* obj) { Builder_CancelChunks(); DeleteChunks(); }
 static void Refresh_(void* obj)      { MapRenderer_Refresh(); }
 
 static void OnNewMap(void) {
 	Game.ChunkUpdates = 0;
+	Builder_CancelChunks();
 	DeleteChunks();
 	ResetPartCounts();
 
@@ -775,6 +962,9 @@ static void OnNewMapLoaded(void) {
 
 	InitChunks();
 	lastCamPos = Vec3_BigPos();
+	/* Nothing has been built yet, so start filling in the map as fast as possible */
+	/*  (rather than at whatever rate the previous map had slowed down to) */
+	chunksTarget = maxChunkUpdates;
 }
 
 static void OnInit(void) {
@@ -791,6 +981,7 @@ static void OnInit(void) {
 	MapRenderer_1DUsedCount = 87; /* Atlas1D_UsedAtlasesCount(); */
 	chunkPos   = IVec3_MaxValue();
 	maxChunkUpdates = Options_GetInt(OPT_MAX_CHUNK_UPDATES, 4, 1024, 30);
+	occlusionCulling = Options_GetBool(OPT_OCCLUSION_CULLING, true);
 	CalcViewDists();
 }
 
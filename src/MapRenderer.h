@@ -30,6 +30,9 @@ struct ChunkPartInfo {
 	cc_uint16 Counts[FACE_COUNT]; /* Counts per face */
 };
 
+/* Every face of a chunk can be seen through the chunk from every other face */
+#define CHUNK_CONNECTED_ALL 0x3F
+
 /* Describes data necessary for rendering a chunk. */
 struct ChunkInfo {	
 	cc_uint16 CentreX, CentreY, CentreZ; /* Centre coordinates of the chunk */
@@ -38,6 +41,8 @@ struct ChunkInfo {
 	cc_uint8 Empty : 1;         /* Whether the chunk is empty of data */
 	cc_uint8 PendingDelete : 1; /* Whether chunk is pending deletion */
 	cc_uint8 AllAir : 1;        /* Whether chunk is completely air */
+	cc_uint8 Building : 1;      /* Whether chunk mesh is being built on a background thread */
+	cc_uint8 Occluded : 1;      /* Whether chunk cannot be seen from the chunk the camera is in */
 	cc_uint8 : 0;               /* pad to next byte*/
 
 	cc_uint8 DrawXMin : 1;
@@ -47,10 +52,8 @@ struct ChunkInfo {
 	cc_uint8 DrawYMin : 1;
 	cc_uint8 DrawYMax : 1;
 	cc_uint8 : 0;          /* pad to next byte */
-#ifdef OCCLUSION
-	public cc_bool Visited = false, Occluded = false;
-	public byte OcclusionFlags, OccludedFlags, DistanceFlags;
-#endif
+	/* Faces of the chunk that can be seen through the chunk from each face. (bit flags) */
+	cc_uint8 Connected[FACE_COUNT];
 #ifndef CC_BUILD_GL11
 	GfxResourceID Vb;
 #endif
@@ -66,6 +69,9 @@ void MapRenderer_RenderTranslucent(double delta);
 /* Potentially builds meshes for several nearby chunks. */
 /* NOTE: This should be called once per frame. */
 void MapRenderer_Update(double delta);
+/* Returns number of non-empty chunks that do not have an up to date mesh yet. */
+/* NOTE: Chunks outside the build distance are also counted. */
+int MapRenderer_UnbuiltChunks(void);
 
 /* Marks the given chunk as needing to be rebuilt/redrawn. */
 /* NOTE: Coordinates outside the map are simply ignored. */
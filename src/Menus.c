@@ -1393,6 +1393,8 @@ static void SaveLevelScreen_RemoveOverwrites(struct SaveLevelScreen* s) {
 	}
 }
 
+static const char* const saveCompression_names[DEFLATE_LEVEL_COUNT] = { "Fast", "Normal", "Best" };
+
 static cc_result SaveLevelScreen_SaveMap(const cc_string* path) {
 	static const cc_string schematic = String_FromConst(".schematic");
 	static const cc_string mine = String_FromConst(".mine");
@@ -1403,6 +1405,8 @@ static cc_result SaveLevelScreen_SaveMap(const cc_string* path) {
 	res = Stream_CreateFile(&stream, path);
 	if (res) { Logger_SysWarn2(res, "creating", path); return res; }
 	GZip_MakeStream(&compStream, &state, &stream);
+	Deflate_SetLevel(&state.Base, Options_GetEnum(OPT_SAVE_COMPRESSION, DEFLATE_LEVEL_NORMAL,
+						saveCompression_names, DEFLATE_LEVEL_COUNT));
 
 	if (String_CaselessEnds(path, &schematic)) {
 		res = Schematic_Save(&compStream);
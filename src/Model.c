@@ -12,6 +12,10 @@
 #include "Block.h"
 #include "Stream.h"
 #include "Options.h"
+#if defined __SSE2__
+#include <emmintrin.h>
+#define MODEL_SSE2
+#endif
 
 struct _ModelsData Models;
 /* NOTE: None of the built in models use more than 12 parts at once, but custom models can use up to 64 parts. */
@@ -93,6 +97,11 @@ float Model_RenderDistance(struct Entity* e) {
 	return dx * dx + dy * dy + dz * dz;
 }
 
+/* Whether Model_BeginBatch has been called */
+static cc_bool batch_active;
+/* Transform of the entity whose vertices are currently being merged (NULL if not merging) */
+static struct Matrix* batch_transform;
+
 void Model_Render(struct Model* model, struct Entity* e) {
 	struct Matrix m;
 	Vec3 pos = e->Position;
@@ -104,6 +113,13 @@ void Model_Render(struct Model* model, struct Entity* e) {
 	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
 
 	model->GetTransform(e, pos, &e->Transform);
+	if (batch_active && (model->flags & MODEL_FLAG_BATCHED)) {
+		/* Vertices get transformed in Model_UnlockVB instead */
+		batch_transform = &e->Transform;
+		model->Draw(e);
+		batch_transform = NULL;
+		return;
+	}
 	Matrix_Mul(&m, &e->Transform, &Gfx.View);
 
 	Gfx_LoadMatrix(MATRIX_VIEW, &m);
@@ -143,6 +159,7 @@ void Model_SetupState(struct Model* model, struct Entity* e) {
 	Models.Active  = model;
 }
 
+static void Model_BindTexture(GfxResourceID tex);
 void Model_ApplyTexture(struct Entity* e) {
 	struct Model* model = Models.Active;
 	struct ModelTex* data;
@@ -158,7 +175,7 @@ void Model_ApplyTexture(struct Entity* e) {
 		Models.skinType = data->skinType;
 	}
 
-	Gfx_BindTexture(tex);
+	Model_BindTexture(tex);
 	_64x64 = Models.skinType != SKIN_64x32;
 
 	Models.uScale = e->uScale * 0.015625f;
@@ -180,7 +197,11 @@ void Model_UpdateVB(void) {
 static struct VertexTextured* real_vertices;
 static GfxResourceID modelVB;
 
+static void Model_LockBatch(int verticesCount);
+static void Model_UnlockBatch(void);
+
 void Model_LockVB(struct Entity* entity, int verticesCount) {
+	if (batch_transform) { Model_LockBatch(verticesCount); return; }
 #ifdef CC_BUILD_LOWMEM
 	if (!entity->ModelVB) {
 		entity->ModelVB = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, Models.Active->maxVertices);
@@ -198,11 +219,176 @@ void Model_LockVB(struct Entity* entity, int verticesCount) {
 }
 
 void Model_UnlockVB(void) {
+	if (batch_transform) { Model_UnlockBatch(); return; }
+
 	Gfx_UnlockDynamicVb(modelVB);
 	Models.Vertices = real_vertices;
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------------Batching------------------------------------------------------*
+*#########################################################################################################################*/
+/* Maximum number of vertices merged before they must be drawn */
+/* NOTE: Must be at least MODELS_MAX_VERTICES, since Model_LockVB can request that many vertices */
+#define MODELS_BATCH_VERTICES 32768
+/* Maximum number of draw calls queued before they must be drawn */
+#define MODELS_BATCH_DRAWS 512
+/* Maximum number of draw calls a model queues after a call to Model_LockVB */
+#define MODELS_BATCH_DRAWS_PER_LOCK 4
+
+struct ModelBatchDraw { GfxResourceID tex; int offset, count; cc_bool alphaTest; };
+static struct ModelBatchDraw batch_draws[MODELS_BATCH_DRAWS];
+static struct VertexTextured* batch_vertices;
+static int batch_count, batch_numDraws;
+/* Index and number of the vertices returned by the most recent Model_LockVB call */
+static int batch_lockOffset, batch_lockCount;
+static GfxResourceID batch_vb, batch_tex;
+static cc_bool batch_alphaTest;
+
+static void Model_BindTexture(GfxResourceID tex) {
+	if (batch_transform) { batch_tex = tex; return; }
+	Gfx_BindTexture(tex);
+}
+
+static void Model_SetAlphaTest(cc_bool enabled) {
+	if (batch_transform) { batch_alphaTest = enabled; return; }
+	Gfx_SetAlphaTest(enabled);
+}
+
+static cc_bool Model_DrawBefore(struct ModelBatchDraw* a, struct ModelBatchDraw* b) {
+	if (a->tex != b->tex) return (cc_uintptr)a->tex < (cc_uintptr)b->tex;
+	return a->alphaTest < b->alphaTest;
+}
+
+/* Copies the vertices of all queued draw calls into the vertex buffer, */
+/*  with the vertices of draw calls that use the same state next to each other */
+static void Model_UploadBatch(void) {
+	struct VertexTextured* dst;
+	struct ModelBatchDraw draw;
+	int i, j, offset = 0;
+
+	/* Insertion sort, since draw calls are mostly in order already */
+	for (i = 1; i < batch_numDraws; i++)
+	{
+		draw = batch_draws[i];
+		for (j = i; j > 0 && Model_DrawBefore(&draw, &batch_draws[j - 1]); j--)
+		{
+			batch_draws[j] = batch_draws[j - 1];
+		}
+		batch_draws[j] = draw;
+	}
+
+	dst = (struct VertexTextured*)Gfx_LockDynamicVb(batch_vb, VERTEX_FORMAT_TEXTURED, batch_count);
+	for (i = 0; i < batch_numDraws; i++)
+	{
+		Mem_Copy(dst + offset, batch_vertices + batch_draws[i].offset, 
+				batch_draws[i].count * sizeof(struct VertexTextured));
+		batch_draws[i].offset = offset;
+		offset += batch_draws[i].count;
+	}
+	Gfx_UnlockDynamicVb(batch_vb);
+}
+
+static void Model_FlushBatch(void) {
+	struct ModelBatchDraw* draw;
+	int i, count;
+	if (!batch_numDraws) { batch_count = 0; return; }
+
+	if (!batch_vb) {
+		batch_vb = Gfx_CreateDynamicVb(VERTEX_FORMAT_TEXTURED, MODELS_BATCH_VERTICES);
+	}
+	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+	Model_UploadBatch();
+
+	for (i = 0; i < batch_numDraws; i += count)
+	{
+		draw = &batch_draws[i];
+		Gfx_BindTexture(draw->tex);
+		Gfx_SetAlphaTest(draw->alphaTest);
+
+		/* Vertices of draw calls with the same state are now contiguous */
+		for (count = 1; i + count < batch_numDraws; count++)
+		{
+			if (Model_DrawBefore(draw, &batch_draws[i + count])) break;
+		}
+		Gfx_DrawVb_IndexedTris_Range(draw[count - 1].offset + draw[count - 1].count - draw->offset, draw->offset);
+	}
+
+	Gfx_SetAlphaTest(true);
+	batch_count    = 0;
+	batch_numDraws = 0;
+}
+
+static void Model_LockBatch(int verticesCount) {
+	if (batch_count + verticesCount > MODELS_BATCH_VERTICES ||
+		batch_numDraws + MODELS_BATCH_DRAWS_PER_LOCK > MODELS_BATCH_DRAWS) Model_FlushBatch();
+
+	batch_lockOffset = batch_count;
+	batch_lockCount  = verticesCount;
+	batch_count     += verticesCount;
+
+	real_vertices   = Models.Vertices;
+	Models.Vertices = batch_vertices + batch_lockOffset;
+}
+
+static void Model_UnlockBatch(void) {
+	struct VertexTextured* v = Models.Vertices;
+	struct Matrix* m = batch_transform;
+	float x, y, z;
+	int i;
+
+	/* Transform vertices into world space, so all entities can be drawn with the same view matrix */
+	for (i = 0; i < batch_lockCount; i++, v++)
+	{
+		x = v->X; y = v->Y; z = v->Z;
+		v->X = x * m->row1.X + y * m->row2.X + z * m->row3.X + m->row4.X;
+		v->Y = x * m->row1.Y + y * m->row2.Y + z * m->row3.Y + m->row4.Y;
+		v->Z = x * m->row1.Z + y * m->row2.Z + z * m->row3.Z + m->row4.Z;
+	}
+	Models.Vertices = real_vertices;
+}
+
+void Model_DrawVb_Range(int verticesCount, int startVertex) {
+	struct ModelBatchDraw* draw;
+	int offset;
+	if (!batch_transform) { Gfx_DrawVb_IndexedTris_Range(verticesCount, startVertex); return; }
+
+	offset = batch_lockOffset + startVertex;
+
+	/* Extend the previous draw call when possible */
+	if (batch_numDraws) {
+		draw = &batch_draws[batch_numDraws - 1];
+		if (draw->tex == batch_tex && draw->alphaTest == batch_alphaTest && draw->offset + draw->count == offset) {
+			draw->count += verticesCount; return;
+		}
+	}
+
+	draw = &batch_draws[batch_numDraws++];
+	draw->tex       = batch_tex;
+	draw->alphaTest = batch_alphaTest;
+	draw->offset    = offset;
+	draw->count     = verticesCount;
+}
+
+void Model_BeginBatch(void) {
+	/* Low memory builds use per entity vertex buffers instead */
+#ifndef CC_BUILD_LOWMEM
+	if (!batch_vertices) {
+		batch_vertices = (struct VertexTextured*)Mem_Alloc(MODELS_BATCH_VERTICES, 
+											sizeof(struct VertexTextured), "model batch vertices");
+	}
+	batch_active    = true;
+	batch_alphaTest = true;
+#endif
+}
+
+void Model_EndBatch(void) {
+	Model_FlushBatch();
+	batch_active = false;
+}
+
+
 void Model_DrawPart(struct ModelPart* part) {
 	struct Model* model        = Models.Active;
 	struct ModelVertex* src    = &model->vertices[part->offset];
@@ -227,22 +413,26 @@ void Model_DrawPart(struct ModelPart* part) {
 #define Model_RotateY t = cosY * v.X - sinY * v.Z; v.Z =  sinY * v.X + cosY * v.Z; v.X = t;
 #define Model_RotateZ t = cosZ * v.X + sinZ * v.Y; v.Y = -sinZ * v.X + cosZ * v.Y; v.X = t;
 
-void Model_DrawRotate(float angleX, float angleY, float angleZ, struct ModelPart* part, cc_bool head) {
-	struct Model* model        = Models.Active;
-	struct ModelVertex* src    = &model->vertices[part->offset];
-	struct VertexTextured* dst = &Models.Vertices[model->index];
+/* Combined rotation of a model part, which transforms a vertex to */
+/*  X * axes[0] + Y * axes[1] + Z * axes[2] + translate */
+struct PartTransform { Vec3 axes[3], translate; };
 
+static void Model_CalcPartTransform(float angleX, float angleY, float angleZ, 
+									struct ModelPart* part, cc_bool head, struct PartTransform* m) {
 	float cosX = (float)Math_Cos(-angleX), sinX = (float)Math_Sin(-angleX);
 	float cosY = (float)Math_Cos(-angleY), sinY = (float)Math_Sin(-angleY);
 	float cosZ = (float)Math_Cos(-angleZ), sinZ = (float)Math_Sin(-angleZ);
 	float t, x = part->rotX, y = part->rotY, z = part->rotZ;
-	
+
 	struct ModelVertex v;
-	int i, count = part->count;
+	int i;
 
-	for (i = 0; i < count; i++) {
-		v = *src;
-		v.X -= x; v.Y -= y; v.Z -= z;
+	/* Rotating each unit axis gives the columns of the combined rotation matrix */
+	for (i = 0; i < 3; i++) 
+	{
+		v.X = i == 0 ? 1.0f : 0.0f;
+		v.Y = i == 1 ? 1.0f : 0.0f;
+		v.Z = i == 2 ? 1.0f : 0.0f;
 
 		/* Rotate locally */
 		if (Models.Rotation == ROTATE_ORDER_ZYX) {
@@ -267,16 +457,107 @@ void Model_DrawRotate(float angleX, float angleY, float angleZ, struct ModelPart
 		if (head) {
 			t = Models.cosHead * v.X - Models.sinHead * v.Z; v.Z = Models.sinHead * v.X + Models.cosHead * v.Z; v.X = t;
 		}
-		dst->X = v.X + x; dst->Y = v.Y + y; dst->Z = v.Z + z;
-		dst->Col = Models.Cols[i >> 2];
+		m->axes[i].X = v.X; m->axes[i].Y = v.Y; m->axes[i].Z = v.Z;
+	}
 
-		dst->U = (v.U & UV_POS_MASK) * Models.uScale - (v.U >> UV_MAX_SHIFT) * 0.01f * Models.uScale;
-		dst->V = (v.V & UV_POS_MASK) * Models.vScale - (v.V >> UV_MAX_SHIFT) * 0.01f * Models.vScale;
-		src++; dst++;
+	/* Vertices are rotated around the part's origin, so origin + M * (vertex - origin) */
+	m->translate.X = x - (m->axes[0].X * x + m->axes[1].X * y + m->axes[2].X * z);
+	m->translate.Y = y - (m->axes[0].Y * x + m->axes[1].Y * y + m->axes[2].Y * z);
+	m->translate.Z = z - (m->axes[0].Z * x + m->axes[1].Z * y + m->axes[2].Z * z);
+}
+
+/* Unpacks vertices into separate X/Y/Z/U/V arrays, each 'stride' floats apart */
+/* NOTE: U/V are stored as texel coordinates, which only need to be multiplied by Models.uScale/vScale */
+static void Model_UnpackVertices(const struct ModelVertex* src, int count, int stride, float* dst) {
+	int i;
+	for (i = 0; i < count; i++, src++) 
+	{
+		dst[i]              = src->X;
+		dst[i + stride]     = src->Y;
+		dst[i + stride * 2] = src->Z;
+		dst[i + stride * 3] = (src->U & UV_POS_MASK) - (src->U >> UV_MAX_SHIFT) * 0.01f;
+		dst[i + stride * 4] = (src->V & UV_POS_MASK) - (src->V >> UV_MAX_SHIFT) * 0.01f;
+	}
+}
+
+/* Transforms unpacked vertices, then appends them to Models.Vertices */
+/* 'first' is the index of the first vertex within the part (used to pick face colour) */
+static void Model_DrawUnpacked(const struct PartTransform* m, const float* src, int stride, int count, int first) {
+	struct Model* model        = Models.Active;
+	struct VertexTextured* dst = &Models.Vertices[model->index];
+	const float* xs = src;
+	const float* ys = src + stride;
+	const float* zs = src + stride * 2;
+	const float* us = src + stride * 3;
+	const float* vs = src + stride * 4;
+	float x, y, z;
+	int i = 0;
+
+#ifdef MODEL_SSE2
+	__m128 ax_x = _mm_set1_ps(m->axes[0].X), ay_x = _mm_set1_ps(m->axes[1].X), az_x = _mm_set1_ps(m->axes[2].X);
+	__m128 ax_y = _mm_set1_ps(m->axes[0].Y), ay_y = _mm_set1_ps(m->axes[1].Y), az_y = _mm_set1_ps(m->axes[2].Y);
+	__m128 ax_z = _mm_set1_ps(m->axes[0].Z), ay_z = _mm_set1_ps(m->axes[1].Z), az_z = _mm_set1_ps(m->axes[2].Z);
+	__m128 t_x  = _mm_set1_ps(m->translate.X), t_y = _mm_set1_ps(m->translate.Y), t_z = _mm_set1_ps(m->translate.Z);
+	__m128 uScale = _mm_set1_ps(Models.uScale), vScale = _mm_set1_ps(Models.vScale);
+	__m128 vx, vy, vz;
+	float outX[4], outY[4], outZ[4], outU[4], outV[4];
+	PackedCol col;
+	int j;
+
+	/* 4 vertices always belong to the same face, as long as 'first' is a multiple of 4 */
+	for (; i + 4 <= count && !(first & 3); i += 4)
+	{
+		vx = _mm_loadu_ps(xs + i); vy = _mm_loadu_ps(ys + i); vz = _mm_loadu_ps(zs + i);
+
+		_mm_storeu_ps(outX, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, ax_x), _mm_mul_ps(vy, ay_x)), _mm_add_ps(_mm_mul_ps(vz, az_x), t_x)));
+		_mm_storeu_ps(outY, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, ax_y), _mm_mul_ps(vy, ay_y)), _mm_add_ps(_mm_mul_ps(vz, az_y), t_y)));
+		_mm_storeu_ps(outZ, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, ax_z), _mm_mul_ps(vy, ay_z)), _mm_add_ps(_mm_mul_ps(vz, az_z), t_z)));
+		_mm_storeu_ps(outU, _mm_mul_ps(_mm_loadu_ps(us + i), uScale));
+		_mm_storeu_ps(outV, _mm_mul_ps(_mm_loadu_ps(vs + i), vScale));
+
+		col = Models.Cols[(first + i) >> 2];
+		for (j = 0; j < 4; j++, dst++)
+		{
+			dst->X = outX[j]; dst->Y = outY[j]; dst->Z = outZ[j];
+			dst->Col = col;
+			dst->U = outU[j]; dst->V = outV[j];
+		}
+	}
+#endif
+
+	for (; i < count; i++, dst++)
+	{
+		x = xs[i]; y = ys[i]; z = zs[i];
+		dst->X = x * m->axes[0].X + y * m->axes[1].X + z * m->axes[2].X + m->translate.X;
+		dst->Y = x * m->axes[0].Y + y * m->axes[1].Y + z * m->axes[2].Y + m->translate.Y;
+		dst->Z = x * m->axes[0].Z + y * m->axes[1].Z + z * m->axes[2].Z + m->translate.Z;
+		dst->Col = Models.Cols[(first + i) >> 2];
+
+		dst->U = us[i] * Models.uScale;
+		dst->V = vs[i] * Models.vScale;
 	}
 	model->index += count;
 }
 
+/* Number of vertices that Model_DrawRotate unpacks at once */
+#define MODEL_UNPACK_VERTICES 32
+
+void Model_DrawRotate(float angleX, float angleY, float angleZ, struct ModelPart* part, cc_bool head) {
+	struct Model* model     = Models.Active;
+	struct ModelVertex* src = &model->vertices[part->offset];
+	float unpacked[MODEL_UNPACK_VERTICES * 5];
+	struct PartTransform m;
+	int i, count;
+
+	Model_CalcPartTransform(angleX, angleY, angleZ, part, head, &m);
+	for (i = 0; i < part->count; i += count)
+	{
+		count = min(part->count - i, MODEL_UNPACK_VERTICES);
+		Model_UnpackVertices(src + i, count, MODEL_UNPACK_VERTICES, unpacked);
+		Model_DrawUnpacked(&m, unpacked, MODEL_UNPACK_VERTICES, count, i);
+	}
+}
+
 void Model_RenderArm(struct Model* model, struct Entity* e) {
 	struct Matrix m, translate;
 	Vec3 pos = e->Position;
@@ -509,15 +790,18 @@ void Model_RegisterTexture(struct ModelTex* tex) {
 	LinkedList_Append(tex, textures_head, textures_tail);
 }
 
-static void Models_TextureChanged(void* obj, struct Stream* stream, const cc_string* name) {
+struct ModelTex* Model_GetTexture(const cc_string* name) {
 	struct ModelTex* tex;
 
 	for (tex = textures_head; tex; tex = tex->next) {
-		if (!String_CaselessEqualsConst(name, tex->name)) continue;
-
-		Game_UpdateTexture(&tex->texID, stream, name, &tex->skinType);
-		return;
+		if (String_CaselessEqualsConst(name, tex->name)) return tex;
 	}
+	return NULL;
+}
+
+static void Models_TextureChanged(void* obj, struct Stream* stream, const cc_string* name) {
+	struct ModelTex* tex = Model_GetTexture(name);
+	if (tex) Game_UpdateTexture(&tex->texID, stream, name, &tex->skinType);
 }
 
 
@@ -659,6 +943,8 @@ static void CustomModel_DrawPart(
 	cc_bool head = false;
 	cc_bool modifiedVertices = false;
 	float value = 0.0f;
+	struct PartTransform m;
+	float* unpacked;
 
 	if (part->fullbright) {
 		for (i = 0; i < FACE_COUNT; i++) 
@@ -766,7 +1052,11 @@ static void CustomModel_DrawPart(
 		}
 	}
 
-	if (rotX || rotY || rotZ || head) {
+	if (!modifiedVertices && cm->unpackedVertices) {
+		unpacked = cm->unpackedVertices + (part - cm->parts) * MODEL_BOX_VERTICES * 5;
+		Model_CalcPartTransform(rotX, rotY, rotZ, &part->modelPart, head, &m);
+		Model_DrawUnpacked(&m, unpacked, MODEL_BOX_VERTICES, MODEL_BOX_VERTICES, 0);
+	} else if (rotX || rotY || rotZ || head) {
 		Model_DrawRotate(rotX, rotY, rotZ, &part->modelPart, head);
 	} else {
 		Model_DrawPart(&part->modelPart);
@@ -803,7 +1093,7 @@ static void CustomModel_Draw(struct Entity* e) {
 	}
 
 	Model_UnlockVB();
-	Gfx_DrawVb_IndexedTris(cm->numParts * MODEL_BOX_VERTICES);
+	Model_DrawVb_Range(cm->numParts * MODEL_BOX_VERTICES, 0);
 	Models.Rotation = ROTATE_ORDER_ZYX;
 }
 
@@ -853,10 +1143,22 @@ static void CheckMaxVertices(void) {
 	}
 }
 
+static void CustomModel_UnpackVertices(struct CustomModel* cm) {
+	int i, stride = MODEL_BOX_VERTICES * 5;
+	cm->unpackedVertices = (float*)Mem_Alloc(cm->numParts, stride * sizeof(float), "CustomModel unpacked");
+
+	for (i = 0; i < cm->numParts; i++)
+	{
+		Model_UnpackVertices(&cm->model.vertices[i * MODEL_BOX_VERTICES], MODEL_BOX_VERTICES,
+							MODEL_BOX_VERTICES, cm->unpackedVertices + i * stride);
+	}
+}
+
 void CustomModel_Register(struct CustomModel* cm) {
 	static struct ModelTex customDefaultTex;
 
 	CheckMaxVertices();
+	if (!cm->unpackedVertices) CustomModel_UnpackVertices(cm);
 	cm->model.name       = cm->name;
 	cm->model.defaultTex = &customDefaultTex;
 
@@ -867,6 +1169,7 @@ void CustomModel_Register(struct CustomModel* cm) {
 	cm->model.GetCollisionSize = CustomModel_GetCollisionSize;
 	cm->model.GetPickingBounds = CustomModel_GetPickingBounds;
 	cm->model.DrawArm          = CustomModel_DrawArm;
+	cm->model.flags           |= MODEL_FLAG_BATCHED;
 
 	/* add to front of models linked list to override original models */
 	if (!models_head) {
@@ -884,6 +1187,7 @@ void CustomModel_Undefine(struct CustomModel* cm) {
 	if (cm->registered) Model_Unregister((struct Model*)cm);
 
 	Mem_Free(cm->model.vertices);
+	Mem_Free(cm->unpackedVertices);
 	Mem_Set(cm, 0, sizeof(struct CustomModel));
 }
 
@@ -949,12 +1253,12 @@ static void HumanModel_DrawCore(struct Entity* e, struct ModelSet* model, cc_boo
 	Model_UnlockVB();
 	if (opaqueBody) {
 		/* human model draws the body opaque so players can't have invisible skins */
-		Gfx_SetAlphaTest(false);
-		Gfx_DrawVb_IndexedTris_Range(HUMAN_BASE_VERTICES, 0);
-		Gfx_SetAlphaTest(true);
-		Gfx_DrawVb_IndexedTris_Range(num - HUMAN_BASE_VERTICES, HUMAN_BASE_VERTICES);
+		Model_SetAlphaTest(false);
+		Model_DrawVb_Range(HUMAN_BASE_VERTICES, 0);
+		Model_SetAlphaTest(true);
+		Model_DrawVb_Range(num - HUMAN_BASE_VERTICES, HUMAN_BASE_VERTICES);
 	} else {
-		Gfx_DrawVb_IndexedTris(num);
+		Model_DrawVb_Range(num, 0);
 	}
 }
 
@@ -1147,7 +1451,7 @@ static void HumanoidModel_Register(void) {
 
 	human_model.calcHumanAnims = true;
 	human_model.usesHumanSkin  = true;
-	human_model.flags |= MODEL_FLAG_CLEAR_HAT;
+	human_model.flags |= MODEL_FLAG_CLEAR_HAT | MODEL_FLAG_BATCHED;
 	human_model.maxVertices    = HUMAN_MAX_VERTICES;
 
 	Model_Register(&human_model);
@@ -1242,7 +1546,7 @@ static void ChibiModel_Register(void) {
 
 	chibi_model.calcHumanAnims = true;
 	chibi_model.usesHumanSkin  = true;
-	chibi_model.flags |= MODEL_FLAG_CLEAR_HAT;
+	chibi_model.flags |= MODEL_FLAG_CLEAR_HAT | MODEL_FLAG_BATCHED;
 	chibi_model.maxVertices    = HUMAN_MAX_VERTICES;
 
 	chibi_model.maxScale    = 3.0f;
@@ -1283,7 +1587,7 @@ static void SittingModel_Register(void) {
 
 	sitting_model.calcHumanAnims = true;
 	sitting_model.usesHumanSkin  = true;
-	sitting_model.flags |= MODEL_FLAG_CLEAR_HAT;
+	sitting_model.flags |= MODEL_FLAG_CLEAR_HAT | MODEL_FLAG_BATCHED;
 	sitting_model.maxVertices    = HUMAN_MAX_VERTICES;
 
 	sitting_model.shadowScale  = 0.5f;
@@ -1335,7 +1639,7 @@ static void HeadModel_Draw(struct Entity* e) {
 	Model_DrawRotate(-e->Pitch * MATH_DEG2RAD, 0, 0, &part, true);
 
 	Model_UnlockVB();
-	Gfx_DrawVb_IndexedTris(HEAD_MAX_VERTICES);
+	Model_DrawVb_Range(HEAD_MAX_VERTICES, 0);
 }
 
 static float HeadModel_GetEyeY(struct Entity* e)  { return 6.0f/16.0f; }
@@ -1351,7 +1655,7 @@ static struct Model head_model = { "head", human_vertices, &human_tex,
 static void HeadModel_Register(void) {
 	Model_Init(&head_model);
 	head_model.usesHumanSkin = true;
-	head_model.flags |= MODEL_FLAG_CLEAR_HAT;
+	head_model.flags |= MODEL_FLAG_CLEAR_HAT | MODEL_FLAG_BATCHED;
 
 	head_model.pushes        = false;
 	head_model.GetTransform  = HeadModel_GetTransform;
@@ -1449,7 +1753,7 @@ static void ChickenModel_Draw(struct Entity* e) {
 	Model_DrawRotate(e->Anim.RightLegX, 0, 0, &chicken_rightLeg, false);
 
 	Model_UnlockVB();
-	Gfx_DrawVb_IndexedTris(CHICKEN_MAX_VERTICES);
+	Model_DrawVb_Range(CHICKEN_MAX_VERTICES, 0);
 }
 
 static float ChickenModel_GetNameY(struct Entity* e) { return 1.0125f; }
@@ -1468,6 +1772,7 @@ static struct Model chicken_model = { "chicken", chicken_vertices, &chicken_tex,
 static void ChickenModel_Register(void) {
 	Model_Init(&chicken_model);
 	chicken_model.maxVertices = CHICKEN_MAX_VERTICES;
+	chicken_model.flags |= MODEL_FLAG_BATCHED;
 	Model_Register(&chicken_model);
 }
 
@@ -1531,7 +1836,7 @@ static void CreeperModel_Draw(struct Entity* e) {
 	Model_DrawRotate(e->Anim.LeftLegX,  0, 0, &creeper_rightLegBack,  false);
 
 	Model_UnlockVB();
-	Gfx_DrawVb_IndexedTris(CREEPER_MAX_VERTICES);
+	Model_DrawVb_Range(CREEPER_MAX_VERTICES, 0);
 }
 
 static float CreeperModel_GetNameY(struct Entity* e) { return 1.7f; }
@@ -1551,6 +1856,7 @@ static struct Model creeper_model  = {
 static void CreeperModel_Register(void) {
 	Model_Init(&creeper_model);
 	creeper_model.maxVertices = CREEPER_MAX_VERTICES;
+	creeper_model.flags |= MODEL_FLAG_BATCHED;
 	Model_Register(&creeper_model);
 }
 
@@ -1614,7 +1920,7 @@ static void PigModel_Draw(struct Entity* e) {
 	Model_DrawRotate(e->Anim.LeftLegX,  0, 0, &pig_rightLegBack,  false);
 
 	Model_UnlockVB();
-	Gfx_DrawVb_IndexedTris(PIG_MAX_VERTICES);
+	Model_DrawVb_Range(PIG_MAX_VERTICES, 0);
 }
 
 static float PigModel_GetNameY(struct Entity* e) { return 1.075f; }
@@ -1633,6 +1939,7 @@ static struct Model pig_model  = { "pig", pig_vertices, &pig_tex,
 static void PigModel_Register(void) {
 	Model_Init(&pig_model);
 	pig_model.maxVertices = PIG_MAX_VERTICES;
+	pig_model.flags |= MODEL_FLAG_BATCHED;
 	Model_Register(&pig_model);
 }
 
@@ -1748,7 +2055,7 @@ static void FurlessModel_Draw(struct Entity* e) {
 	SheepModel_DrawBody(e);
 
 	Model_UnlockVB();
-	Gfx_DrawVb_IndexedTris(SHEEP_BODY_VERTICES);
+	Model_DrawVb_Range(SHEEP_BODY_VERTICES, 0);
 }
 
 static void SheepModel_Draw(struct Entity* e) {
@@ -1764,9 +2071,9 @@ static void SheepModel_Draw(struct Entity* e) {
 	Model_DrawRotate(e->Anim.LeftLegX,  0, 0, &fur_rightLegBack,  false);
 
 	Model_UnlockVB();
-	Gfx_DrawVb_IndexedTris(SHEEP_BODY_VERTICES);
-	Gfx_BindTexture(fur_tex.texID);
-	Gfx_DrawVb_IndexedTris_Range(SHEEP_FUR_VERTICES, SHEEP_BODY_VERTICES);
+	Model_DrawVb_Range(SHEEP_BODY_VERTICES, 0);
+	Model_BindTexture(fur_tex.texID);
+	Model_DrawVb_Range(SHEEP_FUR_VERTICES, SHEEP_BODY_VERTICES);
 }
 
 static float SheepModel_GetNameY(struct Entity* e) { return 1.48125f; }
@@ -1790,12 +2097,14 @@ static struct Model nofur_model  = { "sheep_nofur", sheep_vertices, &sheep_tex,
 static void SheepModel_Register(void) {
 	Model_Init(&sheep_model);
 	sheep_model.maxVertices = SHEEP_BODY_VERTICES + SHEEP_FUR_VERTICES;
+	sheep_model.flags |= MODEL_FLAG_BATCHED;
 	Model_Register(&sheep_model);
 }
 
 static void NoFurModel_Register(void) {
 	Model_Init(&nofur_model);
 	nofur_model.maxVertices = SHEEP_BODY_VERTICES;
+	nofur_model.flags |= MODEL_FLAG_BATCHED;
 	Model_Register(&nofur_model);
 }
 
@@ -1859,7 +2168,7 @@ static void SkeletonModel_Draw(struct Entity* e) {
 	Model_DrawRotate(90.0f * MATH_DEG2RAD,   0, e->Anim.RightArmZ, &skeleton_rightArm, false);
 
 	Model_UnlockVB();
-	Gfx_DrawVb_IndexedTris(SKELETON_MAX_VERTICES);
+	Model_DrawVb_Range(SKELETON_MAX_VERTICES, 0);
 }
 
 static void SkeletonModel_DrawArm(struct Entity* e) {
@@ -1887,6 +2196,7 @@ static void SkeletonModel_Register(void) {
 	skeleton_model.DrawArm     = SkeletonModel_DrawArm;
 	skeleton_model.armX        = 5;
 	skeleton_model.maxVertices = SKELETON_MAX_VERTICES;
+	skeleton_model.flags |= MODEL_FLAG_BATCHED;
 	Model_Register(&skeleton_model);
 }
 
@@ -1962,7 +2272,7 @@ static void SpiderModel_Draw(struct Entity* e) {
 	Models.Rotation = ROTATE_ORDER_ZYX;
 
 	Model_UnlockVB();
-	Gfx_DrawVb_IndexedTris(SPIDER_MAX_VERTICES);
+	Model_DrawVb_Range(SPIDER_MAX_VERTICES, 0);
 }
 
 static float SpiderModel_GetNameY(struct Entity* e) { return 1.0125f; }
@@ -1981,6 +2291,7 @@ static struct Model spider_model  = { "spider", spider_vertices, &spider_tex,
 static void SpiderModel_Register(void) {
 	Model_Init(&spider_model);
 	spider_model.maxVertices = SPIDER_MAX_VERTICES;
+	spider_model.flags |= MODEL_FLAG_BATCHED;
 	Model_Register(&spider_model);
 }
 
@@ -2010,6 +2321,7 @@ static void ZombieModel_Register(void) {
 	Model_Init(&zombie_model);
 	zombie_model.DrawArm     = ZombieModel_DrawArm;
 	zombie_model.maxVertices = HUMAN_MAX_VERTICES;
+	zombie_model.flags |= MODEL_FLAG_BATCHED;
 	Model_Register(&zombie_model);
 }
 
@@ -2253,7 +2565,7 @@ static void SkinnedCubeModel_Draw(struct Entity* e) {
 	Model_DrawRotate(-e->Pitch * MATH_DEG2RAD, 0, 0, &skinnedCube_head, true);
 
 	Model_UnlockVB();
-	Gfx_DrawVb_IndexedTris(SKINNEDCUBE_MAX_VERTICES);
+	Model_DrawVb_Range(SKINNEDCUBE_MAX_VERTICES, 0);
 }
 
 static float SkinnedCubeModel_GetNameY(struct Entity* e) { return 1.075f; }
@@ -2274,6 +2586,7 @@ static void SkinnedCubeModel_Register(void) {
 	skinnedCube_model.usesHumanSkin = true;
 	skinnedCube_model.pushes        = false;
 	skinnedCube_model.maxVertices   = SKINNEDCUBE_MAX_VERTICES;
+	skinnedCube_model.flags |= MODEL_FLAG_BATCHED;
 	Model_Register(&skinnedCube_model);
 }
 
@@ -2347,6 +2660,8 @@ static void HoldModel_Register(void) {
 	hold_model.MakeParts = Model_NoParts;
 	hold_model.Draw      = HoldModel_Draw;
 	hold_model.GetEyeY   = HoldModel_GetEyeY;
+	/* Block in hand is drawn with a different view matrix */
+	hold_model.flags &= ~MODEL_FLAG_BATCHED;
 	Model_Register(&hold_model);
 }
 
@@ -2391,6 +2706,7 @@ static void RegisterDefaultModels(void) {
 static void OnContextLost(void* obj) {
 	struct ModelTex* tex;
 	Gfx_DeleteDynamicVb(&Models.Vb);
+	Gfx_DeleteDynamicVb(&batch_vb);
 	if (Gfx.ManagedTextures) return;
 
 	for (tex = textures_head; tex; tex = tex->next) 
@@ -2410,6 +2726,8 @@ static void OnInit(void) {
 
 static void OnFree(void) {
 	OnContextLost(NULL);
+	Mem_Free(batch_vertices);
+	batch_vertices = NULL;
 	CustomModel_FreeAll();
 }
 
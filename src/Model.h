@@ -39,6 +39,9 @@ struct ModelTex { const char* name; cc_uint8 skinType; GfxResourceID texID; stru
 
 #define MODEL_FLAG_INITED    0x01
 #define MODEL_FLAG_CLEAR_HAT 0x02
+/* Model only draws using Model_LockVB/Model_UnlockVB/Model_DrawVb_Range, */
+/*  so its vertices can be merged with other entities when rendering. */
+#define MODEL_FLAG_BATCHED   0x04
 
 struct Model;
 /* Contains a set of quads and/or boxes that describe a 3D object as well as
@@ -136,6 +139,14 @@ CC_API void Model_ApplyTexture(struct Entity* entity);
 CC_API void Model_UpdateVB(void);
 void Model_LockVB(struct Entity* entity, int verticesCount);
 void Model_UnlockVB(void);
+/* Draws the given range of vertices from the most recent Model_LockVB call. */
+void Model_DrawVb_Range(int verticesCount, int startVertex);
+
+/* Starts merging the vertices of models with MODEL_FLAG_BATCHED into one large vertex buffer. */
+/* Vertices are transformed on the CPU, then drawn in as few draw calls as possible. */
+void Model_BeginBatch(void);
+/* Draws all remaining merged vertices, then stops merging vertices. */
+void Model_EndBatch(void);
 
 /* Draws the given part with no part-specific rotation (e.g. torso). */
 CC_API void Model_DrawPart(struct ModelPart* part);
@@ -156,6 +167,8 @@ void Model_Unregister(struct Model* model);
 /* Adds a texture to the list of automatically managed model textures. */
 /* These textures are automatically loaded from texture packs. (e.g. "skeleton.png") */
 CC_API void Model_RegisterTexture(struct ModelTex* tex);
+/* Returns a pointer to the model texture whose name caselessly matches given name. */
+struct ModelTex* Model_GetTexture(const cc_string* name);
 
 /* Describes data for a box being built. */
 struct BoxDesc {
@@ -288,6 +301,9 @@ struct CustomModel {
 	cc_uint8 numParts;
 	cc_uint8 numArmParts;
 	struct CustomModelPart parts[MAX_CUSTOM_MODEL_PARTS];
+	/* Vertices of each part, unpacked into separate X/Y/Z/U/V arrays for faster drawing */
+	/* NOTE: Only allocated once all of the parts have been defined */
+	float* unpackedVertices;
 };
 
 extern struct CustomModel custom_models[MAX_CUSTOM_MODELS];
@@ -14,6 +14,7 @@ Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 
 #define OPT_VIEW_DISTANCE "viewdist"
 #define OPT_BLOCK_PHYSICS "singleplayerphysics"
+#define OPT_PHYSICS_THREADS "singleplayerphysics-threads"
 #define OPT_NAMES_MODE "namesmode"
 #define OPT_INVERT_MOUSE "invertmouse"
 #define OPT_SENSITIVITY "mousesensitivity"
@@ -21,6 +22,7 @@ Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 #define OPT_DEFAULT_TEX_PACK "defaulttexpack"
 #define OPT_VIEW_BOBBING "viewbobbing"
 #define OPT_ENTITY_SHADOW "entityshadow"
+#define OPT_ENTITY_RENDER_DIST "entity-renderdist"
 #define OPT_RENDER_TYPE "normal"
 #define OPT_SMOOTH_LIGHTING "gfx-smoothlighting"
 #define OPT_MIPMAPS "gfx-mipmaps"
@@ -66,6 +68,14 @@ Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 #define OPT_CLASSIC_CHAT "nostalgia-classicchat"
 #define OPT_CLASSIC_INVENTORY "nostalgia-classicinventory"
 #define OPT_MAX_CHUNK_UPDATES "gfx-maxchunkupdates"
+#define OPT_BUILDER_THREADS "gfx-builderthreads"
+#define OPT_SOFTGPU_THREADS "gfx-softgputhreads"
+#define OPT_GREEDY_MESHING "gfx-greedymeshing"
+#define OPT_OCCLUSION_CULLING "gfx-occlusionculling"
+#define OPT_SAVE_COMPRESSION "save-compression"
+#define OPT_GEN_THREADS "gen-threads"
+#define OPT_NET_CAPTURE "net-capture"
+#define OPT_REPLAY_REALTIME "replay-realtime"
 #define OPT_CAMERA_MASS "cameramass"
 #define OPT_CAMERA_SMOOTH "camera-smooth"
 #define OPT_GRAB_CURSOR "win-grab-cursor"
@@ -74,6 +84,8 @@ Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 #define OPT_HTTP_ONLY "http-no-https"
 #define OPT_HTTPS_VERIFY "https-verify"
 #define OPT_SKIN_SERVER "http-skinserver"
+#define OPT_HTTP_WORKERS "http-workers"
+#define OPT_SKIN_CACHE_SIZE "http-skincache"
 #define OPT_RAW_INPUT "win-raw-input"
 #define OPT_DPI_SCALING "win-dpi-scaling"
 #define OPT_GAME_VERSION "game-version"
@@ -0,0 +1,123 @@
+#include "Profiler.h"
+#include "Platform.h"
+#include "String.h"
+#include "Stream.h"
+#include "Funcs.h"
+
+struct _ProfilerData Profiler;
+const char* const Profiler_Names[PROFILER_SECTIONS_COUNT] = {
+	"Frame", "Tasks", "Network", "Map update",
+	"Render normal", "Render translucent", "Entities", "Gui"
+};
+
+/* Timed section, stored so it can be written out later as a trace event */
+struct ProfilerEvent { cc_uint8 section; cc_uint32 start, duration; };
+/* Only the most recent events are kept (older events are overwritten) */
+#define PROFILER_MAX_EVENTS 16384
+
+static struct ProfilerEvent events[PROFILER_MAX_EVENTS];
+static int eventsCount, eventsHead;
+static cc_uint64 sectionStarts[PROFILER_SECTIONS_COUNT];
+static cc_uint32 frameTimes[PROFILER_SECTIONS_COUNT];
+/* Time that Profiler was enabled at, which all trace events are relative to */
+static cc_uint64 profilerStart;
+
+void Profiler_SetEnabled(cc_bool enabled) {
+	Profiler.Enabled = enabled;
+	Profiler.Head    = 0;
+	eventsCount      = 0;
+	eventsHead       = 0;
+
+	Mem_Set(Profiler.History, 0, sizeof(Profiler.History));
+	Mem_Set(frameTimes,       0, sizeof(frameTimes));
+	profilerStart = Stopwatch_Measure();
+}
+
+void Profiler_Begin(int section) {
+	if (!Profiler.Enabled) return;
+	sectionStarts[section] = Stopwatch_Measure();
+}
+
+void Profiler_End(int section) {
+	struct ProfilerEvent* e;
+	cc_uint64 beg, end;
+	if (!Profiler.Enabled) return;
+
+	beg = sectionStarts[section];
+	end = Stopwatch_Measure();
+
+	e = &events[eventsHead];
+	e->section  = section;
+	e->start    = (cc_uint32)Stopwatch_ElapsedMicroseconds(profilerStart, beg);
+	e->duration = (cc_uint32)Stopwatch_ElapsedMicroseconds(beg, end);
+	frameTimes[section] += e->duration;
+
+	eventsHead  = (eventsHead + 1) % PROFILER_MAX_EVENTS;
+	eventsCount = min(eventsCount + 1, PROFILER_MAX_EVENTS);
+}
+
+void Profiler_EndFrame(void) {
+	int i, head;
+	if (!Profiler.Enabled) return;
+
+	head = (Profiler.Head + 1) % PROFILER_HISTORY;
+	for (i = 0; i < PROFILER_SECTIONS_COUNT; i++)
+	{
+		Profiler.History[i][head] = frameTimes[i];
+		frameTimes[i] = 0;
+	}
+	Profiler.Head = head;
+}
+
+void Profiler_CalcStats(int section, int* avgUS, int* maxUS) {
+	cc_uint32* times = Profiler.History[section];
+	cc_uint32 total = 0, best = 0;
+	int i;
+
+	for (i = 0; i < PROFILER_HISTORY; i++)
+	{
+		total += times[i];
+		best   = max(best, times[i]);
+	}
+	*avgUS = (int)(total / PROFILER_HISTORY);
+	*maxUS = (int)best;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Trace export------------------------------------------------------*
+*#########################################################################################################################*/
+static cc_result Profiler_WriteEvent(struct Stream* s, struct ProfilerEvent* e, cc_bool last) {
+	cc_string str; char strBuffer[256];
+	int start = (int)e->start, duration = (int)e->duration;
+	String_InitArray(str, strBuffer);
+
+	String_Format3(&str, "{\"name\":\"%c\",\"ph\":\"X\",\"ts\":%i,\"dur\":%i,\"pid\":1,\"tid\":1}",
+					Profiler_Names[e->section], &start, &duration);
+	if (!last) String_Append(&str, ',');
+	return Stream_WriteLine(s, &str);
+}
+
+cc_result Profiler_WriteTrace(const cc_string* path) {
+	static const cc_string header = String_FromConst("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	static const cc_string footer = String_FromConst("]}");
+	struct Stream stream;
+	cc_result res, closeRes;
+	int i, index;
+
+	res = Stream_CreateFile(&stream, path);
+	if (res) return res;
+	res = Stream_WriteLine(&stream, (cc_string*)&header);
+
+	/* Events are written from oldest to newest */
+	index = (eventsHead - eventsCount + PROFILER_MAX_EVENTS) % PROFILER_MAX_EVENTS;
+	for (i = 0; i < eventsCount && !res; i++)
+	{
+		res   = Profiler_WriteEvent(&stream, &events[index], i == eventsCount - 1);
+		index = (index + 1) % PROFILER_MAX_EVENTS;
+	}
+
+	if (!res) res = Stream_WriteLine(&stream, (cc_string*)&footer);
+	closeRes = stream.Close(&stream);
+	return res ? res : closeRes;
+}
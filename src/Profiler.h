@@ -0,0 +1,41 @@
+#ifndef CC_PROFILER_H
+#define CC_PROFILER_H
+#include "Core.h"
+/*
+Measures how long the main parts of each frame take, so that stutters can be tracked down to a subsystem
+Copyright 2014-2023 ClassiCube | Licensed under BSD-3
+*/
+
+enum PROFILER_SECTION {
+	PROFILER_FRAME, PROFILER_TASKS, PROFILER_NETWORK, PROFILER_MAP_UPDATE,
+	PROFILER_RENDER_NORMAL, PROFILER_RENDER_TRANSLUCENT, PROFILER_ENTITIES, PROFILER_GUI,
+	PROFILER_SECTIONS_COUNT
+};
+/* Number of frames that per section timings are kept for */
+#define PROFILER_HISTORY 128
+
+CC_VAR extern struct _ProfilerData {
+	/* Whether sections are currently being timed */
+	cc_bool Enabled;
+	/* Index into History of the most recently completed frame */
+	int Head;
+	/* Time taken by each section in the last PROFILER_HISTORY frames, in microseconds */
+	cc_uint32 History[PROFILER_SECTIONS_COUNT][PROFILER_HISTORY];
+} Profiler;
+extern const char* const Profiler_Names[PROFILER_SECTIONS_COUNT];
+
+/* Starts or stops timing sections. (Clears all previously recorded timings) */
+void Profiler_SetEnabled(cc_bool enabled);
+/* Marks the start of the given section. */
+/* NOTE: Sections can be nested, but the same section must not be started twice. */
+void Profiler_Begin(int section);
+/* Marks the end of the given section, adding the elapsed time to the current frame's timings. */
+void Profiler_End(int section);
+/* Moves the timings of the current frame into the history, then starts a new frame. */
+void Profiler_EndFrame(void);
+/* Calculates the average and maximum time in microseconds the given section took over the history. */
+void Profiler_CalcStats(int section, int* avgUS, int* maxUS);
+/* Writes the most recently timed sections to a file in Chrome's trace event format. */
+/* (which can be viewed using chrome://tracing or https://ui.perfetto.dev) */
+cc_result Profiler_WriteTrace(const cc_string* path);
+#endif
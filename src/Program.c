@@ -9,6 +9,7 @@
 #include "Launcher.h"
 #include "Server.h"
 #include "Options.h"
+#include "Bench.h"
 
 static void RunGame(void) {
 	cc_string title; char titleBuffer[STRING_SIZE];
@@ -70,6 +71,7 @@ static void SetupProgram(int argc, char** argv) {
 #define SP_HasDir(path) (String_IndexOf(&path, '/') >= 0 || String_IndexOf(&path, '\\') >= 0)
 
 static int RunProgram(int argc, char** argv) {
+	static const cc_string replayExt = String_FromConst(".ccap");
 	cc_string args[GAME_MAX_CMDARGS];
 	cc_uint16 port;
 
@@ -92,6 +94,11 @@ static int RunProgram(int argc, char** argv) {
 		args[0] = String_UNSAFE_SubstringAt(&args[0], 1);
 		String_Copy(&Launcher_AutoHash, &args[0]);
 		Launcher_Run();
+	/* File path to replay a network capture */
+	} else if (argsCount == 1 && String_CaselessEnds(&args[0], &replayExt) && File_Exists(&args[0])) {
+		Options_Get(LOPT_USERNAME, &Game_Username, DEFAULT_USERNAME);
+		String_Copy(&MP_ReplayPath, &args[0]);
+		RunGame();
 	/* File path to auto load a map in singleplayer */
 	} else if (argsCount == 1 && SP_HasDir(args[0]) && File_Exists(&args[0])) {
 		Options_Get(LOPT_USERNAME, &Game_Username, DEFAULT_USERNAME);
@@ -138,6 +145,16 @@ void android_main(void) {
 	SetupProgram(0, NULL);
 	for (;;) { RunProgram(0, NULL); }
 }
+#elif defined CC_BUILD_BENCH
+/* Benchmark builds run the benchmarks instead of the launcher or game */
+int main(int argc, char** argv) {
+	int res;
+	SetupProgram(argc, argv);
+
+	res = Bench_Run(argc, argv);
+	Process_Exit(res);
+	return res;
+}
 #elif defined CC_BUILD_CONSOLE
 int main(int argc, char** argv) {
 	SetupProgram(argc, argv);
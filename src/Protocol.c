@@ -1239,10 +1239,9 @@ static void CPE_ExtAddEntity2(cc_uint8* data) {
 
 #define BULK_MAX_BLOCKS 256
 static void CPE_BulkBlockUpdate(cc_uint8* data) {
-	cc_int32 indices[BULK_MAX_BLOCKS];
+	int indices[BULK_MAX_BLOCKS];
 	BlockID blocks[BULK_MAX_BLOCKS];
-	int index, i;
-	int x, y, z;
+	int index, i, valid = 0;
 	int count = 1 + *data++;
 
 	for (i = 0; i < count; i++) {
@@ -1269,14 +1268,16 @@ static void CPE_BulkBlockUpdate(cc_uint8* data) {
 	for (i = 0; i < count; i++) {
 		index = indices[i];
 		if (index < 0 || index >= World.Volume) continue;
-		World_Unpack(index, x, y, z);
 
+		indices[valid] = index;
 #ifdef EXTENDED_BLOCKS
-		Game_UpdateBlock(x, y, z, blocks[i] % BLOCK_COUNT);
+		blocks[valid]  = blocks[i] % BLOCK_COUNT;
 #else
-		Game_UpdateBlock(x, y, z, blocks[i]);
+		blocks[valid]  = blocks[i];
 #endif
+		valid++;
 	}
+	Game_UpdateBlocks(indices, blocks, valid);
 }
 
 static void CPE_SetTextColor(cc_uint8* data) {
@@ -21,6 +21,7 @@
 #include "World.h"
 #include "Input.h"
 #include "Utils.h"
+#include "Profiler.h"
 
 #define CHAT_MAX_STATUS Array_Elems(Chat_Status)
 #define CHAT_MAX_BOTTOMRIGHT Array_Elems(Chat_BottomRight)
@@ -2402,4 +2403,182 @@ void TouchScreen_Show(void) {
 	if (!Input_TouchMode) return;
 	Gui_Add((struct Screen*)s, GUI_PRIORITY_TOUCH);
 }
-#endif
\ No newline at end of file
+#endif
+
+/*########################################################################################################################*
+*-----------------------------------------------------ProfilerOverlay-----------------------------------------------------*
+*#########################################################################################################################*/
+static struct ProfilerOverlay {
+	Screen_Body
+	struct FontDesc font;
+	struct TextWidget lbls[PROFILER_SECTIONS_COUNT];
+	GfxResourceID barsVb;
+	double accumulator;
+	int barsX, barWidth;
+} ProfilerOverlay;
+
+static struct Widget* profiler_widgets[PROFILER_SECTIONS_COUNT];
+#define PROFILER_MAX_VERTICES (PROFILER_SECTIONS_COUNT * TEXTWIDGET_MAX)
+#define PROFILER_BARS_VERTICES (PROFILER_SECTIONS_COUNT * PROFILER_HISTORY * 4)
+/* Time taken for a bar to be drawn at full height (i.e. one frame at 60 FPS) */
+#define PROFILER_BAR_MAX_US 16667
+
+static const PackedCol profiler_colors[PROFILER_SECTIONS_COUNT] = {
+	PackedCol_Make(255, 255, 255, 200), PackedCol_Make(255, 160,  64, 200),
+	PackedCol_Make( 64, 160, 255, 200), PackedCol_Make(255,  64,  64, 200),
+	PackedCol_Make( 64, 255,  64, 200), PackedCol_Make( 64, 255, 255, 200),
+	PackedCol_Make(255,  64, 255, 200), PackedCol_Make(255, 255,  64, 200),
+};
+
+static void ProfilerOverlay_UpdateLabels(struct ProfilerOverlay* s) {
+	cc_string str; char strBuffer[STRING_SIZE];
+	int i, avgUS, maxUS;
+	float avgMS, maxMS;
+
+	for (i = 0; i < PROFILER_SECTIONS_COUNT; i++)
+	{
+		Profiler_CalcStats(i, &avgUS, &maxUS);
+		avgMS = avgUS / 1000.0f; maxMS = maxUS / 1000.0f;
+
+		String_InitArray(str, strBuffer);
+		String_Format3(&str, "%c: %f2 ms avg, %f2 ms max", Profiler_Names[i], &avgMS, &maxMS);
+		TextWidget_Set(&s->lbls[i], &str, &s->font);
+	}
+	s->dirty = true;
+}
+
+static void ProfilerOverlay_Layout(void* screen) {
+	struct ProfilerOverlay* s = (struct ProfilerOverlay*)screen;
+	int i, y = 0;
+
+	s->barWidth = max(1, Display_ScaleX(1));
+	s->barsX    = WindowInfo.Width - s->barWidth * PROFILER_HISTORY - Display_ScaleX(5);
+
+	for (i = 0; i < PROFILER_SECTIONS_COUNT; i++)
+	{
+		Widget_SetLocation(&s->lbls[i], ANCHOR_MAX, ANCHOR_MIN, 0, 0);
+		s->lbls[i].xOffset = WindowInfo.Width - s->barsX + Display_ScaleX(5);
+		s->lbls[i].yOffset = Display_ScaleY(5) + y;
+		Widget_Layout(&s->lbls[i]);
+		y += s->lbls[i].height;
+	}
+}
+
+static void ProfilerOverlay_ContextLost(void* screen) {
+	struct ProfilerOverlay* s = (struct ProfilerOverlay*)screen;
+	Font_Free(&s->font);
+	Screen_ContextLost(screen);
+	Gfx_DeleteDynamicVb(&s->barsVb);
+}
+
+static void ProfilerOverlay_ContextRecreated(void* screen) {
+	struct ProfilerOverlay* s = (struct ProfilerOverlay*)screen;
+	Screen_UpdateVb(screen);
+	s->barsVb = Gfx_CreateDynamicVb(VERTEX_FORMAT_COLOURED, PROFILER_BARS_VERTICES);
+
+	Font_Make(&s->font, 12, FONT_FLAGS_PADDING);
+	ProfilerOverlay_UpdateLabels(s);
+}
+
+static void ProfilerOverlay_Update(void* screen, double delta) {
+	struct ProfilerOverlay* s = (struct ProfilerOverlay*)screen;
+	s->accumulator += delta;
+	if (s->accumulator < 0.5) return;
+
+	s->accumulator = 0.0;
+	ProfilerOverlay_UpdateLabels(s);
+}
+
+/* Each section has a row of bars to the right of its label, with one bar per frame of history */
+static int ProfilerOverlay_BuildBars(struct ProfilerOverlay* s) {
+	struct VertexColoured* v;
+	struct TextWidget* lbl;
+	cc_uint32 time;
+	int i, j, frame, count = 0;
+	int x, y, height;
+	PackedCol col;
+
+	v = (struct VertexColoured*)Gfx_LockDynamicVb(s->barsVb, VERTEX_FORMAT_COLOURED, PROFILER_BARS_VERTICES);
+	for (i = 0; i < PROFILER_SECTIONS_COUNT; i++)
+	{
+		lbl = &s->lbls[i];
+		col = profiler_colors[i];
+		/* Oldest frame is drawn on the left */
+		frame = Profiler.Head;
+
+		for (j = 0; j < PROFILER_HISTORY; j++)
+		{
+			frame  = (frame + 1) % PROFILER_HISTORY;
+			time   = min(Profiler.History[i][frame], PROFILER_BAR_MAX_US);
+			height = (int)(time * (lbl->height - 2) / PROFILER_BAR_MAX_US);
+			if (!height) continue;
+
+			x = s->barsX + j * s->barWidth;
+			y = lbl->y + lbl->height - 1;
+
+			v->X = (float)x;                 v->Y = (float)y;            v->Z = 0; v->Col = col; v++;
+			v->X = (float)(x + s->barWidth); v->Y = (float)y;            v->Z = 0; v->Col = col; v++;
+			v->X = (float)(x + s->barWidth); v->Y = (float)(y - height); v->Z = 0; v->Col = col; v++;
+			v->X = (float)x;                 v->Y = (float)(y - height); v->Z = 0; v->Col = col; v++;
+			count += 4;
+		}
+	}
+	Gfx_UnlockDynamicVb(s->barsVb);
+	return count;
+}
+
+static void ProfilerOverlay_Render(void* screen, double delta) {
+	struct ProfilerOverlay* s = (struct ProfilerOverlay*)screen;
+	struct TextWidget* last   = &s->lbls[PROFILER_SECTIONS_COUNT - 1];
+	PackedCol backCol = PackedCol_Make(20, 20, 20, 160);
+	int x, y, count;
+	if (Game_HideGui) return;
+
+	x = s->lbls[0].x - Display_ScaleX(5);
+	y = s->lbls[0].y;
+	Gfx_Draw2DFlat(x, y, WindowInfo.Width - x, last->y + last->height - y, backCol);
+
+	count = ProfilerOverlay_BuildBars(s);
+	if (count) {
+		Gfx_SetVertexFormat(VERTEX_FORMAT_COLOURED);
+		Gfx_BindDynamicVb(s->barsVb);
+		Gfx_DrawVb_IndexedTris(count);
+	}
+	Screen_Render2Widgets(screen, delta);
+}
+
+static void ProfilerOverlay_Init(void* screen) {
+	struct ProfilerOverlay* s = (struct ProfilerOverlay*)screen;
+	int i;
+	s->widgets     = profiler_widgets;
+	s->numWidgets  = PROFILER_SECTIONS_COUNT;
+	s->maxVertices = PROFILER_MAX_VERTICES;
+
+	for (i = 0; i < PROFILER_SECTIONS_COUNT; i++)
+	{
+		TextWidget_Init(&s->lbls[i]);
+		profiler_widgets[i] = (struct Widget*)&s->lbls[i];
+	}
+	Profiler_SetEnabled(true);
+}
+
+static void ProfilerOverlay_Free(void* screen) {
+	Profiler_SetEnabled(false);
+}
+
+static const struct ScreenVTABLE ProfilerOverlay_VTABLE = {
+	ProfilerOverlay_Init,   ProfilerOverlay_Update, ProfilerOverlay_Free,
+	ProfilerOverlay_Render, Screen_BuildMesh,
+	Screen_FInput,          Screen_InputUp,         Screen_FKeyPress, Screen_FText,
+	Screen_FPointer,        Screen_PointerUp,       Screen_FPointer,  Screen_FMouseScroll,
+	ProfilerOverlay_Layout, ProfilerOverlay_ContextLost, ProfilerOverlay_ContextRecreated
+};
+void ProfilerOverlay_Show(void) {
+	struct ProfilerOverlay* s = &ProfilerOverlay;
+	s->VTABLE = &ProfilerOverlay_VTABLE;
+	Gui_Add((struct Screen*)s, GUI_PRIORITY_PROFILER);
+}
+
+void ProfilerOverlay_Hide(void) {
+	Gui_Remove((struct Screen*)&ProfilerOverlay);
+}
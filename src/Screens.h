@@ -29,6 +29,10 @@ void LoadingScreen_Show(const cc_string* title, const cc_string* message);
 void GeneratingScreen_Show(void);
 void ChatScreen_Show(void);
 void DisconnectScreen_Show(const cc_string* title, const cc_string* message);
+/* Shows per frame timings from Profiler, and starts timing. */
+void ProfilerOverlay_Show(void);
+/* Hides per frame timings, and stops timing. */
+void ProfilerOverlay_Hide(void);
 #ifdef CC_BUILD_TOUCH
 void TouchScreen_Refresh(void);
 void TouchScreen_Show(void);
@@ -25,6 +25,9 @@
 #include "Input.h"
 #include "Errors.h"
 #include "Options.h"
+#include "Profiler.h"
+#include "Stream.h"
+#include "Utils.h"
 
 static char nameBuffer[STRING_SIZE];
 static char motdBuffer[STRING_SIZE];
@@ -215,8 +218,16 @@ static void SPConnection_Init(void) {
 *--------------------------------------------------Multiplayer connection-------------------------------------------------*
 *#########################################################################################################################*/
 static cc_socket net_socket;
-static cc_uint8  net_readBuffer[4096 * 5];
-static cc_uint8* net_readCurrent;
+/* Received data is stored in a ring buffer, so leftover partial packets never need to be moved */
+/*  (a packet that wraps around the end of the ring has its start mirrored into the slack after the end) */
+#define NET_RING_SIZE  (4096 * 16)
+#define NET_RING_MASK  (NET_RING_SIZE - 1)
+#define NET_RING_SLACK 2048 /* Must be larger than the largest packet */
+static cc_uint8  net_readBuffer[NET_RING_SIZE + NET_RING_SLACK];
+/* Total number of bytes processed/received (wrap around is fine, as only the difference matters) */
+static cc_uint32 net_readPos, net_writePos;
+/* Maximum time spent receiving data in one network tick, so the game doesn't freeze */
+#define NET_TICK_BUDGET_US 8000
 
 static cc_result net_writeFailure;
 static double net_lastPacket;
@@ -226,14 +237,76 @@ static cc_bool net_connecting;
 static double net_connectTimeout;
 #define NET_TIMEOUT_SECS 15
 
+/* Capture files start with net_captureMagic, followed by a record for each read from the socket */
+/*  Record format: [U32 BE ms since connecting] [U32 BE data length] [data] */
+static const cc_uint8 net_captureMagic[8] = { 'C','C','N','E','T','C','A','P' };
+static struct Stream net_captureStream;
+static cc_bool net_capturing, net_replaying;
+static cc_uint64 net_captureStart;
+
+static void NetCapture_Start(void) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct DateTime now;
+	cc_result res;
+
+	if (!Options_GetBool(OPT_NET_CAPTURE, false)) return;
+	if (!Utils_EnsureDirectory("captures")) return;
+	DateTime_CurrentLocal(&now);
+
+	String_InitArray(path, pathBuffer);
+	String_Format3(&path, "captures/capture_%p4-%p2-%p2", &now.year, &now.month, &now.day);
+	String_Format3(&path, "-%p2-%p2-%p2.ccap", &now.hour, &now.minute, &now.second);
+
+	res = Stream_CreateFile(&net_captureStream, &path);
+	if (res) { Logger_SysWarn2(res, "creating", &path); return; }
+
+	res = Stream_Write(&net_captureStream, net_captureMagic, sizeof(net_captureMagic));
+	if (res) { Logger_SysWarn2(res, "writing to", &path); net_captureStream.Close(&net_captureStream); return; }
+
+	net_capturing    = true;
+	net_captureStart = Stopwatch_Measure();
+	Chat_Add1("&eCapturing received network data to %s", &path);
+}
+
+static void NetCapture_Write(const cc_uint8* data, cc_uint32 len) {
+	cc_uint8 header[8];
+	cc_uint32 time;
+	cc_result res;
+
+	time = (cc_uint32)(Stopwatch_ElapsedMicroseconds(net_captureStart, Stopwatch_Measure()) / 1000);
+	Stream_SetU32_BE(header + 0, time);
+	Stream_SetU32_BE(header + 4, len);
+
+	if (!(res = Stream_Write(&net_captureStream, header, sizeof(header)))) {
+		res = Stream_Write(&net_captureStream, data, len);
+	}
+	if (!res) return;
+
+	Logger_SimpleWarn(res, "writing network capture");
+	net_captureStream.Close(&net_captureStream);
+	net_capturing = false;
+}
+
+static void NetCapture_Stop(void) {
+	cc_result res;
+	if (!net_capturing) return;
+	net_capturing = false;
+
+	res = net_captureStream.Close(&net_captureStream);
+	if (res) Logger_SimpleWarn(res, "closing network capture");
+}
+
 static void OnClose(void);
 static void MPConnection_FinishConnect(void) {
 	net_connecting = false;
 	Event_RaiseVoid(&NetEvents.Connected);
 	Event_RaiseFloat(&WorldEvents.Loading, 0.0f);
 
-	net_readCurrent = net_readBuffer;
-	net_lastPacket  = Game.Time;
+	net_readPos    = 0;
+	net_writePos   = 0;
+	net_lastPacket = Game.Time;
+	/* Replaying a capture shouldn't produce another capture of it */
+	if (!net_replaying) NetCapture_Start();
 	Classic_SendLogin();
 }
 
@@ -350,65 +423,98 @@ static void DisconnectInvalidOpcode(cc_uint8 opcode) {
 	Game_Disconnect(&title, &tmp); return;
 }
 
-static void MPConnection_Tick(struct ScheduledTask* task) {
-	Net_Handler handler;
-	cc_uint8* readEnd;
-	cc_uint8* readCur;
-	cc_uint32 read;
-	int i, remaining;
+/* Reads as much data as possible from the socket into the ring buffer */
+static cc_result MPConnection_ReadSocket(cc_uint32* read) {
+	cc_uint32 index = net_writePos & NET_RING_MASK;
+	cc_uint32 space = NET_RING_SIZE - (net_writePos - net_readPos);
+	/* Can only read up to the end of the ring buffer at once */
+	cc_uint32 count = min(space, NET_RING_SIZE - index);
 	cc_result res;
 
-	if (Server.Disconnected) return;
-	if (net_connecting) { MPConnection_TickConnect(); return; }
+	*read = 0;
+	if (!count) return 0;
+	res = Socket_Read(net_socket, net_readBuffer + index, count, read);
 
-	/* NOTE: using a read call that is a multiple of 4096 (appears to?) improve read performance */	
-	res = Socket_Read(net_socket, net_readCurrent, 4096 * 4, &read);
-	
-	if (res) {
-		/* 'no data available for non-blocking read' is an expected error */
-		if (res == ReturnCode_SocketInProgess)  res = 0;
-		if (res == ReturnCode_SocketWouldBlock) res = 0;
-
-		if (res) { DisconnectReadFailed(res); return; }
-	} else if (read == 0) {
-		/* recv only returns 0 read when socket is closed.. probably? */
-		/* Over 30 seconds since last packet, connection probably dropped */
-		/* TODO: Should this be checked unconditonally instead of just when read = 0 ? */
-		if (net_lastPacket + 30 < Game.Time) { MPConnection_Disconnect(); return; }
-	} else {
-		readCur        = net_readBuffer;
-		readEnd        = net_readCurrent + read;
-		net_lastPacket = Game.Time;
+	if (net_capturing && *read) NetCapture_Write(net_readBuffer + index, *read);
+	net_writePos += *read;
+	return res;
+}
 
-		while (readCur < readEnd) {
-			cc_uint8 opcode = readCur[0];
+static void ReplayConnection_TimeHandler(Net_Handler handler, cc_uint8* data);
 
-			/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
-			if (cpe_needD3Fix && lastOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
-				Platform_LogConst("Skipping invalid HackControl byte from D3 server");
-				readCur++;
-				LocalPlayer_ResetJumpVelocity();
-				continue;
-			}
+/* Calls the handlers for all of the complete packets in the ring buffer */
+static void MPConnection_ProcessPackets(void) {
+	Net_Handler handler;
+	cc_uint32 index, size;
+	cc_uint8 opcode;
+
+	while (net_readPos != net_writePos && !Server.Disconnected) {
+		index  = net_readPos & NET_RING_MASK;
+		opcode = net_readBuffer[index];
+
+		/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
+		if (cpe_needD3Fix && lastOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
+			Platform_LogConst("Skipping invalid HackControl byte from D3 server");
+			net_readPos++;
+			LocalPlayer_ResetJumpVelocity();
+			continue;
+		}
 
-			if (readCur + Protocol.Sizes[opcode] > readEnd) break;
-			handler = Protocol.Handlers[opcode];
-			if (!handler) { DisconnectInvalidOpcode(opcode); return; }
+		/* Protocol packets might be split up across TCP packets */
+		/* If so, the rest of the packet is received in a later read */
+		size = Protocol.Sizes[opcode];
+		if (net_writePos - net_readPos < size) break;
 
-			lastOpcode = opcode;
-			handler(readCur + 1); /* skip opcode */
-			readCur += Protocol.Sizes[opcode];
+		handler = Protocol.Handlers[opcode];
+		if (!handler) { DisconnectInvalidOpcode(opcode); return; }
+
+		/* Packet wraps around the end of the ring, so make its data contiguous for the handler */
+		if (index + size > NET_RING_SIZE) {
+			Mem_Copy(net_readBuffer + NET_RING_SIZE, net_readBuffer, index + size - NET_RING_SIZE);
 		}
 
-		/* Protocol packets might be split up across TCP packets */
-		/* If so, copy last few unprocessed bytes back to beginning of buffer */
-		/* These bytes are then later combined with subsequently read TCP packet data */
-		remaining = (int)(readEnd - readCur);
-		for (i = 0; i < remaining; i++) 
-		{
-			net_readBuffer[i] = readCur[i];
+		lastOpcode = opcode;
+		if (net_replaying) {
+			ReplayConnection_TimeHandler(handler, net_readBuffer + index + 1);
+		} else {
+			handler(net_readBuffer + index + 1); /* skip opcode */
+		}
+		net_readPos += size;
+	}
+}
+
+static void MPConnection_DoTick(void) {
+	cc_uint64 beg;
+	cc_uint32 read;
+	cc_result res;
+
+	if (Server.Disconnected) return;
+	if (net_connecting) { MPConnection_TickConnect(); return; }
+	beg = Stopwatch_Measure();
+
+	/* Drain the socket of all received data, to avoid falling behind the server */
+	/*  (e.g. when the server sends a large map, or many entities are moving around) */
+	for (;;) {
+		res = MPConnection_ReadSocket(&read);
+
+		if (res) {
+			/* 'no data available for non-blocking read' is an expected error */
+			if (res == ReturnCode_SocketInProgess)  break;
+			if (res == ReturnCode_SocketWouldBlock) break;
+
+			DisconnectReadFailed(res); return;
+		} else if (read == 0) {
+			/* recv only returns 0 read when socket is closed.. probably? */
+			/* Over 30 seconds since last packet, connection probably dropped */
+			/* TODO: Should this be checked unconditonally instead of just when read = 0 ? */
+			if (net_lastPacket + 30 < Game.Time) { MPConnection_Disconnect(); return; }
+			break;
 		}
-		net_readCurrent = net_readBuffer + remaining;
+
+		net_lastPacket = Game.Time;
+		MPConnection_ProcessPackets();
+		if (Server.Disconnected) return;
+		if (Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure()) >= NET_TICK_BUDGET_US) break;
 	}
 
 	if (net_writeFailure) {
@@ -423,6 +529,12 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 	Protocol_Tick();
 }
 
+static void MPConnection_Tick(struct ScheduledTask* task) {
+	Profiler_Begin(PROFILER_NETWORK);
+	MPConnection_DoTick();
+	Profiler_End(PROFILER_NETWORK);
+}
+
 static void MPConnection_SendData(const cc_uint8* data, cc_uint32 len) {
 	cc_uint32 wrote;
 	cc_result res;
@@ -456,7 +568,184 @@ static void MPConnection_Init(void) {
 	Server.SendBlock    = MPConnection_SendBlock;
 	Server.SendChat     = MPConnection_SendChat;
 	Server.SendData     = MPConnection_SendData;
-	net_readCurrent     = net_readBuffer;
+	net_readPos         = 0;
+	net_writePos        = 0;
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Replay connection----------------------------------------------------*
+*#########################################################################################################################*/
+/* Replays a network capture through the same code path as a multiplayer connection */
+/*  (so that problems seen on a live server can be reproduced and measured) */
+static char replayBuffer[FILENAME_SIZE];
+cc_string MP_ReplayPath = String_FromArray(replayBuffer);
+
+static struct Stream replay_stream;
+static cc_uint8  replay_record[NET_RING_SIZE];
+static cc_uint32 replay_recordTime, replay_recordLen, replay_recordOffset;
+static cc_bool   replay_opened, replay_hasRecord, replay_realtime, replay_finished;
+static cc_uint64 replay_start;
+/* Number of times and total time (in Stopwatch units) the handler for each opcode was called */
+static int       replay_opcodeCounts[256];
+static cc_uint64 replay_opcodeTimes[256];
+#define REPLAY_TICK_BUDGET_US 50000
+
+static void ReplayConnection_TimeHandler(Net_Handler handler, cc_uint8* data) {
+	cc_uint8 opcode = data[-1];
+	cc_uint64 beg   = Stopwatch_Measure();
+	handler(data);
+
+	/* NOTE: Many handlers take less than a microsecond, so accumulate raw Stopwatch time */
+	replay_opcodeTimes[opcode] += Stopwatch_Measure() - beg;
+	replay_opcodeCounts[opcode]++;
+}
+
+static void ReplayConnection_Fail(const cc_string* reason) {
+	static const cc_string title = String_FromConst("Failed to replay network capture");
+	Game_Disconnect(&title, reason);
+}
+
+static void ReplayConnection_FailRead(cc_result res) {
+	cc_string msg; char msgBuffer[STRING_SIZE];
+	String_InitArray(msg, msgBuffer);
+	String_Format1(&msg, "Error reading capture file: %i", &res);
+	ReplayConnection_Fail(&msg);
+}
+
+static void ReplayConnection_BeginConnect(void) {
+	cc_uint8 magic[sizeof(net_captureMagic)];
+	cc_result res;
+
+	replay_hasRecord = false;
+	replay_finished  = false;
+	Mem_Set(replay_opcodeCounts, 0, sizeof(replay_opcodeCounts));
+	Mem_Set(replay_opcodeTimes,  0, sizeof(replay_opcodeTimes));
+
+	res = Stream_OpenFile(&replay_stream, &MP_ReplayPath);
+	if (res) { Logger_SysWarn2(res, "opening", &MP_ReplayPath); ReplayConnection_FailRead(res); return; }
+
+	Server.Disconnected = false;
+	replay_opened       = true;
+	res = Stream_Read(&replay_stream, magic, sizeof(magic));
+
+	if (res) { ReplayConnection_FailRead(res); return; }
+	if (!Mem_Equal(magic, net_captureMagic, sizeof(magic))) {
+		static const cc_string reason = String_FromConst("File is not a network capture");
+		ReplayConnection_Fail(&reason); return;
+	}
+
+	replay_realtime = Options_GetBool(OPT_REPLAY_REALTIME, false);
+	replay_start    = Stopwatch_Measure();
+	MPConnection_FinishConnect();
+}
+
+static cc_bool ReplayConnection_ReadRecord(void) {
+	cc_uint8 header[8];
+	cc_result res;
+
+	res = Stream_Read(&replay_stream, header, sizeof(header));
+	if (res == ERR_END_OF_STREAM) return false;
+	if (res) { ReplayConnection_FailRead(res); return false; }
+
+	replay_recordTime   = Stream_GetU32_BE(header + 0);
+	replay_recordLen    = Stream_GetU32_BE(header + 4);
+	replay_recordOffset = 0;
+	if (replay_recordLen > NET_RING_SIZE) { ReplayConnection_FailRead(ERR_INVALID_ARGUMENT); return false; }
+
+	res = Stream_Read(&replay_stream, replay_record, replay_recordLen);
+	if (res) { ReplayConnection_FailRead(res); return false; }
+	return replay_hasRecord = true;
+}
+
+/* Copies as much of the current record into the ring buffer as possible, then processes packets */
+static void ReplayConnection_Feed(void) {
+	cc_uint32 index, count;
+
+	while (replay_recordOffset < replay_recordLen) {
+		index = net_writePos & NET_RING_MASK;
+		count = NET_RING_SIZE - (net_writePos - net_readPos);
+		count = min(count, NET_RING_SIZE - index);
+		count = min(count, replay_recordLen - replay_recordOffset);
+
+		Mem_Copy(net_readBuffer + index, replay_record + replay_recordOffset, count);
+		net_writePos        += count;
+		replay_recordOffset += count;
+
+		MPConnection_ProcessPackets();
+		if (Server.Disconnected) return;
+	}
+	replay_hasRecord = false;
+}
+
+static void ReplayConnection_Report(void) {
+	cc_string str; char strBuffer[STRING_SIZE];
+	int i, elapsed;
+	float totalMS, avgUS;
+	cc_uint64 totalUS;
+	cc_uint8 opcode;
+
+	elapsed = (int)(Stopwatch_ElapsedMicroseconds(replay_start, Stopwatch_Measure()) / 1000);
+	Chat_Add1("&eFinished replaying network capture in %i ms", &elapsed);
+	Platform_Log1("Finished replaying network capture in %i ms", &elapsed);
+
+	for (i = 0; i < 256; i++)
+	{
+		if (!replay_opcodeCounts[i]) continue;
+		totalUS = Stopwatch_ElapsedMicroseconds(0, replay_opcodeTimes[i]);
+		totalMS = totalUS / 1000.0f;
+		avgUS   = (float)totalUS / replay_opcodeCounts[i];
+
+		opcode  = (cc_uint8)i;
+
+		String_InitArray(str, strBuffer);
+		String_Format4(&str, "Opcode %b: %i packets, %f2 ms total, %f2 us avg",
+						&opcode, &replay_opcodeCounts[i], &totalMS, &avgUS);
+		Chat_Add1("&e  %s", &str);
+		Platform_Log(str.buffer, str.length);
+	}
+}
+
+static void ReplayConnection_Tick(struct ScheduledTask* task) {
+	cc_uint64 beg = Stopwatch_Measure();
+	cc_uint32 elapsed;
+	if (Server.Disconnected || replay_finished) return;
+
+	for (;;) {
+		if (!replay_hasRecord && !ReplayConnection_ReadRecord()) {
+			if (Server.Disconnected) return;
+			replay_finished = true;
+			ReplayConnection_Report(); return;
+		}
+
+		/* In real time mode, wait until the same time has elapsed as when the data was originally received */
+		if (replay_realtime) {
+			elapsed = (cc_uint32)(Stopwatch_ElapsedMicroseconds(replay_start, beg) / 1000);
+			if (replay_recordTime > elapsed) return;
+		}
+
+		ReplayConnection_Feed();
+		if (Server.Disconnected) return;
+		if (Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure()) >= REPLAY_TICK_BUDGET_US) return;
+	}
+}
+
+static void ReplayConnection_SendBlock(int x, int y, int z, BlockID old, BlockID now) { }
+static void ReplayConnection_SendChat(const cc_string* text) { }
+static void ReplayConnection_SendData(const cc_uint8* data, cc_uint32 len) { }
+
+static void ReplayConnection_Init(void) {
+	Server_ResetState();
+	Server.IsSinglePlayer = false;
+
+	Server.BeginConnect = ReplayConnection_BeginConnect;
+	Server.Tick         = ReplayConnection_Tick;
+	Server.SendBlock    = ReplayConnection_SendBlock;
+	Server.SendChat     = ReplayConnection_SendChat;
+	Server.SendData     = ReplayConnection_SendData;
+	net_replaying       = true;
+	net_readPos         = 0;
+	net_writePos        = 0;
 }
 
 
@@ -476,7 +765,9 @@ static void OnInit(void) {
 	String_InitArray(Server.MOTD,    motdBuffer);
 	String_InitArray(Server.AppName, appBuffer);
 
-	if (!Server.Address.length) {
+	if (MP_ReplayPath.length) {
+		ReplayConnection_Init();
+	} else if (!Server.Address.length) {
 		SPConnection_Init();
 	} else {
 		MPConnection_Init();
@@ -509,9 +800,15 @@ static void OnClose(void) {
 		Physics_Free();
 	} else {
 		Ping_Reset();
+		NetCapture_Stop();
 		if (Server.Disconnected) return;
 
-		Socket_Close(net_socket);
+		if (!net_replaying) {
+			Socket_Close(net_socket);
+		} else if (replay_opened) {
+			replay_stream.Close(&replay_stream);
+			replay_opened = false;
+		}
 		Server.Disconnected = true;
 	}
 }
@@ -71,4 +71,7 @@ void Server_RetrieveTexturePack(const cc_string* url);
 
 /* Path of map to automatically load in singleplayer */
 extern cc_string SP_AutoloadMap;
+/* Path of network capture to replay instead of connecting to a server */
+/* NOTE: Network captures are saved when the net-capture option is enabled */
+extern cc_string MP_ReplayPath;
 #endif
@@ -343,11 +343,17 @@ static cc_result Stream_BufferedSeek(struct Stream* s, cc_uint32 position) {
 	return res;
 }
 
+static cc_result Stream_BufferedLength(struct Stream* s, cc_uint32* length) {
+	struct Stream* source = s->Meta.Buffered.Source;
+	return source->Length(source, length);
+}
+
 void Stream_ReadonlyBuffered(struct Stream* s, struct Stream* source, void* data, cc_uint32 size) {
 	Stream_Init(s);
 	s->Read   = Stream_BufferedRead;
 	s->ReadU8 = Stream_BufferedReadU8;
 	s->Seek   = Stream_BufferedSeek;
+	s->Length = Stream_BufferedLength;
 
 	s->Meta.Buffered.Left   = 0;
 	s->Meta.Buffered.End    = 0;	
@@ -16,6 +16,8 @@
 #include "Utils.h"
 #include "Chat.h" /* TODO avoid this include */
 #include "Errors.h"
+#include "Builder.h"
+#include "Model.h"
 
 /*########################################################################################################################*
 *------------------------------------------------------TerrainAtlas-------------------------------------------------------*
@@ -76,6 +78,9 @@ static void Atlas_Update1D(void) {
 	maxTilesPerAtlas = maxAtlasHeight / Atlas2D.TileSize;
 	maxTiles         = Atlas2D.RowsCount * ATLAS2D_TILES_PER_ROW;
 
+	/* Greedy mesh builder needs tiles to also repeat vertically */
+	if (Builder_GreedyMeshing && !Builder_SmoothLighting) maxTilesPerAtlas = 1;
+
 	Atlas1D.TilesPerAtlas = min(maxTilesPerAtlas, maxTiles);
 	Atlas1D.Count = Math_CeilDiv(maxTiles, Atlas1D.TilesPerAtlas);
 
@@ -244,20 +249,23 @@ static cc_bool UseDedicatedCache(cc_string* path, const cc_string* key) {
 	return !cacheInvalid;
 }
 
-CC_NOINLINE static void MakeCachePath(cc_string* mainPath, cc_string* altPath, const cc_string* url) {
-	cc_string key; char keyBuffer[STRING_INT_CHARS];
-	String_InitArray(key, keyBuffer);
-	HashUrl(&key, url);
-	
-	if (UseDedicatedCache(mainPath, &key)) {
+static void MakeCachePathForKey(cc_string* mainPath, cc_string* altPath, const cc_string* key) {
+	if (UseDedicatedCache(mainPath, key)) {
 		/* If using dedicated cache directory, also fallback to default cache directory */
-		String_Format1(altPath,  "texturecache/%s",  &key);
+		String_Format1(altPath,  "texturecache/%s",  key);
 	} else {
 		mainPath->length = 0;
-		String_Format1(mainPath, "texturecache/%s",  &key);
+		String_Format1(mainPath, "texturecache/%s",  key);
 	}
 }
 
+CC_NOINLINE static void MakeCachePath(cc_string* mainPath, cc_string* altPath, const cc_string* url) {
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+	String_InitArray(key, keyBuffer);
+	HashUrl(&key, url);
+	MakeCachePathForKey(mainPath, altPath, &key);
+}
+
 /* Returns non-zero if given URL has been cached */
 static int IsCached(const cc_string* url) {
 	cc_string mainPath; char mainBuffer[FILENAME_SIZE];
@@ -315,35 +323,176 @@ static cc_string GetCachedETag(const cc_string* url) {
 	return GetCachedTag(url, &etagCache);
 }
 
+/* Whether the ETag/Last-Modified lists have changed since they were last saved */
+static cc_bool etagsChanged, lastModChanged;
+
 CC_NOINLINE static void SetCachedTag(const cc_string* url, struct StringsBuffer* list,
-									 const cc_string* data, const char* file) {
+									 const cc_string* data, cc_bool* changed) {
 	cc_string key; char keyBuffer[STRING_INT_CHARS];
 	if (!data->length) return;
 
 	String_InitArray(key, keyBuffer);
 	HashUrl(&key, url);
 	EntryList_Set(list, &key, data, ' ');
-	EntryList_Save(list, file);
+	*changed = true;
+}
+
+static void SaveCachedTags(void) {
+	if (etagsChanged)   EntryList_Save(&etagCache,    ETAGS_TXT);
+	if (lastModChanged) EntryList_Save(&lastModCache, LASTMOD_TXT);
+
+	etagsChanged   = false;
+	lastModChanged = false;
 }
 
 /* Updates cached data, ETag, and Last-Modified for the given URL */
-static void UpdateCache(struct HttpRequest* req) {
-	cc_string url, altPath, value;
+static void UpdateCache(const cc_string* url, struct HttpRequest* req) {
+	cc_string altPath, value;
 	cc_string path; char pathBuffer[FILENAME_SIZE];
 	cc_result res;
-	url = String_FromRawArray(req->url);
 
 	value = String_FromRawArray(req->etag);
-	SetCachedTag(&url, &etagCache,    &value, ETAGS_TXT);
+	SetCachedTag(url, &etagCache,    &value, &etagsChanged);
 	value = String_FromRawArray(req->lastModified);
-	SetCachedTag(&url, &lastModCache, &value, LASTMOD_TXT);
+	SetCachedTag(url, &lastModCache, &value, &lastModChanged);
 
 	String_InitArray(path, pathBuffer);
 	altPath = String_Empty;
-	MakeCachePath(&path, &altPath, &url);
+	MakeCachePath(&path, &altPath, url);
 
 	res = Stream_WriteAllTo(&path, req->data, req->size);
-	if (res) { Logger_SysWarn2(res, "caching", &url); }
+	if (res) { Logger_SysWarn2(res, "caching", url); }
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------SkinCache--------------------------------------------------------*
+*#########################################################################################################################*/
+/* Skins are cached the same way as texture packs, except that the total size of cached skins is limited */
+/* skins.txt lists the size of each cached skin, from least recently to most recently used */
+/* NOTE: Changes are only saved periodically, to avoid rewriting files every time a skin is downloaded */
+static struct StringsBuffer skinsList;
+static cc_uint32 skinsSize, skinsMaxSize;
+static cc_bool skinsChanged;
+#define SKINS_TXT "texturecache/skins.txt"
+
+static cc_uint32 SkinCache_EntrySize(int i) {
+	cc_string entry, key, value;
+	int size;
+
+	StringsBuffer_UNSAFE_GetRaw(&skinsList, i, &entry);
+	String_UNSAFE_Separate(&entry, ' ', &key, &value);
+	return Convert_ParseInt(&value, &size) && size > 0 ? size : 0;
+}
+
+static void SkinCache_Save(void) {
+	SaveCachedTags();
+	if (!skinsChanged) return;
+
+	EntryList_Save(&skinsList, SKINS_TXT);
+	skinsChanged = false;
+}
+static void SkinCache_SaveTask(struct ScheduledTask* task) { SkinCache_Save(); }
+
+/* Removes the least recently used skin from the cache */
+static void SkinCache_RemoveOldest(void) {
+	cc_string entry, key, value;
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string altPath;
+	char keyBuffer[STRING_SIZE];
+
+	StringsBuffer_UNSAFE_GetRaw(&skinsList, 0, &entry);
+	String_UNSAFE_Separate(&entry, ' ', &key, &value);
+	/* Key must be copied, as it's about to be removed from the list */
+	String_CopyToRawArray(keyBuffer, &key);
+	key = String_Init(keyBuffer, key.length, key.length);
+
+	skinsSize -= SkinCache_EntrySize(0);
+	StringsBuffer_Remove(&skinsList, 0);
+	skinsChanged = true;
+
+	if (EntryList_Remove(&etagCache,    &key, ' ')) etagsChanged   = true;
+	if (EntryList_Remove(&lastModCache, &key, ' ')) lastModChanged = true;
+
+	/* Files can't be deleted, so empty the cached file instead */
+	String_InitArray(path, pathBuffer);
+	altPath = String_Empty;
+	MakeCachePathForKey(&path, &altPath, &key);
+	Stream_WriteAllTo(&path, NULL, 0);
+}
+
+static void SkinCache_Init(void) {
+	int i;
+	EntryList_UNSAFE_Load(&skinsList, SKINS_TXT);
+	skinsMaxSize = Options_GetInt(OPT_SKIN_CACHE_SIZE, 0, 1024, 16) * 1024 * 1024;
+
+	skinsSize = 0;
+	for (i = 0; i < skinsList.count; i++) 
+	{
+		skinsSize += SkinCache_EntrySize(i);
+	}
+
+	/* Size limit may have been reduced since skins were cached */
+	while (skinsList.count && skinsSize > skinsMaxSize) 
+	{
+		SkinCache_RemoveOldest();
+	}
+	SkinCache_Save();
+}
+
+cc_bool TextureCache_OpenSkin(const cc_string* url, struct Stream* stream) {
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+	cc_string entry; char entryBuffer[STRING_SIZE];
+	cc_string raw;
+	int i;
+
+	String_InitArray(key, keyBuffer);
+	HashUrl(&key, url);
+	i = EntryList_Find(&skinsList, &key, ' ');
+	if (i == -1) return false;
+
+	/* Move to end of list, as it's now the most recently used skin */
+	String_InitArray(entry, entryBuffer);
+	StringsBuffer_UNSAFE_GetRaw(&skinsList, i, &raw);
+	String_Copy(&entry, &raw);
+
+	StringsBuffer_Remove(&skinsList, i);
+	StringsBuffer_Add(&skinsList, &entry);
+	skinsChanged = true;
+	return OpenCachedData(url, stream);
+}
+
+void TextureCache_GetSkinTags(const cc_string* url, cc_string* lastModified, cc_string* etag) {
+	*lastModified = GetCachedLastModified(url);
+	*etag         = GetCachedETag(url);
+}
+
+void TextureCache_AddSkin(const cc_string* url, struct HttpRequest* req) {
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+	cc_string size; char sizeBuffer[STRING_INT_CHARS];
+	int i;
+	if (!req->size || req->size > skinsMaxSize) return;
+
+	String_InitArray(key, keyBuffer);
+	HashUrl(&key, url);
+	i = EntryList_Find(&skinsList, &key, ' ');
+
+	if (i >= 0) {
+		skinsSize -= SkinCache_EntrySize(i);
+		StringsBuffer_Remove(&skinsList, i);
+	}
+	while (skinsList.count && skinsSize + req->size > skinsMaxSize) 
+	{
+		SkinCache_RemoveOldest();
+	}
+	UpdateCache(url, req);
+
+	String_InitArray(size, sizeBuffer);
+	String_AppendUInt32(&size, req->size);
+	EntryList_Set(&skinsList, &key, &size, ' ');
+
+	skinsSize   += req->size;
+	skinsChanged = true;
 }
 
 
@@ -383,14 +532,154 @@ cc_result TexturePack_ExtractDefault(DefaultZipCallback callback) {
 }
 
 
+static struct TextureEntry* entries_head;
+static struct TextureEntry* entries_tail;
+
+void TextureEntry_Register(struct TextureEntry* entry) {
+	LinkedList_Append(entry, entries_head, entries_tail);
+}
+
+/* Cooperatively threaded platforms can't decode in parallel, and low memory platforms can't afford */
+/*  to keep every PNG file in the texture pack in memory at once */
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_LOWMEM
+#define PACK_PARALLEL_PNGS
+#endif
+#define PACK_MAX_PNGS 64
+/* Max number of PNGs that are decoded ahead of being used, as otherwise every decoded */
+/*  bitmap in the texture pack would be kept in memory at once (very large for HD packs) */
+#define PACK_MAX_DECODING 6
+
+/* PNG file in a texture pack that is waiting to be or is being decoded on a background thread */
+struct PackPng { cc_uint32 offset; int decodeID; cc_uint8* data; cc_uint32 size; };
+static struct PackPng packPngs[PACK_MAX_PNGS];
+static int packPngsCount, packPngsQueued;
+
+#ifdef PACK_PARALLEL_PNGS
+/* Whether the given file is used by the game, rather than e.g. being unused or a sound */
+static cc_bool IsUsedPackPng(const cc_string* name) {
+	static const cc_string png = String_FromConst(".png");
+	struct TextureEntry* e;
+	if (!String_CaselessEnds(name, &png)) return false;
+
+	for (e = entries_head; e; e = e->next) 
+	{
+		if (String_CaselessEqualsConst(name, e->filename)) return true;
+	}
+	return Model_GetTexture(name) != NULL;
+}
+
+static cc_bool SelectPackPng(const cc_string* path) {
+	cc_string name = *path;
+	Utils_UNSAFE_GetFilename(&name);
+	return IsUsedPackPng(&name);
+}
+
+static cc_result QueuePackPng(const cc_string* path, struct Stream* stream, struct ZipEntry* source) {
+	cc_uint32 size = source->UncompressedSize;
+	struct PackPng* png;
+	cc_uint8* data;
+
+	/* Anything that fails here gets reported when the file is decoded normally instead */
+	if (!size || packPngsCount >= PACK_MAX_PNGS) return 0;
+	data = (cc_uint8*)Mem_TryAlloc(size, 1);
+	if (!data) return 0;
+
+	if (Stream_Read(stream, data, size)) { Mem_Free(data); return 0; }
+
+	png = &packPngs[packPngsCount++];
+	png->offset   = source->LocalHeaderOffset;
+	png->decodeID = 0;
+	png->data     = data;
+	png->size     = size;
+	return 0;
+}
+#endif
+
+/* Starts decoding PNGs in the order they were found, until the first 'end' PNGs have been started */
+static void QueuePackPngs(int end) {
+	struct PackPng* png;
+	end = min(end, packPngsCount);
+
+	for (; packPngsQueued < end; packPngsQueued++)
+	{
+		png = &packPngs[packPngsQueued];
+		png->decodeID = PngDecoder_AddOwned(png->data, png->size, NULL, 0);
+		png->data     = NULL;
+	}
+}
+
+static int TakePackPng(cc_uint32 offset) {
+	int i, id;
+	for (i = 0; i < packPngsCount; i++) 
+	{
+		if (packPngs[i].offset != offset) continue;
+		/* Entries are processed in the same order the PNGs were found, */
+		/*  so start decoding the next PNG as each one is taken */
+		QueuePackPngs(i + 1 + PACK_MAX_DECODING);
+
+		id = packPngs[i].decodeID;
+		packPngs[i].decodeID = 0;
+		return id;
+	}
+	return 0;
+}
+
 static cc_bool SelectZipEntry(const cc_string* path) { return true; }
 static cc_result ProcessZipEntry(const cc_string* path, struct Stream* stream, struct ZipEntry* source) {
+	struct PngDecodeResult result;
+	struct Stream mem;
 	cc_string name = *path;
+	int id;
 	Utils_UNSAFE_GetFilename(&name);
-	Event_RaiseEntry(&TextureEvents.FileChanged, stream, &name);
+
+	id = TakePackPng(source->LocalHeaderOffset);
+	if (id && PngDecoder_WaitResult(id, &result)) {
+		PngDecodeResult_MakeStream(&mem, &result);
+		Event_RaiseEntry(&TextureEvents.FileChanged, &mem, &name);
+		PngDecodeResult_Free(&result);
+	} else {
+		Event_RaiseEntry(&TextureEvents.FileChanged, stream, &name);
+	}
 	return 0;
 }
 
+#define PACK_BUFFER_SIZE 16384
+static cc_result ExtractZip(struct Stream* stream) {
+	struct Stream buffered;
+	cc_uint8* buffer;
+	cc_result res;
+	int i;
+
+	/* Reading the directory and entry headers directly from a file costs several reads per entry */
+	buffer = (cc_uint8*)Mem_TryAlloc(PACK_BUFFER_SIZE, 1);
+	if (buffer) {
+		Stream_ReadonlyBuffered(&buffered, stream, buffer, PACK_BUFFER_SIZE);
+		stream = &buffered;
+	}
+
+#ifdef PACK_PARALLEL_PNGS
+	/* Read the PNG files to be decoded in parallel first and start decoding the first few, */
+	/*  then wait for each one when it is reached while processing entries in order */
+	packPngsCount  = 0;
+	packPngsQueued = 0;
+	Zip_Extract(stream, SelectPackPng, QueuePackPng);
+	QueuePackPngs(PACK_MAX_DECODING);
+#endif
+	res = Zip_Extract(stream, SelectZipEntry, ProcessZipEntry);
+
+	/* Discard results that were never used (e.g. due to error extracting) */
+	for (i = 0; i < packPngsCount; i++) 
+	{
+		if (packPngs[i].decodeID) PngDecoder_Cancel(packPngs[i].decodeID);
+		Mem_Free(packPngs[i].data);
+	}
+	packPngsCount  = 0;
+	packPngsQueued = 0;
+
+	Mem_Free(buffer);
+	return res;
+}
+
 static cc_result ExtractPng(struct Stream* stream) {
 	struct Bitmap bmp;
 	cc_result res = Png_Decode(&bmp, stream);
@@ -413,7 +702,7 @@ static cc_result ExtractFrom(struct Stream* stream, const cc_string* path) {
 	res = ExtractPng(stream);
 	if (res == PNG_ERR_INVALID_SIG) {
 		/* file isn't a .png image, probably a .zip archive then */
-		res = Zip_Extract(stream, SelectZipEntry, ProcessZipEntry);
+		res = ExtractZip(stream);
 
 		if (res) Logger_SysWarn2(res, "extracting", path);
 	} else if (res) {
@@ -480,7 +769,8 @@ static void ApplyDownloaded(struct HttpRequest* item) {
 	cc_string url;
 
 	url = String_FromRawArray(item->url);
-	UpdateCache(item);
+	UpdateCache(&url, item);
+	SaveCachedTags();
 	/* Took too long to download and is no longer active texture pack */
 	if (!String_Equals(&TexturePack_Url, &url)) return;
 
@@ -535,13 +825,6 @@ void TexturePack_Extract(const cc_string* url) {
 	TexturePack_ExtractCurrent(false);
 }
 
-static struct TextureEntry* entries_head;
-static struct TextureEntry* entries_tail;
-
-void TextureEntry_Register(struct TextureEntry* entry) {
-	LinkedList_Append(entry, entries_head, entries_tail);
-}
-
 
 /*########################################################################################################################*
 *---------------------------------------------------Textures component----------------------------------------------------*
@@ -601,6 +884,8 @@ static void OnInit(void) {
 	Utils_EnsureDirectory("texpacks");
 	Utils_EnsureDirectory("texturecache");
 	TextureCache_Init();
+	SkinCache_Init();
+	ScheduledTask_Add(30, SkinCache_SaveTask);
 }
 
 static void OnReset(void) {
@@ -611,6 +896,7 @@ static void OnReset(void) {
 
 static void OnFree(void) {
 	OnContextLost(NULL);
+	SkinCache_Save();
 	Atlas2D_Free();
 	TexturePack_Url.length = 0;
 	entries_head = NULL;
@@ -87,6 +87,15 @@ void TextureCache_Deny(const cc_string* url);
 /* Clears the list of denied URLs, returning number removed. */
 int TextureCache_ClearDenied(void);
 
+/* Opens the cached skin for the given URL, and marks it as most recently used. */
+/* Returns false if the skin for the given URL is not in the skin cache. */
+cc_bool TextureCache_OpenSkin(const cc_string* url, struct Stream* stream);
+/* Gets the Last-Modified and ETag of the cached data for the given URL. */
+void TextureCache_GetSkinTags(const cc_string* url, cc_string* lastModified, cc_string* etag);
+/* Adds the downloaded skin for the given URL to the skin cache. */
+/* Least recently used skins are removed when the skin cache grows too large. */
+void TextureCache_AddSkin(const cc_string* url, struct HttpRequest* req);
+
 /* Request ID of texture pack currently being downloaded */
 extern int TexturePack_ReqID;
 /* Sets the filename of the default texture pack used. */
@@ -0,0 +1,106 @@
+#include "Core.h"
+#if defined CC_BUILD_HEADLESS
+#include "Window.h"
+#include "Platform.h"
+#include "Input.h"
+#include "Event.h"
+#include "Graphics.h"
+#include "String.h"
+#include "Funcs.h"
+#include "Bitmap.h"
+#include "Errors.h"
+
+/* Window backend that never shows anything on screen */
+/*  (used by benchmark builds, where only the engine itself is being measured) */
+#define HEADLESS_WIDTH  640
+#define HEADLESS_HEIGHT 480
+
+struct _DisplayData DisplayInfo;
+struct _WinData WindowInfo;
+int Display_ScaleX(int x) { return x; }
+int Display_ScaleY(int y) { return y; }
+
+void Window_Init(void) {
+	DisplayInfo.Width  = HEADLESS_WIDTH;
+	DisplayInfo.Height = HEADLESS_HEIGHT;
+	DisplayInfo.Depth  = 4; /* 32 bit */
+	DisplayInfo.ScaleX = 1;
+	DisplayInfo.ScaleY = 1;
+}
+
+static void DoCreateWindow(int width, int height) {
+	WindowInfo.Width   = width;
+	WindowInfo.Height  = height;
+	WindowInfo.Focused = true;
+	WindowInfo.Exists  = true;
+}
+void Window_Create2D(int width, int height) { DoCreateWindow(width, height); }
+void Window_Create3D(int width, int height) { DoCreateWindow(width, height); }
+
+void Window_SetTitle(const cc_string* title) { }
+void Clipboard_GetText(cc_string* value) { }
+void Clipboard_SetText(const cc_string* value) { }
+
+int Window_GetWindowState(void) { return WINDOW_STATE_NORMAL; }
+cc_result Window_EnterFullscreen(void) { return ERR_NOT_SUPPORTED; }
+cc_result Window_ExitFullscreen(void)  { return ERR_NOT_SUPPORTED; }
+int Window_IsObscured(void)            { return 0; }
+
+void Window_Show(void) { }
+void Window_SetSize(int width, int height) {
+	WindowInfo.Width  = width;
+	WindowInfo.Height = height;
+	Event_RaiseVoid(&WindowEvents.Resized);
+}
+
+void Window_Close(void) {
+	WindowInfo.Exists = false;
+	Event_RaiseVoid(&WindowEvents.Closing);
+}
+
+void Window_ProcessEvents(double delta) { }
+
+void Cursor_SetPosition(int x, int y) { }
+void Window_EnableRawMouse(void)  { Input.RawMode = true;  }
+void Window_DisableRawMouse(void) { Input.RawMode = false; }
+void Window_UpdateRawMouse(void)  { }
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Framebuffer--------------------------------------------------------*
+*#########################################################################################################################*/
+void Window_AllocFramebuffer(struct Bitmap* bmp) {
+	bmp->scan0 = (BitmapCol*)Mem_Alloc(bmp->width * bmp->height, 4, "window pixels");
+}
+
+void Window_DrawFramebuffer(Rect2D r) { }
+
+void Window_FreeFramebuffer(struct Bitmap* bmp) {
+	Mem_Free(bmp->scan0);
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Soft keyboard------------------------------------------------------*
+*#########################################################################################################################*/
+void Window_OpenKeyboard(struct OpenKeyboardArgs* args) { }
+void Window_SetKeyboardText(const cc_string* text) { }
+void Window_CloseKeyboard(void) { }
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Misc/Other--------------------------------------------------------*
+*#########################################################################################################################*/
+void Window_ShowDialog(const char* title, const char* msg) {
+	Platform_LogConst(title);
+	Platform_LogConst(msg);
+}
+
+cc_result Window_OpenFileDialog(const struct OpenFileDialogArgs* args) {
+	return ERR_NOT_SUPPORTED;
+}
+
+cc_result Window_SaveFileDialog(const struct SaveFileDialogArgs* args) {
+	return ERR_NOT_SUPPORTED;
+}
+#endif
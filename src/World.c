@@ -10,9 +10,130 @@
 #include "Game.h"
 #include "TexturePack.h"
 #include "Window.h"
+#include "Builder.h"
 
 struct _WorldData World;
 static char nameBuffer[STRING_SIZE];
+
+#ifdef CC_BUILD_PALETTEDWORLD
+/*########################################################################################################################*
+*-----------------------------------------------------World sections------------------------------------------------------*
+*#########################################################################################################################*/
+/* Maps a block to 1 + its index in the palette being built, or 0 if not in the palette yet */
+/* NOTE: Only used on the main thread, and always cleared again after building a palette */
+static cc_uint16 paletteLookup[1024];
+
+static int CalcPaletteBits(int count) {
+	if (count <=   1) return 0;
+	if (count <=   2) return 1;
+	if (count <=   4) return 2;
+	if (count <=  16) return 4;
+	if (count <= 256) return 8;
+	return SECTION_DIRECT_BITS;
+}
+
+/* Replaces the contents of the section with the given blocks, using as few bits per block as possible */
+static cc_bool WorldSection_Pack(struct WorldSection* s, const BlockID* blocks) {
+	BlockID palette[1024];
+	int i, bits, count = 0, size;
+	cc_uint8* data = NULL;
+
+	for (i = 0; i < CHUNK_SIZE_3; i++) {
+		if (paletteLookup[blocks[i]]) continue;
+		palette[count++] = blocks[i];
+		paletteLookup[blocks[i]] = count;
+	}
+	bits = CalcPaletteBits(count);
+
+	if (bits == SECTION_DIRECT_BITS) {
+		data = (cc_uint8*)Mem_TryAlloc(CHUNK_SIZE_3, sizeof(BlockID));
+		if (data) Mem_Copy(data, blocks, CHUNK_SIZE_3 * sizeof(BlockID));
+	} else if (bits) {
+		size = (CHUNK_SIZE_3 / 8) * bits;
+		data = (cc_uint8*)Mem_TryAlloc(size + (1 << bits) * sizeof(BlockID), 1);
+
+		if (data) {
+			Mem_Set(data, 0, size);
+			Mem_Copy(data + size, palette, count * sizeof(BlockID));
+
+			for (i = 0; i < CHUNK_SIZE_3; i++) {
+				size = i * bits;
+				data[size >> 3] |= (paletteLookup[blocks[i]] - 1) << (size & 7);
+			}
+		}
+	}
+	for (i = 0; i < count; i++) paletteLookup[palette[i]] = 0;
+
+	if (bits && !data) return false;
+	Mem_Free(s->Data);
+
+	s->Data  = data;
+	s->Block = palette[0];
+	s->Bits  = bits;
+	s->PaletteCount = bits == SECTION_DIRECT_BITS || !bits ? 0 : count;
+	s->Palette = bits == SECTION_DIRECT_BITS || !bits ? NULL : (BlockID*)(data + (CHUNK_SIZE_3 / 8) * bits);
+	return true;
+}
+
+static void FreeSections(void) {
+	int i;
+	if (!World.Sections) return;
+
+	for (i = 0; i < World.ChunksCount; i++) {
+		Mem_Free(World.Sections[i].Data);
+	}
+	Mem_Free(World.Sections);
+	World.Sections = NULL;
+}
+
+/* Converts World.Blocks (and World.Blocks2) into sections, then frees them */
+static cc_bool BuildSections(void) {
+	BlockID blocks[CHUNK_SIZE_3];
+	int cx, cy, cz, x, y, z, i, index;
+	BlockRaw* upper = NULL;
+	BlockID block;
+
+	World.Sections = (struct WorldSection*)Mem_TryAllocCleared(World.ChunksCount, sizeof(struct WorldSection));
+	if (!World.Sections) return false;
+#ifdef EXTENDED_BLOCKS
+	if (World.Blocks2 != World.Blocks) upper = World.Blocks2;
+#endif
+
+	for (cy = 0; cy < World.ChunksY; cy++)
+		for (cz = 0; cz < World.ChunksZ; cz++)
+			for (cx = 0; cx < World.ChunksX; cx++)
+	{
+		/* Parts of sections on the edges of the map may be outside the map */
+		Mem_Set(blocks, 0, sizeof(blocks));
+		i = 0;
+
+		for (y = cy << CHUNK_SHIFT; y < (cy << CHUNK_SHIFT) + CHUNK_SIZE; y++)
+			for (z = cz << CHUNK_SHIFT; z < (cz << CHUNK_SHIFT) + CHUNK_SIZE; z++)
+				for (x = cx << CHUNK_SHIFT; x < (cx << CHUNK_SHIFT) + CHUNK_SIZE; x++, i++)
+		{
+			if (!World_Contains(x, y, z)) continue;
+			index = World_Pack(x, y, z);
+
+			block = World.Blocks[index];
+#ifdef EXTENDED_BLOCKS
+			if (upper) block = (block | (upper[index] << 8)) & World.IDMask;
+#endif
+			blocks[i] = block;
+		}
+
+		if (!WorldSection_Pack(&World.Sections[World_ChunkPack(cx, cy, cz)], blocks)) return false;
+	}
+
+	Mem_Free(upper);
+	Mem_Free(World.Blocks);
+	World.Blocks  = NULL;
+#ifdef EXTENDED_BLOCKS
+	World.Blocks2 = NULL;
+#endif
+	return true;
+}
+#endif
+
 /*########################################################################################################################*
 *----------------------------------------------------------World----------------------------------------------------------*
 *#########################################################################################################################*/
@@ -38,6 +159,11 @@ static void GenerateNewUuid(void) {
 }
 
 void World_Reset(void) {
+	/* Background threads may still be reading blocks to build chunk meshes */
+	Builder_CancelChunks();
+#ifdef CC_BUILD_PALETTEDWORLD
+	FreeSections();
+#endif
 #ifdef EXTENDED_BLOCKS
 	if (World.Blocks != World.Blocks2) Mem_Free(World.Blocks2);
 	World.Blocks2 = NULL;
@@ -75,6 +201,9 @@ void World_SetNewMap(BlockRaw* blocks, int width, int height, int length) {
 		World.IDMask  = 0xFF;
 	}
 #endif
+#ifdef CC_BUILD_PALETTEDWORLD
+	if (World.Blocks && !BuildSections()) World_OutOfMemory();
+#endif
 
 	if (Env.EdgeHeight == -1)   { Env.EdgeHeight   = height / 2; }
 	if (Env.CloudsHeight == -1) { Env.CloudsHeight = height + 2; }
@@ -113,7 +242,49 @@ void World_OutOfMemory(void) {
 }
 
 
+#if defined CC_BUILD_PALETTEDWORLD
+void World_SetBlock(int x, int y, int z, BlockID block) {
+	struct WorldSection* s = &World.Sections[World_ChunkPack(x >> 4, y >> 4, z >> 4)];
+	BlockID blocks[CHUNK_SIZE_3];
+	int i = World_SectionIndex(x, y, z);
+	int p, mask;
+
 #ifdef EXTENDED_BLOCKS
+	if (block >= 256) World.IDMask = 0x3FF;
+#endif
+	if (s->Bits == SECTION_DIRECT_BITS) { ((BlockID*)s->Data)[i] = block; return; }
+	if (!s->Data && s->Block == block) return;
+
+	for (p = 0; p < s->PaletteCount; p++) {
+		if (s->Palette[p] == block) break;
+	}
+
+	if (p == s->PaletteCount) {
+		if (s->Data && p < (1 << s->Bits)) {
+			s->Palette[s->PaletteCount++] = block;
+		} else {
+			/* Palette is full, so repack with more bits per block */
+			/* Background threads may be reading from the data that is about to be freed */
+			Builder_CancelChunks();
+			for (p = 0; p < CHUNK_SIZE_3; p++) blocks[p] = WorldSection_Get(s, p);
+			blocks[i] = block;
+
+			if (!WorldSection_Pack(s, blocks)) World_OutOfMemory();
+			return;
+		}
+	}
+
+	i   *= s->Bits;
+	mask = ((1 << s->Bits) - 1) << (i & 7);
+	s->Data[i >> 3] = (s->Data[i >> 3] & ~mask) | (p << (i & 7));
+}
+
+BlockID World_GetRawBlock(int index) {
+	int x, y, z;
+	World_Unpack(index, x, y, z);
+	return World_GetBlock(x, y, z);
+}
+#elif defined EXTENDED_BLOCKS
 static CC_NOINLINE void LazyInitUpper(int i, BlockID block) {
 	BlockRaw* data = (BlockRaw*)Mem_TryAllocCleared(World.Volume, 1);
 	if (!data) { World_OutOfMemory(); return; }
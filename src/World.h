@@ -18,14 +18,39 @@ extern struct IGameComponent World_Component;
 #define World_ChunkPack(cx, cy, cz) (((cz) * World.ChunksY + (cy)) * World.ChunksX + (cx))
 /* TODO: Swap Y and Z? Make sure to update MapRenderer's ResetChunkCache and ClearChunkCache methods! */
 
+#ifdef CC_BUILD_PALETTEDWORLD
+/* Number of bits per block in a section that stores blocks directly, instead of as palette indices */
+#define SECTION_DIRECT_BITS (sizeof(BlockID) * 8)
+
+/* A 16x16x16 section of the world (same bounds as the corresponding chunk) */
+/* Blocks are stored as indices into a palette of the different blocks in the section */
+struct WorldSection {
+	/* Packed palette indices, or NULL if every block in the section is the same */
+	cc_uint8* Data;
+	/* Blocks that palette indices map to. (Stored in the same allocation as Data) */
+	BlockID* Palette;
+	/* Block of every block in the section, when Data is NULL */
+	BlockID Block;
+	/* Number of bits each palette index uses. (0, 1, 2, 4, 8, or SECTION_DIRECT_BITS) */
+	cc_uint8 Bits;
+	/* Number of blocks used in the palette */
+	cc_uint16 PaletteCount;
+};
+#endif
+
 
 CC_VAR extern struct _WorldData {
 	/* The blocks in the world. */
+	/* NOTE: With CC_BUILD_PALETTEDWORLD, only used while a map is being loaded. */
 	BlockRaw* Blocks;
 #ifdef EXTENDED_BLOCKS
 	/* The upper 8 bit of blocks in the world. */
 	/* If only 8 bit blocks are used, equals World_Blocks. */
 	BlockRaw* Blocks2;
+#endif
+#ifdef CC_BUILD_PALETTEDWORLD
+	/* The sections the blocks in the world are stored in. (ChunksCount sections) */
+	struct WorldSection* Sections;
 #endif
 	/* Volume of the world. */
 	int Volume;
@@ -76,7 +101,32 @@ void World_OutOfMemory(void);
 #ifdef EXTENDED_BLOCKS
 /* Sets World.Blocks2 and updates internal state for more than 256 blocks. */
 void World_SetMapUpper(BlockRaw* blocks);
+#endif
+
+/* World_HasBlocks() - whether the world currently has any blocks */
+#if defined CC_BUILD_PALETTEDWORLD
+#define World_HasBlocks() (World.Sections != NULL)
+#define World_SectionIndex(x, y, z) ((((y) & 0x0F) << 8) | (((z) & 0x0F) << 4) | ((x) & 0x0F))
 
+/* Gets the block at the given index within a section. (see World_SectionIndex) */
+static CC_INLINE BlockID WorldSection_Get(const struct WorldSection* s, int i) {
+	if (!s->Data) return s->Block;
+	if (s->Bits == SECTION_DIRECT_BITS) return ((BlockID*)s->Data)[i];
+
+	i *= s->Bits;
+	return s->Palette[(s->Data[i >> 3] >> (i & 7)) & ((1 << s->Bits) - 1)];
+}
+
+/* Gets the block at the given coordinates. */
+/* NOTE: Does NOT check that the coordinates are inside the map. */
+static CC_INLINE BlockID World_GetBlock(int x, int y, int z) {
+	const struct WorldSection* s = &World.Sections[World_ChunkPack(x >> 4, y >> 4, z >> 4)];
+	return WorldSection_Get(s, World_SectionIndex(x, y, z));
+}
+/* Gets the block at the given packed index. (slow!) */
+BlockID World_GetRawBlock(int index);
+#elif defined EXTENDED_BLOCKS
+#define World_HasBlocks() (World.Blocks != NULL)
 #define World_GetRawBlock(idx) ((World.Blocks[idx] | (World.Blocks2[idx] << 8)) & World.IDMask)
 
 /* Gets the block at the given coordinates. */
@@ -86,6 +136,7 @@ static CC_INLINE BlockID World_GetBlock(int x, int y, int z) {
 	return (BlockID)World_GetRawBlock(i);
 }
 #else
+#define World_HasBlocks() (World.Blocks != NULL)
 #define World_GetBlock(x, y, z) World.Blocks[World_Pack(x, y, z)]
 #define World_GetRawBlock(idx)  World.Blocks[idx]
 #endif
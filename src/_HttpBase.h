@@ -39,22 +39,22 @@ static void RequestList_EnsureSpace(struct RequestList* list) {
 				sizeof(struct HttpRequest), HTTP_DEF_ELEMS, 10);
 }
 
-/* Adds a request to the list */
+/* Adds a request to the list, after all requests with the same or a higher priority */
 static void RequestList_Append(struct RequestList* list, struct HttpRequest* item, cc_uint8 flags) {
-	int i;
+	int i, j;
 	RequestList_EnsureSpace(list);
 
 	if (flags & HTTP_FLAG_PRIORITY) {
-		/* Shift all requests right one place */
-		for (i = list->count; i > 0; i--) 
-		{
-			HttpRequest_Copy(&list->entries[i], &list->entries[i - 1]);
-		}
 		/* Insert new request at front/start */
 		i = 0;
 	} else {
-		/* Insert new request at end */
-		i = list->count;
+		for (i = list->count; i > 0 && list->entries[i - 1].priority > item->priority; i--) { }
+	}
+
+	/* Shift requests after the new request right one place */
+	for (j = list->count; j > i; j--) 
+	{
+		HttpRequest_Copy(&list->entries[j], &list->entries[j - 1]);
 	}
 
 	HttpRequest_Copy(&list->entries[i], item);
@@ -113,6 +113,13 @@ static struct RequestList processedReqs;
 static int nextReqID;
 static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags);
 
+static cc_uint8 Http_GetPriority(cc_uint8 flags) {
+	if (flags & HTTP_FLAG_PRIORITY)        return 0;
+	if (flags & HTTP_FLAG_LOWEST_PRIORITY) return 3;
+	if (flags & HTTP_FLAG_LOW_PRIORITY)    return 2;
+	return 1;
+}
+
 /* Adds a req to the list of pending requests, waking up worker thread if needed. */
 static int Http_Add(const cc_string* url, cc_uint8 flags, cc_uint8 type, const cc_string* lastModified,
 					const cc_string* etag, const void* data, cc_uint32 size, struct StringsBuffer* cookies) {
@@ -125,6 +132,7 @@ static int Http_Add(const cc_string* url, cc_uint8 flags, cc_uint8 type, const c
 
 	req.id = ++nextReqID;
 	req.requestType = type;
+	req.priority    = Http_GetPriority(flags);
 
 	/* Change http:// to https:// if required */
 	if (httpsOnly) {
@@ -221,15 +229,19 @@ static void Http_CleanCacheTask(struct ScheduledTask* task) {
 /*########################################################################################################################*
 *----------------------------------------------------Http public api------------------------------------------------------*
 *#########################################################################################################################*/
+void Http_GetSkinUrl(const cc_string* skinName, cc_string* dst) {
+	if (Utils_IsUrlPrefix(skinName)) {
+		String_Copy(dst, skinName);
+	} else {
+		String_Format2(dst, "%s/%s.png", &skinServer, skinName);
+	}
+}
+
 int Http_AsyncGetSkin(const cc_string* skinName, cc_uint8 flags) {
 	cc_string url; char urlBuffer[URL_MAX_SIZE];
 	String_InitArray(url, urlBuffer);
 
-	if (Utils_IsUrlPrefix(skinName)) {
-		String_Copy(&url, skinName);
-	} else {
-		String_Format2(&url, "%s/%s.png", &skinServer, skinName);
-	}
+	Http_GetSkinUrl(skinName, &url);
 	return Http_AsyncGetData(&url, flags);
 }
 